@@ -64,3 +64,29 @@ void AppCommand::setSearchTerms(const std::set<std::string> &searchTerms)
 {
 	m_searchTerms = searchTerms;
 }
+
+
+/**
+ * @brief Get the priority of the lookups made for the command.
+ *
+ * This function returns the priority used when the command's lookups are sent to the QRZ API.
+ * Background lookups are throttled as the daily lookup quota runs low.
+ *
+ * @return The lookup priority of the command.
+ */
+LookupPriority AppCommand::getPriority() const
+{
+	return m_priority;
+}
+
+/**
+ * @brief Set the priority of the lookups made for the command.
+ *
+ * This function sets the priority used when the command's lookups are sent to the QRZ API.
+ *
+ * @param priority The lookup priority to set for the command.
+ */
+void AppCommand::setPriority(LookupPriority priority)
+{
+	m_priority = priority;
+}
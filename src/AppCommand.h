@@ -7,6 +7,7 @@
 #include <functional>
 
 #include "Action.h"
+#include "LookupPriority.h"
 #include "model/Callsign.h"
 
 namespace qrz
@@ -65,12 +66,34 @@ namespace qrz
 		 */
 		void setSearchTerms(const std::set<std::string> &searchTerms);
 
+		/**
+		 * @brief Get the priority of the lookups made for the command.
+		 *
+		 * This function returns the priority used when the command's lookups are sent to the QRZ API.
+		 * Background lookups are throttled as the daily lookup quota runs low.
+		 *
+		 * @return The lookup priority of the command.
+		 */
+		LookupPriority getPriority() const;
+
+		/**
+		 * @brief Set the priority of the lookups made for the command.
+		 *
+		 * This function sets the priority used when the command's lookups are sent to the QRZ API.
+		 *
+		 * @param priority The lookup priority to set for the command.
+		 */
+		void setPriority(LookupPriority priority);
+
 	private:
 		// The action to be performed by the AppController
 		Action m_action = Action::CALLSIGN_ACTION;
 
 		// List of terms to be used in the QRZ API calls to fetch the relevant records
 		std::set<std::string> m_searchTerms;
+
+		// Priority of the QRZ API calls, lookups asked for by the user are interactive
+		LookupPriority m_priority = LookupPriority::INTERACTIVE;
 	};
 }
 
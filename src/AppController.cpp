@@ -1,14 +1,103 @@
 #include "AppController.h"
 
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
 
 #include "Action.h"
-#include "exception/NotFoundException.h"
+#include "CallsignCanonicalizer.h"
+#include "exception/CancelledException.h"
+#include "exception/CircuitOpenException.h"
+#include "exception/RateLimitException.h"
 
 using namespace qrz;
 
+namespace
+{
+	/**
+	 * @brief Deletes a coroutine client once control is back in the event loop.
+	 *
+	 * The last lookup holding the client may be finishing inside a signal of one of the client's own network replies,
+	 * where deleting the network access manager would pull the reply from under the signal.
+	 */
+	struct DeferredClientDeleter
+	{
+		void operator()(AsyncQRZClient *asyncClient) const
+		{
+			if (QThread::currentThread()->loopLevel() == 0)
+			{
+				delete asyncClient;
+				return;
+			}
+
+			QTimer::singleShot(0, [asyncClient]() { delete asyncClient; });
+		}
+	};
+}
+
+/**
+ * @brief Constructs the controller and starts the lookup thread.
+ *
+ * The lookup service lives on its own thread. Its signals reach the controller as queued calls, so the records it
+ * fetches are added to the table on the GUI thread. The age of every record added to the table is tracked from here
+ * on, so it can be checked against QRZ again once it is stale. Callsign lookups go through a provider chain that
+ * starts out with QRZ alone. Lookups refused because QRZ is unreachable are deferred until it can be reached again.
+ */
 AppController::AppController(Configuration *config, TableModel *table) : config(config), tableModel(table)
 {
+	m_resolver.addProvider(client);
+
+	m_lookupService = std::make_unique<LookupService>(client,
+			[this](const std::string &call, LookupPriority priority)
+			{
+				return fetchCancellableCallsign(call, priority);
+			},
+			m_maxFailedCallCount);
+
+	m_lookupService->moveToThread(&m_lookupThread);
+
+	connect(m_lookupService.get(), &LookupService::callsignFound, this, &AppController::onCallsignFound);
+	connect(m_lookupService.get(), &LookupService::lookupsFinished, this, &AppController::onLookupsFinished);
+	connect(m_lookupService.get(), &LookupService::progress, this,
+			[this](quint64, int done, int total) { emit lookupProgress(done, total); });
+	connect(m_lookupService.get(), &LookupService::lookupFailed, this, &AppController::displayError);
+	connect(m_lookupService.get(), &LookupService::credentialsNeeded, this, &AppController::credentialsNeeded);
+	connect(m_lookupService.get(), &LookupService::bioFetched, this, &AppController::bioFetched);
+	connect(m_lookupService.get(), &LookupService::callsignRefreshed, this, &AppController::onCallsignRefreshed);
+	connect(m_lookupService.get(), &LookupService::speculativeFetched, this, &AppController::onSpeculativeFetched);
+	connect(m_lookupService.get(), &LookupService::lookupUnavailable, this, &AppController::deferLookup);
+
+	connect(tableModel, &TableModel::callsignAdded, this, &AppController::trackRecordAge);
+	connect(tableModel, &TableModel::callsignRemoved, this,
+			[this](const Callsign &callsign)
+			{
+				m_staleRefresher.forget(callsign.getCall());
+				m_placeholders.erase(callsign.getCall());
+			});
+	connect(&m_staleRefreshTimer, &QTimer::timeout, this, &AppController::refreshStaleRecord);
+	connect(&m_deferredDrainTimer, &QTimer::timeout, this, &AppController::drainDeferredLookup);
+
+	m_lookupThread.setObjectName("QRZ lookups");
+	m_lookupThread.start();
+}
+
+/**
+ * @brief Stops the background token refresher and the lookup thread before the client they use goes away.
+ *
+ * Lookups still in flight are cancelled, so the lookup thread does not hold up shutdown waiting on QRZ. Batches that
+ * were queued but not started are dropped.
+ */
+AppController::~AppController()
+{
+	if (m_tokenRefresher)
+	{
+		m_tokenRefresher->stop();
+	}
+
+	cancelAllLookups();
+
+	m_lookupThread.quit();
+	m_lookupThread.wait();
 }
 
 /**
@@ -19,28 +108,189 @@ AppController::AppController(Configuration *config, TableModel *table) : config(
  * if a session key and session expiration are set in the configuration. If not, it refreshes the token by fetching a new
  * session key and expiration from the QRZ API. If the token is already expired, it refreshes it as well. Finally, it sets
  * the session key and expiration in the QRZ API client.
+ *
+ * The persistent callsign and bio caches are opened here as well, so records from earlier sessions are available
+ * right away, the retry and circuit breaker settings are applied, and the background token refresher is started.
+ * A fallback endpoint, if one is configured, joins the lookup chain behind QRZ. The coroutine client is switched on
+ * if the configuration asks for it, and the check for stale records in the table is started.
+ *
+ * Lookups deferred while offline, in this session or an earlier one, are read back from disk, and are looked up again
+ * at the configured rate once QRZ can be reached.
  */
 void AppController::initialize()
 {
+	client.setDailyLookupLimit(config->getDailyLookupLimit());
+	client.setBackgroundLookupRate(config->getBackgroundLookupRate());
+	client.setMemoryCacheLimits(config->getMemoryCacheSize(), std::chrono::hours(config->getCallsignCacheTtl()),
+								std::chrono::minutes(config->getNotFoundTtl()));
+	client.setRequestDeadlines({std::chrono::seconds(config->getConnectTimeout()), std::chrono::seconds(config->getReadTimeout()),
+								std::chrono::seconds(config->getRequestTimeout())});
+	client.setRetryPolicy({config->getRetryAttempts()});
+	client.getCircuitBreaker().setFailureThreshold(config->getBreakerFailureThreshold());
+	client.getCircuitBreaker().setOpenDuration(std::chrono::seconds(config->getBreakerOpenTime()));
+	m_lookupService->setBackgroundQueueDepth(config->getBackgroundQueueDepth());
+	m_staleRefresher.setMaxAge(std::chrono::hours(config->getStaleRecordAge()));
+	m_staleRefresher.setLookupsPerHour(config->getStaleRefreshBudget());
+
+	// The breaker changes state on whichever thread made the request, the status bar lives on the GUI thread
+	client.getCircuitBreaker().setListener([this](net::CircuitState)
+	{
+		QMetaObject::invokeMethod(this, [this]() { emit serviceStateChanged(); }, Qt::QueuedConnection);
+	});
+
+	try
+	{
+		std::filesystem::path cacheDirectory = config->getCacheDirectory();
+
+		client.setCallsignCache(std::make_shared<cache::CallsignCache>(cacheDirectory / "callsigns",
+																		std::chrono::hours(config->getCallsignCacheTtl())));
+		client.setBioCache(std::make_shared<cache::BioCache>(cacheDirectory / "bios",
+															 static_cast<std::size_t>(config->getBioMemoryBudget()) * 1024));
+	}
+	catch (std::exception &e)
+	{
+		// Lookups still work without the cache, they just always go to QRZ
+		std::cerr << "Unable to open callsign cache: " << e.what() << std::endl;
+	}
+
+	try
+	{
+		std::filesystem::path queuePath = std::filesystem::path(config->getCacheDirectory()) / "deferred_lookups";
+
+		m_deferredLookups = std::make_unique<cache::DeferredLookupQueue>(queuePath);
+	}
+	catch (std::exception &e)
+	{
+		// Misses while offline are then simply not looked up again
+		std::cerr << "Unable to open deferred lookup queue: " << e.what() << std::endl;
+	}
+
+	openTrafficArchive();
+
+	m_offlineMode = config->getOfflineMode();
+
 	client.setUsername(config->getUsername());
+	client.setPassword(config->getPassword());
 	client.setSessionKey(config->getSessionKey());
 	client.setSessionExpiration(config->getSessionExpiration());
+
+	configureLookupChain();
+
+	useAsyncClient(config->getAsyncLookups());
+
+	startTokenRefresher();
+
+	m_staleRefreshTimer.start(std::chrono::minutes(1));
+	m_deferredDrainTimer.start(std::chrono::milliseconds(60000 / config->getDeferredLookupRate()));
+}
+
+/**
+ * @brief Records QRZ responses to an archive, or replays them from one, if the configuration asks for it.
+ *
+ * Replaying takes precedence over recording. The archive is only opened once, a client already recording or replaying
+ * keeps its archive.
+ */
+void AppController::openTrafficArchive()
+{
+	if (client.getTrafficArchive())
+	{
+		return;
+	}
+
+	try
+	{
+		std::string replayPath = config->getReplayTrafficFrom();
+		std::string recordPath = config->getRecordTrafficTo();
+
+		if (!replayPath.empty())
+		{
+			auto archive = std::make_shared<net::TrafficArchive>(replayPath, net::TrafficArchive::Mode::REPLAY);
+			archive->setReplaySpeed(config->getReplaySpeed() / 100.0);
+
+			client.setTrafficArchive(archive);
+		}
+		else if (!recordPath.empty())
+		{
+			client.setTrafficArchive(std::make_shared<net::TrafficArchive>(recordPath, net::TrafficArchive::Mode::RECORD));
+		}
+	}
+	catch (std::exception &e)
+	{
+		// Lookups then simply go to QRZ unrecorded
+		std::cerr << "Unable to open traffic archive: " << e.what() << std::endl;
+	}
+}
+
+/**
+ * @brief Adds the fallback endpoint to the lookup chain behind QRZ, if one is configured, and sets the hedge delay.
+ *
+ * The fallback logs in with the same account and keeps a session of its own, and it shares the callsign cache on disk
+ * with QRZ, so a record either of them fetched is found by both. It is only added once, the chain cannot change while
+ * the lookup thread may be using it.
+ */
+void AppController::configureLookupChain()
+{
+	m_resolver.setHedgeDelay(std::chrono::milliseconds(config->getHedgeDelay()));
+
+	std::string fallbackUrl = config->getFallbackBaseUrl();
+	if (fallbackUrl.empty() || m_resolver.getProviderCount() > 1)
+	{
+		return;
+	}
+
+	m_fallbackClient.setBaseUrl(fallbackUrl);
+	m_fallbackClient.setUsername(config->getUsername());
+	m_fallbackClient.setPassword(config->getPassword());
+	m_fallbackClient.setRequestDeadlines(client.getRequestDeadlines());
+	m_fallbackClient.setRetryPolicy(client.getRetryPolicy());
+	m_fallbackClient.setCallsignCache(client.getCallsignCache());
+	m_fallbackClient.setTrafficArchive(client.getTrafficArchive());
+
+	m_resolver.addProvider(m_fallbackClient);
 }
 
+/**
+ * @brief Returns how each provider in the lookup chain has been answering, in chain order.
+ *
+ * @return The statistics of QRZ, and of the fallback endpoint if one is configured.
+ */
+std::vector<LookupProviderStats> AppController::getLookupProviderStats() const
+{
+	return m_resolver.getProviderStats();
+}
+
+/**
+ * @brief Checks that an account is configured and brings the client up to date with the configuration.
+ *
+ * Nothing here waits on the network. The lookup service renews an expired session on the lookup thread before its
+ * next batch, and the coroutine client does so from the event loop.
+ *
+ * @return False if there are no credentials, in which case credentialsNeeded has been emitted.
+ */
 bool AppController::preflight()
 {
 	std::string userCall = config->getUsername();
 	std::string password = config->getPassword();
 
-	client.setUsername(userCall);
-	client.setSessionKey(config->getSessionKey());
-	client.setSessionExpiration(config->getSessionExpiration());
+	// Keep a token the background refresher swapped in, unless the account itself changed
+	if (userCall != client.getUsername() || !client.tokenIsValid())
+	{
+		client.setSessionKey(config->getSessionKey());
+		client.setSessionExpiration(config->getSessionExpiration());
+	}
 
-	if (!config->hasSessionKey() || !config->hasSessionExpiration() || !client.tokenIsValid())
+	client.setUsername(userCall);
+	client.setPassword(password);
+	// The fallback keeps a session of its own, which has to be dropped if the account changed
+	if (userCall != m_fallbackClient.getUsername())
 	{
-		refreshToken();
+		m_fallbackClient.setSessionExpiration("1970-01-01 00:00:00");
 	}
-	else if (userCall.empty() || password.empty())
+
+	m_fallbackClient.setUsername(userCall);
+	m_fallbackClient.setPassword(password);
+
+	if (userCall.empty() || password.empty())
 	{
 		emit credentialsNeeded();
 		return false;
@@ -55,7 +305,11 @@ bool AppController::preflight()
  * This function takes an AppCommand object and performs different operations based on the command's action type.
  * The action type determines the type of operation to be performed.
  *
+ * Callsign lookups are handed to the lookup thread, or started on the coroutine client, and this returns straight
+ * away. Bio and DXCC commands have no view in the window and still run on the calling thread.
+ *
  * @param command The AppCommand object representing the command to be executed.
+ * @return True if the command was accepted.
  */
 bool AppController::handleCommand(const AppCommand &command)
 {
@@ -67,7 +321,7 @@ bool AppController::handleCommand(const AppCommand &command)
 	switch (command.getAction())
 	{
 		case Action::CALLSIGN_ACTION:
-			return fetchAndRenderCallsigns(command.getSearchTerms());
+			return fetchAndRenderCallsigns(command.getSearchTerms(), command.getPriority());
 			break;
 		case Action::BIO_ACTION:
 			return fetchAndRenderBios(command.getSearchTerms());
@@ -80,228 +334,1121 @@ bool AppController::handleCommand(const AppCommand &command)
 	return false;
 }
 
+/**
+ * @brief Looks up a single callsign, passing the record to the callback on the GUI thread once it arrives.
+ *
+ * @param call The callsign.
+ * @param callback Called with the record. Not called if the lookup failed.
+ */
 void AppController::fetchCallsign(const std::string &call, QrzCallsignResponseCallback callback)
 {
-	std::vector<Callsign> callsigns = fetchCallsignRecords({call});
-
-	if (callsigns.size() > 0)
+	if (m_asyncClient)
 	{
-		callback(callsigns.at(0));
+		startCallsignLookups({call}, LookupPriority::INTERACTIVE, callback);
+		return;
 	}
-}
 
-std::string AppController::fetchBio(const std::string &call)
-{
-	std::vector<std::string> bios = fetchBios({call});
-	return bios.at(0);
+	queueCallsignLookups({call}, LookupPriority::INTERACTIVE, callback);
 }
 
 /**
- * @brief Fetches and renders callsigns based on the given search terms and output format.
+ * @brief Fetches the records of stations heard on the air into the caches, ahead of anyone asking for them.
  *
- * This function takes a set of search terms and an output format and fetches the callsign records using the fetchCallsignRecords function.
- * It then creates a renderer object based on the output format using the RendererFactory and renders the callsigns using the Render function.
- * After rendering, it updates the application configuration from the client state.
+ * Once a station calls us, or is picked from the map, its lookup is then answered from the cache without waiting on
+ * QRZ. Stations already in the table, already prefetched, or known not to be in QRZ are skipped, and only the
+ * configured number of the most recently heard are fetched at a time. Prefetching only fills a lookup queue that is
+ * otherwise empty, at background priority, so it never delays a lookup anyone is waiting for, and it gives way when
+ * the quota runs low. Nothing is prefetched while offline.
  *
- * @param searchTerms The set of search terms used to fetch the callsign records.
- * @param format The output format in which the callsigns should be rendered.
+ * @param calls The callsigns heard, most recently heard first.
  */
-bool AppController::fetchAndRenderCallsigns(const std::set<std::string> &searchTerms)
+void AppController::prefetchCallsigns(const std::vector<std::string> &calls)
 {
-	bool status = true;
-
-	try
+	if (isOffline())
 	{
-		const std::vector<Callsign> callsigns = fetchCallsignRecords(searchTerms);
+		return;
+	}
 
-		status = (callsigns.size() > 0);
+	LookupSchedulerStats stats = m_lookupService->getQueueStats();
 
-		tableModel->addCallsigns(callsigns);
+	if (stats.queued[LookupPriority::INTERACTIVE] > 0 || stats.queued[LookupPriority::DETAIL] > 0 ||
+		stats.queued[LookupPriority::BACKGROUND] > 0)
+	{
+		return;
+	}
 
-		updateConfigFromClientState();
+	if (config->getUsername().empty() || config->getPassword().empty())
+	{
+		return;
 	}
-	catch(std::exception e)
+
+	std::vector<std::string> wanted;
+	std::size_t limit = config->getPrefetchLimit();
+
+	for (const std::string &heard : calls)
 	{
-		status = false;
+		if (wanted.size() >= limit)
+		{
+			break;
+		}
+
+		// Compound callsigns like VE3/K4RWR/P are looked up by the callsign of the station
+		std::string call = CallsignCanonicalizer::canonicalize(heard);
+
+		if (call.empty() || m_prefetched.contains(call) || tableModel->containsCallsign(resolveCallsign(call)) ||
+			client.isKnownNotFound(call))
+		{
+			continue;
+		}
+
+		m_prefetched.insert(call);
+		wanted.push_back(call);
 	}
 
-	return status;
+	if (!wanted.empty())
+	{
+		m_lookupService->queuePrefetch(wanted, readCredentials());
+	}
 }
 
 /**
-* @brief Fetches and renders DXCC records based on the given search terms and output format.
-*
-* This function takes a set of search terms and an output format and fetches the DXCC records using the fetchDXCCRecords function.
-* It then creates a renderer object based on the output format using the RendererFactory and renders the DXCC records using the Render function.
-* After rendering, it updates the application configuration from the client state.
-*
-* @param searchTerms The set of search terms used to fetch the DXCC records.
-* @param format The output format in which the DXCC records should be rendered.
-*/
-bool AppController::fetchAndRenderDXCC(const std::set<std::string> &searchTerms)
+ * @brief Starts fetching the bio for the detail view, emitting bioFetched once it is here.
+ *
+ * A bio fetch still in progress from an earlier call is cancelled first, since its dialog is being reused.
+ * The download runs on the lookup thread, or on the event loop with the coroutine client.
+ *
+ * @param call The callsign.
+ */
+void AppController::fetchBio(const std::string &call)
 {
-	try
+	auto cancel = std::make_shared<net::CancellationToken>();
+
 	{
-		const std::vector<DXCC> dxccRecords = fetchDXCCRecords(searchTerms);
+		std::lock_guard<std::mutex> lock(m_cancelMutex);
 
-		// TODO do something with the records
+		if (m_bioCancel)
+		{
+			m_bioCancel->cancel();
+		}
 
-		updateConfigFromClientState();
+		m_bioCancel = cancel;
 	}
-	catch(std::exception e)
+
+	if (!m_asyncClient)
 	{
-		return false;
+		m_lookupService->queueBio(call, cancel);
+		return;
 	}
 
-	return true;
+	std::shared_ptr<AsyncQRZClient> asyncClient = m_asyncClient;
+
+	asyncClient->fetchBio(call, "", cancel).start(
+			[this, call, asyncClient](std::string bio)
+			{
+				emit bioFetched(call, bio);
+			},
+			[this](std::exception_ptr error)
+			{
+				try
+				{
+					std::rethrow_exception(error);
+				}
+				catch (CancelledException &)
+				{
+					// The dialog was closed, nobody is waiting for the bio any more
+				}
+				catch (std::exception &e)
+				{
+					emit displayError(e.what());
+				}
+			});
 }
 
 /**
- * @brief Fetches and renders bios based on the given search terms.
- *
- * This function fetches the specified callsign records and renders them.
- *
- * Unlike callsigns and DXCC records, bio HTML content is rendered directly as it is received from the QRZ API.
+ * @brief Aborts the lookup of a callsign if it is in flight.
  *
- * @param searchTerms The set of search terms used to fetch the bio content.
+ * @param call The callsign.
  */
-bool AppController::fetchAndRenderBios(const std::set<std::string> &searchTerms)
+void AppController::cancelLookup(const std::string &call)
 {
-	try
+	std::lock_guard<std::mutex> lock(m_cancelMutex);
+
+	auto it = m_lookupCancels.find(CallsignCanonicalizer::canonicalize(call));
+	if (it != m_lookupCancels.end())
 	{
-		std::vector<std::string> bios = fetchBios(searchTerms);
+		it->second->cancel();
+	}
+}
 
-		//TODO do something with bios
+/**
+ * @brief Aborts the bio fetch for the detail view if it is in flight.
+ */
+void AppController::cancelBioFetch()
+{
+	std::lock_guard<std::mutex> lock(m_cancelMutex);
 
-		updateConfigFromClientState();
+	if (m_bioCancel)
+	{
+		m_bioCancel->cancel();
 	}
-	catch(std::exception e)
+}
+
+/**
+ * @brief Opens a connection to QRZ ahead of a lookup the user has started typing.
+ *
+ * The TCP connect and TLS handshake then overlap with the typing instead of delaying the lookup. A pooled
+ * connection stays open for the keep-alive time, so calls within m_prewarmInterval of the previous one do nothing.
+ */
+void AppController::prewarmConnection()
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	if (now - m_lastPrewarm < m_prewarmInterval)
 	{
-		return false;
+		return;
 	}
 
-	return true;
+	if (isOffline())
+	{
+		return;
+	}
+
+	m_lastPrewarm = now;
+
+	if (m_asyncClient)
+	{
+		m_asyncClient->prewarmConnection();
+		return;
+	}
+
+	m_lookupService->queuePrewarm();
 }
 
 /**
- * @brief Fetches the callsign records based on the given search terms.
- *
- * This function fetches the callsign records based on the provided search terms.
- * It makes API calls to retrieve the callsigns and stores them in a vector.
- * It handles authentication errors and retries the API call after refreshing the token.
- * It also displays a progress bar to show the progress of fetching the callsigns.
+ * @brief Starts looking up the callsign being typed, before the user asks for it.
  *
- * @param searchTerms The set of search terms used to fetch the callsign records.
- * @return A vector of Callsign objects representing the fetched callsign records.
+ * Callsigns already in the table or known not to be in QRZ are not looked up, and nothing is looked up without an
+ * account, since a speculative lookup should never end in a login prompt. Nothing is looked up while offline either.
+ * The lookup is counted as a background lookup against the quota. Text that is not yet a complete callsign only
+ * cancels the lookup of the previous one.
  *
- * @note This function assumes that the necessary APIs and client objects are properly initialized before calling this function.
- * @note This function prints any errors encountered during the API calls to the standard error stream.
- * @note This function sets the progress bar option and progress values to reflect the progress of fetching the callsigns.
+ * @param call The callsign being typed.
  */
-std::vector<Callsign> AppController::fetchCallsignRecords(const std::set<std::string> &searchTerms)
+void AppController::speculateCallsign(const std::string &call)
 {
-	// Buffer for the output
-	std::vector<Callsign> callsigns;
-
-	// Error buffer, we will display the errors after all API calls have been made and progress bar is removed
-	std::vector<std::string> errors;
+	std::string key = CallsignCanonicalizer::canonicalize(call);
 
-	// Display our progress bar
-	//auto bar = buildProgressBar();
+	if (key == m_speculativeCall)
+	{
+		return;
+	}
 
-	// Progress bar value
-	auto progress = 0.0f;
+	if (m_speculativeCancel)
+	{
+		m_speculativeCancel->cancel();
+		m_speculativeCancel.reset();
+	}
 
-	// Amount to advance the progress bar after each call
-	float tickSize = 100/searchTerms.size();
+	m_speculativeCall = key;
+	m_speculativeRecord.reset();
 
-	// Use an iterator so we cen reset the current element in the event of authentication error
-	auto it = searchTerms.begin();
-	while (it != searchTerms.end())
+	if (key.empty() || tableModel->containsCallsign(resolveCallsign(key)) || client.isKnownNotFound(key) ||
+		config->getUsername().empty() || config->getPassword().empty() || isOffline())
 	{
-		const std::string &call = *it;
+		return;
+	}
 
-		if(invalidCallsigns.contains(call))
-		{
-			it++;
-			continue;
-		}
+	auto cancel = std::make_shared<net::CancellationToken>();
+	m_speculativeCancel = cancel;
 
-		try
-		{
-			// Hide the cursor - we do this on every iteration in case we hit an authentication error previously
-			//showConsoleCursor(false);
+	if (!m_asyncClient)
+	{
+		m_lookupService->queueSpeculative(key, cancel, readCredentials());
+		return;
+	}
 
-			// Update progress bar
-			//bar->setOption(indicators::option::PostfixText{std::format("Fetching {:s}", call)});
-			//bar->setProgress(progress);
+	std::shared_ptr<AsyncQRZClient> asyncClient = m_asyncClient;
 
-			progress += tickSize;
+	asyncClient->fetchCallsign(key, LookupPriority::BACKGROUND, cancel).start(
+			[this, key, asyncClient](Callsign callsign)
+			{
+				onSpeculativeFetched(key, callsign);
+			},
+			[](std::exception_ptr)
+			{
+				// Nobody asked for the record yet, the lookup of the callsign will report any problem
+			});
+}
 
-			// Fetch the callsign and add it to the output buffer
-			Callsign callsign = client.fetchCallsign(call);
+/**
+ * @brief Returns the callsign of the record a callsign is known to resolve to.
+ *
+ * A prefix or suffix is dropped first, so VE3/K4RWR and K4RWR/P both find the row of K4RWR.
+ *
+ * @param call The callsign, which may be a portable or former callsign, or another alias.
+ * @return The callsign of the record, or the callsign itself, canonicalized.
+ */
+std::string AppController::resolveCallsign(const std::string &call) const
+{
+	std::string key = CallsignCanonicalizer::canonicalize(call);
 
-			callsigns.push_back(callsign);
+	return client.getAliasIndex().canonicalize(key.empty() ? call : key);
+}
 
-			// Reset the fail counter
-			resetFailedCallCount();
+/**
+ * @brief Returns the lookup quota most recently reported by the QRZ API.
+ *
+ * @return The quota status.
+ */
+QuotaStatus AppController::getQuotaStatus() const
+{
+	return client.getQuotaStatus();
+}
 
-			it++;
-		}
-		catch (AuthenticationException &e)
-		{
-			// If we have not exceeded the max fail count, try to authenticate
-			if (m_failedCallCount < m_maxFailedCallCount)
-			{
-				// Hide the progress bar and give the cursor back
-				//eraseLine();
-				//showConsoleCursor(true);
+/**
+ * @brief Returns the number of callsign lookups saved by sharing a lookup already in flight.
+ *
+ * @return The number of requests saved.
+ */
+std::uint64_t AppController::getCoalescedLookupCount() const
+{
+	std::uint64_t coalesced = client.getCoalescedLookupCount();
 
-				// Ask the user for their password, and refresh the bearer token
-				refreshToken();
+	return m_asyncClient ? coalesced + m_asyncClient->getCoalescedLookupCount() : coalesced;
+}
 
-				// Increment the error counter so we don't do this forever
-				m_failedCallCount++;
-			}
-			else
-			{
-				// Save the error for display after we have mde all of our API calls
-				errors.push_back(std::format("QRZ API Error: {:s}", e.what()));
-				it++;
-			}
-		}
-		catch (NotFoundException &e)
+/**
+ * @brief Returns the depths and wait times of the queue of lookups waiting for the lookup thread.
+ *
+ * @return The scheduler statistics.
+ */
+LookupSchedulerStats AppController::getLookupQueueStats() const
+{
+	return m_lookupService->getQueueStats();
+}
+
+/**
+ * @brief Returns the counters and sizes of the bio cache.
+ *
+ * @return The bio cache statistics, all zero if bios are not cached.
+ */
+cache::BioCacheStats AppController::getBioCacheStats() const
+{
+	std::shared_ptr<cache::BioCache> bioCache = client.getBioCache();
+
+	return bioCache ? bioCache->getStats() : cache::BioCacheStats();
+}
+
+/**
+ * @brief Returns the counters of the bytes received from each endpoint of the QRZ API.
+ *
+ * @return The counters, keyed by endpoint.
+ */
+std::map<std::string, net::TransferStats> AppController::getTransferStats() const
+{
+	return client.getTransferStats();
+}
+
+/**
+ * @brief Returns the state of the circuit breaker guarding requests to QRZ.
+ *
+ * @return The circuit breaker statistics.
+ */
+net::CircuitBreakerStats AppController::getCircuitBreakerStats()
+{
+	return client.getCircuitBreaker().getStats();
+}
+
+/**
+ * @brief Turns offline mode on or off by hand, and remembers the choice in the configuration.
+ *
+ * Coming back online starts on the deferred lookups straight away, rather than at the next tick of the drain.
+ *
+ * @param enabled True to stay offline.
+ */
+void AppController::setOfflineMode(bool enabled)
+{
+	m_offlineMode = enabled;
+	config->setOfflineMode(enabled);
+
+	emit serviceStateChanged();
+
+	if (!enabled)
+	{
+		drainDeferredLookup();
+	}
+}
+
+/**
+ * @brief Whether offline mode was turned on by hand.
+ *
+ * @return True if offline mode is on.
+ */
+bool AppController::isOfflineMode() const
+{
+	return m_offlineMode;
+}
+
+/**
+ * @brief Whether lookups are answered from local data only, either by hand or because QRZ is unreachable.
+ *
+ * QRZ counts as unreachable while the circuit breaker is open and its pause has not run out. Once it has, the next
+ * lookup is the one that tries QRZ again, so lookups go out as usual.
+ *
+ * @return True if no request would be made for a lookup right now.
+ */
+bool AppController::isOffline()
+{
+	if (m_offlineMode)
+	{
+		return true;
+	}
+
+	net::CircuitBreakerStats breaker = client.getCircuitBreaker().getStats();
+
+	return breaker.state == net::CircuitState::OPEN && breaker.retryIn.count() > 0;
+}
+
+/**
+ * @brief Returns the number of callsigns waiting to be looked up once QRZ can be reached again.
+ *
+ * @return The number of deferred lookups.
+ */
+std::size_t AppController::getDeferredLookupCount() const
+{
+	return m_deferredLookups ? m_deferredLookups->size() : 0;
+}
+
+/**
+ * @brief Chooses between the blocking client and the coroutine client for lookups.
+ *
+ * The coroutine client is built on the blocking one, so the session, quota, caches and circuit breaker carry over in
+ * either direction. Lookups still in flight when the coroutine client is switched off are cancelled. The client is
+ * deleted once the last of them has finished, since each holds a reference to it.
+ *
+ * @param enabled True to use the coroutine client, false for the blocking client.
+ */
+void AppController::useAsyncClient(bool enabled)
+{
+	if (enabled && !m_asyncClient)
+	{
+		m_asyncClient = std::shared_ptr<AsyncQRZClient>(new AsyncQRZClient(client), DeferredClientDeleter());
+	}
+	else if (!enabled && m_asyncClient)
+	{
+		cancelAllLookups();
+		m_asyncClient.reset();
+	}
+}
+
+/**
+ * @brief Whether lookups go through the coroutine client.
+ *
+ * @return True if the coroutine client is in use.
+ */
+bool AppController::isUsingAsyncClient() const
+{
+	return m_asyncClient != nullptr;
+}
+
+/**
+ * @brief Fetches and renders callsigns based on the given search terms and output format.
+ *
+ * This function takes a set of search terms and an output format and fetches the callsign records using the fetchCallsignRecords function.
+ * It then creates a renderer object based on the output format using the RendererFactory and renders the callsigns using the Render function.
+ * After rendering, it updates the application configuration from the client state.
+ *
+ * The lookups are only started here, on the lookup thread or the coroutine client, and each record is added to the
+ * table once it arrives. A record the speculative lookup already fetched while the callsign was being typed is added
+ * straight away. A portable, former or other alias callsign whose record is already in the table is not looked up
+ * again, and a search term that cannot be a callsign is never looked up at all.
+ *
+ * While offline, the batch is answered from local data only, and the callsigns that would need a request are
+ * deferred.
+ *
+ * @param searchTerms The set of search terms used to fetch the callsign records.
+ * @param priority The priority of the lookups.
+ */
+bool AppController::fetchAndRenderCallsigns(const std::set<std::string> &searchTerms, LookupPriority priority)
+{
+	std::vector<std::string> terms = filterKnownNotFound(canonicalizeCallsigns(searchTerms, priority));
+
+	if (terms.empty())
+	{
+		return false;
+	}
+
+	collapseAliases(terms);
+
+	if (terms.empty())
+	{
+		emit lookupsFinished(0);
+		return true;
+	}
+
+	if (takeSpeculativeRecord(terms) && terms.empty())
+	{
+		emit lookupsFinished(1);
+		return true;
+	}
+
+	if (isOffline())
+	{
+		emit lookupsFinished(answerOffline(terms));
+		return true;
+	}
+
+	if (m_asyncClient)
+	{
+		startCallsignLookups(terms, priority);
+	}
+	else
+	{
+		queueCallsignLookups(terms, priority);
+	}
+
+	return true;
+}
+
+/**
+* @brief Fetches and renders DXCC records based on the given search terms and output format.
+*
+* This function takes a set of search terms and an output format and fetches the DXCC records using the fetchDXCCRecords function.
+* It then creates a renderer object based on the output format using the RendererFactory and renders the DXCC records using the Render function.
+* After rendering, it updates the application configuration from the client state. With the coroutine client the
+* records are fetched on the event loop and this returns once the fetch has started.
+*
+* @param searchTerms The set of search terms used to fetch the DXCC records.
+* @param format The output format in which the DXCC records should be rendered.
+*/
+bool AppController::fetchAndRenderDXCC(const std::set<std::string> &searchTerms)
+{
+	if (m_asyncClient)
+	{
+		fetchDXCCRecordsAsync(searchTerms).start(
+				[this](std::vector<DXCC> dxccRecords)
+				{
+					// TODO do something with the records
+
+					updateConfigFromClientState();
+				},
+				[](std::exception_ptr)
+				{
+					// Errors of each term have already been reported
+				});
+
+		return true;
+	}
+
+	try
+	{
+		const std::vector<DXCC> dxccRecords = fetchDXCCRecords(searchTerms);
+
+		// TODO do something with the records
+
+		updateConfigFromClientState();
+	}
+	catch(std::exception e)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Fetches and renders bios based on the given search terms.
+ *
+ * This function fetches the specified callsign records and renders them.
+ *
+ * Unlike callsigns and DXCC records, bio HTML content is rendered directly as it is received from the QRZ API. With the
+ * coroutine client the bios are fetched on the event loop and this returns once the fetch has started.
+ *
+ * @param searchTerms The set of search terms used to fetch the bio content.
+ */
+bool AppController::fetchAndRenderBios(const std::set<std::string> &searchTerms)
+{
+	if (m_asyncClient)
+	{
+		fetchBiosAsync(searchTerms).start(
+				[this](std::vector<std::string> bios)
+				{
+					//TODO do something with bios
+
+					updateConfigFromClientState();
+				},
+				[](std::exception_ptr)
+				{
+					// Errors of each bio have already been reported
+				});
+
+		return true;
+	}
+
+	try
+	{
+		std::vector<std::string> bios = fetchBios(searchTerms);
+
+		//TODO do something with bios
+
+		updateConfigFromClientState();
+	}
+	catch(std::exception e)
+	{
+		return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief Fetches the callsign records based on the given search terms.
+ *
+ * This function fetches the callsign records based on the provided search terms, blocking the calling thread until
+ * all of them are done. The lookups are made by the lookup service, on worker threads of its own, and the results are
+ * returned in the same order as the search terms.
+ *
+ * @param searchTerms The set of search terms used to fetch the callsign records.
+ * @param priority The priority of the lookups.
+ * @return A vector of Callsign objects representing the fetched callsign records.
+ *
+ * @note Any errors encountered during the API calls are collected and reported through the displayError signal.
+ */
+std::vector<Callsign> AppController::fetchCallsignRecords(const std::set<std::string> &searchTerms, LookupPriority priority)
+{
+	return m_lookupService->fetchCallsignRecords(filterKnownNotFound(searchTerms), priority, readCredentials(),
+												 config->getLookupWorkers());
+}
+
+/**
+ * @brief Hands a batch of callsign lookups to the lookup thread.
+ *
+ * The configuration is read here, on the GUI thread, and passed along with the batch. The batch waits behind any more
+ * urgent work already queued. Each record is added to the table as it arrives, or passed to the callback instead if
+ * one is given.
+ *
+ * @param terms The callsigns to look up.
+ * @param priority The priority of the lookups.
+ * @param callback Called on the GUI thread with each record fetched. May be null.
+ */
+void AppController::queueCallsignLookups(const std::vector<std::string> &terms, LookupPriority priority,
+										 QrzCallsignResponseCallback callback)
+{
+	quint64 requestId = m_nextRequestId++;
+
+	if (callback)
+	{
+		m_lookupCallbacks[requestId] = callback;
+	}
+
+	LookupCredentials credentials = readCredentials();
+	int workers = config->getLookupWorkers();
+
+	m_lookupService->queueCallsigns(requestId, terms, priority, credentials, workers);
+}
+
+/**
+ * @brief Takes a record fetched on the lookup thread.
+ *
+ * @param requestId The batch the record belongs to.
+ * @param callsign The record.
+ */
+void AppController::onCallsignFound(quint64 requestId, const Callsign &callsign)
+{
+	auto it = m_lookupCallbacks.find(requestId);
+
+	if (it != m_lookupCallbacks.end())
+	{
+		it->second(callsign);
+	}
+	else
+	{
+		addRecord(callsign);
+	}
+}
+
+/**
+ * @brief Finishes a batch of lookups made on the lookup thread.
+ *
+ * The session may have been renewed along the way, so it is written back to the configuration.
+ *
+ * @param requestId The batch.
+ * @param found The number of records fetched.
+ */
+void AppController::onLookupsFinished(quint64 requestId, int found)
+{
+	m_lookupCallbacks.erase(requestId);
+
+	updateConfigFromClientState();
+
+	emit lookupsFinished(found);
+}
+
+/**
+ * @brief Hands the stalest record in the table to the lookup thread to be checked, if nothing else is waiting.
+ *
+ * Called once a minute. The check is only made while the lookup thread is idle, with no lookups in flight or queued,
+ * so it never holds up a lookup the user asked for. It runs at background priority, so it is also held back when the
+ * daily quota runs low. How many checks are made per hour is limited by the refresher. Nothing is checked while
+ * offline.
+ */
+void AppController::refreshStaleRecord()
+{
+	if (isOffline() || !lookupsIdle())
+	{
+		return;
+	}
+
+	std::optional<std::string> call = m_staleRefresher.next();
+
+	if (call.has_value())
+	{
+		m_lookupService->queueRefresh(call.value(), readCredentials());
+	}
+}
+
+/**
+ * @brief Takes a record checked against QRZ, updating its row if QRZ has changed it.
+ *
+ * Only a record whose moddate differs from the one on display replaces its row, so the table and the map are left
+ * alone for the many records that have not changed. A record QRZ could not be reached for has no moddate and is
+ * ignored.
+ *
+ * @param callsign The current record.
+ */
+void AppController::onCallsignRefreshed(const Callsign &callsign)
+{
+	if (callsign.getModdate().empty())
+	{
+		return;
+	}
+
+	Callsign current;
+
+	try
+	{
+		current = tableModel->getCallsign(callsign.getCall());
+	}
+	catch (std::exception &)
+	{
+		// The row was removed while the check was in flight
+		return;
+	}
+
+	m_staleRefresher.track(current.getCall(), StaleRecordRefresher::Clock::now());
+
+	if (current.getModdate() != callsign.getModdate())
+	{
+		tableModel->updateCallsign(callsign);
+	}
+}
+
+/**
+ * @brief Keeps the record of a speculative lookup, if the user is still typing that callsign.
+ *
+ * @param call The normalized callsign the lookup was made for.
+ * @param callsign The record.
+ */
+void AppController::onSpeculativeFetched(const std::string &call, const Callsign &callsign)
+{
+	if (call != m_speculativeCall)
+	{
+		return;
+	}
+
+	m_speculativeRecord = callsign;
+	m_speculativeCancel.reset();
+}
+
+/**
+ * @brief Hands a batch the speculative lookup made for one of its callsigns.
+ *
+ * Either way the speculative lookup is done with. Its token is dropped rather than cancelled, since cancelling it
+ * would also cancel the lookup of the batch that shares it.
+ *
+ * @param terms The callsigns of the batch.
+ * @return True if a record was added to the table.
+ */
+bool AppController::takeSpeculativeRecord(std::vector<std::string> &terms)
+{
+	if (m_speculativeCall.empty())
+	{
+		return false;
+	}
+
+	auto it = std::find_if(terms.begin(), terms.end(), [this](const std::string &term)
+	{
+		return CallsignCanonicalizer::canonicalize(term) == m_speculativeCall;
+	});
+
+	if (it == terms.end())
+	{
+		return false;
+	}
+
+	std::optional<Callsign> record = std::move(m_speculativeRecord);
+
+	m_speculativeCall.clear();
+	m_speculativeRecord.reset();
+	m_speculativeCancel.reset();
+
+	if (!record.has_value())
+	{
+		return false;
+	}
+
+	std::string requested = *it;
+	terms.erase(it);
+	addRecord(record.value(), requested);
+
+	return true;
+}
+
+/**
+ * @brief Answers a batch from local data only, deferring the callsigns that would need a request.
+ *
+ * Every provider's local store is asked, so a record either QRZ or the fallback fetched earlier is found.
+ *
+ * @param terms The callsigns of the batch.
+ * @return The number of records found locally.
+ */
+int AppController::answerOffline(const std::vector<std::string> &terms)
+{
+	int found = 0;
+
+	for (const std::string &call : terms)
+	{
+		std::optional<Callsign> local = m_resolver.findLocalCallsign(call);
+
+		if (local.has_value())
+		{
+			addRecord(local.value(), call);
+			found++;
+		}
+		else
+		{
+			deferLookup(call);
+		}
+	}
+
+	return found;
+}
+
+/**
+ * @brief Queues a callsign to be looked up once QRZ can be reached again.
+ *
+ * A callsign with no row in the table gets a placeholder holding just the callsign, so a station heard while offline
+ * still shows up, and what JS8Call reports about it has somewhere to go. The deferred lookup fills it in.
+ *
+ * @param call The callsign.
+ */
+void AppController::deferLookup(const std::string &call)
+{
+	if (!m_deferredLookups)
+	{
+		return;
+	}
+
+	try
+	{
+		if (!m_deferredLookups->add(call))
 		{
-			if(!invalidCallsigns.contains(call))
+			return;
+		}
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << "Unable to defer lookup of " << call << ": " << e.what() << std::endl;
+		return;
+	}
+
+	std::string key = CallsignCanonicalizer::canonicalize(call);
+	if (!key.empty() && !tableModel->containsCallsign(resolveCallsign(key)))
+	{
+		Callsign placeholder;
+		placeholder.setCall(key);
+
+		m_placeholders.insert(key);
+		tableModel->addCallsigns({placeholder});
+	}
+
+	emit serviceStateChanged();
+}
+
+/**
+ * @brief Looks up the oldest deferred callsign, if QRZ can be reached and nothing else is waiting.
+ *
+ * Called at the configured rate, so a long queue built up during an outage does not burn through the quota, or knock
+ * QRZ straight back over, the moment it returns. The lookups run at background priority. Once the pause of the circuit
+ * breaker has run out, the first of them is the one that finds out whether QRZ is back.
+ *
+ * The callsign only leaves the queue once its record has been added, or QRZ has said it has none. Until then it goes
+ * to the back of the queue, so a lookup that is held back to save quota or fails again is tried later rather than lost.
+ */
+void AppController::drainDeferredLookup()
+{
+	if (!m_deferredLookups || m_deferredLookups->size() == 0 || isOffline() || !lookupsIdle())
+	{
+		return;
+	}
+
+	if (config->getUsername().empty() || config->getPassword().empty())
+	{
+		return;
+	}
+
+	std::optional<cache::DeferredLookupQueue::Entry> entry;
+
+	try
+	{
+		entry = m_deferredLookups->rotate();
+
+		// Nothing will ever come back for a callsign QRZ does not have
+		if (entry.has_value() && client.isKnownNotFound(entry->call))
+		{
+			m_deferredLookups->remove(entry->call);
+			emit serviceStateChanged();
+			return;
+		}
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << "Unable to read deferred lookup queue: " << e.what() << std::endl;
+		return;
+	}
+
+	if (!entry.has_value())
+	{
+		return;
+	}
+
+	auto addToTable = [this, call = entry->call](const Callsign &callsign) { addRecord(callsign, call); };
+
+	if (m_asyncClient)
+	{
+		startCallsignLookups({entry->call}, LookupPriority::BACKGROUND, addToTable);
+	}
+	else
+	{
+		queueCallsignLookups({entry->call}, LookupPriority::BACKGROUND, addToTable);
+	}
+}
+
+/**
+ * @brief Adds a fetched record to the table, filling in its placeholder row if it has one.
+ *
+ * A callsign that was waiting to be looked up again no longer needs to be. The record may be for another callsign than
+ * the one asked for, such as when a former or portable callsign was deferred, so the deferred lookup and placeholder
+ * are looked for under both.
+ *
+ * @param callsign The record.
+ * @param requested The callsign that was looked up, if known.
+ */
+void AppController::addRecord(const Callsign &callsign, const std::string &requested)
+{
+	std::string requestedKey = CallsignCanonicalizer::canonicalize(requested);
+	if (requestedKey == callsign.getCall())
+	{
+		requestedKey.clear();
+	}
+
+	if (m_deferredLookups)
+	{
+		try
+		{
+			bool removed = m_deferredLookups->remove(callsign.getCall());
+
+			if (!requestedKey.empty() && m_deferredLookups->remove(requestedKey))
 			{
-				errors.emplace_back(e.what());
-				invalidCallsigns.insert(call);
+				removed = true;
+			}
+
+			if (removed)
+			{
+				emit serviceStateChanged();
 			}
+		}
+		catch (std::exception &e)
+		{
+			std::cerr << "Unable to update deferred lookup queue: " << e.what() << std::endl;
+		}
+	}
+
+	bool ownPlaceholder = m_placeholders.erase(callsign.getCall()) > 0;
+
+	if (!requestedKey.empty() && m_placeholders.erase(requestedKey) > 0)
+	{
+		// Folding into the record's own row only updates it, otherwise the row reports the record added, which starts
+		// tracking its age
+		bool hadRow = tableModel->containsCallsign(callsign.getCall());
+
+		if (tableModel->replaceCallsign(requestedKey, callsign))
+		{
+			if (hadRow)
+			{
+				trackRecordAge(callsign);
+			}
+			return;
+		}
+	}
+
+	if (ownPlaceholder && tableModel->updateCallsign(callsign))
+	{
+		trackRecordAge(callsign);
+		return;
+	}
+
+	tableModel->addCallsigns({callsign});
+}
+
+/**
+ * @brief Whether the lookup thread and the coroutine client have nothing in flight or waiting.
+ */
+bool AppController::lookupsIdle()
+{
+	LookupSchedulerStats stats = m_lookupService->getQueueStats();
+
+	if (stats.queued[LookupPriority::INTERACTIVE] > 0 || stats.queued[LookupPriority::DETAIL] > 0 ||
+		stats.queued[LookupPriority::BACKGROUND] > 0 || !m_lookupCallbacks.empty())
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_cancelMutex);
+
+	return m_lookupCancels.empty();
+}
+
+/**
+ * @brief Starts tracking the age of a record added to the table.
+ *
+ * A record answered from the callsign cache may have been fetched long before it was added, so its age is taken from
+ * the cache where there is one.
+ *
+ * @param callsign The record.
+ */
+void AppController::trackRecordAge(const Callsign &callsign)
+{
+	// A placeholder has no record to age yet, it is tracked once its deferred lookup fills it in
+	if (m_placeholders.contains(callsign.getCall()))
+	{
+		return;
+	}
+
+	StaleRecordRefresher::Clock::time_point fetchedAt = StaleRecordRefresher::Clock::now();
+
+	std::shared_ptr<cache::CallsignCache> callsignCache = client.getCallsignCache();
+	if (callsignCache)
+	{
+		try
+		{
+			std::optional<cache::CallsignCacheEntry> entry = callsignCache->getEntry(callsign.getCall());
+			if (entry.has_value())
+			{
+				fetchedAt = entry->storedAt;
+			}
+		}
+		catch (std::exception &e)
+		{
+			std::cerr << "Callsign cache error: " << e.what() << std::endl;
+		}
+	}
+
+	m_staleRefresher.track(callsign.getCall(), fetchedAt);
+}
+
+/**
+ * @brief Drops the callsigns that are aliases of a record already in the table or already in the batch.
+ *
+ * Only aliases QRZ has told us about are recognised, so the first lookup of a portable callsign still goes out, and
+ * the row it produces is the one later lookups of the callsign resolve to.
+ *
+ * @param terms The callsigns, which keep their order.
+ */
+void AppController::collapseAliases(std::vector<std::string> &terms)
+{
+	std::set<std::string> batch;
+
+	std::erase_if(terms, [this, &batch](const std::string &term)
+	{
+		std::string call = resolveCallsign(term);
+
+		if (!batch.insert(call).second)
+		{
+			return true;
+		}
+
+		return call != CallsignCanonicalizer::canonicalize(term) && tableModel->containsCallsign(call);
+	});
+}
+
+/**
+ * @brief Turns the search terms into the keys the callsigns are looked up under, dropping anything that cannot be a
+ *        callsign.
+ *
+ * Portable callsigns are looked up by the callsign of the station, so VE3/K4RWR and K4RWR/P share one lookup. The
+ * terms that were dropped are reported for lookups the user asked for; callsigns heard on the air are dropped quietly.
+ *
+ * @param searchTerms The search terms.
+ * @param priority The priority of the lookups.
+ * @return The callsigns worth looking up.
+ */
+std::set<std::string> AppController::canonicalizeCallsigns(const std::set<std::string> &searchTerms,
+														   LookupPriority priority)
+{
+	std::set<std::string> calls;
+	std::string rejected;
 
-			it++;
+	for (const std::string &term : searchTerms)
+	{
+		std::string call = CallsignCanonicalizer::canonicalize(term);
+
+		if (!call.empty())
+		{
+			calls.insert(call);
 		}
-		catch (std::exception &e)
+		else
 		{
-			// Save the error for display after we have mde all of our API calls
-			errors.emplace_back(e.what());
-
-			it++;
+			rejected += rejected.empty() ? term : ", " + term;
 		}
 	}
 
-	// Display the errors, if any
-	if(!errors.empty())
+	if (!rejected.empty() && priority == LookupPriority::INTERACTIVE)
+	{
+		emit displayError(std::format("Not a valid callsign: {:s}", rejected));
+	}
+
+	return calls;
+}
+
+/**
+ * @brief Drops the callsigns QRZ has recently said it has no record for.
+ *
+ * @param searchTerms The callsigns.
+ * @return The callsigns worth looking up, in order.
+ */
+std::vector<std::string> AppController::filterKnownNotFound(const std::set<std::string> &searchTerms)
+{
+	std::vector<std::string> terms;
+	for (const std::string &call : searchTerms)
 	{
-		std::ostringstream msg;
-		for(const std::string& error : errors)
+		if (!client.isKnownNotFound(call))
 		{
-			msg << error << "\n\n";
+			terms.push_back(call);
 		}
-
-		emit displayError(msg.str());
 	}
 
-	return callsigns;
+	return terms;
+}
+
+/**
+ * @brief Reads the account to log in with from the configuration, to hand to the lookup thread.
+ *
+ * @return The credentials.
+ */
+LookupCredentials AppController::readCredentials() const
+{
+	return {config->getUsername(), config->getPassword()};
 }
 
 /**
@@ -442,6 +1589,377 @@ std::vector<std::string> AppController::fetchBios(const std::set<std::string> &s
 	return bios;
 }
 
+/**
+ * @brief Fetches DXCC records with the coroutine client, without blocking the GUI thread.
+ *
+ * A lookup rejected because the session expired logs in again and is retried, up to the same number of times as a
+ * lookup on the blocking client. Errors are collected and written to the console once every term has been tried.
+ *
+ * @param searchTerms The set of search terms used to fetch the DXCC records.
+ * @return A task resulting in the DXCC records that were found.
+ */
+net::Task<std::vector<DXCC>> AppController::fetchDXCCRecordsAsync(std::set<std::string> searchTerms)
+{
+	// Held for the whole fetch, the client may be switched off while the fetch is waiting
+	std::shared_ptr<AsyncQRZClient> asyncClient = m_asyncClient;
+
+	std::vector<DXCC> dxccs;
+	std::vector<std::string> errors;
+
+	for (const std::string &term : searchTerms)
+	{
+		for (int failures = 0;; failures++)
+		{
+			try
+			{
+				dxccs.push_back(co_await asyncClient->fetchDXCC(term));
+				break;
+			}
+			catch (AuthenticationException &e)
+			{
+				if (failures >= m_maxFailedCallCount)
+				{
+					errors.push_back(std::format("QRZ API Error: {:s}", e.what()));
+					break;
+				}
+			}
+			catch (std::exception &e)
+			{
+				errors.emplace_back(e.what());
+				break;
+			}
+
+			// The session was rejected, log in again before retrying
+			co_await refreshTokenAsync(*asyncClient);
+		}
+	}
+
+	for (const std::string &error : errors)
+	{
+		std::cerr << error << std::endl;
+	}
+
+	co_return dxccs;
+}
+
+/**
+ * @brief Fetches bios with the coroutine client, without blocking the GUI thread.
+ *
+ * A download rejected because the session expired logs in again and is retried, up to the same number of times as a
+ * download on the blocking client. Errors are collected and written to the console once every bio has been tried.
+ *
+ * @param searchTerms The set of callsigns whose bios are fetched.
+ * @return A task resulting in the bios that were found.
+ */
+net::Task<std::vector<std::string>> AppController::fetchBiosAsync(std::set<std::string> searchTerms)
+{
+	// Held for the whole fetch, the client may be switched off while the fetch is waiting
+	std::shared_ptr<AsyncQRZClient> asyncClient = m_asyncClient;
+
+	std::vector<std::string> bios;
+	std::vector<std::string> errors;
+
+	for (const std::string &call : searchTerms)
+	{
+		for (int failures = 0;; failures++)
+		{
+			try
+			{
+				bios.push_back(co_await asyncClient->fetchBio(call));
+				break;
+			}
+			catch (AuthenticationException &e)
+			{
+				if (failures >= m_maxFailedCallCount)
+				{
+					errors.push_back(std::format("QRZ API Error: {:s}", e.what()));
+					break;
+				}
+			}
+			catch (std::exception &e)
+			{
+				errors.emplace_back(e.what());
+				break;
+			}
+
+			// The session was rejected, log in again before retrying
+			co_await refreshTokenAsync(*asyncClient);
+		}
+	}
+
+	for (const std::string &error : errors)
+	{
+		std::cerr << error << std::endl;
+	}
+
+	co_return bios;
+}
+
+/**
+ * @brief Fetches a callsign record, registering it so it can be aborted with cancelLookup().
+ *
+ * The lookup goes through the provider chain, so a fallback endpoint, if one is configured, answers when QRZ cannot.
+ *
+ * @param call The callsign.
+ * @param priority The priority of the lookup.
+ * @return The callsign record.
+ *
+ * @throws CancelledException If the lookup was cancelled.
+ */
+Callsign AppController::fetchCancellableCallsign(const std::string &call, LookupPriority priority)
+{
+	std::string key = CallsignCanonicalizer::canonicalize(call);
+	std::shared_ptr<net::CancellationToken> cancel = registerLookup(key);
+
+	try
+	{
+		Callsign callsign = m_resolver.fetchCallsign(call, priority, cancel);
+		unregisterLookup(key, cancel);
+
+		return callsign;
+	}
+	catch (...)
+	{
+		unregisterLookup(key, cancel);
+		throw;
+	}
+}
+
+/**
+ * @brief Starts a lookup on the coroutine client for each callsign, adding each record to the table as it arrives.
+ *
+ * The lookups finish independently of each other, on the GUI thread. Background lookups held back to save quota and
+ * cancelled lookups are only logged. A refusal because QRZ is unreachable is shown once per call of this function,
+ * and only for interactive lookups. Progress is reported as the lookups finish, the same way as for a batch on the
+ * lookup thread.
+ *
+ * @param terms The callsigns to look up.
+ * @param priority The priority of the lookups.
+ * @param callback Called with each record fetched. May be null.
+ */
+void AppController::startCallsignLookups(const std::vector<std::string> &terms, LookupPriority priority,
+										 QrzCallsignResponseCallback callback)
+{
+	struct Batch
+	{
+		int total = 0;
+		int done = 0;
+		int found = 0;
+		bool unavailableReported = false;
+	};
+
+	auto batch = std::make_shared<Batch>();
+	batch->total = static_cast<int>(terms.size());
+
+	auto finishOne = [this, batch]()
+	{
+		emit lookupProgress(++batch->done, batch->total);
+
+		if (batch->done == batch->total)
+		{
+			emit lookupsFinished(batch->found);
+		}
+	};
+
+	for (const std::string &call : terms)
+	{
+		fetchCallsignAsync(call, priority).start(
+				[this, call, callback, batch, finishOne](Callsign callsign)
+				{
+					if (callback)
+					{
+						callback(callsign);
+					}
+					else
+					{
+						addRecord(callsign, call);
+					}
+
+					updateConfigFromClientState();
+
+					batch->found++;
+					finishOne();
+				},
+				[this, call, priority, batch, finishOne](std::exception_ptr error)
+				{
+					try
+					{
+						std::rethrow_exception(error);
+					}
+					catch (AuthenticationException &e)
+					{
+						emit displayError(std::format("QRZ API Error: {:s}", e.what()));
+					}
+					catch (RateLimitException &e)
+					{
+						std::cerr << call << ": " << e.what() << std::endl;
+					}
+					catch (CancelledException &e)
+					{
+						std::cerr << call << ": " << e.what() << std::endl;
+					}
+					catch (CircuitOpenException &e)
+					{
+						deferLookup(call);
+
+						if (priority == LookupPriority::BACKGROUND)
+						{
+							std::cerr << call << ": " << e.what() << std::endl;
+						}
+						else if (!batch->unavailableReported)
+						{
+							batch->unavailableReported = true;
+							emit displayError(e.what());
+						}
+					}
+					catch (std::exception &e)
+					{
+						emit displayError(e.what());
+					}
+
+					finishOne();
+				});
+	}
+}
+
+/**
+ * @brief Fetches a callsign record with the coroutine client, registering it so it can be aborted with cancelLookup().
+ *
+ * A lookup rejected because the session expired logs in again and is retried, up to the same number of times as a
+ * lookup on the blocking client. If no credentials are stored, credentialsNeeded is emitted instead.
+ *
+ * @param call The callsign.
+ * @param priority The priority of the lookup.
+ * @return A task resulting in the callsign record.
+ */
+net::Task<Callsign> AppController::fetchCallsignAsync(std::string call, LookupPriority priority)
+{
+	std::string key = CallsignCanonicalizer::canonicalize(call);
+	std::shared_ptr<net::CancellationToken> cancel = registerLookup(key);
+
+	// Held for the whole lookup, the client may be switched off while the lookup is waiting
+	std::shared_ptr<AsyncQRZClient> asyncClient = m_asyncClient;
+
+	Callsign callsign;
+	std::exception_ptr error;
+	bool credentialsMissing = false;
+
+	for (int failures = 0;; failures++)
+	{
+		try
+		{
+			callsign = co_await asyncClient->fetchCallsign(call, priority, cancel);
+			break;
+		}
+		catch (AuthenticationException &)
+		{
+			error = std::current_exception();
+			credentialsMissing = !client.hasCredentials();
+
+			if (failures >= m_maxFailedCallCount || credentialsMissing)
+			{
+				break;
+			}
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+			break;
+		}
+
+		// The session was rejected, log in again before retrying
+		try
+		{
+			co_await asyncClient->fetchToken();
+			error = nullptr;
+		}
+		catch (...)
+		{
+			error = std::current_exception();
+			break;
+		}
+	}
+
+	unregisterLookup(key, cancel);
+
+	if (credentialsMissing)
+	{
+		emit credentialsNeeded();
+	}
+
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+
+	co_return callsign;
+}
+
+/**
+ * @brief Registers a cancellation token for a callsign lookup, so cancelLookup() can reach it.
+ *
+ * @param key The normalized callsign.
+ * @return The token.
+ */
+std::shared_ptr<net::CancellationToken> AppController::registerLookup(const std::string &key)
+{
+	auto cancel = std::make_shared<net::CancellationToken>();
+
+	std::lock_guard<std::mutex> lock(m_cancelMutex);
+	m_lookupCancels[key] = cancel;
+
+	return cancel;
+}
+
+/**
+ * @brief Forgets the cancellation token of a finished callsign lookup, unless a newer lookup replaced it.
+ *
+ * @param key The normalized callsign.
+ * @param cancel The token registerLookup() returned.
+ */
+void AppController::unregisterLookup(const std::string &key, const std::shared_ptr<net::CancellationToken> &cancel)
+{
+	std::lock_guard<std::mutex> lock(m_cancelMutex);
+
+	auto it = m_lookupCancels.find(key);
+	if (it != m_lookupCancels.end() && it->second == cancel)
+	{
+		m_lookupCancels.erase(it);
+	}
+}
+
+/**
+ * @brief Cancels every callsign lookup, the bio fetch and the speculative lookup in flight.
+ *
+ * The tokens of the callsign lookups are forgotten as well. A lookup that finishes afterwards finds its token gone,
+ * which unregisterLookup() allows for.
+ */
+void AppController::cancelAllLookups()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_cancelMutex);
+
+		for (auto &[key, cancel] : m_lookupCancels)
+		{
+			cancel->cancel();
+		}
+
+		m_lookupCancels.clear();
+
+		if (m_bioCancel)
+		{
+			m_bioCancel->cancel();
+			m_bioCancel.reset();
+		}
+	}
+
+	if (m_speculativeCancel)
+	{
+		m_speculativeCancel->cancel();
+		m_speculativeCancel.reset();
+	}
+}
+
 /**
  * @brief Refreshes the access token by fetching a new token from the QRZ API
  *
@@ -450,9 +1968,68 @@ std::vector<std::string> AppController::fetchBios(const std::set<std::string> &s
  * The function then sets the username and password in the QRZ client, fetches a new token,
  * and updates the configuration with the new session information.
  *
+ * A login that fails because QRZ is unreachable is reported through the displayError signal.
+ *
  * @note This function assumes that the necessary APIs and client objects are properly initialized before calling this function.
  */
 bool AppController::refreshToken()
+{
+	if (!applyCredentials())
+	{
+		return false;
+	}
+
+	try
+	{
+		client.fetchToken();
+	}
+	catch (std::exception &e)
+	{
+		emit displayError(std::format("Unable to log in to QRZ: {:s}", e.what()));
+		return false;
+	}
+
+	onTokenRefreshed();
+
+	return true;
+}
+
+/**
+ * @brief Refreshes the access token with the coroutine client.
+ *
+ * Works like refreshToken(), but the GUI thread keeps running while the login is on the wire.
+ *
+ * @param asyncClient The coroutine client to log in with.
+ * @return A task resulting in true if a new token was fetched.
+ */
+net::Task<bool> AppController::refreshTokenAsync(AsyncQRZClient &asyncClient)
+{
+	if (!applyCredentials())
+	{
+		co_return false;
+	}
+
+	try
+	{
+		co_await asyncClient.fetchToken();
+	}
+	catch (std::exception &e)
+	{
+		emit displayError(std::format("Unable to log in to QRZ: {:s}", e.what()));
+		co_return false;
+	}
+
+	onTokenRefreshed();
+
+	co_return true;
+}
+
+/**
+ * @brief Hands the stored credentials to the client ahead of a login, asking for them if there are none.
+ *
+ * @return True if there are credentials to log in with.
+ */
+bool AppController::applyCredentials()
 {
 	std::string userCall = config->getUsername();
 	std::string password = config->getPassword();
@@ -466,11 +2043,65 @@ bool AppController::refreshToken()
 	client.setUsername(userCall);
 	client.setPassword(password);
 
-	client.fetchToken();
+	return true;
+}
 
+/**
+ * @brief Stores the session of a successful login and lets the token refresher know about it.
+ */
+void AppController::onTokenRefreshed()
+{
 	updateConfigFromClientState();
 
-	return true;
+	// The credentials may have changed, so let the refresher take another look
+	if (m_tokenRefresher)
+	{
+		m_tokenRefresher->wake();
+	}
+}
+
+/**
+ * @brief Starts renewing the session token in the background.
+ *
+ * The refresher runs on its own thread. Once it has renewed the token, the new session is written back to the
+ * configuration through a queued call, since the configuration belongs to the GUI thread.
+ */
+void AppController::startTokenRefresher()
+{
+	if (m_tokenRefresher)
+	{
+		return;
+	}
+
+	m_tokenRefresher = std::make_unique<net::TokenRefresher>(
+			[this]() { return client.getTokenTimeRemaining(); },
+			[this]()
+			{
+				if (!client.hasCredentials())
+				{
+					return false;
+				}
+
+				client.fetchToken();
+				return client.tokenIsValid();
+			},
+			std::chrono::minutes(config->getTokenRefreshLead()));
+
+	m_tokenRefresher->setCallback([this](bool refreshed)
+	{
+		if (!refreshed)
+		{
+			return;
+		}
+
+		QMetaObject::invokeMethod(this, [this]()
+		{
+			updateConfigFromClientState();
+			emit sessionRefreshed();
+		}, Qt::QueuedConnection);
+	});
+
+	m_tokenRefresher->start();
 }
 
 /**
@@ -1,16 +1,32 @@
 #ifndef QRZ_APPCONTROLLER_H
 #define QRZ_APPCONTROLLER_H
 
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
 #include <string>
 
 #include <QObject>
+#include <QThread>
+#include <QTimer>
 
 #include "AppCommand.h"
+#include "AsyncQRZClient.h"
 #include "Configuration.h"
+#include "LookupResolver.h"
+#include "LookupService.h"
 #include "QRZClient.h"
+#include "StaleRecordRefresher.h"
 #include "Util.h"
+#include "cache/DeferredLookupQueue.h"
 #include "model/Callsign.h"
 #include "model/DXCC.h"
+#include "model/QuotaStatus.h"
+#include "net/Task.h"
+#include "net/TokenRefresher.h"
 #include "tablemodel.h"
 
 namespace qrz
@@ -24,6 +40,11 @@ namespace qrz
 	public:
 		explicit AppController(Configuration *config, TableModel *tableModel);
 
+		/**
+		 * @brief Stops the background token refresher and the lookup thread before the client they use goes away.
+		 */
+		~AppController() override;
+
 		/**
 		 * @brief Initializes the application by setting up the necessary configurations and checking for authentication.
 		 *
@@ -34,6 +55,13 @@ namespace qrz
 		 */
 		void initialize();
 
+		/**
+		 * @brief Checks that an account is configured and brings the client up to date with the configuration.
+		 *
+		 * No request is made here. An expired session is renewed by whichever client makes the next lookup.
+		 *
+		 * @return False if there are no credentials, in which case credentialsNeeded has been emitted.
+		 */
 		bool preflight();
 
 		/**
@@ -42,18 +70,196 @@ namespace qrz
 		 * This function takes an AppCommand object and performs different operations based on the command's action type.
 		 * The action type determines the type of operation to be performed.
 		 *
+		 * Callsign lookups are only started here. The records are added to the table as they arrive, and
+		 * lookupsFinished is emitted once the batch is done.
+		 *
 		 * @param command The AppCommand object representing the command to be executed.
+		 * @return True if the command was accepted.
 		 */
 		bool handleCommand(const AppCommand &command);
 
-		std::string fetchBio(const std::string &call);
+		/**
+		 * @brief Starts fetching the bio for the detail view, emitting bioFetched once it is here.
+		 *
+		 * A bio fetch still in progress from an earlier call is cancelled first.
+		 *
+		 * @param call The callsign.
+		 */
+		void fetchBio(const std::string &call);
+
+		/**
+		 * @brief Opens a connection to QRZ ahead of a lookup the user has started typing.
+		 *
+		 * Calls within the keep-alive time of the previous one do nothing, so this may be called on every keystroke.
+		 */
+		void prewarmConnection();
+
+		/**
+		 * @brief Starts looking up the callsign being typed, before the user asks for it.
+		 *
+		 * A speculative lookup of a different callsign still in progress is cancelled. If the record is here by the
+		 * time the callsign is looked up, it goes straight into the table. An empty callsign only cancels.
+		 *
+		 * @param call The callsign being typed.
+		 */
+		void speculateCallsign(const std::string &call);
+
+		/**
+		 * @brief Returns the callsign of the record a callsign is known to resolve to.
+		 *
+		 * @param call The callsign, which may be a portable or former callsign, or another alias.
+		 * @return The callsign of the record, or the callsign itself, canonicalized.
+		 */
+		std::string resolveCallsign(const std::string &call) const;
+
+		/**
+		 * @brief Returns the lookup quota most recently reported by the QRZ API.
+		 *
+		 * @return The quota status.
+		 */
+		QuotaStatus getQuotaStatus() const;
+
+		/**
+		 * @brief Returns the number of callsign lookups saved by sharing a lookup already in flight.
+		 *
+		 * @return The number of requests saved.
+		 */
+		std::uint64_t getCoalescedLookupCount() const;
+
+		/**
+		 * @brief Returns the depths and wait times of the queue of lookups waiting for the lookup thread.
+		 *
+		 * @return The scheduler statistics.
+		 */
+		LookupSchedulerStats getLookupQueueStats() const;
+
+		/**
+		 * @brief Returns the counters and sizes of the bio cache.
+		 *
+		 * @return The bio cache statistics, all zero if bios are not cached.
+		 */
+		cache::BioCacheStats getBioCacheStats() const;
+
+		/**
+		 * @brief Returns the counters of the bytes received from each endpoint of the QRZ API.
+		 *
+		 * @return The counters, keyed by endpoint.
+		 */
+		std::map<std::string, net::TransferStats> getTransferStats() const;
+
+		/**
+		 * @brief Returns how each provider in the lookup chain has been answering, in chain order.
+		 *
+		 * @return The statistics of QRZ, and of the fallback endpoint if one is configured.
+		 */
+		std::vector<LookupProviderStats> getLookupProviderStats() const;
+
+		/**
+		 * @brief Returns the state of the circuit breaker guarding requests to QRZ.
+		 *
+		 * @return The circuit breaker statistics.
+		 */
+		net::CircuitBreakerStats getCircuitBreakerStats();
+
+		/**
+		 * @brief Chooses between the blocking client and the coroutine client for lookups.
+		 *
+		 * With the coroutine client, callsign lookups run on the event loop and each record is added to the table as
+		 * soon as it arrives, rather than the caller blocking until the whole batch has been fetched. Both clients
+		 * share one session, quota and set of caches, so switching keeps everything fetched so far.
+		 *
+		 * @param enabled True to use the coroutine client, false for the blocking client.
+		 */
+		void useAsyncClient(bool enabled);
+
+		/**
+		 * @brief Whether lookups go through the coroutine client.
+		 *
+		 * @return True if the coroutine client is in use.
+		 */
+		bool isUsingAsyncClient() const;
+
+		/**
+		 * @brief Turns offline mode on or off by hand, and remembers the choice in the configuration.
+		 *
+		 * While offline, lookups are answered from local data only, and callsigns that would need a request are
+		 * deferred until QRZ can be reached again.
+		 *
+		 * @param enabled True to stay offline.
+		 */
+		void setOfflineMode(bool enabled);
+
+		/**
+		 * @brief Whether offline mode was turned on by hand.
+		 *
+		 * @return True if offline mode is on.
+		 */
+		bool isOfflineMode() const;
+
+		/**
+		 * @brief Whether lookups are answered from local data only, either by hand or because QRZ is unreachable.
+		 *
+		 * @return True if no request would be made for a lookup right now.
+		 */
+		bool isOffline();
+
+		/**
+		 * @brief Returns the number of callsigns waiting to be looked up once QRZ can be reached again.
+		 *
+		 * @return The number of deferred lookups.
+		 */
+		std::size_t getDeferredLookupCount() const;
 
 	public slots:
 		void fetchCallsign(const std::string &call, QrzCallsignResponseCallback callback);
+
+		/**
+		 * @brief Fetches the records of stations heard on the air into the caches, ahead of anyone asking for them.
+		 *
+		 * @param calls The callsigns heard, most recently heard first.
+		 */
+		void prefetchCallsigns(const std::vector<std::string> &calls);
+
+		/**
+		 * @brief Aborts the lookup of a callsign if it is in flight.
+		 *
+		 * @param call The callsign.
+		 */
+		void cancelLookup(const std::string &call);
+
+		/**
+		 * @brief Aborts the bio fetch for the detail view if it is in flight.
+		 */
+		void cancelBioFetch();
 	signals:
 		void credentialsNeeded();
 		void displayError(const std::string &msg);
 
+		/**
+		 * @brief Emitted on the GUI thread after the session token was renewed in the background.
+		 */
+		void sessionRefreshed();
+
+		/**
+		 * @brief Emitted on the GUI thread when QRZ stops or starts responding.
+		 */
+		void serviceStateChanged();
+
+		/**
+		 * @brief Emitted on the GUI thread as the lookups of a batch finish.
+		 */
+		void lookupProgress(int done, int total);
+
+		/**
+		 * @brief Emitted on the GUI thread once a batch of lookups is done and its records are in the table.
+		 */
+		void lookupsFinished(int found);
+
+		/**
+		 * @brief Emitted on the GUI thread with the bio requested by fetchBio().
+		 */
+		void bioFetched(const std::string &call, const std::string &html);
+
 	protected:
 		// The application configuration instance
 		Configuration *config;
@@ -61,6 +267,16 @@ namespace qrz
 		// QRZ API client instance
 		QRZClient client;
 
+		// Second QRZ compatible endpoint lookups fall back to, in the chain only if one is configured
+		QRZClient m_fallbackClient;
+
+		// Asks the local caches, then QRZ, then the fallback, racing the two if a hedge delay is configured
+		LookupResolver m_resolver;
+
+		// Runs lookups as coroutines on the event loop when enabled, sharing the session and caches of client. Lookups
+		// started on it hold a reference too, so switching it off does not pull it from under them.
+		std::shared_ptr<AsyncQRZClient> m_asyncClient;
+
 		// Counter for failed API calls
 		int m_failedCallCount = 0;
 
@@ -70,6 +286,73 @@ namespace qrz
 		// Flag to determine whether or not to display the progress bar
 		bool displayProgress = false;
 
+		// Renews the session token before it expires, so lookups never wait on a login
+		std::unique_ptr<net::TokenRefresher> m_tokenRefresher;
+
+		// Guards the cancellation tokens, which are registered by lookup threads and cancelled from the GUI
+		std::mutex m_cancelMutex;
+
+		// Cancellation tokens of the callsign lookups in flight, keyed by normalized callsign
+		std::map<std::string, std::shared_ptr<net::CancellationToken>> m_lookupCancels;
+
+		// Cancellation token of the bio fetch for the detail view
+		std::shared_ptr<net::CancellationToken> m_bioCancel;
+
+		// Runs the lookup service, so the GUI thread never waits on QRZ
+		QThread m_lookupThread;
+
+		// Makes the lookups of the blocking client on the lookup thread
+		std::unique_ptr<LookupService> m_lookupService;
+
+		// Identifies the next batch handed to the lookup service
+		quint64 m_nextRequestId = 1;
+
+		// Callbacks waiting for the records of a batch, in place of the table
+		std::map<quint64, QrzCallsignResponseCallback> m_lookupCallbacks;
+
+		// Picks the records in the table that are due to be checked against QRZ again
+		StaleRecordRefresher m_staleRefresher;
+
+		// Checks for a stale record to refresh while the lookup thread is idle
+		QTimer m_staleRefreshTimer;
+
+		// Callsigns already handed over for prefetching this session
+		std::set<std::string> m_prefetched;
+
+		// When a connection was last opened ahead of a lookup
+		std::chrono::steady_clock::time_point m_lastPrewarm;
+
+		// Time within which another prewarm would find the previous connection still open
+		static inline const std::chrono::seconds m_prewarmInterval = std::chrono::seconds(20);
+
+		// The normalized callsign being looked up speculatively, its record once it is here, and its cancellation token
+		std::string m_speculativeCall;
+		std::optional<Callsign> m_speculativeRecord;
+		std::shared_ptr<net::CancellationToken> m_speculativeCancel;
+
+
+		// Offline mode, as turned on by hand
+		bool m_offlineMode = false;
+
+		// Callsigns missed while offline, looked up once QRZ can be reached again. Null if it could not be opened
+		std::unique_ptr<cache::DeferredLookupQueue> m_deferredLookups;
+
+		// Hands the next deferred lookup to the lookup thread, at the configured rate
+		QTimer m_deferredDrainTimer;
+
+		// Callsigns whose rows only hold the callsign, waiting for their deferred lookup
+		std::set<std::string> m_placeholders;
+
+		/**
+		 * @brief Adds the fallback endpoint to the lookup chain behind QRZ, if one is configured, and sets the hedge
+		 *        delay.
+		 */
+		void configureLookupChain();
+
+		/**
+		 * @brief Records QRZ responses to an archive, or replays them from one, if the configuration asks for it.
+		 */
+		void openTrafficArchive();
 
 		/**
 		 * @brief Fetches and renders callsigns based on the given search terms and output format.
@@ -77,10 +360,10 @@ namespace qrz
 		 * This function fetches the specified callsign records and renders them into the specified output format.
 		 *
 		 * @param searchTerms The set of search terms used to fetch the callsign records.
-		 * @param format The output format in which the callsigns should be rendered.
+		 * @param priority The priority of the lookups.
 		 * @return bool If an error was encountered, returns false
 		 */
-		bool fetchAndRenderCallsigns(const std::set<std::string> &searchTerms);
+		bool fetchAndRenderCallsigns(const std::set<std::string> &searchTerms, LookupPriority priority = LookupPriority::INTERACTIVE);
 
 		/**
 		 * @brief Fetches and renders bios based on the given search terms.
@@ -106,15 +389,200 @@ namespace qrz
 		/**
 		 * @brief Fetches the callsign records based on the given search terms.
 		 *
-		 * This function fetches the callsign records based on the provided search terms.
-		 * It also displays a progress bar to show the progress of fetching the callsigns.
+		 * This function fetches the callsign records based on the provided search terms, running up to the configured
+		 * number of lookups at the same time. The records are returned in the same order as the search terms.
 		 *
 		 * @param searchTerms The set of search terms used to fetch the callsign records.
+		 * @param priority The priority of the lookups.
 		 * @return A vector of Callsign objects representing the fetched callsign records.
 		 *
 		 * @note This function assumes that the necessary APIs and client objects are properly initialized before calling this function.
 		 */
-		std::vector<Callsign> fetchCallsignRecords(const std::set<std::string> &searchTerms);
+		std::vector<Callsign> fetchCallsignRecords(const std::set<std::string> &searchTerms, LookupPriority priority = LookupPriority::INTERACTIVE);
+
+		/**
+		 * @brief Hands a batch of callsign lookups to the lookup thread.
+		 *
+		 * Each record is added to the table as it arrives, or passed to the callback instead if one is given.
+		 *
+		 * @param terms The callsigns to look up.
+		 * @param priority The priority of the lookups.
+		 * @param callback Called on the GUI thread with each record fetched. May be null.
+		 */
+		void queueCallsignLookups(const std::vector<std::string> &terms, LookupPriority priority,
+								  QrzCallsignResponseCallback callback = nullptr);
+
+		/**
+		 * @brief Takes a record fetched on the lookup thread.
+		 *
+		 * @param requestId The batch the record belongs to.
+		 * @param callsign The record.
+		 */
+		void onCallsignFound(quint64 requestId, const Callsign &callsign);
+
+		/**
+		 * @brief Finishes a batch of lookups made on the lookup thread.
+		 *
+		 * @param requestId The batch.
+		 * @param found The number of records fetched.
+		 */
+		void onLookupsFinished(quint64 requestId, int found);
+
+		/**
+		 * @brief Hands the stalest record in the table to the lookup thread to be checked, if nothing else is waiting.
+		 */
+		void refreshStaleRecord();
+
+		/**
+		 * @brief Takes a record checked against QRZ, updating its row if QRZ has changed it.
+		 *
+		 * @param callsign The current record.
+		 */
+		void onCallsignRefreshed(const Callsign &callsign);
+
+		/**
+		 * @brief Keeps the record of a speculative lookup, if the user is still typing that callsign.
+		 *
+		 * @param call The normalized callsign the lookup was made for.
+		 * @param callsign The record.
+		 */
+		void onSpeculativeFetched(const std::string &call, const Callsign &callsign);
+
+		/**
+		 * @brief Hands a batch the speculative lookup made for one of its callsigns.
+		 *
+		 * A record that is already here is added to the table and its callsign taken out of the batch. A lookup still
+		 * in progress is left to finish, since the lookup of the batch shares it.
+		 *
+		 * @param terms The callsigns of the batch.
+		 * @return True if a record was added to the table.
+		 */
+		bool takeSpeculativeRecord(std::vector<std::string> &terms);
+
+		/**
+		 * @brief Answers a batch from local data only, deferring the callsigns that would need a request.
+		 *
+		 * @param terms The callsigns of the batch.
+		 * @return The number of records found locally.
+		 */
+		int answerOffline(const std::vector<std::string> &terms);
+
+		/**
+		 * @brief Queues a callsign to be looked up once QRZ can be reached again.
+		 *
+		 * @param call The callsign.
+		 */
+		void deferLookup(const std::string &call);
+
+		/**
+		 * @brief Looks up the oldest deferred callsign, if QRZ can be reached and nothing else is waiting.
+		 */
+		void drainDeferredLookup();
+
+		/**
+		 * @brief Adds a fetched record to the table, filling in its placeholder row if it has one.
+		 *
+		 * @param callsign The record.
+		 * @param requested The callsign that was looked up, if known.
+		 */
+		void addRecord(const Callsign &callsign, const std::string &requested = "");
+
+		/**
+		 * @brief Whether the lookup thread and the coroutine client have nothing in flight or waiting.
+		 */
+		bool lookupsIdle();
+
+		/**
+		 * @brief Starts tracking the age of a record added to the table.
+		 *
+		 * @param callsign The record.
+		 */
+		void trackRecordAge(const Callsign &callsign);
+
+		/**
+		 * @brief Drops the callsigns that are aliases of a record already in the table or already in the batch.
+		 *
+		 * @param terms The callsigns, which keep their order.
+		 */
+		void collapseAliases(std::vector<std::string> &terms);
+
+		/**
+		 * @brief Turns the search terms into the keys the callsigns are looked up under, dropping anything that
+		 *        cannot be a callsign.
+		 *
+		 * @param searchTerms The search terms.
+		 * @param priority The priority of the lookups.
+		 * @return The callsigns worth looking up.
+		 */
+		std::set<std::string> canonicalizeCallsigns(const std::set<std::string> &searchTerms, LookupPriority priority);
+
+		/**
+		 * @brief Drops the callsigns QRZ has recently said it has no record for.
+		 *
+		 * @param searchTerms The callsigns.
+		 * @return The callsigns worth looking up, in order.
+		 */
+		std::vector<std::string> filterKnownNotFound(const std::set<std::string> &searchTerms);
+
+		/**
+		 * @brief Reads the account to log in with from the configuration, to hand to the lookup thread.
+		 *
+		 * @return The credentials.
+		 */
+		LookupCredentials readCredentials() const;
+
+		/**
+		 * @brief Fetches a callsign record, registering it so it can be aborted with cancelLookup().
+		 *
+		 * @param call The callsign.
+		 * @param priority The priority of the lookup.
+		 * @return The callsign record.
+		 */
+		Callsign fetchCancellableCallsign(const std::string &call, LookupPriority priority);
+
+		/**
+		 * @brief Starts a lookup on the coroutine client for each callsign, adding each record to the table as it arrives.
+		 *
+		 * Errors are reported the same way fetchCallsignRecords() reports them.
+		 *
+		 * @param terms The callsigns to look up.
+		 * @param priority The priority of the lookups.
+		 * @param callback Called with each record fetched. May be null.
+		 */
+		void startCallsignLookups(const std::vector<std::string> &terms, LookupPriority priority,
+								  QrzCallsignResponseCallback callback = nullptr);
+
+		/**
+		 * @brief Fetches a callsign record with the coroutine client, registering it so it can be aborted with cancelLookup().
+		 *
+		 * A lookup rejected because the session expired logs in again and is retried.
+		 *
+		 * @param call The callsign.
+		 * @param priority The priority of the lookup.
+		 * @return A task resulting in the callsign record.
+		 */
+		net::Task<Callsign> fetchCallsignAsync(std::string call, LookupPriority priority);
+
+		/**
+		 * @brief Registers a cancellation token for a callsign lookup, so cancelLookup() can reach it.
+		 *
+		 * @param key The normalized callsign.
+		 * @return The token.
+		 */
+		std::shared_ptr<net::CancellationToken> registerLookup(const std::string &key);
+
+		/**
+		 * @brief Forgets the cancellation token of a finished callsign lookup, unless a newer lookup replaced it.
+		 *
+		 * @param key The normalized callsign.
+		 * @param cancel The token registerLookup() returned.
+		 */
+		void unregisterLookup(const std::string &key, const std::shared_ptr<net::CancellationToken> &cancel);
+
+		/**
+		 * @brief Cancels every callsign lookup, the bio fetch and the speculative lookup in flight.
+		 */
+		void cancelAllLookups();
 
 		/**
 		 * @brief Fetches DXCC records based on the given search terms.
@@ -140,6 +608,22 @@ namespace qrz
 		 */
 		std::vector<std::string> fetchBios(const std::set<std::string> &searchTerms);
 
+		/**
+		 * @brief Fetches DXCC records with the coroutine client, without blocking the GUI thread.
+		 *
+		 * @param searchTerms The set of search terms used to fetch the DXCC records.
+		 * @return A task resulting in the DXCC records that were found.
+		 */
+		net::Task<std::vector<DXCC>> fetchDXCCRecordsAsync(std::set<std::string> searchTerms);
+
+		/**
+		 * @brief Fetches bios with the coroutine client, without blocking the GUI thread.
+		 *
+		 * @param searchTerms The set of callsigns whose bios are fetched.
+		 * @return A task resulting in the bios that were found.
+		 */
+		net::Task<std::vector<std::string>> fetchBiosAsync(std::set<std::string> searchTerms);
+
 		/**
 		 * @brief Refreshes the access token by fetching a new token from the QRZ API
 		 *
@@ -149,6 +633,33 @@ namespace qrz
 		 */
 		bool refreshToken();
 
+		/**
+		 * @brief Refreshes the access token with the coroutine client.
+		 *
+		 * @param asyncClient The coroutine client to log in with.
+		 * @return A task resulting in true if a new token was fetched.
+		 */
+		net::Task<bool> refreshTokenAsync(AsyncQRZClient &asyncClient);
+
+		/**
+		 * @brief Hands the stored credentials to the client ahead of a login, asking for them if there are none.
+		 *
+		 * @return True if there are credentials to log in with.
+		 */
+		bool applyCredentials();
+
+		/**
+		 * @brief Stores the session of a successful login and lets the token refresher know about it.
+		 */
+		void onTokenRefreshed();
+
+		/**
+		 * @brief Starts renewing the session token in the background.
+		 *
+		 * The renewed token is written back to the configuration on the GUI thread.
+		 */
+		void startTokenRefresher();
+
 		/**
 		 * @brief Retrieves the user's callsign from the user.
 		 *
@@ -202,7 +713,6 @@ namespace qrz
 		static void eraseLine();
 
 	private:
-		std::set<std::string> invalidCallsigns;
 		TableModel *tableModel;
 	};
 }
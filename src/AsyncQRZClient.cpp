@@ -0,0 +1,775 @@
+#include "AsyncQRZClient.h"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTimer>
+#include <QUrl>
+
+#include <Poco/InflatingStream.h>
+#include <Poco/StreamCopier.h>
+
+#include "exception/CancelledException.h"
+#include "exception/CircuitOpenException.h"
+#include "exception/NotFoundException.h"
+#include "exception/RateLimitException.h"
+#include "exception/TimeoutException.h"
+#include "exception/TransportException.h"
+#include "model/QrzXmlDecoder.h"
+
+using namespace qrz;
+
+namespace
+{
+	/**
+	 * @brief Suspends the awaiting coroutine until a network reply has finished.
+	 */
+	struct ReplyFinished
+	{
+		QNetworkReply *reply;
+
+		bool await_ready() const noexcept
+		{
+			return reply->isFinished();
+		}
+
+		void await_suspend(std::coroutine_handle<> handle) const
+		{
+			QObject::connect(reply, &QNetworkReply::finished, reply, [handle]() { handle.resume(); },
+							 Qt::SingleShotConnection);
+		}
+
+		void await_resume() const noexcept
+		{}
+	};
+
+	/**
+	 * @brief Suspends the awaiting coroutine until a timer fires.
+	 */
+	struct TimerElapsed
+	{
+		QObject *context;
+		std::chrono::milliseconds delay;
+
+		bool await_ready() const noexcept
+		{
+			return false;
+		}
+
+		void await_suspend(std::coroutine_handle<> handle) const
+		{
+			QTimer::singleShot(delay, context, [handle]() { handle.resume(); });
+		}
+
+		void await_resume() const noexcept
+		{}
+	};
+
+	/**
+	 * @brief Suspends the awaiting coroutine until the request it joined has finished, or until it is cancelled.
+	 *
+	 * The token may be cancelled on any thread, so the coroutine is resumed from the event loop of the context object,
+	 * like it would be when the request lands.
+	 */
+	template<typename Flight>
+	struct FlightLanded
+	{
+		Flight &flight;
+		QObject *context;
+		std::shared_ptr<net::CancellationToken> cancel;
+		net::CancellationToken::Registration registration;
+
+		bool await_ready() const noexcept
+		{
+			return cancel && cancel->isCancelled();
+		}
+
+		void await_suspend(std::coroutine_handle<> handle)
+		{
+			auto waiter = std::make_shared<typename Flight::Waiter>(handle);
+			flight.waiters.push_back(waiter);
+
+			if (cancel)
+			{
+				registration = cancel->subscribe([context = context, waiter]()
+				{
+					QMetaObject::invokeMethod(context, [waiter]() { waiter->resume(); }, Qt::QueuedConnection);
+				});
+			}
+		}
+
+		void await_resume() const noexcept
+		{}
+	};
+
+	/**
+	 * @brief Whether a request failed only because its own caller cancelled it.
+	 */
+	bool wasCancelled(std::exception_ptr error)
+	{
+		try
+		{
+			std::rethrow_exception(error);
+		}
+		catch (CancelledException &)
+		{
+			return true;
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+
+	/**
+	 * @brief Deletes a reply once control is back in the event loop, since it may still be emitting a signal.
+	 */
+	struct ReplyDeleter
+	{
+		void operator()(QNetworkReply *reply) const
+		{
+			reply->deleteLater();
+		}
+	};
+}
+
+AsyncQRZClient::AsyncQRZClient(QRZClient &client) : m_client(client)
+{
+}
+
+/**
+ * @brief Returns the client whose settings and session state are shared.
+ *
+ * @return A reference to the client.
+ */
+QRZClient &AsyncQRZClient::getClient()
+{
+	return m_client;
+}
+
+/**
+ * @brief Fetches a Callsign object for a given callsign string.
+ *
+ * Recently fetched records are answered from memory, and callsigns QRZ recently reported as not found fail straight
+ * away. Otherwise a fresh record in the callsign cache, if one is set, is returned without going to the network. A
+ * portable callsign is looked up by the callsign of the station, and input that cannot be a callsign fails without a
+ * request being made.
+ *
+ * If a lookup for the same callsign is already in flight, the task waits for it and looks in the caches again, where
+ * that lookup left its record. Should that lookup have failed, the task fails with the same error rather than sending
+ * the request again, unless the lookup was only cancelled by its own caller. Cancelling the task stops the wait.
+ *
+ * @param call The callsign to fetch information for.
+ * @param priority How urgently the record is needed.
+ * @param cancel Cancels the lookup. May be null.
+ * @return A task resulting in the Callsign object containing the fetched callsign information.
+ */
+net::Task<Callsign> AsyncQRZClient::fetchCallsign(std::string call, LookupPriority priority,
+												  std::shared_ptr<net::CancellationToken> cancel)
+{
+	std::string key = QRZClient::canonicalKey(call);
+
+	while (true)
+	{
+		std::optional<Callsign> remembered = m_client.findRememberedRecord(key);
+		if (remembered.has_value())
+		{
+			co_return remembered.value();
+		}
+
+		std::optional<std::string> notFound = m_client.m_notFoundCache->get(key);
+		if (notFound.has_value())
+		{
+			throw NotFoundException{notFound.value()};
+		}
+
+		std::optional<Callsign> cached = m_client.findCachedRecord(key);
+		if (cached.has_value())
+		{
+			co_return cached.value();
+		}
+
+		auto it = m_flights.find(key);
+		if (it == m_flights.end())
+		{
+			break;
+		}
+
+		std::shared_ptr<Flight> flight = it->second;
+
+		m_coalesced++;
+		co_await join(flight, cancel);
+
+		if (cancel)
+		{
+			cancel->throwIfCancelled();
+		}
+
+		if (flight->error && !wasCancelled(flight->error))
+		{
+			std::rethrow_exception(flight->error);
+		}
+	}
+
+	m_flights.emplace(key, std::make_shared<Flight>());
+
+	Callsign callsign;
+	std::exception_ptr error;
+
+	try
+	{
+		callsign = co_await lookupCallsign(key, priority, cancel);
+	}
+	catch (NotFoundException &e)
+	{
+		m_client.m_notFoundCache->put(key, e.what());
+		error = std::current_exception();
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+
+	land(key, error);
+
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+
+	co_return callsign;
+}
+
+/**
+ * @brief Fetches the biography information for a given callsign.
+ *
+ * If a bio cache is set, a bio cached for the same biodate is returned without going to the network. When no biodate
+ * is given it is taken from the cached callsign record, if there is one.
+ *
+ * @param call The callsign for which to fetch the biography information.
+ * @param biodate The biodate of the callsign record.
+ * @param cancel Cancels the download. May be null.
+ * @return A task resulting in the bio HTML.
+ *
+ * @throws TransportException If QRZ could not be reached or answered with an HTTP error.
+ */
+net::Task<std::string> AsyncQRZClient::fetchBio(std::string call, std::string biodate,
+												std::shared_ptr<net::CancellationToken> cancel)
+{
+	std::shared_ptr<cache::BioCache> bioCache = m_client.getBioCache();
+
+	if (bioCache && biodate.empty())
+	{
+		biodate = m_client.findBiodate(call);
+	}
+
+	if (bioCache && !biodate.empty())
+	{
+		std::optional<std::string> cached = bioCache->get(call, biodate);
+		if (cached.has_value())
+		{
+			co_return cached.value();
+		}
+	}
+
+	if (!m_client.tokenIsValid())
+	{
+		co_await fetchToken();
+	}
+
+	std::string output;
+
+	try
+	{
+		Poco::URI uri(m_client.getBaseUrl());
+
+		uri.addQueryParameter("html", call);
+		uri.addQueryParameter("s", m_client.getSessionKey());
+
+		QrzResponse response = co_await sendRequest(uri, cancel);
+		const Poco::Net::HTTPResponse &httpResponse = response.getHttpResponse();
+
+		QRZClient::throwIfFailed(httpResponse);
+
+		output = response.getBody();
+
+		if (bioCache && !biodate.empty() && !output.empty())
+		{
+			QRZClient::storeBioInCache(*bioCache, call, biodate, output);
+		}
+	}
+	catch (Poco::Exception &ex)
+	{
+		throw TransportException("QRZ could not be reached: " + ex.displayText());
+	}
+
+	co_return output;
+}
+
+/**
+ * @brief Fetches the DXCC information for a given query string.
+ *
+ * @param query The query string for which to fetch the DXCC information.
+ * @return A task resulting in the DXCC object.
+ *
+ * @throws TransportException If QRZ could not be reached or answered with an HTTP error.
+ */
+net::Task<DXCC> AsyncQRZClient::fetchDXCC(std::string query)
+{
+	DXCC dxcc;
+
+	if (!m_client.tokenIsValid())
+	{
+		co_await fetchToken();
+	}
+
+	try
+	{
+		Poco::URI uri(m_client.getBaseUrl());
+
+		uri.addQueryParameter("dxcc", query);
+		uri.addQueryParameter("s", m_client.getSessionKey());
+
+		QrzResponse response = co_await sendRequest(uri);
+		const Poco::Net::HTTPResponse &httpResponse = response.getHttpResponse();
+
+		QRZClient::throwIfFailed(httpResponse);
+
+		m_client.updateQuota(QrzXmlDecoder::decodeDXCC(response.getBody(), dxcc));
+	}
+	catch (Poco::Exception &ex)
+	{
+		throw TransportException("QRZ could not be reached: " + ex.displayText());
+	}
+
+	co_return dxcc;
+}
+
+/**
+ * @brief Fetches a session token from the QRZ API.
+ *
+ * Callers that ask for a token while one is already being fetched wait for that login and share its outcome.
+ *
+ * @return A task that finishes once the session has been renewed.
+ */
+net::Task<void> AsyncQRZClient::fetchToken()
+{
+	const std::string key;
+
+	auto it = m_flights.find(key);
+	if (it != m_flights.end())
+	{
+		std::shared_ptr<Flight> flight = it->second;
+		co_await join(flight);
+
+		if (flight->error)
+		{
+			std::rethrow_exception(flight->error);
+		}
+
+		co_return;
+	}
+
+	m_flights.emplace(key, std::make_shared<Flight>());
+
+	std::exception_ptr error;
+
+	try
+	{
+		co_await requestToken();
+	}
+	catch (...)
+	{
+		error = std::current_exception();
+	}
+
+	land(key, error);
+
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+/**
+ * @brief Returns the number of callsign lookups saved by waiting for a lookup already in flight.
+ *
+ * @return The number of requests saved.
+ */
+std::uint64_t AsyncQRZClient::getCoalescedLookupCount() const
+{
+	return m_coalesced;
+}
+
+/**
+ * @brief Opens a connection to QRZ ahead of a lookup, so the lookup does not wait for the TLS handshake.
+ *
+ * The network access manager keeps the connection for the next request to the same host. Nothing is done while the
+ * circuit breaker is open, or while responses are replayed from an archive.
+ */
+void AsyncQRZClient::prewarmConnection()
+{
+	if (m_client.getCircuitBreaker().getState() == net::CircuitState::OPEN || m_client.isReplaying())
+	{
+		return;
+	}
+
+	Poco::URI uri(m_client.getBaseUrl());
+
+	if (uri.getScheme() == "https")
+	{
+		m_network.connectToHostEncrypted(QString::fromStdString(uri.getHost()), uri.getPort());
+	}
+	else
+	{
+		m_network.connectToHost(QString::fromStdString(uri.getHost()), uri.getPort());
+	}
+}
+
+/**
+ * @brief Sends a request to the QRZ API and returns the response.
+ *
+ * Transport errors, timeouts and 5xx responses are retried after a jittered, exponentially growing delay, as long as
+ * the retry fits before the total deadline. Every attempt is reported to the circuit breaker, and while the breaker
+ * is open the request fails straight away.
+ *
+ * The client's traffic archive records the response, or answers the request instead of QRZ when it is replaying.
+ *
+ * @param uri The URI of the API endpoint to send the request to.
+ * @param cancel Cancels the request. May be null.
+ * @return A task resulting in the HTTP response and body.
+ */
+net::Task<QrzResponse> AsyncQRZClient::sendRequest(Poco::URI uri, std::shared_ptr<net::CancellationToken> cancel)
+{
+	std::string endpoint = QRZClient::endpointOf(uri);
+
+	uri.setPath(Poco::format("/xml/%s/", QRZClient::m_apiVersion));
+	uri.addQueryParameter("agent", QRZClient::m_userAgent);
+
+	std::shared_ptr<net::TrafficArchive> archive = m_client.getTrafficArchive();
+	if (archive && archive->isReplaying())
+	{
+		net::RecordedExchange exchange = archive->replay(uri);
+
+		co_await sleepFor(archive->getReplayDelay(exchange));
+
+		if (cancel)
+		{
+			cancel->throwIfCancelled();
+		}
+
+		co_return QRZClient::replayedResponse(exchange);
+	}
+
+	std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+	net::RequestDeadlines deadlines = m_client.getRequestDeadlines();
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + deadlines.total;
+
+	net::RetryPolicy retryPolicy = m_client.getRetryPolicy();
+	net::CircuitBreaker &circuitBreaker = m_client.getCircuitBreaker();
+
+	for (int attempt = 1;; attempt++)
+	{
+		if (!circuitBreaker.allowRequest())
+		{
+			throw CircuitOpenException();
+		}
+
+		std::chrono::milliseconds delay = retryPolicy.delayFor(attempt - 1);
+
+		try
+		{
+			QrzResponse response = co_await exchange(uri.toString(), endpoint, deadlines, deadline, cancel);
+
+			if (!QRZClient::isServerError(response.getHttpResponse().getStatus()))
+			{
+				circuitBreaker.recordSuccess();
+				QRZClient::recordResponse(archive.get(), uri, started, response);
+				co_return response;
+			}
+
+			circuitBreaker.recordFailure();
+
+			// Out of retries, hand the error response to the caller
+			if (!QRZClient::shouldRetry(retryPolicy, attempt, delay, deadline))
+			{
+				QRZClient::recordResponse(archive.get(), uri, started, response);
+				co_return response;
+			}
+		}
+		catch (TimeoutException &)
+		{
+			circuitBreaker.recordFailure();
+
+			if (!QRZClient::shouldRetry(retryPolicy, attempt, delay, deadline))
+			{
+				throw;
+			}
+		}
+		catch (Poco::IOException &)
+		{
+			circuitBreaker.recordFailure();
+
+			if (!QRZClient::shouldRetry(retryPolicy, attempt, delay, deadline))
+			{
+				throw;
+			}
+		}
+		catch (...)
+		{
+			// Cancelled, or an error that says nothing about the health of the server
+			circuitBreaker.recordAbandoned();
+			throw;
+		}
+
+		co_await sleepFor(delay);
+
+		if (cancel)
+		{
+			cancel->throwIfCancelled();
+		}
+	}
+}
+
+/**
+ * @brief Finishes after the given time, leaving the event loop to other work in the meantime.
+ *
+ * @param delay How long to wait. Zero waits for the next pass of the event loop.
+ * @return A task that finishes once the time has passed.
+ */
+net::Task<void> AsyncQRZClient::sleepFor(std::chrono::milliseconds delay)
+{
+	co_await TimerElapsed{&m_network, delay};
+}
+
+/**
+ * @brief Makes a single attempt at a request.
+ *
+ * The whole attempt is bounded by the time left before the request deadline. The network manager has a single
+ * inactivity timeout rather than separate connect and read timeouts, so the longer of the two is used for it.
+ * Cancelling the token aborts the reply, from whichever thread it was cancelled on.
+ */
+net::Task<QrzResponse> AsyncQRZClient::exchange(std::string url, std::string endpoint, net::RequestDeadlines deadlines,
+												std::chrono::steady_clock::time_point deadline,
+												std::shared_ptr<net::CancellationToken> cancel)
+{
+	if (cancel)
+	{
+		cancel->throwIfCancelled();
+	}
+
+	std::chrono::milliseconds total = net::RequestDeadlines::capped(deadlines.total, deadline);
+	std::chrono::milliseconds idle = net::RequestDeadlines::capped(std::max(deadlines.connect, deadlines.read), deadline);
+
+	if (total.count() == 0)
+	{
+		throw TimeoutException();
+	}
+
+	QNetworkRequest request(QUrl(QString::fromStdString(url)));
+	request.setRawHeader("Accept-Encoding", "gzip, deflate");
+	request.setTransferTimeout(static_cast<int>(idle.count()));
+
+	std::unique_ptr<QNetworkReply, ReplyDeleter> reply(m_network.get(request));
+	QNetworkReply *target = reply.get();
+
+	bool timedOut = false;
+
+	QTimer timer;
+	timer.setSingleShot(true);
+	QObject::connect(&timer, &QTimer::timeout, target, [target, &timedOut]()
+	{
+		timedOut = true;
+		target->abort();
+	});
+	timer.start(total);
+
+	// Released before the reply, and the token does not run a callback while a registration is being released
+	net::CancellationToken::Registration registration;
+	if (cancel)
+	{
+		registration = cancel->subscribe([target]()
+		{
+			QMetaObject::invokeMethod(target, &QNetworkReply::abort, Qt::QueuedConnection);
+		});
+	}
+
+	co_await ReplyFinished{target};
+
+	timer.stop();
+
+	if (cancel && cancel->isCancelled())
+	{
+		throw CancelledException();
+	}
+
+	if (timedOut || reply->error() == QNetworkReply::OperationCanceledError || reply->error() == QNetworkReply::TimeoutError)
+	{
+		throw TimeoutException();
+	}
+
+	QVariant status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+	if (!status.isValid())
+	{
+		throw Poco::IOException(reply->errorString().toStdString());
+	}
+
+	QByteArray raw = reply->readAll();
+	std::string body = decodeBody(raw, reply->rawHeader("Content-Encoding").toStdString());
+
+	m_client.m_transferCounter->record(endpoint, raw.size(), body.size());
+
+	std::string reason = reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute).toString().toStdString();
+	Poco::Net::HTTPResponse response(static_cast<Poco::Net::HTTPResponse::HTTPStatus>(status.toInt()), reason);
+
+	co_return QrzResponse{response, body};
+}
+
+/**
+ * @brief Looks up a callsign on the QRZ API, without coalescing.
+ *
+ * Background lookups are checked against the rate limiter first, and are refused while the daily quota is running
+ * low. If the session key is not valid, a new token is fetched before making the request.
+ *
+ * @throws RateLimitException If a background lookup was held back to save quota.
+ * @throws TransportException If QRZ could not be reached or answered with an HTTP error.
+ */
+net::Task<Callsign> AsyncQRZClient::lookupCallsign(std::string call, LookupPriority priority,
+												   std::shared_ptr<net::CancellationToken> cancel)
+{
+	Callsign callsign;
+	callsign.setCall(call);
+
+	if (!m_client.m_rateLimiter->tryAcquire(priority))
+	{
+		throw RateLimitException();
+	}
+
+	if (!m_client.tokenIsValid())
+	{
+		co_await fetchToken();
+	}
+
+	try
+	{
+		Poco::URI uri(m_client.getBaseUrl());
+
+		uri.addQueryParameter("callsign", call);
+		uri.addQueryParameter("s", m_client.getSessionKey());
+
+		QrzResponse response = co_await sendRequest(uri, cancel);
+		const Poco::Net::HTTPResponse &httpResponse = response.getHttpResponse();
+
+		QRZClient::throwIfFailed(httpResponse);
+
+		m_client.updateQuota(QrzXmlDecoder::decodeCallsign(response.getBody(), callsign));
+
+		m_client.storeInCache(call, callsign);
+	}
+	catch (Poco::Exception &ex)
+	{
+		throw TransportException("QRZ could not be reached: " + ex.displayText());
+	}
+
+	co_return callsign;
+}
+
+/**
+ * @brief Requests a token from the QRZ API, without coalescing.
+ */
+net::Task<void> AsyncQRZClient::requestToken()
+{
+	Poco::URI uri(m_client.getBaseUrl());
+
+	{
+		std::lock_guard<std::mutex> lock(m_client.m_stateMutex);
+		uri.addQueryParameter("username", m_client.m_username);
+		uri.addQueryParameter("password", m_client.m_password);
+	}
+
+	std::string body;
+
+	try
+	{
+		QrzResponse response = co_await sendRequest(uri);
+		const Poco::Net::HTTPResponse &httpResponse = response.getHttpResponse();
+
+		QRZClient::throwIfFailed(httpResponse);
+
+		body = response.getBody();
+	}
+	catch (Poco::Exception &ex)
+	{
+		throw TransportException("QRZ could not be reached: " + ex.displayText());
+	}
+
+	m_client.acceptToken(body);
+}
+
+/**
+ * @brief Waits for a request already in flight.
+ *
+ * @param flight The request.
+ * @param cancel Stops the wait early. May be null.
+ * @return A task that finishes once the request has, or once the token is cancelled.
+ */
+net::Task<void> AsyncQRZClient::join(std::shared_ptr<Flight> flight, std::shared_ptr<net::CancellationToken> cancel)
+{
+	co_await FlightLanded<Flight>{*flight, &m_network, std::move(cancel)};
+}
+
+/**
+ * @brief Marks a request as finished and resumes the tasks waiting for it.
+ *
+ * The request is forgotten first, so a waiting task that has to try again starts a request of its own.
+ *
+ * @param key The key the request was registered under.
+ * @param error What the request failed with, or null.
+ */
+void AsyncQRZClient::land(const std::string &key, std::exception_ptr error)
+{
+	auto it = m_flights.find(key);
+	if (it == m_flights.end())
+	{
+		return;
+	}
+
+	std::shared_ptr<Flight> flight = it->second;
+	m_flights.erase(it);
+
+	flight->error = error;
+
+	std::vector<std::shared_ptr<Flight::Waiter>> waiters = std::move(flight->waiters);
+	for (const std::shared_ptr<Flight::Waiter> &waiter : waiters)
+	{
+		waiter->resume();
+	}
+}
+
+/**
+ * @brief Inflates a gzip or deflate encoded response body.
+ *
+ * The Accept-Encoding header is set by hand, so that the bytes on the wire can be counted, which leaves inflating
+ * the body to the client rather than the network manager.
+ */
+std::string AsyncQRZClient::decodeBody(const QByteArray &raw, const std::string &contentEncoding)
+{
+	if (!QRZClient::isCompressed(contentEncoding))
+	{
+		return raw.toStdString();
+	}
+
+	std::istringstream compressed(raw.toStdString());
+
+	// The zlib window bits plus 32 detect a gzip or zlib header on their own
+	Poco::InflatingInputStream inflater(compressed, 15 + 32);
+
+	std::string body;
+	Poco::StreamCopier::copyToString(inflater, body);
+
+	return body;
+}
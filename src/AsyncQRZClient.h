@@ -0,0 +1,258 @@
+#ifndef QRZ_ASYNCQRZCLIENT_H
+#define QRZ_ASYNCQRZCLIENT_H
+
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <QNetworkAccessManager>
+
+#include "LookupPriority.h"
+#include "QRZClient.h"
+#include "model/Callsign.h"
+#include "model/DXCC.h"
+#include "net/CancellationToken.h"
+#include "net/RequestDeadlines.h"
+#include "net/Task.h"
+
+namespace qrz
+{
+	/**
+	 * @class AsyncQRZClient
+	 *
+	 * @brief Talks to the QRZ API from the Qt event loop, with lookups written as coroutines.
+	 *
+	 * The client offers the same fetchCallsign(), fetchBio(), fetchDXCC() and fetchToken() calls as QRZClient, but each
+	 * returns a Task that suspends while its request is on the wire instead of blocking the calling thread. Requests go
+	 * through a QNetworkAccessManager, so any number of lookups can be in flight on the GUI thread without a worker
+	 * thread each.
+	 *
+	 * The client is built on a QRZClient and shares its settings, session, quota, caches, circuit breaker and
+	 * transfer counters, so the two can be used side by side and a token renewed by one is used by the other.
+	 *
+	 * Every call has to be made, and every task run, on the thread that created the client.
+	 */
+	class AsyncQRZClient
+	{
+	public:
+		/**
+		 * @brief Constructs a client on top of the settings and session state of a blocking client.
+		 *
+		 * @param client The client whose state is shared. Has to outlive this client.
+		 */
+		explicit AsyncQRZClient(QRZClient &client);
+
+		virtual ~AsyncQRZClient() = default;
+
+		AsyncQRZClient(const AsyncQRZClient &) = delete;
+
+		AsyncQRZClient &operator=(const AsyncQRZClient &) = delete;
+
+		/**
+		 * @brief Returns the client whose settings and session state are shared.
+		 *
+		 * @return A reference to the client.
+		 */
+		QRZClient &getClient();
+
+		/**
+		 * @brief Fetches a Callsign object for a given callsign string.
+		 *
+		 * Records are answered from the same caches QRZClient::fetchCallsign() uses. If a lookup for the same callsign
+		 * is already in flight, the task waits for it and takes the record it stored, or the error it failed with,
+		 * instead of making another request.
+		 *
+		 * @param call The callsign to fetch information for.
+		 * @param priority How urgently the record is needed.
+		 * @param cancel Cancels the lookup. May be null.
+		 * @return A task resulting in the Callsign object containing the fetched callsign information.
+		 *
+		 * @throws NotFoundException If QRZ has no record for the callsign.
+		 * @throws RateLimitException If a background lookup was held back to save quota.
+		 * @throws TimeoutException If QRZ did not answer in time.
+		 * @throws TransportException If QRZ could not be reached or answered with an HTTP error.
+		 * @throws CancelledException If the lookup was cancelled.
+		 * @throws CircuitOpenException If QRZ has been failing and requests are paused.
+		 */
+		net::Task<Callsign> fetchCallsign(std::string call, LookupPriority priority = LookupPriority::INTERACTIVE,
+										  std::shared_ptr<net::CancellationToken> cancel = nullptr);
+
+		/**
+		 * @brief Fetches the biography information for a given callsign.
+		 *
+		 * A bio cached for the same biodate is returned without going to the network.
+		 *
+		 * @param call The callsign for which to fetch the biography information.
+		 * @param biodate The biodate of the callsign record.
+		 * @param cancel Cancels the download. May be null.
+		 * @return A task resulting in the bio HTML.
+		 *
+		 * @throws TimeoutException If QRZ did not answer in time.
+		 * @throws TransportException If QRZ could not be reached or answered with an HTTP error.
+		 * @throws CancelledException If the download was cancelled.
+		 */
+		net::Task<std::string> fetchBio(std::string call, std::string biodate = "",
+										std::shared_ptr<net::CancellationToken> cancel = nullptr);
+
+		/**
+		 * @brief Fetches the DXCC information for a given query string.
+		 *
+		 * @param query The query string for which to fetch the DXCC information.
+		 * @return A task resulting in the DXCC object.
+		 *
+		 * @throws TransportException If QRZ could not be reached or answered with an HTTP error.
+		 */
+		net::Task<DXCC> fetchDXCC(std::string query);
+
+		/**
+		 * @brief Fetches a session token from the QRZ API.
+		 *
+		 * Callers that ask for a token while one is already being fetched wait for that login instead of logging in a
+		 * second time.
+		 *
+		 * @return A task that finishes once the session has been renewed.
+		 *
+		 * @throws std::runtime_error If an invalid XML response is received from the QRZ API.
+		 * @throws TransportException If QRZ could not be reached or answered with an HTTP error.
+		 */
+		net::Task<void> fetchToken();
+
+		/**
+		 * @brief Returns the number of callsign lookups saved by waiting for a lookup already in flight.
+		 *
+		 * @return The number of requests saved.
+		 */
+		std::uint64_t getCoalescedLookupCount() const;
+
+		/**
+		 * @brief Opens a connection to QRZ ahead of a lookup, so the lookup does not wait for the TLS handshake.
+		 *
+		 * Returns straight away, the connection is made by the network access manager in the background.
+		 */
+		void prewarmConnection();
+
+	protected:
+		/**
+		 * @brief A request in flight that other tasks are waiting for.
+		 */
+		struct Flight
+		{
+			/**
+			 * @brief A task waiting for the request, which is resumed either when the request lands or when the task
+			 * is cancelled, whichever comes first.
+			 */
+			struct Waiter
+			{
+				std::coroutine_handle<> handle;
+				bool resumed = false;
+
+				void resume()
+				{
+					if (!resumed)
+					{
+						resumed = true;
+						handle.resume();
+					}
+				}
+			};
+
+			// Tasks to resume once the request has finished
+			std::vector<std::shared_ptr<Waiter>> waiters;
+
+			// What the request failed with, if it did
+			std::exception_ptr error;
+		};
+
+		// The client whose settings, session and caches are shared
+		QRZClient &m_client;
+
+		// Sends the requests, and resumes the tasks waiting on them from the event loop
+		QNetworkAccessManager m_network;
+
+		// Requests in flight, keyed by normalized callsign, or by an empty string for a login
+		std::map<std::string, std::shared_ptr<Flight>> m_flights;
+
+		// Callsign lookups answered by a lookup that was already in flight
+		std::uint64_t m_coalesced = 0;
+
+		/**
+		 * @brief Sends a request to the QRZ API and returns the response.
+		 *
+		 * Requests are bounded by the deadlines, retried and reported to the circuit breaker the same way as
+		 * QRZClient::sendRequest(), but the task suspends for the response and between retries.
+		 *
+		 * @param uri The URI of the API endpoint to send the request to.
+		 * @param cancel Cancels the request. May be null.
+		 * @return A task resulting in the HTTP response and body.
+		 *
+		 * @throws TimeoutException If a deadline passed before the response was complete.
+		 * @throws CancelledException If the request was cancelled.
+		 * @throws CircuitOpenException If QRZ has been failing and requests are paused.
+		 */
+		virtual net::Task<QrzResponse> sendRequest(Poco::URI uri, std::shared_ptr<net::CancellationToken> cancel = nullptr);
+
+		/**
+		 * @brief Finishes after the given time, leaving the event loop to other work in the meantime.
+		 *
+		 * @param delay How long to wait. Zero waits for the next pass of the event loop.
+		 * @return A task that finishes once the time has passed.
+		 */
+		net::Task<void> sleepFor(std::chrono::milliseconds delay);
+
+	private:
+		/**
+		 * @brief Makes a single attempt at a request.
+		 *
+		 * @throws TimeoutException If a deadline passed before the response was complete.
+		 * @throws CancelledException If the request was cancelled.
+		 * @throws Poco::IOException If the request failed in transit.
+		 */
+		net::Task<QrzResponse> exchange(std::string url, std::string endpoint, net::RequestDeadlines deadlines,
+										std::chrono::steady_clock::time_point deadline,
+										std::shared_ptr<net::CancellationToken> cancel);
+
+		/**
+		 * @brief Looks up a callsign on the QRZ API, without coalescing.
+		 *
+		 * @see QRZClient::lookupCallsign()
+		 */
+		net::Task<Callsign> lookupCallsign(std::string call, LookupPriority priority,
+										   std::shared_ptr<net::CancellationToken> cancel);
+
+		/**
+		 * @brief Requests a token from the QRZ API, without coalescing.
+		 */
+		net::Task<void> requestToken();
+
+		/**
+		 * @brief Waits for a request already in flight.
+		 *
+		 * @param flight The request.
+		 * @param cancel Stops the wait early. May be null.
+		 * @return A task that finishes once the request has, or once the token is cancelled.
+		 */
+		net::Task<void> join(std::shared_ptr<Flight> flight, std::shared_ptr<net::CancellationToken> cancel = nullptr);
+
+		/**
+		 * @brief Marks a request as finished and resumes the tasks waiting for it.
+		 *
+		 * @param key The key the request was registered under.
+		 * @param error What the request failed with, or null.
+		 */
+		void land(const std::string &key, std::exception_ptr error);
+
+		/**
+		 * @brief Inflates a gzip or deflate encoded response body.
+		 *
+		 * @throws Poco::IOException If the body could not be inflated, or is encoded in a way that cannot be read.
+		 */
+		static std::string decodeBody(const QByteArray &raw, const std::string &contentEncoding);
+	};
+}
+
+#endif //QRZ_ASYNCQRZCLIENT_H
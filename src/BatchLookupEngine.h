@@ -0,0 +1,304 @@
+#ifndef QRZ_BATCHLOOKUPENGINE_H
+#define QRZ_BATCHLOOKUPENGINE_H
+
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "exception/AuthenticationException.h"
+#include "exception/CancelledException.h"
+#include "exception/CircuitOpenException.h"
+#include "exception/NotFoundException.h"
+#include "exception/RateLimitException.h"
+#include "exception/TransportException.h"
+
+namespace qrz
+{
+	/**
+	 * @class BatchLookupEngine
+	 *
+	 * @brief Runs a batch of QRZ API lookups on a bounded number of worker threads.
+	 *
+	 * Each search term is looked up by the supplied lookup function, and the outcomes are returned in the same order
+	 * as the terms, regardless of which worker finished first.
+	 *
+	 * Authentication failures are handled the same way the serial lookup loop in AppController handles them: the
+	 * token is refreshed and the lookup retried, up to a maximum number of consecutive failures. The refresh is shared
+	 * by all workers, so when several lookups fail on the same expired session key only one of them refreshes the
+	 * token and the others simply retry with the new one.
+	 *
+	 * @tparam T The type of record returned by the lookup function.
+	 */
+	template<typename T>
+	class BatchLookupEngine
+	{
+	public:
+		typedef std::function<T(const std::string &term)> LookupFunction;
+		typedef std::function<bool()> RefreshFunction;
+
+		/**
+		 * @brief The result of looking up a single search term.
+		 */
+		struct Outcome
+		{
+			// The search term that was looked up
+			std::string term;
+
+			// The record, if the lookup succeeded
+			std::optional<T> result;
+
+			// The error message, if the lookup failed
+			std::string error;
+
+			// Whether the lookup failed because QRZ has no record for the term
+			bool notFound = false;
+
+			// Whether the lookup was held back to save quota, rather than failing
+			bool deferred = false;
+
+			// Whether the caller cancelled the lookup, rather than it failing
+			bool cancelled = false;
+
+			// Whether QRZ could not be reached, or the lookup was refused because QRZ has been failing
+			bool unavailable = false;
+		};
+
+		/**
+		 * @brief Constructs a BatchLookupEngine.
+		 *
+		 * @param lookup The function used to look up a single term. It is called concurrently from the worker threads.
+		 * @param refresh The function used to refresh the session token. It returns false if the token could not be
+		 *        refreshed, for example because no credentials are configured. It is never called concurrently.
+		 * @param workers The maximum number of lookups to run at once.
+		 * @param maxFailedCallCount The maximum number of consecutive authentication failures before giving up.
+		 */
+		BatchLookupEngine(LookupFunction lookup, RefreshFunction refresh, std::size_t workers, int maxFailedCallCount)
+				: m_lookup(std::move(lookup)), m_refresh(std::move(refresh)), m_workers(std::max<std::size_t>(workers, 1)),
+				  m_maxFailedCallCount(maxFailedCallCount)
+		{}
+
+		/**
+		 * @brief Sets a function to be called as soon as each term has been looked up.
+		 *
+		 * The function is called from whichever worker finished the term, so it may be called concurrently, and
+		 * before run() has returned.
+		 *
+		 * @param onOutcome The function, or null for none.
+		 */
+		void setOutcomeCallback(std::function<void(const Outcome &outcome)> onOutcome)
+		{
+			m_onOutcome = std::move(onOutcome);
+		}
+
+		/**
+		 * @brief Looks up all of the given terms.
+		 *
+		 * @param terms The search terms to look up.
+		 * @return One outcome per term, in the same order as the terms.
+		 */
+		std::vector<Outcome> run(const std::vector<std::string> &terms)
+		{
+			std::vector<Outcome> outcomes(terms.size());
+
+			m_nextIndex = 0;
+			m_failedCallCount = 0;
+			m_tokenGeneration = 0;
+			m_authExhausted = false;
+
+			std::size_t workerCount = std::min(m_workers, terms.size());
+
+			if (workerCount <= 1)
+			{
+				work(terms, outcomes);
+				return outcomes;
+			}
+
+			std::vector<std::thread> threads;
+			threads.reserve(workerCount);
+
+			for (std::size_t i = 0; i < workerCount; i++)
+			{
+				threads.emplace_back([this, &terms, &outcomes]()
+				{
+					work(terms, outcomes);
+				});
+			}
+
+			for (std::thread &thread : threads)
+			{
+				thread.join();
+			}
+
+			return outcomes;
+		}
+
+	private:
+		LookupFunction m_lookup;
+		RefreshFunction m_refresh;
+		std::size_t m_workers;
+		int m_maxFailedCallCount;
+
+		// Called with each outcome as soon as it is known
+		std::function<void(const Outcome &outcome)> m_onOutcome;
+
+		// Index of the next term to hand to a worker
+		std::atomic<std::size_t> m_nextIndex = 0;
+
+		// Guards the authentication state below
+		std::mutex m_authMutex;
+
+		// Consecutive authentication failures since the last successful lookup
+		int m_failedCallCount = 0;
+
+		// Incremented every time the token is refreshed
+		int m_tokenGeneration = 0;
+
+		// Set once the token can no longer be refreshed, after which authentication failures are reported as errors
+		bool m_authExhausted = false;
+
+		/**
+		 * @brief Worker loop, takes terms until there are none left.
+		 */
+		void work(const std::vector<std::string> &terms, std::vector<Outcome> &outcomes)
+		{
+			for (std::size_t index = m_nextIndex++; index < terms.size(); index = m_nextIndex++)
+			{
+				lookupTerm(terms.at(index), outcomes.at(index));
+
+				if (m_onOutcome)
+				{
+					m_onOutcome(outcomes.at(index));
+				}
+			}
+		}
+
+		/**
+		 * @brief Looks up a single term, retrying after a token refresh if authentication fails.
+		 */
+		void lookupTerm(const std::string &term, Outcome &outcome)
+		{
+			outcome.term = term;
+
+			while (true)
+			{
+				int generation = currentGeneration();
+
+				try
+				{
+					outcome.result = m_lookup(term);
+
+					std::lock_guard<std::mutex> lock(m_authMutex);
+					m_failedCallCount = 0;
+
+					return;
+				}
+				catch (AuthenticationException &e)
+				{
+					if (!refreshAfterFailure(generation))
+					{
+						outcome.error = std::format("QRZ API Error: {:s}", e.what());
+						return;
+					}
+				}
+				catch (NotFoundException &e)
+				{
+					outcome.error = e.what();
+					outcome.notFound = true;
+					return;
+				}
+				catch (RateLimitException &e)
+				{
+					outcome.error = e.what();
+					outcome.deferred = true;
+					return;
+				}
+				catch (CancelledException &e)
+				{
+					outcome.error = e.what();
+					outcome.cancelled = true;
+					return;
+				}
+				catch (CircuitOpenException &e)
+				{
+					outcome.error = e.what();
+					outcome.unavailable = true;
+					return;
+				}
+				catch (TransportException &e)
+				{
+					outcome.error = e.what();
+					outcome.unavailable = true;
+					return;
+				}
+				catch (std::exception &e)
+				{
+					outcome.error = e.what();
+					return;
+				}
+			}
+		}
+
+		int currentGeneration()
+		{
+			std::lock_guard<std::mutex> lock(m_authMutex);
+			return m_tokenGeneration;
+		}
+
+		/**
+		 * @brief Handles an authentication failure seen by a lookup that started with the given token generation.
+		 *
+		 * If another worker has already refreshed the token since that lookup started, there is nothing to do but
+		 * retry. Otherwise this worker refreshes it, unless the failure limit has been reached. A refresh that throws,
+		 * for example because QRZ is unreachable, counts as a refresh that failed.
+		 *
+		 * @return True if the lookup should be retried.
+		 */
+		bool refreshAfterFailure(int generation)
+		{
+			std::lock_guard<std::mutex> lock(m_authMutex);
+
+			if (m_authExhausted)
+			{
+				return false;
+			}
+
+			if (generation != m_tokenGeneration)
+			{
+				return true;
+			}
+
+			bool refreshed = false;
+
+			if (m_failedCallCount < m_maxFailedCallCount)
+			{
+				try
+				{
+					refreshed = m_refresh();
+				}
+				catch (std::exception &)
+				{
+					refreshed = false;
+				}
+			}
+
+			if (!refreshed)
+			{
+				m_authExhausted = true;
+				return false;
+			}
+
+			m_failedCallCount++;
+			m_tokenGeneration++;
+
+			return true;
+		}
+	};
+}
+
+#endif //QRZ_BATCHLOOKUPENGINE_H
@@ -0,0 +1,314 @@
+#include "CallsignCanonicalizer.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+using namespace qrz;
+
+namespace
+{
+	// Longest prefix before the last digit, and longest run of letters after it
+	constexpr int MAX_PREFIX = 4;
+	constexpr int MAX_LETTERS = 4;
+	constexpr int MAX_BASE = MAX_PREFIX + 1 + MAX_LETTERS;
+
+	enum CharClass : std::uint8_t
+	{
+		LETTER, DIGIT, OTHER, CHAR_CLASSES
+	};
+
+	constexpr CharClass classify(char c)
+	{
+		if (c >= 'A' && c <= 'Z')
+		{
+			return LETTER;
+		}
+
+		if (c >= '0' && c <= '9')
+		{
+			return DIGIT;
+		}
+
+		return OTHER;
+	}
+
+	/*
+	 * What the DFA needs to remember about the characters read so far. The digit read last splits the input into the
+	 * prefix before it and the letters after it, so a new digit makes everything read so far the prefix.
+	 */
+	struct BaseState
+	{
+		int length = 0;
+		bool anyLetter = false;
+		bool digitSeen = false;
+		int prefixLength = 0;
+		bool prefixHasLetter = false;
+	};
+
+	// State 0 is the dead state, which every character leads back to
+	constexpr std::size_t STATE_COUNT = 1 + (MAX_BASE + 1) * 2 * 2 * (MAX_PREFIX + 1) * 2;
+
+	constexpr std::uint16_t encode(const BaseState &state)
+	{
+		std::size_t id = state.length;
+		id = id * 2 + state.anyLetter;
+		id = id * 2 + state.digitSeen;
+		id = id * (MAX_PREFIX + 1) + state.prefixLength;
+		id = id * 2 + state.prefixHasLetter;
+
+		return static_cast<std::uint16_t>(id + 1);
+	}
+
+	constexpr BaseState decode(std::size_t id)
+	{
+		id -= 1;
+
+		BaseState state;
+		state.prefixHasLetter = id % 2;
+		id /= 2;
+		state.prefixLength = static_cast<int>(id % (MAX_PREFIX + 1));
+		id /= (MAX_PREFIX + 1);
+		state.digitSeen = id % 2;
+		id /= 2;
+		state.anyLetter = id % 2;
+		id /= 2;
+		state.length = static_cast<int>(id);
+
+		return state;
+	}
+
+	constexpr int trailingLetters(const BaseState &state)
+	{
+		return state.digitSeen ? state.length - state.prefixLength - 1 : 0;
+	}
+
+	constexpr bool accepts(const BaseState &state)
+	{
+		int letters = trailingLetters(state);
+
+		return state.digitSeen && state.prefixLength >= 1 && state.prefixHasLetter && letters >= 1 &&
+			   letters <= MAX_LETTERS;
+	}
+
+	constexpr std::uint16_t step(const BaseState &state, CharClass charClass)
+	{
+		if (charClass == OTHER || state.length >= MAX_BASE)
+		{
+			return 0;
+		}
+
+		BaseState next = state;
+		next.length++;
+
+		if (charClass == LETTER)
+		{
+			next.anyLetter = true;
+
+			if (trailingLetters(next) > MAX_LETTERS)
+			{
+				return 0;
+			}
+		}
+		else
+		{
+			// A later digit only makes the prefix longer, so a prefix that is already too long never recovers
+			if (state.length > MAX_PREFIX)
+			{
+				return 0;
+			}
+
+			next.digitSeen = true;
+			next.prefixLength = state.length;
+			next.prefixHasLetter = state.anyLetter;
+		}
+
+		return encode(next);
+	}
+
+	struct BaseCallsignDfa
+	{
+		std::array<std::array<std::uint16_t, CHAR_CLASSES>, STATE_COUNT> transitions{};
+		std::array<bool, STATE_COUNT> accepting{};
+		std::uint16_t start = 0;
+	};
+
+	constexpr BaseCallsignDfa buildBaseCallsignDfa()
+	{
+		BaseCallsignDfa dfa;
+		dfa.start = encode(BaseState{});
+
+		for (std::size_t id = 1; id < STATE_COUNT; id++)
+		{
+			BaseState state = decode(id);
+
+			dfa.accepting[id] = accepts(state);
+			dfa.transitions[id][LETTER] = step(state, LETTER);
+			dfa.transitions[id][DIGIT] = step(state, DIGIT);
+			dfa.transitions[id][OTHER] = 0;
+		}
+
+		return dfa;
+	}
+
+	constexpr BaseCallsignDfa BASE_CALLSIGN_DFA = buildBaseCallsignDfa();
+
+	static_assert(encode(decode(STATE_COUNT - 1)) == STATE_COUNT - 1, "The state encoding must round trip");
+	static_assert(!BASE_CALLSIGN_DFA.accepting[0], "The dead state must not accept");
+
+	std::vector<std::string_view> split(std::string_view call)
+	{
+		std::vector<std::string_view> parts;
+		std::size_t start = 0;
+
+		while (true)
+		{
+			std::size_t slash = call.find('/', start);
+			parts.push_back(call.substr(start, slash - start));
+
+			if (slash == std::string_view::npos)
+			{
+				return parts;
+			}
+
+			start = slash + 1;
+		}
+	}
+}
+
+std::string CanonicalCallsign::toString() const
+{
+	std::string call = base;
+
+	if (!prefix.empty())
+	{
+		call = prefix + "/" + call;
+	}
+
+	if (!suffix.empty())
+	{
+		call += "/" + suffix;
+	}
+
+	return call;
+}
+
+/**
+ * @brief Takes a callsign apart.
+ *
+ * A callsign of two parts is the station callsign and either a prefix or a suffix, whichever the other part is. When
+ * both parts could be the callsign of a station, the longer one is taken to be the station, as in W1AW/KH6A where the
+ * station is operating from a location that uses callsign-like designators.
+ *
+ * @param call The callsign, in any case, with or without surrounding whitespace.
+ * @return The parts of the callsign in upper case, or nothing if the input cannot be a callsign.
+ */
+std::optional<CanonicalCallsign> CallsignCanonicalizer::parse(std::string_view call)
+{
+	std::size_t begin = call.find_first_not_of(" \t\r\n");
+	if (begin == std::string_view::npos)
+	{
+		return std::nullopt;
+	}
+
+	std::size_t end = call.find_last_not_of(" \t\r\n");
+	std::string_view trimmed = call.substr(begin, end - begin + 1);
+
+	if (trimmed.size() > MAX_LENGTH)
+	{
+		return std::nullopt;
+	}
+
+	std::string upper(trimmed);
+	for (char &c : upper)
+	{
+		if (c >= 'a' && c <= 'z')
+		{
+			c = static_cast<char>(c - 'a' + 'A');
+		}
+	}
+
+	std::vector<std::string_view> parts = split(upper);
+	CanonicalCallsign canonical;
+
+	if (parts.size() == 1 && isBaseCallsign(parts[0]))
+	{
+		canonical.base = parts[0];
+	}
+	else if (parts.size() == 2)
+	{
+		bool firstIsBase = isBaseCallsign(parts[0]) && isDesignator(parts[1]);
+		bool secondIsBase = isBaseCallsign(parts[1]) && isDesignator(parts[0]);
+
+		if (firstIsBase && (!secondIsBase || parts[0].size() >= parts[1].size()))
+		{
+			canonical.base = parts[0];
+			canonical.suffix = parts[1];
+		}
+		else if (secondIsBase)
+		{
+			canonical.prefix = parts[0];
+			canonical.base = parts[1];
+		}
+	}
+	else if (parts.size() == 3 && isDesignator(parts[0]) && isBaseCallsign(parts[1]) && isDesignator(parts[2]))
+	{
+		canonical.prefix = parts[0];
+		canonical.base = parts[1];
+		canonical.suffix = parts[2];
+	}
+
+	if (canonical.base.empty())
+	{
+		return std::nullopt;
+	}
+
+	return canonical;
+}
+
+std::string CallsignCanonicalizer::canonicalize(std::string_view call)
+{
+	std::optional<CanonicalCallsign> canonical = parse(call);
+
+	return canonical.has_value() ? canonical->base : std::string();
+}
+
+bool CallsignCanonicalizer::isValid(std::string_view call)
+{
+	return parse(call).has_value();
+}
+
+bool CallsignCanonicalizer::isBaseCallsign(std::string_view call)
+{
+	std::uint16_t state = BASE_CALLSIGN_DFA.start;
+
+	for (char c : call)
+	{
+		state = BASE_CALLSIGN_DFA.transitions[state][classify(c)];
+
+		if (state == 0)
+		{
+			return false;
+		}
+	}
+
+	return BASE_CALLSIGN_DFA.accepting[state];
+}
+
+bool CallsignCanonicalizer::isDesignator(std::string_view part)
+{
+	if (part.empty() || part.size() > MAX_PREFIX)
+	{
+		return false;
+	}
+
+	for (char c : part)
+	{
+		if (classify(c) == OTHER)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
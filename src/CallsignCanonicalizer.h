@@ -0,0 +1,94 @@
+#ifndef QRZ_CALLSIGNCANONICALIZER_H
+#define QRZ_CALLSIGNCANONICALIZER_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace qrz
+{
+	/**
+	 * @brief A callsign taken apart into the station callsign and the designators around it.
+	 */
+	struct CanonicalCallsign
+	{
+		// Where the station is operating from, VE3 in VE3/K4RWR
+		std::string prefix;
+
+		// The callsign of the station, K4RWR in VE3/K4RWR/P
+		std::string base;
+
+		// How or where the station is operating, P in K4RWR/P
+		std::string suffix;
+
+		/**
+		 * @brief Returns the key lookups, caches and the table use for the callsign, which is the base callsign.
+		 */
+		const std::string &getKey() const
+		{
+			return base;
+		}
+
+		/**
+		 * @brief Returns the callsign as it is written on the air, with its prefix and suffix.
+		 */
+		std::string toString() const;
+	};
+
+	/**
+	 * @class CallsignCanonicalizer
+	 *
+	 * @brief Turns whatever was typed or heard into the single key a callsign is looked up and cached under.
+	 *
+	 * A callsign is up to three parts separated by slashes: an optional prefix for the country the station is
+	 * operating from, the callsign of the station, and an optional suffix such as P, M, MM, QRP or a call area. All of
+	 * VE3/K4RWR, k4rwr/p and K4RWR/QRP are the station K4RWR, and that is the key they canonicalize to.
+	 *
+	 * The callsign of the station is recognized by a DFA that is built at compile time: a prefix of one to four
+	 * letters and digits holding at least one letter, the last digit of the callsign, and one to four letters. Input
+	 * that cannot be a callsign, such as a name, a grid square, a frequency or anything with punctuation in it, is
+	 * rejected here, before it uses up a QRZ lookup.
+	 */
+	class CallsignCanonicalizer
+	{
+	public:
+		/**
+		 * @brief Takes a callsign apart.
+		 *
+		 * @param call The callsign, in any case, with or without surrounding whitespace.
+		 * @return The parts of the callsign in upper case, or nothing if the input cannot be a callsign.
+		 */
+		static std::optional<CanonicalCallsign> parse(std::string_view call);
+
+		/**
+		 * @brief Returns the key a callsign is looked up and cached under.
+		 *
+		 * @param call The callsign.
+		 * @return The base callsign in upper case, or an empty string if the input cannot be a callsign.
+		 */
+		static std::string canonicalize(std::string_view call);
+
+		/**
+		 * @brief Checks whether the input could be a callsign, with or without a prefix and suffix.
+		 */
+		static bool isValid(std::string_view call);
+
+		/**
+		 * @brief Checks whether the input is the callsign of a station, without a prefix or suffix.
+		 *
+		 * @param call The callsign, in upper case.
+		 */
+		static bool isBaseCallsign(std::string_view call);
+
+	private:
+		// Longest input worth taking apart, a prefix, a callsign and a suffix with the slashes between them
+		static constexpr std::size_t MAX_LENGTH = 19;
+
+		/**
+		 * @brief Checks whether a part of a callsign can be a prefix or suffix: one to four letters and digits.
+		 */
+		static bool isDesignator(std::string_view part);
+	};
+}
+
+#endif //QRZ_CALLSIGNCANONICALIZER_H
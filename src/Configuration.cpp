@@ -1,10 +1,12 @@
 #include "Configuration.h"
+#include <algorithm>
 
 #include <iostream>
 
 #include <Poco/Crypto/CipherFactory.h>
 #include <Poco/Crypto/CipherKey.h>
 #include <Poco/Crypto/CipherKeyImpl.h>
+#include <QStandardPaths>
 
 #include "Util.h"
 
@@ -137,6 +139,431 @@ int Configuration::getJs8CallPort()
 	return getValue(f_js8CallPort).toInt();
 }
 
+/**
+ * @brief Retrieves the number of QRZ lookups that may run at the same time.
+ *
+ * This function retrieves the "network/lookup_workers" value from the configuration file. If the value has not been
+ * set, or is not a positive number, the default is returned.
+ *
+ * @return The number of lookup workers as an integer.
+ */
+int Configuration::getLookupWorkers()
+{
+	int workers = getValue(f_lookupWorkers).toInt();
+
+	return (workers > 0) ? workers : d_lookupWorkers;
+}
+
+/**
+ * @brief Retrieves the number of QRZ lookups the account may make in a 24 hour period.
+ *
+ * This function retrieves the "network/daily_lookup_limit" value from the configuration file. If the value has not
+ * been set, or is not a positive number, the default is returned.
+ *
+ * @return The daily lookup limit as an integer.
+ */
+int Configuration::getDailyLookupLimit()
+{
+	int limit = getValue(f_dailyLookupLimit).toInt();
+
+	return (limit > 0) ? limit : d_dailyLookupLimit;
+}
+
+/**
+ * @brief Retrieves the number of background lookups allowed per minute while the daily quota is untouched.
+ *
+ * This function retrieves the "network/background_lookups_per_minute" value from the configuration file. If the value
+ * has not been set, or is not a positive number, the default is returned.
+ *
+ * @return The background lookup rate as an integer.
+ */
+int Configuration::getBackgroundLookupRate()
+{
+	int rate = getValue(f_backgroundLookupRate).toInt();
+
+	return (rate > 0) ? rate : d_backgroundLookupRate;
+}
+
+/**
+ * @brief Retrieves how many minutes before it expires the session token is renewed in the background.
+ *
+ * This function retrieves the "network/token_refresh_lead_minutes" value from the configuration file. If the value has
+ * not been set, or is not a positive number, the default is returned.
+ *
+ * @return The token refresh lead time in minutes.
+ */
+int Configuration::getTokenRefreshLead()
+{
+	int minutes = getValue(f_tokenRefreshLead).toInt();
+
+	return (minutes > 0) ? minutes : d_tokenRefreshLead;
+}
+
+/**
+ * @brief Retrieves how many seconds to wait for a connection to the QRZ API.
+ *
+ * This function retrieves the "network/connect_timeout_seconds" value from the configuration file. If the value has not been set,
+ * or is not a positive number, the default is returned.
+ *
+ * @return The timeout in seconds.
+ */
+int Configuration::getConnectTimeout()
+{
+	int seconds = getValue(f_connectTimeout).toInt();
+
+	return (seconds > 0) ? seconds : d_connectTimeout;
+}
+
+/**
+ * @brief Retrieves how many seconds to wait for the QRZ API to send anything.
+ *
+ * This function retrieves the "network/read_timeout_seconds" value from the configuration file. If the value has not been set,
+ * or is not a positive number, the default is returned.
+ *
+ * @return The timeout in seconds.
+ */
+int Configuration::getReadTimeout()
+{
+	int seconds = getValue(f_readTimeout).toInt();
+
+	return (seconds > 0) ? seconds : d_readTimeout;
+}
+
+/**
+ * @brief Retrieves how many seconds a whole request to the QRZ API may take.
+ *
+ * This function retrieves the "network/request_timeout_seconds" value from the configuration file. If the value has not been set,
+ * or is not a positive number, the default is returned.
+ *
+ * @return The timeout in seconds.
+ */
+int Configuration::getRequestTimeout()
+{
+	int seconds = getValue(f_requestTimeout).toInt();
+
+	return (seconds > 0) ? seconds : d_requestTimeout;
+}
+
+/**
+ * @brief Retrieves how many times a request that failed for a transient reason is tried in total.
+ *
+ * This function retrieves the "network/retry_attempts" value from the configuration file. If the value has not been set,
+ * or is not a positive number, the default is returned.
+ *
+ * @return The number of attempts, including the first.
+ */
+int Configuration::getRetryAttempts()
+{
+	int attempts = getValue(f_retryAttempts).toInt();
+
+	return (attempts > 0) ? attempts : d_retryAttempts;
+}
+
+/**
+ * @brief Retrieves how many failed requests in a row pause lookups to the QRZ API.
+ *
+ * This function retrieves the "network/breaker_failure_threshold" value from the configuration file. If the value has
+ * not been set, or is not a positive number, the default is returned.
+ *
+ * @return The number of consecutive failures.
+ */
+int Configuration::getBreakerFailureThreshold()
+{
+	int failures = getValue(f_breakerFailureThreshold).toInt();
+
+	return (failures > 0) ? failures : d_breakerFailureThreshold;
+}
+
+/**
+ * @brief Retrieves how many seconds lookups stay paused before QRZ is tried again.
+ *
+ * This function retrieves the "network/breaker_open_seconds" value from the configuration file. If the value has not
+ * been set, or is not a positive number, the default is returned.
+ *
+ * @return The pause in seconds.
+ */
+int Configuration::getBreakerOpenTime()
+{
+	int seconds = getValue(f_breakerOpenTime).toInt();
+
+	return (seconds > 0) ? seconds : d_breakerOpenTime;
+}
+
+/**
+ * @brief Retrieves whether lookups run as coroutines on the event loop instead of on worker threads.
+ *
+ * This function retrieves the "network/async_lookups" value from the configuration file. If the value has not been
+ * set, lookups block worker threads as they always have.
+ *
+ * @return True if lookups use the coroutine client.
+ */
+bool Configuration::getAsyncLookups()
+{
+	return getValue(f_asyncLookups).toBool();
+}
+
+/**
+ * @brief Retrieves how many background lookups may wait for the lookup thread at once.
+ *
+ * This function retrieves the "network/background_queue_depth" value from the configuration file. If the value has not
+ * been set, or is not a positive number, the default is returned.
+ *
+ * @return The queue depth as an integer.
+ */
+int Configuration::getBackgroundQueueDepth()
+{
+	int depth = getValue(f_backgroundQueueDepth).toInt();
+
+	return (depth > 0) ? depth : d_backgroundQueueDepth;
+}
+
+/**
+ * @brief Retrieves the age, in hours, after which a record in the table is checked against QRZ again.
+ *
+ * This function retrieves the "cache/stale_record_age_hours" value from the configuration file. If the value has not
+ * been set, or is not a positive number, the default is returned.
+ *
+ * @return The stale record age in hours.
+ */
+int Configuration::getStaleRecordAge()
+{
+	int hours = getValue(f_staleRecordAge).toInt();
+
+	return (hours > 0) ? hours : d_staleRecordAge;
+}
+
+/**
+ * @brief Retrieves the number of lookups per hour that may be spent checking stale records.
+ *
+ * This function retrieves the "network/stale_refresh_lookups_per_hour" value from the configuration file. If the value
+ * has not been set, or is not a positive number, the default is returned.
+ *
+ * @return The stale refresh budget in lookups per hour.
+ */
+int Configuration::getStaleRefreshBudget()
+{
+	int lookups = getValue(f_staleRefreshBudget).toInt();
+
+	return (lookups > 0) ? lookups : d_staleRefreshBudget;
+}
+
+/**
+ * @brief Retrieves how often, in seconds, JS8Call is asked for the stations it has heard.
+ *
+ * This function retrieves the "js8call/activity_poll_seconds" value from the configuration file. If the value has not
+ * been set, or is not a positive number, the default is returned.
+ *
+ * @return The call activity poll interval in seconds.
+ */
+int Configuration::getJs8CallActivityPoll()
+{
+	int seconds = getValue(f_js8CallActivityPoll).toInt();
+
+	return (seconds > 0) ? seconds : d_js8CallActivityPoll;
+}
+
+/**
+ * @brief Retrieves the number of heard stations whose records may be prefetched after each call activity poll.
+ *
+ * This function retrieves the "network/prefetch_lookups_per_poll" value from the configuration file. If the value has
+ * not been set, or is not a positive number, the default is returned.
+ *
+ * @return The prefetch limit per poll.
+ */
+int Configuration::getPrefetchLimit()
+{
+	int lookups = getValue(f_prefetchLimit).toInt();
+
+	return (lookups > 0) ? lookups : d_prefetchLimit;
+}
+
+/**
+ * @brief Retrieves the pause in typing, in milliseconds, before a callsign is looked up speculatively.
+ *
+ * This function retrieves the "network/type_ahead_delay_ms" value from the configuration file. If the value has not
+ * been set, or is not a positive number, the default is returned.
+ *
+ * @return The type-ahead delay in milliseconds.
+ */
+int Configuration::getTypeAheadDelay()
+{
+	int milliseconds = getValue(f_typeAheadDelay).toInt();
+
+	return (milliseconds > 0) ? milliseconds : d_typeAheadDelay;
+}
+
+/**
+ * @brief Retrieves how long QRZ has before a lookup is raced against the fallback.
+ *
+ * This function retrieves the "network/hedge_delay_ms" value from the configuration file. If the value has not been
+ * set, or is not a positive number, the default is returned.
+ *
+ * @return The hedge delay in milliseconds, or 0 if lookups are not raced.
+ */
+int Configuration::getHedgeDelay()
+{
+	int milliseconds = getValue(f_hedgeDelay).toInt();
+
+	return (milliseconds > 0) ? milliseconds : d_hedgeDelay;
+}
+
+/**
+ * @brief Retrieves the number of deferred lookups per minute that may be made once QRZ can be reached again.
+ *
+ * This function retrieves the "network/deferred_lookups_per_minute" value from the configuration file. If the value has
+ * not been set, or is not a positive number, the default is returned.
+ *
+ * @return The deferred lookup rate in lookups per minute.
+ */
+int Configuration::getDeferredLookupRate()
+{
+	int lookups = getValue(f_deferredLookupRate).toInt();
+
+	return (lookups > 0) ? lookups : d_deferredLookupRate;
+}
+
+/**
+ * @brief Retrieves whether lookups are answered from local data only, with misses deferred until later.
+ *
+ * This function retrieves the "network/offline_mode" value from the configuration file. If the value has not been
+ * set, lookups go to QRZ whenever it can be reached.
+ *
+ * @return True if offline mode was turned on by hand.
+ */
+bool Configuration::getOfflineMode()
+{
+	return getValue(f_offlineMode).toBool();
+}
+
+/**
+ * @brief Retrieves the base URL of a second QRZ compatible endpoint that lookups fall back to.
+ *
+ * This function retrieves the "network/fallback_base_url" value from the configuration file.
+ *
+ * @return The base URL, or an empty string if there is no fallback.
+ */
+std::string Configuration::getFallbackBaseUrl()
+{
+	return getValue(f_fallbackBaseUrl).toString().toStdString();
+}
+
+/**
+ * @brief Retrieves the file QRZ responses are recorded to.
+ *
+ * This function retrieves the "network/record_traffic_to" value from the configuration file.
+ *
+ * @return The archive file, or an empty string if responses are not recorded.
+ */
+std::string Configuration::getRecordTrafficTo()
+{
+	return getValue(f_recordTrafficTo).toString().toStdString();
+}
+
+/**
+ * @brief Retrieves the file QRZ responses are replayed from instead of sending requests to QRZ.
+ *
+ * This function retrieves the "network/replay_traffic_from" value from the configuration file.
+ *
+ * @return The archive file, or an empty string if requests go to QRZ.
+ */
+std::string Configuration::getReplayTrafficFrom()
+{
+	return getValue(f_replayTrafficFrom).toString().toStdString();
+}
+
+/**
+ * @brief Retrieves how fast replayed responses are handed out, as a percentage of their recorded speed.
+ *
+ * This function retrieves the "network/replay_speed_percent" value from the configuration file. If the value has not
+ * been set, responses are replayed with their recorded latency. Unlike most settings, 0 is kept as it is.
+ *
+ * @return The replay speed in percent, 0 to answer without waiting.
+ */
+int Configuration::getReplaySpeed()
+{
+	QVariant percent = getValue(f_replaySpeed);
+
+	return percent.isValid() ? std::max(percent.toInt(), 0) : d_replaySpeed;
+}
+
+/**
+ * @brief Retrieves the directory the callsign cache is stored in.
+ *
+ * This function retrieves the "cache/directory" value from the configuration file. If the value has not been set, the
+ * platform cache location is returned.
+ *
+ * @return The cache directory as a string.
+ */
+std::string Configuration::getCacheDirectory()
+{
+	if (hasValue(f_cacheDirectory))
+	{
+		return getValue(f_cacheDirectory).toString().toStdString();
+	}
+
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString();
+}
+
+/**
+ * @brief Retrieves how many hours a cached callsign record is considered fresh.
+ *
+ * This function retrieves the "cache/callsign_ttl_hours" value from the configuration file. If the value has not
+ * been set, or is not a positive number, the default is returned.
+ *
+ * @return The callsign cache TTL in hours.
+ */
+int Configuration::getCallsignCacheTtl()
+{
+	int hours = getValue(f_callsignCacheTtl).toInt();
+
+	return (hours > 0) ? hours : d_callsignCacheTtl;
+}
+
+/**
+ * @brief Retrieves how many callsign records are kept in memory.
+ *
+ * This function retrieves the "cache/memory_records" value from the configuration file. If the value has not been
+ * set, or is not a positive number, the default is returned.
+ *
+ * @return The number of records kept in memory.
+ */
+int Configuration::getMemoryCacheSize()
+{
+	int records = getValue(f_memoryCacheSize).toInt();
+
+	return (records > 0) ? records : d_memoryCacheSize;
+}
+
+/**
+ * @brief Retrieves how many minutes a callsign QRZ has no record for is remembered.
+ *
+ * This function retrieves the "cache/not_found_ttl_minutes" value from the configuration file. If the value has not
+ * been set, or is not a positive number, the default is returned.
+ *
+ * @return The not found TTL in minutes.
+ */
+int Configuration::getNotFoundTtl()
+{
+	int minutes = getValue(f_notFoundTtl).toInt();
+
+	return (minutes > 0) ? minutes : d_notFoundTtl;
+}
+
+/**
+ * @brief Retrieves how many kilobytes of compressed bios are kept in memory.
+ *
+ * This function retrieves the "cache/bio_memory_kb" value from the configuration file. If the value has not been set,
+ * or is not a positive number, the default is returned.
+ *
+ * @return The bio memory budget in kilobytes.
+ */
+int Configuration::getBioMemoryBudget()
+{
+	int kilobytes = getValue(f_bioMemoryBudget).toInt();
+
+	return (kilobytes > 0) ? kilobytes : d_bioMemoryBudget;
+}
+
 /**
  * @brief Retrieves the value associated with the "station/callsign" key from the configuration.
  *
@@ -396,6 +823,296 @@ void Configuration::setJs8CallConnectionDetails(const std::string &host, int por
 	}
 }
 
+/**
+ * @brief Sets the number of QRZ lookups that may run at the same time.
+ *
+ * @param workers The number of lookup workers.
+ */
+void Configuration::setLookupWorkers(int workers)
+{
+	setValue(f_lookupWorkers, workers);
+}
+
+/**
+ * @brief Sets the number of QRZ lookups the account may make in a 24 hour period.
+ *
+ * @param limit The daily lookup limit.
+ */
+void Configuration::setDailyLookupLimit(int limit)
+{
+	setValue(f_dailyLookupLimit, limit);
+}
+
+/**
+ * @brief Sets the number of background lookups allowed per minute while the daily quota is untouched.
+ *
+ * @param rate The background lookup rate.
+ */
+void Configuration::setBackgroundLookupRate(int rate)
+{
+	setValue(f_backgroundLookupRate, rate);
+}
+
+/**
+ * @brief Sets how many minutes before it expires the session token is renewed in the background.
+ *
+ * @param minutes The token refresh lead time in minutes.
+ */
+void Configuration::setTokenRefreshLead(int minutes)
+{
+	setValue(f_tokenRefreshLead, minutes);
+}
+
+/**
+ * @brief Sets how many seconds to wait for a connection to the QRZ API.
+ *
+ * @param seconds The timeout in seconds.
+ */
+void Configuration::setConnectTimeout(int seconds)
+{
+	setValue(f_connectTimeout, seconds);
+}
+
+/**
+ * @brief Sets how many seconds to wait for the QRZ API to send anything.
+ *
+ * @param seconds The timeout in seconds.
+ */
+void Configuration::setReadTimeout(int seconds)
+{
+	setValue(f_readTimeout, seconds);
+}
+
+/**
+ * @brief Sets how many seconds a whole request to the QRZ API may take.
+ *
+ * @param seconds The timeout in seconds.
+ */
+void Configuration::setRequestTimeout(int seconds)
+{
+	setValue(f_requestTimeout, seconds);
+}
+
+/**
+ * @brief Sets how many times a request that failed for a transient reason is tried in total.
+ *
+ * @param attempts The number of attempts, including the first.
+ */
+void Configuration::setRetryAttempts(int attempts)
+{
+	setValue(f_retryAttempts, attempts);
+}
+
+/**
+ * @brief Sets how many failed requests in a row pause lookups to the QRZ API.
+ *
+ * @param failures The number of consecutive failures.
+ */
+void Configuration::setBreakerFailureThreshold(int failures)
+{
+	setValue(f_breakerFailureThreshold, failures);
+}
+
+/**
+ * @brief Sets how many seconds lookups stay paused before QRZ is tried again.
+ *
+ * @param seconds The pause in seconds.
+ */
+void Configuration::setBreakerOpenTime(int seconds)
+{
+	setValue(f_breakerOpenTime, seconds);
+}
+
+/**
+ * @brief Sets whether lookups run as coroutines on the event loop instead of on worker threads.
+ *
+ * @param enabled True to use the coroutine client.
+ */
+void Configuration::setAsyncLookups(bool enabled)
+{
+	setValue(f_asyncLookups, enabled);
+}
+
+/**
+ * @brief Sets how many background lookups may wait for the lookup thread at once.
+ *
+ * @param depth The queue depth.
+ */
+void Configuration::setBackgroundQueueDepth(int depth)
+{
+	setValue(f_backgroundQueueDepth, depth);
+}
+
+/**
+ * @brief Sets the age, in hours, after which a record in the table is checked against QRZ again.
+ *
+ * @param hours The stale record age in hours.
+ */
+void Configuration::setStaleRecordAge(int hours)
+{
+	setValue(f_staleRecordAge, hours);
+}
+
+/**
+ * @brief Sets the number of lookups per hour that may be spent checking stale records.
+ *
+ * @param lookups The stale refresh budget in lookups per hour.
+ */
+void Configuration::setStaleRefreshBudget(int lookups)
+{
+	setValue(f_staleRefreshBudget, lookups);
+}
+
+/**
+ * @brief Sets how often, in seconds, JS8Call is asked for the stations it has heard.
+ *
+ * @param seconds The call activity poll interval in seconds.
+ */
+void Configuration::setJs8CallActivityPoll(int seconds)
+{
+	setValue(f_js8CallActivityPoll, seconds);
+}
+
+/**
+ * @brief Sets the number of heard stations whose records may be prefetched after each call activity poll.
+ *
+ * @param lookups The prefetch limit per poll.
+ */
+void Configuration::setPrefetchLimit(int lookups)
+{
+	setValue(f_prefetchLimit, lookups);
+}
+
+/**
+ * @brief Sets the pause in typing, in milliseconds, before a callsign is looked up speculatively.
+ *
+ * @param milliseconds The type-ahead delay in milliseconds.
+ */
+void Configuration::setTypeAheadDelay(int milliseconds)
+{
+	setValue(f_typeAheadDelay, milliseconds);
+}
+
+/**
+ * @brief Sets how long QRZ has before a lookup is raced against the fallback.
+ *
+ * @param milliseconds The hedge delay in milliseconds, 0 to not race lookups.
+ */
+void Configuration::setHedgeDelay(int milliseconds)
+{
+	setValue(f_hedgeDelay, milliseconds);
+}
+
+/**
+ * @brief Sets the number of deferred lookups per minute that may be made once QRZ can be reached again.
+ *
+ * @param lookups The deferred lookup rate in lookups per minute.
+ */
+void Configuration::setDeferredLookupRate(int lookups)
+{
+	setValue(f_deferredLookupRate, lookups);
+}
+
+/**
+ * @brief Sets whether lookups are answered from local data only, with misses deferred until later.
+ *
+ * @param enabled True to stay offline.
+ */
+void Configuration::setOfflineMode(bool enabled)
+{
+	setValue(f_offlineMode, enabled);
+}
+
+/**
+ * @brief Sets the base URL of a second QRZ compatible endpoint that lookups fall back to.
+ *
+ * @param baseUrl The base URL, or an empty string for no fallback.
+ */
+void Configuration::setFallbackBaseUrl(const std::string &baseUrl)
+{
+	setValue(f_fallbackBaseUrl, baseUrl.c_str());
+}
+
+/**
+ * @brief Sets the file QRZ responses are recorded to.
+ *
+ * @param path The archive file, or an empty string to stop recording.
+ */
+void Configuration::setRecordTrafficTo(const std::string &path)
+{
+	setValue(f_recordTrafficTo, path.c_str());
+}
+
+/**
+ * @brief Sets the file QRZ responses are replayed from instead of sending requests to QRZ.
+ *
+ * @param path The archive file, or an empty string to send requests to QRZ.
+ */
+void Configuration::setReplayTrafficFrom(const std::string &path)
+{
+	setValue(f_replayTrafficFrom, path.c_str());
+}
+
+/**
+ * @brief Sets how fast replayed responses are handed out, as a percentage of their recorded speed.
+ *
+ * @param percent The replay speed in percent, 0 to answer without waiting.
+ */
+void Configuration::setReplaySpeed(int percent)
+{
+	setValue(f_replaySpeed, percent);
+}
+
+/**
+ * @brief Sets the directory the callsign cache is stored in.
+ *
+ * @param directory The cache directory.
+ */
+void Configuration::setCacheDirectory(const std::string &directory)
+{
+	setValue(f_cacheDirectory, directory.c_str());
+}
+
+/**
+ * @brief Sets how many hours a cached callsign record is considered fresh.
+ *
+ * @param hours The callsign cache TTL in hours.
+ */
+void Configuration::setCallsignCacheTtl(int hours)
+{
+	setValue(f_callsignCacheTtl, hours);
+}
+
+/**
+ * @brief Sets how many callsign records are kept in memory.
+ *
+ * @param records The number of records kept in memory.
+ */
+void Configuration::setMemoryCacheSize(int records)
+{
+	setValue(f_memoryCacheSize, records);
+}
+
+/**
+ * @brief Sets how many minutes a callsign QRZ has no record for is remembered.
+ *
+ * @param minutes The not found TTL in minutes.
+ */
+void Configuration::setNotFoundTtl(int minutes)
+{
+	setValue(f_notFoundTtl, minutes);
+}
+
+/**
+ * @brief Sets how many kilobytes of compressed bios are kept in memory.
+ *
+ * @param kilobytes The bio memory budget in kilobytes.
+ */
+void Configuration::setBioMemoryBudget(int kilobytes)
+{
+	setValue(f_bioMemoryBudget, kilobytes);
+}
+
 /**
 * @brief Checks if the configuration has a username value.
 *
@@ -117,6 +117,293 @@ namespace qrz
 		 */
 		int getJs8CallPort();
 
+		/**
+		 * @brief Retrieves the number of QRZ lookups that may run at the same time.
+		 *
+		 * This function retrieves the "network/lookup_workers" value from the configuration file, falling back to a
+		 * default when it has not been set.
+		 *
+		 * @return The number of lookup workers as an integer.
+		 */
+		int getLookupWorkers();
+
+		/**
+		 * @brief Retrieves the number of QRZ lookups the account may make in a 24 hour period.
+		 *
+		 * This function retrieves the "network/daily_lookup_limit" value from the configuration file, falling back to a
+		 * default when it has not been set.
+		 *
+		 * @return The daily lookup limit as an integer.
+		 */
+		int getDailyLookupLimit();
+
+		/**
+		 * @brief Retrieves the number of background lookups allowed per minute while the daily quota is untouched.
+		 *
+		 * This function retrieves the "network/background_lookups_per_minute" value from the configuration file, falling
+		 * back to a default when it has not been set.
+		 *
+		 * @return The background lookup rate as an integer.
+		 */
+		int getBackgroundLookupRate();
+
+		/**
+		 * @brief Retrieves how many minutes before it expires the session token is renewed in the background.
+		 *
+		 * This function retrieves the "network/token_refresh_lead_minutes" value from the configuration file, falling
+		 * back to a default when it has not been set.
+		 *
+		 * @return The token refresh lead time in minutes.
+		 */
+		int getTokenRefreshLead();
+
+		/**
+		 * @brief Retrieves how many seconds to wait for a connection to the QRZ API.
+		 *
+		 * This function retrieves the "network/connect_timeout_seconds" value from the configuration file, falling back to a
+		 * default when it has not been set.
+		 *
+		 * @return The timeout in seconds.
+		 */
+		int getConnectTimeout();
+
+		/**
+		 * @brief Retrieves how many seconds to wait for the QRZ API to send anything.
+		 *
+		 * This function retrieves the "network/read_timeout_seconds" value from the configuration file, falling back to a
+		 * default when it has not been set.
+		 *
+		 * @return The timeout in seconds.
+		 */
+		int getReadTimeout();
+
+		/**
+		 * @brief Retrieves how many seconds a whole request to the QRZ API may take.
+		 *
+		 * This function retrieves the "network/request_timeout_seconds" value from the configuration file, falling back to a
+		 * default when it has not been set.
+		 *
+		 * @return The timeout in seconds.
+		 */
+		int getRequestTimeout();
+
+		/**
+		 * @brief Retrieves how many times a request that failed for a transient reason is tried in total.
+		 *
+		 * This function retrieves the "network/retry_attempts" value from the configuration file, falling back to a
+		 * default when it has not been set.
+		 *
+		 * @return The number of attempts, including the first.
+		 */
+		int getRetryAttempts();
+
+		/**
+		 * @brief Retrieves how many failed requests in a row pause lookups to the QRZ API.
+		 *
+		 * This function retrieves the "network/breaker_failure_threshold" value from the configuration file, falling back
+		 * to a default when it has not been set.
+		 *
+		 * @return The number of consecutive failures.
+		 */
+		int getBreakerFailureThreshold();
+
+		/**
+		 * @brief Retrieves how many seconds lookups stay paused before QRZ is tried again.
+		 *
+		 * This function retrieves the "network/breaker_open_seconds" value from the configuration file, falling back to a
+		 * default when it has not been set.
+		 *
+		 * @return The pause in seconds.
+		 */
+		int getBreakerOpenTime();
+
+		/**
+		 * @brief Retrieves whether lookups run as coroutines on the event loop instead of on worker threads.
+		 *
+		 * This function retrieves the "network/async_lookups" value from the configuration file. Lookups block worker
+		 * threads unless it has been turned on.
+		 *
+		 * @return True if lookups use the coroutine client.
+		 */
+		bool getAsyncLookups();
+
+		/**
+		 * @brief Retrieves how many background lookups may wait for the lookup thread at once.
+		 *
+		 * This function retrieves the "network/background_queue_depth" value from the configuration file, falling back
+		 * to a default when it has not been set.
+		 *
+		 * @return The queue depth as an integer.
+		 */
+		int getBackgroundQueueDepth();
+
+		/**
+		 * @brief Retrieves the age, in hours, after which a record in the table is checked against QRZ again.
+		 *
+		 * This function retrieves the "cache/stale_record_age_hours" value from the configuration file, falling back to
+		 * a default when it has not been set.
+		 *
+		 * @return The stale record age in hours.
+		 */
+		int getStaleRecordAge();
+
+		/**
+		 * @brief Retrieves the number of lookups per hour that may be spent checking stale records.
+		 *
+		 * This function retrieves the "network/stale_refresh_lookups_per_hour" value from the configuration file,
+		 * falling back to a default when it has not been set.
+		 *
+		 * @return The stale refresh budget in lookups per hour.
+		 */
+		int getStaleRefreshBudget();
+
+		/**
+		 * @brief Retrieves how often, in seconds, JS8Call is asked for the stations it has heard.
+		 *
+		 * This function retrieves the "js8call/activity_poll_seconds" value from the configuration file, falling back
+		 * to a default when it has not been set.
+		 *
+		 * @return The call activity poll interval in seconds.
+		 */
+		int getJs8CallActivityPoll();
+
+		/**
+		 * @brief Retrieves the number of heard stations whose records may be prefetched after each call activity poll.
+		 *
+		 * This function retrieves the "network/prefetch_lookups_per_poll" value from the configuration file, falling
+		 * back to a default when it has not been set.
+		 *
+		 * @return The prefetch limit per poll.
+		 */
+		int getPrefetchLimit();
+
+		/**
+		 * @brief Retrieves the pause in typing, in milliseconds, before a callsign is looked up speculatively.
+		 *
+		 * This function retrieves the "network/type_ahead_delay_ms" value from the configuration file, falling back to
+		 * a default when it has not been set.
+		 *
+		 * @return The type-ahead delay in milliseconds.
+		 */
+		int getTypeAheadDelay();
+
+		/**
+		 * @brief Retrieves how long QRZ has before a lookup is raced against the fallback.
+		 *
+		 * This function retrieves the "network/hedge_delay_ms" value from the configuration file, falling back to a
+		 * default when it has not been set.
+		 *
+		 * @return The hedge delay in milliseconds, or 0 if lookups are not raced.
+		 */
+		int getHedgeDelay();
+
+		/**
+		 * @brief Retrieves the number of deferred lookups per minute that may be made once QRZ can be reached again.
+		 *
+		 * This function retrieves the "network/deferred_lookups_per_minute" value from the configuration file, falling
+		 * back to a default when it has not been set.
+		 *
+		 * @return The deferred lookup rate in lookups per minute.
+		 */
+		int getDeferredLookupRate();
+
+		/**
+		 * @brief Retrieves whether lookups are answered from local data only, with misses deferred until later.
+		 *
+		 * This function retrieves the "network/offline_mode" value from the configuration file. Lookups go to QRZ
+		 * unless it has been turned on.
+		 *
+		 * @return True if offline mode was turned on by hand.
+		 */
+		bool getOfflineMode();
+
+		/**
+		 * @brief Retrieves the base URL of a second QRZ compatible endpoint that lookups fall back to.
+		 *
+		 * This function retrieves the "network/fallback_base_url" value from the configuration file.
+		 *
+		 * @return The base URL, or an empty string if there is no fallback.
+		 */
+		std::string getFallbackBaseUrl();
+
+		/**
+		 * @brief Retrieves the file QRZ responses are recorded to.
+		 *
+		 * This function retrieves the "network/record_traffic_to" value from the configuration file.
+		 *
+		 * @return The archive file, or an empty string if responses are not recorded.
+		 */
+		std::string getRecordTrafficTo();
+
+		/**
+		 * @brief Retrieves the file QRZ responses are replayed from instead of sending requests to QRZ.
+		 *
+		 * This function retrieves the "network/replay_traffic_from" value from the configuration file.
+		 *
+		 * @return The archive file, or an empty string if requests go to QRZ.
+		 */
+		std::string getReplayTrafficFrom();
+
+		/**
+		 * @brief Retrieves how fast replayed responses are handed out, as a percentage of their recorded speed.
+		 *
+		 * This function retrieves the "network/replay_speed_percent" value from the configuration file, falling back
+		 * to a default when it has not been set.
+		 *
+		 * @return The replay speed in percent, 0 to answer without waiting.
+		 */
+		int getReplaySpeed();
+
+		/**
+		 * @brief Retrieves the directory the callsign cache is stored in.
+		 *
+		 * This function retrieves the "cache/directory" value from the configuration file, falling back to the
+		 * platform cache location when it has not been set.
+		 *
+		 * @return The cache directory as a string.
+		 */
+		std::string getCacheDirectory();
+
+		/**
+		 * @brief Retrieves how many hours a cached callsign record is considered fresh.
+		 *
+		 * This function retrieves the "cache/callsign_ttl_hours" value from the configuration file, falling back to a
+		 * default when it has not been set.
+		 *
+		 * @return The callsign cache TTL in hours.
+		 */
+		int getCallsignCacheTtl();
+
+		/**
+		 * @brief Retrieves how many callsign records are kept in memory.
+		 *
+		 * This function retrieves the "cache/memory_records" value from the configuration file, falling back to a
+		 * default when it has not been set.
+		 *
+		 * @return The number of records kept in memory.
+		 */
+		int getMemoryCacheSize();
+
+		/**
+		 * @brief Retrieves how many minutes a callsign QRZ has no record for is remembered.
+		 *
+		 * This function retrieves the "cache/not_found_ttl_minutes" value from the configuration file, falling back to
+		 * a default when it has not been set.
+		 *
+		 * @return The not found TTL in minutes.
+		 */
+		int getNotFoundTtl();
+
+		/**
+		 * @brief Retrieves how many kilobytes of compressed bios are kept in memory.
+		 *
+		 * This function retrieves the "cache/bio_memory_kb" value from the configuration file, falling back to a
+		 * default when it has not been set.
+		 *
+		 * @return The bio memory budget in kilobytes.
+		 */
+		int getBioMemoryBudget();
+
 		/**
 		 * @brief Sets the username value in the configuration.
 		 *
@@ -188,6 +475,209 @@ namespace qrz
 
 		void setJs8CallConnectionDetails(const std::string &host, int port);
 
+		/**
+		 * @brief Sets the number of QRZ lookups that may run at the same time.
+		 *
+		 * @param workers The number of lookup workers.
+		 */
+		void setLookupWorkers(int workers);
+
+		/**
+		 * @brief Sets the number of QRZ lookups the account may make in a 24 hour period.
+		 *
+		 * @param limit The daily lookup limit.
+		 */
+		void setDailyLookupLimit(int limit);
+
+		/**
+		 * @brief Sets the number of background lookups allowed per minute while the daily quota is untouched.
+		 *
+		 * @param rate The background lookup rate.
+		 */
+		void setBackgroundLookupRate(int rate);
+
+		/**
+		 * @brief Sets how many minutes before it expires the session token is renewed in the background.
+		 *
+		 * @param minutes The token refresh lead time in minutes.
+		 */
+		void setTokenRefreshLead(int minutes);
+
+		/**
+		 * @brief Sets how many seconds to wait for a connection to the QRZ API.
+		 *
+		 * @param seconds The timeout in seconds.
+		 */
+		void setConnectTimeout(int seconds);
+
+		/**
+		 * @brief Sets how many seconds to wait for the QRZ API to send anything.
+		 *
+		 * @param seconds The timeout in seconds.
+		 */
+		void setReadTimeout(int seconds);
+
+		/**
+		 * @brief Sets how many seconds a whole request to the QRZ API may take.
+		 *
+		 * @param seconds The timeout in seconds.
+		 */
+		void setRequestTimeout(int seconds);
+
+		/**
+		 * @brief Sets how many times a request that failed for a transient reason is tried in total.
+		 *
+		 * @param attempts The number of attempts, including the first.
+		 */
+		void setRetryAttempts(int attempts);
+
+		/**
+		 * @brief Sets how many failed requests in a row pause lookups to the QRZ API.
+		 *
+		 * @param failures The number of consecutive failures.
+		 */
+		void setBreakerFailureThreshold(int failures);
+
+		/**
+		 * @brief Sets how many seconds lookups stay paused before QRZ is tried again.
+		 *
+		 * @param seconds The pause in seconds.
+		 */
+		void setBreakerOpenTime(int seconds);
+
+		/**
+		 * @brief Sets whether lookups run as coroutines on the event loop instead of on worker threads.
+		 *
+		 * @param enabled True to use the coroutine client.
+		 */
+		void setAsyncLookups(bool enabled);
+
+		/**
+		 * @brief Sets how many background lookups may wait for the lookup thread at once.
+		 *
+		 * @param depth The queue depth.
+		 */
+		void setBackgroundQueueDepth(int depth);
+
+		/**
+		 * @brief Sets the age, in hours, after which a record in the table is checked against QRZ again.
+		 *
+		 * @param hours The stale record age in hours.
+		 */
+		void setStaleRecordAge(int hours);
+
+		/**
+		 * @brief Sets the number of lookups per hour that may be spent checking stale records.
+		 *
+		 * @param lookups The stale refresh budget in lookups per hour.
+		 */
+		void setStaleRefreshBudget(int lookups);
+
+		/**
+		 * @brief Sets how often, in seconds, JS8Call is asked for the stations it has heard.
+		 *
+		 * @param seconds The call activity poll interval in seconds.
+		 */
+		void setJs8CallActivityPoll(int seconds);
+
+		/**
+		 * @brief Sets the number of heard stations whose records may be prefetched after each call activity poll.
+		 *
+		 * @param lookups The prefetch limit per poll.
+		 */
+		void setPrefetchLimit(int lookups);
+
+		/**
+		 * @brief Sets the pause in typing, in milliseconds, before a callsign is looked up speculatively.
+		 *
+		 * @param milliseconds The type-ahead delay in milliseconds.
+		 */
+		void setTypeAheadDelay(int milliseconds);
+
+		/**
+		 * @brief Sets how long QRZ has before a lookup is raced against the fallback.
+		 *
+		 * @param milliseconds The hedge delay in milliseconds, 0 to not race lookups.
+		 */
+		void setHedgeDelay(int milliseconds);
+
+		/**
+		 * @brief Sets the number of deferred lookups per minute that may be made once QRZ can be reached again.
+		 *
+		 * @param lookups The deferred lookup rate in lookups per minute.
+		 */
+		void setDeferredLookupRate(int lookups);
+
+		/**
+		 * @brief Sets whether lookups are answered from local data only, with misses deferred until later.
+		 *
+		 * @param enabled True to stay offline.
+		 */
+		void setOfflineMode(bool enabled);
+
+		/**
+		 * @brief Sets the base URL of a second QRZ compatible endpoint that lookups fall back to.
+		 *
+		 * @param baseUrl The base URL, or an empty string for no fallback.
+		 */
+		void setFallbackBaseUrl(const std::string &baseUrl);
+
+		/**
+		 * @brief Sets the file QRZ responses are recorded to.
+		 *
+		 * @param path The archive file, or an empty string to stop recording.
+		 */
+		void setRecordTrafficTo(const std::string &path);
+
+		/**
+		 * @brief Sets the file QRZ responses are replayed from instead of sending requests to QRZ.
+		 *
+		 * @param path The archive file, or an empty string to send requests to QRZ.
+		 */
+		void setReplayTrafficFrom(const std::string &path);
+
+		/**
+		 * @brief Sets how fast replayed responses are handed out, as a percentage of their recorded speed.
+		 *
+		 * @param percent The replay speed in percent, 0 to answer without waiting.
+		 */
+		void setReplaySpeed(int percent);
+
+		/**
+		 * @brief Sets the directory the callsign cache is stored in.
+		 *
+		 * @param directory The cache directory.
+		 */
+		void setCacheDirectory(const std::string &directory);
+
+		/**
+		 * @brief Sets how many hours a cached callsign record is considered fresh.
+		 *
+		 * @param hours The callsign cache TTL in hours.
+		 */
+		void setCallsignCacheTtl(int hours);
+
+		/**
+		 * @brief Sets how many callsign records are kept in memory.
+		 *
+		 * @param records The number of records kept in memory.
+		 */
+		void setMemoryCacheSize(int records);
+
+		/**
+		 * @brief Sets how many minutes a callsign QRZ has no record for is remembered.
+		 *
+		 * @param minutes The not found TTL in minutes.
+		 */
+		void setNotFoundTtl(int minutes);
+
+		/**
+		 * @brief Sets how many kilobytes of compressed bios are kept in memory.
+		 *
+		 * @param kilobytes The bio memory budget in kilobytes.
+		 */
+		void setBioMemoryBudget(int kilobytes);
+
 		/**
 		 * @brief Sets the callsign for the station.
 		 *
@@ -369,6 +859,60 @@ namespace qrz
 		static inline const char *f_grid = "station/grid";
 		static inline const char *f_lat = "station/lat";
 		static inline const char *f_lng = "station/lng";
+		static inline const char *f_lookupWorkers = "network/lookup_workers";
+		static inline const char *f_dailyLookupLimit = "network/daily_lookup_limit";
+		static inline const char *f_backgroundLookupRate = "network/background_lookups_per_minute";
+		static inline const char *f_tokenRefreshLead = "network/token_refresh_lead_minutes";
+		static inline const char *f_connectTimeout = "network/connect_timeout_seconds";
+		static inline const char *f_readTimeout = "network/read_timeout_seconds";
+		static inline const char *f_requestTimeout = "network/request_timeout_seconds";
+		static inline const char *f_retryAttempts = "network/retry_attempts";
+		static inline const char *f_breakerFailureThreshold = "network/breaker_failure_threshold";
+		static inline const char *f_breakerOpenTime = "network/breaker_open_seconds";
+		static inline const char *f_asyncLookups = "network/async_lookups";
+		static inline const char *f_backgroundQueueDepth = "network/background_queue_depth";
+		static inline const char *f_staleRecordAge = "cache/stale_record_age_hours";
+		static inline const char *f_staleRefreshBudget = "network/stale_refresh_lookups_per_hour";
+		static inline const char *f_js8CallActivityPoll = "js8call/activity_poll_seconds";
+		static inline const char *f_prefetchLimit = "network/prefetch_lookups_per_poll";
+		static inline const char *f_typeAheadDelay = "network/type_ahead_delay_ms";
+		static inline const char *f_hedgeDelay = "network/hedge_delay_ms";
+		static inline const char *f_deferredLookupRate = "network/deferred_lookups_per_minute";
+		static inline const char *f_offlineMode = "network/offline_mode";
+		static inline const char *f_fallbackBaseUrl = "network/fallback_base_url";
+		static inline const char *f_recordTrafficTo = "network/record_traffic_to";
+		static inline const char *f_replayTrafficFrom = "network/replay_traffic_from";
+		static inline const char *f_replaySpeed = "network/replay_speed_percent";
+		static inline const char *f_cacheDirectory = "cache/directory";
+		static inline const char *f_callsignCacheTtl = "cache/callsign_ttl_hours";
+		static inline const char *f_memoryCacheSize = "cache/memory_records";
+		static inline const char *f_notFoundTtl = "cache/not_found_ttl_minutes";
+		static inline const char *f_bioMemoryBudget = "cache/bio_memory_kb";
+
+		// Default values
+		static inline const int d_lookupWorkers = 4;
+		static inline const int d_dailyLookupLimit = 5000;
+		static inline const int d_backgroundLookupRate = 30;
+		static inline const int d_tokenRefreshLead = 30;
+		static inline const int d_connectTimeout = 5;
+		static inline const int d_readTimeout = 10;
+		static inline const int d_requestTimeout = 20;
+		static inline const int d_retryAttempts = 3;
+		static inline const int d_breakerFailureThreshold = 5;
+		static inline const int d_breakerOpenTime = 30;
+		static inline const int d_backgroundQueueDepth = 25;
+		static inline const int d_staleRecordAge = 12;
+		static inline const int d_staleRefreshBudget = 6;
+		static inline const int d_js8CallActivityPoll = 30;
+		static inline const int d_prefetchLimit = 10;
+		static inline const int d_typeAheadDelay = 300;
+		static inline const int d_hedgeDelay = 0;
+		static inline const int d_deferredLookupRate = 6;
+		static inline const int d_replaySpeed = 100;
+		static inline const int d_callsignCacheTtl = 24 * 7;
+		static inline const int d_memoryCacheSize = 500;
+		static inline const int d_notFoundTtl = 60;
+		static inline const int d_bioMemoryBudget = 4096;
 
 		QSettings *settings;
 
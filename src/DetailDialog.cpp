@@ -5,6 +5,7 @@
 
 #include <QWebEngineSettings>
 #include <QWebEngineProfile>
+#include <QCloseEvent>
 #include <QHeaderView>
 #include <QFile>
 #include <QFileDialog>
@@ -64,6 +65,13 @@ void DetailDialog::setCallsign(const Callsign &callsign)
 	loadCallsign();
 }
 
+void DetailDialog::closeEvent(QCloseEvent *event)
+{
+	emit closed();
+
+	QMainWindow::closeEvent(event);
+}
+
 void DetailDialog::loadCallsign()
 {
 	ui.callsign->setText(callsign.getCall().c_str());
@@ -35,6 +35,9 @@ signals:
 	void setZoom(QVariant);
 	void disableCenterAnimation();
 	void clearMapItems();
+	void closed();
+protected:
+	void closeEvent(QCloseEvent *event) override;
 private:
 	Callsign callsign;
 	DetailTableModel tableModel;
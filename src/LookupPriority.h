@@ -0,0 +1,23 @@
+#ifndef QRZ_LOOKUPPRIORITY_H
+#define QRZ_LOOKUPPRIORITY_H
+
+namespace qrz
+{
+	/**
+	 * @brief Define how urgently a QRZ lookup is needed
+	 *
+	 * Interactive lookups were asked for by the user and are always sent. Detail lookups, such as the bio for the
+	 * detail view, were asked for too, but can wait for interactive ones. Background lookups, such as stations heard
+	 * by JS8Call, are throttled as the daily lookup quota runs low.
+	 *
+	 * The values are in order of urgency, most urgent first.
+	 */
+	enum LookupPriority
+	{
+		INTERACTIVE,
+		DETAIL,
+		BACKGROUND
+	};
+}
+
+#endif //QRZ_LOOKUPPRIORITY_H
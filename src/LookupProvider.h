@@ -0,0 +1,56 @@
+#ifndef QRZ_LOOKUPPROVIDER_H
+#define QRZ_LOOKUPPROVIDER_H
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "LookupPriority.h"
+#include "model/Callsign.h"
+#include "net/CancellationToken.h"
+
+namespace qrz
+{
+	/**
+	 * @class LookupProvider
+	 *
+	 * @brief A source of callsign records that a LookupResolver can put in its chain.
+	 *
+	 * QRZClient is the provider the application is built around. Other providers, such as a second QRZ endpoint or a
+	 * local stand-in used by the tests, only need to answer these two calls.
+	 */
+	class LookupProvider
+	{
+	public:
+		virtual ~LookupProvider() = default;
+
+		/**
+		 * @brief Returns a name that tells this provider apart from the others in a chain, for the statistics.
+		 */
+		virtual std::string getProviderName() const = 0;
+
+		/**
+		 * @brief Answers a lookup from what the provider already holds, without going to the network.
+		 *
+		 * @param call The callsign.
+		 * @return The record, or nothing if it would take a request to find it.
+		 */
+		virtual std::optional<Callsign> findLocalCallsign(const std::string &call) = 0;
+
+		/**
+		 * @brief Fetches the record of a callsign, going to the network if need be.
+		 *
+		 * @param call The callsign.
+		 * @param priority How urgently the record is needed.
+		 * @param cancel Cancels the lookup from another thread. May be null.
+		 * @return The record.
+		 *
+		 * @throws NotFoundException If the provider has no record for the callsign.
+		 * @throws CancelledException If the lookup was cancelled.
+		 */
+		virtual Callsign fetchCallsign(const std::string call, LookupPriority priority,
+									   const std::shared_ptr<net::CancellationToken> &cancel) = 0;
+	};
+}
+
+#endif //QRZ_LOOKUPPROVIDER_H
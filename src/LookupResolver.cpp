@@ -0,0 +1,392 @@
+#include "LookupResolver.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <condition_variable>
+#include <stdexcept>
+#include <thread>
+
+#include "exception/CancelledException.h"
+#include "exception/CircuitOpenException.h"
+#include "exception/RateLimitException.h"
+
+using namespace qrz;
+
+LookupResolver::LookupResolver(std::chrono::milliseconds hedgeDelay) : m_hedgeDelay(hedgeDelay.count())
+{
+}
+
+void LookupResolver::addProvider(LookupProvider &provider)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	ProviderEntry entry;
+	entry.provider = &provider;
+
+	m_providers.push_back(std::move(entry));
+}
+
+std::size_t LookupResolver::getProviderCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_providers.size();
+}
+
+void LookupResolver::setHedgeDelay(std::chrono::milliseconds hedgeDelay)
+{
+	m_hedgeDelay = std::max(hedgeDelay.count(), std::chrono::milliseconds::rep(0));
+}
+
+std::chrono::milliseconds LookupResolver::getHedgeDelay() const
+{
+	return std::chrono::milliseconds(m_hedgeDelay.load());
+}
+
+/**
+ * @brief Fetches the record of a callsign from the first provider that has it.
+ *
+ * Every provider's local store is checked before any of them is asked over the network. The remote providers are
+ * then asked in chain order, racing the first two if the lookup is interactive and a hedge delay is set. A provider
+ * that fails hands the lookup on to the next one; only cancelling the lookup stops the chain early.
+ *
+ * @param call The callsign.
+ * @param priority How urgently the record is needed.
+ * @param cancel Cancels the lookup from another thread. May be null.
+ * @return The record.
+ *
+ * @throws NotFoundException If no provider has a record for the callsign.
+ * @throws CancelledException If the lookup was cancelled.
+ * @throws std::logic_error If the chain has no providers.
+ */
+Callsign LookupResolver::fetchCallsign(const std::string &call, LookupPriority priority,
+									   const std::shared_ptr<net::CancellationToken> &cancel)
+{
+	std::vector<LookupProvider *> providers = getProviders();
+
+	if (providers.empty())
+	{
+		throw std::logic_error("The lookup chain has no providers");
+	}
+
+	std::optional<Callsign> local = findLocalCallsign(call);
+	if (local.has_value())
+	{
+		return local.value();
+	}
+
+	std::exception_ptr firstError;
+	std::size_t next = 0;
+
+	if (priority == LookupPriority::INTERACTIVE && providers.size() >= 2 && getHedgeDelay().count() > 0)
+	{
+		std::optional<Callsign> raced = race(providers, call, priority, cancel, firstError);
+		if (raced.has_value())
+		{
+			return raced.value();
+		}
+
+		next = 2;
+	}
+
+	for (; next < providers.size(); next++)
+	{
+		if (cancel)
+		{
+			cancel->throwIfCancelled();
+		}
+
+		try
+		{
+			return fetchFrom(next, *providers[next], call, priority, cancel);
+		}
+		catch (CancelledException &)
+		{
+			throw;
+		}
+		catch (...)
+		{
+			if (!firstError)
+			{
+				firstError = std::current_exception();
+			}
+		}
+	}
+
+	std::rethrow_exception(firstError);
+}
+
+/**
+ * @brief Answers a lookup from the local store of any provider, without going to the network.
+ *
+ * The providers are asked in chain order, and the first record found is returned.
+ *
+ * @param call The callsign.
+ * @return The record, or nothing if it would take a request to find it.
+ */
+std::optional<Callsign> LookupResolver::findLocalCallsign(const std::string &call)
+{
+	for (LookupProvider *provider : getProviders())
+	{
+		std::optional<Callsign> local = provider->findLocalCallsign(call);
+		if (local.has_value())
+		{
+			m_localHits++;
+			return local;
+		}
+	}
+
+	return std::nullopt;
+}
+
+std::vector<LookupProviderStats> LookupResolver::getProviderStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::vector<LookupProviderStats> stats;
+	for (const ProviderEntry &entry : m_providers)
+	{
+		std::vector<std::chrono::milliseconds> latencies(entry.latencies.begin(), entry.latencies.end());
+
+		LookupProviderStats providerStats;
+		providerStats.name = entry.provider->getProviderName();
+		providerStats.lookups = entry.lookups;
+		providerStats.failures = entry.failures;
+		providerStats.hedgesWon = entry.hedgesWon;
+		providerStats.p50 = percentile(latencies, 0.5);
+		providerStats.p90 = percentile(latencies, 0.9);
+		providerStats.p99 = percentile(latencies, 0.99);
+
+		stats.push_back(providerStats);
+	}
+
+	return stats;
+}
+
+std::uint64_t LookupResolver::getLocalHitCount() const
+{
+	return m_localHits;
+}
+
+/**
+ * @brief Returns the latency below which the given fraction of the samples fall.
+ *
+ * Uses the nearest-rank method, so the result is always one of the samples.
+ *
+ * @param samples The latencies, in any order.
+ * @param fraction The fraction, between 0.0 and 1.0.
+ * @return The latency, or zero if there are no samples.
+ */
+std::chrono::milliseconds LookupResolver::percentile(std::vector<std::chrono::milliseconds> samples, double fraction)
+{
+	if (samples.empty())
+	{
+		return std::chrono::milliseconds(0);
+	}
+
+	fraction = std::clamp(fraction, 0.0, 1.0);
+
+	auto rank = static_cast<std::size_t>(std::ceil(fraction * static_cast<double>(samples.size())));
+	std::size_t index = (rank == 0) ? 0 : rank - 1;
+
+	std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(index), samples.end());
+
+	return samples[index];
+}
+
+std::vector<LookupProvider *> LookupResolver::getProviders() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::vector<LookupProvider *> providers;
+	for (const ProviderEntry &entry : m_providers)
+	{
+		providers.push_back(entry.provider);
+	}
+
+	return providers;
+}
+
+/**
+ * @brief Asks one provider over the network, recording how long it took.
+ *
+ * Lookups that never reached the provider, because they were held back to save quota or the circuit breaker was
+ * open, and lookups that were cancelled are not recorded, so they do not drag the percentiles down.
+ */
+Callsign LookupResolver::fetchFrom(std::size_t index, LookupProvider &provider, const std::string &call,
+								   LookupPriority priority, const std::shared_ptr<net::CancellationToken> &cancel)
+{
+	Clock::time_point started = Clock::now();
+
+	auto elapsed = [started]()
+	{
+		return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - started);
+	};
+
+	try
+	{
+		Callsign callsign = provider.fetchCallsign(call, priority, cancel);
+
+		recordLatency(index, elapsed(), false);
+
+		return callsign;
+	}
+	catch (RateLimitException &)
+	{
+		throw;
+	}
+	catch (CircuitOpenException &)
+	{
+		throw;
+	}
+	catch (...)
+	{
+		if (!cancel || !cancel->isCancelled())
+		{
+			recordLatency(index, elapsed(), true);
+		}
+
+		throw;
+	}
+}
+
+/**
+ * @brief Races the second provider against the first once the hedge delay has passed.
+ *
+ * The first provider is started straight away. If it has not answered when the delay runs out, or fails before then,
+ * the second provider is started as well. The first record to arrive wins, and the other lookup is cancelled and
+ * waited for, so no lookup outlives the call.
+ *
+ * @param firstError Set to the error of the first provider to fail, if neither had a record.
+ * @return The record of whichever answered first, or nothing if both failed.
+ *
+ * @throws CancelledException If the lookup was cancelled.
+ */
+std::optional<Callsign> LookupResolver::race(const std::vector<LookupProvider *> &providers, const std::string &call,
+											 LookupPriority priority,
+											 const std::shared_ptr<net::CancellationToken> &cancel,
+											 std::exception_ptr &firstError)
+{
+	struct Leg
+	{
+		std::shared_ptr<net::CancellationToken> cancel = std::make_shared<net::CancellationToken>();
+		std::exception_ptr error;
+		bool done = false;
+		std::thread thread;
+	};
+
+	std::mutex mutex;
+	std::condition_variable changed;
+	std::optional<Callsign> winner;
+	std::size_t winningLeg = 0;
+	std::array<Leg, 2> legs;
+
+	// Cancelling the lookup cancels both legs, the registration goes before the legs do
+	net::CancellationToken::Registration registration;
+	if (cancel)
+	{
+		registration = cancel->subscribe([&legs]()
+		{
+			legs[0].cancel->cancel();
+			legs[1].cancel->cancel();
+		});
+	}
+
+	auto run = [&](std::size_t leg)
+	{
+		try
+		{
+			Callsign callsign = fetchFrom(leg, *providers[leg], call, priority, legs[leg].cancel);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!winner.has_value())
+			{
+				winner = callsign;
+				winningLeg = leg;
+			}
+			legs[leg].done = true;
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			legs[leg].error = std::current_exception();
+			legs[leg].done = true;
+		}
+
+		changed.notify_all();
+	};
+
+	legs[0].thread = std::thread(run, 0);
+
+	bool hedged = false;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait_for(lock, getHedgeDelay(), [&]() { return winner.has_value() || legs[0].done; });
+
+		hedged = !winner.has_value() && !(cancel && cancel->isCancelled());
+	}
+
+	if (hedged)
+	{
+		legs[1].thread = std::thread(run, 1);
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		changed.wait(lock, [&]() { return winner.has_value() || (legs[0].done && (!hedged || legs[1].done)); });
+	}
+
+	// Stops the lookup that lost the race
+	for (Leg &leg : legs)
+	{
+		leg.cancel->cancel();
+	}
+
+	for (Leg &leg : legs)
+	{
+		if (leg.thread.joinable())
+		{
+			leg.thread.join();
+		}
+	}
+
+	if (winner.has_value())
+	{
+		if (winningLeg == 1)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_providers[1].hedgesWon++;
+		}
+
+		return winner;
+	}
+
+	if (cancel)
+	{
+		cancel->throwIfCancelled();
+	}
+
+	firstError = legs[0].error ? legs[0].error : legs[1].error;
+
+	return std::nullopt;
+}
+
+void LookupResolver::recordLatency(std::size_t index, std::chrono::milliseconds latency, bool failed)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	ProviderEntry &entry = m_providers[index];
+
+	entry.lookups++;
+	if (failed)
+	{
+		entry.failures++;
+	}
+
+	entry.latencies.push_back(latency);
+	if (entry.latencies.size() > MAX_SAMPLES)
+	{
+		entry.latencies.pop_front();
+	}
+}
@@ -0,0 +1,194 @@
+#ifndef QRZ_LOOKUPRESOLVER_H
+#define QRZ_LOOKUPRESOLVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "LookupPriority.h"
+#include "LookupProvider.h"
+#include "model/Callsign.h"
+#include "net/CancellationToken.h"
+
+namespace qrz
+{
+	/**
+	 * @brief Snapshot of how one provider in a LookupResolver chain has been answering.
+	 */
+	struct LookupProviderStats
+	{
+		// The name of the provider
+		std::string name;
+
+		// Lookups that went to the provider and ran to completion, successful or not
+		std::uint64_t lookups = 0;
+
+		// Lookups the provider failed, including callsigns it has no record for
+		std::uint64_t failures = 0;
+
+		// Races the provider won after being started as the hedge
+		std::uint64_t hedgesWon = 0;
+
+		// Latency percentiles over the most recent lookups
+		std::chrono::milliseconds p50{0};
+		std::chrono::milliseconds p90{0};
+		std::chrono::milliseconds p99{0};
+	};
+
+	/**
+	 * @class LookupResolver
+	 *
+	 * @brief Answers callsign lookups from a chain of providers: what is held locally first, then the network.
+	 *
+	 * A lookup is first offered to every provider's local store, so a record any of them has cached costs no request.
+	 * Otherwise the remote providers are asked in the order they were added, moving on to the next one when a provider
+	 * fails, and the error of the first provider is reported if they all do.
+	 *
+	 * With a hedge delay set, an interactive lookup the first provider has not answered within the delay is raced
+	 * against the second provider, and whichever answers first wins while the other is cancelled. Only interactive
+	 * lookups are hedged, since a race can spend a lookup on both providers. The latency of every remote lookup is
+	 * recorded per provider, so the delay can be set from the percentiles getProviderStats() reports.
+	 *
+	 * Providers are not owned by the resolver and must outlive it. Lookups may be made from several threads at once.
+	 */
+	class LookupResolver
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		/**
+		 * @brief Constructs a resolver with no providers.
+		 *
+		 * @param hedgeDelay How long the first provider has before the second is raced against it. Zero turns
+		 *        hedging off.
+		 */
+		explicit LookupResolver(std::chrono::milliseconds hedgeDelay = std::chrono::milliseconds(0));
+
+		LookupResolver(const LookupResolver &) = delete;
+
+		LookupResolver &operator=(const LookupResolver &) = delete;
+
+		/**
+		 * @brief Adds a provider to the end of the chain.
+		 *
+		 * @param provider The provider, which must outlive the resolver.
+		 */
+		void addProvider(LookupProvider &provider);
+
+		/**
+		 * @brief Returns the number of providers in the chain.
+		 */
+		std::size_t getProviderCount() const;
+
+		/**
+		 * @brief Sets how long the first provider has before the second is raced against it.
+		 *
+		 * @param hedgeDelay The delay. Zero turns hedging off.
+		 */
+		void setHedgeDelay(std::chrono::milliseconds hedgeDelay);
+
+		/**
+		 * @brief Returns how long the first provider has before the second is raced against it.
+		 */
+		std::chrono::milliseconds getHedgeDelay() const;
+
+		/**
+		 * @brief Fetches the record of a callsign from the first provider that has it.
+		 *
+		 * @param call The callsign.
+		 * @param priority How urgently the record is needed.
+		 * @param cancel Cancels the lookup from another thread. May be null.
+		 * @return The record.
+		 *
+		 * @throws NotFoundException If no provider has a record for the callsign.
+		 * @throws CancelledException If the lookup was cancelled.
+		 * @throws std::logic_error If the chain has no providers.
+		 */
+		Callsign fetchCallsign(const std::string &call, LookupPriority priority = LookupPriority::INTERACTIVE,
+							   const std::shared_ptr<net::CancellationToken> &cancel = nullptr);
+
+		/**
+		 * @brief Answers a lookup from the local store of any provider, without going to the network.
+		 *
+		 * @param call The callsign.
+		 * @return The record, or nothing if it would take a request to find it.
+		 */
+		std::optional<Callsign> findLocalCallsign(const std::string &call);
+
+		/**
+		 * @brief Returns how each provider has been answering, in chain order.
+		 */
+		std::vector<LookupProviderStats> getProviderStats() const;
+
+		/**
+		 * @brief Returns the number of lookups answered from a provider's local store.
+		 */
+		std::uint64_t getLocalHitCount() const;
+
+		/**
+		 * @brief Returns the latency below which the given fraction of the samples fall.
+		 *
+		 * @param samples The latencies, in any order.
+		 * @param fraction The fraction, between 0.0 and 1.0.
+		 * @return The latency, or zero if there are no samples.
+		 */
+		static std::chrono::milliseconds percentile(std::vector<std::chrono::milliseconds> samples, double fraction);
+
+	private:
+		// Number of recent latencies kept per provider for the percentiles
+		static constexpr std::size_t MAX_SAMPLES = 512;
+
+		struct ProviderEntry
+		{
+			LookupProvider *provider = nullptr;
+			std::deque<std::chrono::milliseconds> latencies;
+			std::uint64_t lookups = 0;
+			std::uint64_t failures = 0;
+			std::uint64_t hedgesWon = 0;
+		};
+
+		// Guards the providers and their statistics
+		mutable std::mutex m_mutex;
+		std::vector<ProviderEntry> m_providers;
+
+		std::atomic<std::chrono::milliseconds::rep> m_hedgeDelay;
+		std::atomic<std::uint64_t> m_localHits = 0;
+
+		/**
+		 * @brief Returns the providers in chain order.
+		 */
+		std::vector<LookupProvider *> getProviders() const;
+
+		/**
+		 * @brief Asks one provider over the network, recording how long it took.
+		 */
+		Callsign fetchFrom(std::size_t index, LookupProvider &provider, const std::string &call, LookupPriority priority,
+						   const std::shared_ptr<net::CancellationToken> &cancel);
+
+		/**
+		 * @brief Races the second provider against the first once the hedge delay has passed.
+		 *
+		 * @param firstError Set to the error of the first provider to fail, if neither had a record.
+		 * @return The record of whichever answered first, or nothing if both failed.
+		 *
+		 * @throws CancelledException If the lookup was cancelled.
+		 */
+		std::optional<Callsign> race(const std::vector<LookupProvider *> &providers, const std::string &call,
+									 LookupPriority priority, const std::shared_ptr<net::CancellationToken> &cancel,
+									 std::exception_ptr &firstError);
+
+		/**
+		 * @brief Records a lookup that ran to completion.
+		 */
+		void recordLatency(std::size_t index, std::chrono::milliseconds latency, bool failed);
+	};
+}
+
+#endif //QRZ_LOOKUPRESOLVER_H
@@ -0,0 +1,195 @@
+#include "LookupScheduler.h"
+
+#include <algorithm>
+
+using namespace qrz;
+
+LookupScheduler::LookupScheduler(std::size_t backgroundCapacity)
+		: m_backgroundCapacity(std::max<std::size_t>(backgroundCapacity, 1))
+{
+}
+
+bool LookupScheduler::submit(LookupPriority priority, Job run, Job drop, const std::string &key)
+{
+	return submit(priority, std::move(run), std::move(drop), key, Clock::now());
+}
+
+/**
+ * @brief Queues a job at the given time.
+ *
+ * A background job for a callsign that already has one waiting is dropped straight away, since the waiting job will
+ * fetch the same record. Otherwise, if the background queue is full, the oldest background job is dropped to make
+ * room.
+ *
+ * @param priority The priority of the job.
+ * @param run Does the work, called from runNext().
+ * @param drop Called instead of run if the job is dropped to relieve the background queue. May be null.
+ * @param key Identifies the callsign a background job is for, so it is not queued twice. May be empty.
+ * @param now The current time.
+ * @return False if the job was dropped straight away, in which case drop has been called.
+ */
+bool LookupScheduler::submit(LookupPriority priority, Job run, Job drop, const std::string &key, Clock::time_point now)
+{
+	std::deque<Entry> dropped;
+	bool merged = false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (priority == LookupPriority::BACKGROUND)
+		{
+			std::deque<Entry> &queue = m_queues[LookupPriority::BACKGROUND];
+
+			merged = !key.empty() && std::any_of(queue.begin(), queue.end(),
+					[&key](const Entry &entry) { return entry.key == key; });
+
+			if (merged)
+			{
+				m_stats.merged++;
+			}
+			else
+			{
+				dropped = trimBackground(1);
+			}
+		}
+
+		if (!merged)
+		{
+			m_queues[priority].push_back({std::move(run), drop, key, now});
+		}
+	}
+
+	for (Entry &entry : dropped)
+	{
+		if (entry.drop)
+		{
+			entry.drop();
+		}
+	}
+
+	if (merged)
+	{
+		if (drop)
+		{
+			drop();
+		}
+
+		return false;
+	}
+
+	return true;
+}
+
+bool LookupScheduler::runNext()
+{
+	return runNext(Clock::now());
+}
+
+/**
+ * @brief Runs the most urgent job waiting, at the given time.
+ *
+ * The time the job spent waiting is added to the statistics of its priority before it runs.
+ *
+ * @param now The current time.
+ * @return False if there was nothing to run.
+ */
+bool LookupScheduler::runNext(Clock::time_point now)
+{
+	Job run;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (std::size_t priority = 0; priority < m_queues.size(); priority++)
+		{
+			std::deque<Entry> &queue = m_queues[priority];
+
+			if (queue.empty())
+			{
+				continue;
+			}
+
+			Entry entry = std::move(queue.front());
+			queue.pop_front();
+
+			auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(now - entry.queuedAt);
+			waited = std::max(waited, std::chrono::milliseconds(0));
+
+			m_stats.started[priority]++;
+			m_stats.totalWait[priority] += waited;
+			m_stats.maxWait[priority] = std::max(m_stats.maxWait[priority], waited);
+
+			run = std::move(entry.run);
+			break;
+		}
+	}
+
+	if (!run)
+	{
+		return false;
+	}
+
+	run();
+
+	return true;
+}
+
+void LookupScheduler::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (std::deque<Entry> &queue : m_queues)
+	{
+		queue.clear();
+	}
+}
+
+void LookupScheduler::setBackgroundCapacity(std::size_t capacity)
+{
+	std::deque<Entry> dropped;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_backgroundCapacity = std::max<std::size_t>(capacity, 1);
+		dropped = trimBackground(0);
+	}
+
+	for (Entry &entry : dropped)
+	{
+		if (entry.drop)
+		{
+			entry.drop();
+		}
+	}
+}
+
+LookupSchedulerStats LookupScheduler::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	LookupSchedulerStats stats = m_stats;
+
+	for (std::size_t priority = 0; priority < m_queues.size(); priority++)
+	{
+		stats.queued[priority] = m_queues[priority].size();
+	}
+
+	return stats;
+}
+
+std::deque<LookupScheduler::Entry> LookupScheduler::trimBackground(std::size_t room)
+{
+	std::deque<Entry> dropped;
+	std::deque<Entry> &queue = m_queues[LookupPriority::BACKGROUND];
+
+	while (!queue.empty() && queue.size() + room > m_backgroundCapacity)
+	{
+		dropped.push_back(std::move(queue.front()));
+		queue.pop_front();
+
+		m_stats.shed++;
+	}
+
+	return dropped;
+}
@@ -0,0 +1,169 @@
+#ifndef QRZ_LOOKUPSCHEDULER_H
+#define QRZ_LOOKUPSCHEDULER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include "LookupPriority.h"
+
+namespace qrz
+{
+	/**
+	 * @brief Snapshot of the queue depths and wait times of a LookupScheduler.
+	 *
+	 * The arrays are indexed by LookupPriority.
+	 */
+	struct LookupSchedulerStats
+	{
+		// Jobs waiting to run
+		std::array<std::size_t, 3> queued{};
+
+		// Jobs started
+		std::array<std::uint64_t, 3> started{};
+
+		// Time the started jobs spent waiting, in total
+		std::array<std::chrono::milliseconds, 3> totalWait{};
+
+		// Longest time a started job spent waiting
+		std::array<std::chrono::milliseconds, 3> maxWait{};
+
+		// Background jobs dropped because the queue was full
+		std::uint64_t shed = 0;
+
+		// Background jobs dropped because a job for the same callsign was already waiting
+		std::uint64_t merged = 0;
+
+		/**
+		 * @brief Returns the average time a started job of the given priority spent waiting.
+		 */
+		std::chrono::milliseconds getAverageWait(LookupPriority priority) const
+		{
+			if (started[priority] == 0)
+			{
+				return std::chrono::milliseconds(0);
+			}
+
+			return totalWait[priority] / static_cast<std::chrono::milliseconds::rep>(started[priority]);
+		}
+	};
+
+	/**
+	 * @class LookupScheduler
+	 *
+	 * @brief Orders lookup jobs by priority, so interactive lookups never queue behind background traffic.
+	 *
+	 * Jobs are run one at a time, most urgent first: interactive lookups, then detail lookups such as bios, then
+	 * background lookups, each in the order they were submitted. A job that is already running is not interrupted, so
+	 * an interactive lookup waits for at most one other job.
+	 *
+	 * Only the background queue is bounded. A station heard again while its lookup is still waiting is not queued a
+	 * second time, and once the queue is full the oldest waiting background job is dropped to make room, since the
+	 * stations heard most recently are the ones most likely to be worked.
+	 *
+	 * The scheduler is safe to use from several threads at once. Jobs and their drop callbacks are never called with
+	 * the internal lock held.
+	 */
+	class LookupScheduler
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+		typedef std::function<void()> Job;
+
+		/**
+		 * @brief Constructs an empty scheduler.
+		 *
+		 * @param backgroundCapacity The number of background jobs that may wait at once.
+		 */
+		explicit LookupScheduler(std::size_t backgroundCapacity = 25);
+
+		/**
+		 * @brief Queues a job.
+		 *
+		 * @param priority The priority of the job.
+		 * @param run Does the work, called from runNext().
+		 * @param drop Called instead of run if the job is dropped to relieve the background queue. May be null.
+		 * @param key Identifies the callsign a background job is for, so it is not queued twice. May be empty.
+		 * @return False if the job was dropped straight away, in which case drop has been called.
+		 */
+		bool submit(LookupPriority priority, Job run, Job drop = nullptr, const std::string &key = "");
+
+		/**
+		 * @brief Queues a job at the given time.
+		 *
+		 * @see submit()
+		 */
+		bool submit(LookupPriority priority, Job run, Job drop, const std::string &key, Clock::time_point now);
+
+		/**
+		 * @brief Runs the most urgent job waiting, on the calling thread.
+		 *
+		 * @return False if there was nothing to run.
+		 */
+		bool runNext();
+
+		/**
+		 * @brief Runs the most urgent job waiting, at the given time.
+		 *
+		 * @see runNext()
+		 */
+		bool runNext(Clock::time_point now);
+
+		/**
+		 * @brief Drops every job still waiting, without calling their drop callbacks.
+		 */
+		void clear();
+
+		/**
+		 * @brief Sets the number of background jobs that may wait at once.
+		 *
+		 * Jobs already waiting beyond the new capacity are dropped, oldest first.
+		 *
+		 * @param capacity The capacity, at least one.
+		 */
+		void setBackgroundCapacity(std::size_t capacity);
+
+		/**
+		 * @brief Returns the queue depths and wait times.
+		 *
+		 * @return A snapshot of the scheduler statistics.
+		 */
+		LookupSchedulerStats getStats() const;
+
+	private:
+		/**
+		 * @brief A job waiting to run.
+		 */
+		struct Entry
+		{
+			Job run;
+			Job drop;
+			std::string key;
+			Clock::time_point queuedAt;
+		};
+
+		mutable std::mutex m_mutex;
+
+		// Waiting jobs, indexed by LookupPriority
+		std::array<std::deque<Entry>, 3> m_queues;
+
+		std::size_t m_backgroundCapacity;
+
+		LookupSchedulerStats m_stats;
+
+		/**
+		 * @brief Takes the oldest background jobs off the queue until it fits the capacity. Must be called with the
+		 *        mutex held.
+		 *
+		 * @param room The number of places to leave free for jobs about to be queued.
+		 * @return The jobs taken off, to be dropped once the mutex is released.
+		 */
+		std::deque<Entry> trimBackground(std::size_t room);
+	};
+}
+
+#endif //QRZ_LOOKUPSCHEDULER_H
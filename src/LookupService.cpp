@@ -0,0 +1,484 @@
+#include "LookupService.h"
+
+#include <atomic>
+#include <format>
+#include <iostream>
+#include <sstream>
+
+#include "BatchLookupEngine.h"
+#include "CallsignCanonicalizer.h"
+#include "exception/CancelledException.h"
+
+using namespace qrz;
+
+LookupService::LookupService(QRZClient &client, CallsignLookup lookup, int maxFailedCallCount)
+		: m_client(client), m_lookup(std::move(lookup)), m_maxFailedCallCount(maxFailedCallCount)
+{
+}
+
+/**
+ * @brief Fetches the callsign records for the given callsigns, blocking the calling thread until all are done.
+ *
+ * The API calls are spread over a bounded number of worker threads by a BatchLookupEngine, and the results are
+ * returned in the same order as the callsigns. Authentication errors are retried after refreshing the token, and the
+ * refresh is shared by all workers, so a batch that runs into an expired session only logs in once.
+ *
+ * Background lookups held back to save quota, and cancelled lookups, are not reported as errors, they are simply
+ * skipped. Lookups refused because QRZ is unreachable are reported once per batch, and only for interactive lookups,
+ * so a stream of JS8Call decodes during an outage does not turn into a stream of error dialogs. Each of them is
+ * reported through lookupUnavailable, so it can be made again once QRZ is back.
+ *
+ * @param terms The callsigns to look up.
+ * @param priority The priority of the lookups.
+ * @param credentials The account to log in with if the session has expired.
+ * @param workers The maximum number of lookups to run at once.
+ * @param onFound Called with each record as soon as it has been fetched, or with null for a lookup that failed, along
+ *        with the number of callsigns done so far. May be null.
+ * @return The records fetched, in the same order as the callsigns.
+ */
+std::vector<Callsign> LookupService::fetchCallsignRecords(const std::vector<std::string> &terms, LookupPriority priority,
+														  const LookupCredentials &credentials, int workers,
+														  const std::function<void(const Callsign *callsign, int done)> &onFound)
+{
+	std::vector<Callsign> callsigns;
+
+	// Error buffer, we will report the errors after all API calls have been made
+	std::vector<std::string> errors;
+
+	bool credentialsMissing = false;
+	bool unavailableReported = false;
+
+	BatchLookupEngine<Callsign> engine(
+			[this, priority](const std::string &call)
+			{
+				return m_lookup(call, priority);
+			},
+			[this, &credentials, &credentialsMissing]()
+			{
+				if (credentials.username.empty() || credentials.password.empty())
+				{
+					credentialsMissing = true;
+					return false;
+				}
+
+				m_client.setUsername(credentials.username);
+				m_client.setPassword(credentials.password);
+				m_client.fetchToken();
+
+				return true;
+			},
+			workers,
+			m_maxFailedCallCount);
+
+	std::atomic<int> done = 0;
+
+	if (onFound)
+	{
+		engine.setOutcomeCallback([&onFound, &done](const BatchLookupEngine<Callsign>::Outcome &outcome)
+		{
+			onFound(outcome.result.has_value() ? &outcome.result.value() : nullptr, ++done);
+		});
+	}
+
+	for (auto &outcome : engine.run(terms))
+	{
+		if (outcome.result.has_value())
+		{
+			callsigns.push_back(outcome.result.value());
+		}
+		else if (outcome.deferred || outcome.cancelled)
+		{
+			std::cerr << outcome.term << ": " << outcome.error << std::endl;
+		}
+		else if (outcome.unavailable)
+		{
+			emit lookupUnavailable(outcome.term);
+
+			if (priority == LookupPriority::BACKGROUND)
+			{
+				std::cerr << outcome.term << ": " << outcome.error << std::endl;
+			}
+			else if (!unavailableReported)
+			{
+				errors.push_back(outcome.error);
+				unavailableReported = true;
+			}
+		}
+		else
+		{
+			errors.push_back(outcome.error);
+		}
+	}
+
+	if (credentialsMissing)
+	{
+		emit credentialsNeeded();
+	}
+
+	if (!errors.empty())
+	{
+		std::ostringstream msg;
+		for (const std::string &error : errors)
+		{
+			msg << error << "\n\n";
+		}
+
+		emit lookupFailed(msg.str());
+	}
+
+	return callsigns;
+}
+
+/**
+ * @brief Schedules a batch of callsign lookups to run on the thread of the service.
+ *
+ * A background batch for a single callsign is keyed by that callsign, so a station heard again while its lookup is
+ * still waiting is not looked up twice.
+ *
+ * @param requestId Identifies the batch in the signals.
+ * @param terms The callsigns to look up.
+ * @param priority The priority of the lookups.
+ * @param credentials The account to log in with if the session has expired.
+ * @param workers The maximum number of lookups to run at once.
+ */
+void LookupService::queueCallsigns(quint64 requestId, const std::vector<std::string> &terms, LookupPriority priority,
+								   const LookupCredentials &credentials, int workers)
+{
+	std::string key = (terms.size() == 1) ? CallsignCanonicalizer::canonicalize(terms.front()) : "";
+
+	m_scheduler.submit(priority,
+			[this, requestId, terms, priority, credentials, workers]()
+			{
+				lookupCallsigns(requestId, terms, priority, credentials, workers);
+			},
+			[this, requestId, key]()
+			{
+				std::cerr << "Background lookup dropped: " << key << std::endl;
+
+				emit lookupsFinished(requestId, 0);
+			},
+			key);
+
+	schedule();
+}
+
+/**
+ * @brief Schedules a bio download to run on the thread of the service, after any interactive lookups.
+ *
+ * @param call The callsign.
+ * @param cancel Cancels the download. May be null.
+ */
+void LookupService::queueBio(const std::string &call, const std::shared_ptr<net::CancellationToken> &cancel)
+{
+	m_scheduler.submit(LookupPriority::DETAIL, [this, call, cancel]() { fetchBio(call, cancel); });
+
+	schedule();
+}
+
+/**
+ * @brief Schedules a check of a record against QRZ, at background priority.
+ *
+ * The check is keyed by the callsign, so it is merged with a background lookup of the same station already waiting.
+ *
+ * @param call The callsign.
+ * @param credentials The account to log in with if the session has expired.
+ */
+void LookupService::queueRefresh(const std::string &call, const LookupCredentials &credentials)
+{
+	m_scheduler.submit(LookupPriority::BACKGROUND,
+			[this, call, credentials]() { refreshCallsign(call, credentials); },
+			nullptr,
+			CallsignCanonicalizer::canonicalize(call));
+
+	schedule();
+}
+
+/**
+ * @brief Schedules records to be fetched into the caches ahead of need, at background priority.
+ *
+ * Each callsign is a job of its own, keyed by the callsign, so a station already waiting to be looked up is not
+ * fetched twice.
+ *
+ * @param calls The callsigns, most wanted first.
+ * @param credentials The account to log in with if the session has expired.
+ */
+void LookupService::queuePrefetch(const std::vector<std::string> &calls, const LookupCredentials &credentials)
+{
+	for (const std::string &call : calls)
+	{
+		m_scheduler.submit(LookupPriority::BACKGROUND,
+				[this, call, credentials]() { prefetchCallsign(call, credentials); },
+				nullptr,
+				CallsignCanonicalizer::canonicalize(call));
+
+		schedule();
+	}
+}
+
+/**
+ * @brief Schedules a connection to QRZ to be opened ahead of a lookup the user is about to make.
+ */
+void LookupService::queuePrewarm()
+{
+	m_scheduler.submit(LookupPriority::INTERACTIVE, [this]() { m_client.prewarmConnection(); });
+
+	schedule();
+}
+
+/**
+ * @brief Schedules a lookup of a callsign the user is still typing, ahead of it being asked for.
+ *
+ * @param call The callsign.
+ * @param cancel Cancels the lookup once the user has typed something else. May be null.
+ * @param credentials The account to log in with if the session has expired.
+ */
+void LookupService::queueSpeculative(const std::string &call, const std::shared_ptr<net::CancellationToken> &cancel,
+									 const LookupCredentials &credentials)
+{
+	m_scheduler.submit(LookupPriority::DETAIL,
+			[this, call, cancel, credentials]() { fetchSpeculative(call, cancel, credentials); });
+
+	schedule();
+}
+
+/**
+ * @brief Sets the number of background batches that may wait at once.
+ *
+ * @param depth The queue depth.
+ */
+void LookupService::setBackgroundQueueDepth(std::size_t depth)
+{
+	m_scheduler.setBackgroundCapacity(depth);
+}
+
+/**
+ * @brief Returns the depths and wait times of the queue of scheduled work.
+ *
+ * @return The scheduler statistics.
+ */
+LookupSchedulerStats LookupService::getQueueStats() const
+{
+	return m_scheduler.getStats();
+}
+
+/**
+ * @brief Asks the thread of the service to run the most urgent job waiting.
+ *
+ * One run is posted for every job submitted. Each takes whatever is most urgent when it gets its turn, rather than
+ * the job it was posted for, and finds nothing to do if that job was dropped.
+ */
+void LookupService::schedule()
+{
+	QMetaObject::invokeMethod(this, [this]() { m_scheduler.runNext(); }, Qt::QueuedConnection);
+}
+
+/**
+ * @brief Looks up a batch of callsigns, reporting each record as it arrives.
+ *
+ * An expired session is renewed before any lookup is made, rather than letting every worker run into it. If that
+ * fails the batch is abandoned and the reason reported.
+ *
+ * @param requestId Identifies the batch in the signals.
+ * @param terms The callsigns to look up.
+ * @param priority The priority of the lookups.
+ * @param credentials The account to log in with if the session has expired.
+ * @param workers The maximum number of lookups to run at once.
+ */
+void LookupService::lookupCallsigns(quint64 requestId, const std::vector<std::string> &terms, LookupPriority priority,
+									const LookupCredentials &credentials, int workers)
+{
+	int total = static_cast<int>(terms.size());
+
+	try
+	{
+		if (!m_client.tokenIsValid() && !login(credentials))
+		{
+			emit lookupsFinished(requestId, 0);
+			return;
+		}
+	}
+	catch (std::exception &e)
+	{
+		emit lookupFailed(std::format("Unable to log in to QRZ: {:s}", e.what()));
+		emit lookupsFinished(requestId, 0);
+		return;
+	}
+
+	// Runs on the lookup workers, the signals are queued to the receivers
+	std::vector<Callsign> callsigns = fetchCallsignRecords(terms, priority, credentials, workers,
+			[this, requestId, total](const Callsign *callsign, int done)
+			{
+				if (callsign != nullptr)
+				{
+					emit callsignFound(requestId, *callsign);
+				}
+
+				emit progress(requestId, done, total);
+			});
+
+	emit lookupsFinished(requestId, static_cast<int>(callsigns.size()));
+}
+
+/**
+ * @brief Downloads the bio of a callsign, emitting bioFetched once it is here.
+ *
+ * A cancelled download is dropped silently, since whoever asked for it is no longer waiting. Any other failure is
+ * reported through lookupFailed.
+ *
+ * @param call The callsign.
+ * @param cancel Cancels the download. May be null.
+ */
+void LookupService::fetchBio(const std::string &call, const std::shared_ptr<net::CancellationToken> &cancel)
+{
+	try
+	{
+		std::string bio = m_client.fetchBio(call, "", cancel);
+
+		emit bioFetched(call, bio);
+	}
+	catch (CancelledException &)
+	{
+		// The dialog was closed, nobody is waiting for the bio any more
+	}
+	catch (std::exception &e)
+	{
+		emit lookupFailed(e.what());
+	}
+}
+
+/**
+ * @brief Fetches the current record of a callsign from QRZ, emitting callsignRefreshed once it is here.
+ *
+ * Nobody is waiting on the check, so nothing here ends up in front of the user. Failures are logged, and an expired
+ * session without an account to renew it with skips the check rather than asking for credentials.
+ *
+ * @param call The callsign.
+ * @param credentials The account to log in with if the session has expired.
+ */
+void LookupService::refreshCallsign(const std::string &call, const LookupCredentials &credentials)
+{
+	try
+	{
+		if (!ensureSessionQuietly(credentials))
+		{
+			return;
+		}
+
+		emit callsignRefreshed(m_client.refreshCallsign(call, LookupPriority::BACKGROUND));
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << call << ": " << e.what() << std::endl;
+	}
+}
+
+/**
+ * @brief Fetches the record of a callsign into the caches, so a later lookup of it is answered locally.
+ *
+ * The lookup goes through the client like any other, so a record that is already cached costs no request and one
+ * QRZ does not have is remembered as not found. Nobody is waiting on the record, so failures are only logged.
+ *
+ * @param call The callsign.
+ * @param credentials The account to log in with if the session has expired.
+ */
+void LookupService::prefetchCallsign(const std::string &call, const LookupCredentials &credentials)
+{
+	try
+	{
+		if (!ensureSessionQuietly(credentials))
+		{
+			return;
+		}
+
+		m_client.fetchCallsign(call, LookupPriority::BACKGROUND);
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << call << ": " << e.what() << std::endl;
+	}
+}
+
+/**
+ * @brief Looks up a callsign the user is still typing, emitting speculativeFetched once the record is here.
+ *
+ * A lookup cancelled while it waited in the queue is skipped without touching the network. The record lands in the
+ * caches like any other, so even if it arrives after the user pressed Enter, the lookup that follows is answered
+ * from memory.
+ *
+ * @param call The callsign.
+ * @param cancel Cancels the lookup once the user has typed something else. May be null.
+ * @param credentials The account to log in with if the session has expired.
+ */
+void LookupService::fetchSpeculative(const std::string &call, const std::shared_ptr<net::CancellationToken> &cancel,
+									 const LookupCredentials &credentials)
+{
+	if (cancel && cancel->isCancelled())
+	{
+		return;
+	}
+
+	try
+	{
+		if (!ensureSessionQuietly(credentials))
+		{
+			return;
+		}
+
+		emit speculativeFetched(call, m_client.fetchCallsign(call, LookupPriority::BACKGROUND, cancel));
+	}
+	catch (CancelledException &)
+	{
+		// The user typed something else
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << call << ": " << e.what() << std::endl;
+	}
+}
+
+/**
+ * @brief Renews an expired session for work nobody is waiting on, without asking for credentials.
+ *
+ * @param credentials The account to log in with.
+ * @return True if there is a valid session. False if it has expired and there is no account to renew it with.
+ *
+ * @throws std::exception If QRZ could not be reached or refused the login.
+ */
+bool LookupService::ensureSessionQuietly(const LookupCredentials &credentials)
+{
+	if (m_client.tokenIsValid())
+	{
+		return true;
+	}
+
+	if (credentials.username.empty() || credentials.password.empty())
+	{
+		return false;
+	}
+
+	return login(credentials);
+}
+
+/**
+ * @brief Logs in with the given account.
+ *
+ * @param credentials The account.
+ * @return True if a session was started. False if there is no account, in which case credentialsNeeded has been
+ *         emitted.
+ *
+ * @throws std::exception If QRZ could not be reached or refused the login.
+ */
+bool LookupService::login(const LookupCredentials &credentials)
+{
+	if (credentials.username.empty() || credentials.password.empty())
+	{
+		emit credentialsNeeded();
+		return false;
+	}
+
+	m_client.setUsername(credentials.username);
+	m_client.setPassword(credentials.password);
+	m_client.fetchToken();
+
+	return true;
+}
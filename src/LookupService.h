@@ -0,0 +1,292 @@
+#ifndef QRZ_LOOKUPSERVICE_H
+#define QRZ_LOOKUPSERVICE_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <QObject>
+
+#include "LookupPriority.h"
+#include "LookupScheduler.h"
+#include "QRZClient.h"
+#include "model/Callsign.h"
+#include "net/CancellationToken.h"
+
+namespace qrz
+{
+	/**
+	 * @brief The account a lookup may log in with, read from the configuration before the lookup is handed over.
+	 */
+	struct LookupCredentials
+	{
+		std::string username;
+		std::string password;
+	};
+
+	/**
+	 * @class LookupService
+	 *
+	 * @brief Runs QRZ lookups with the blocking client away from the GUI thread.
+	 *
+	 * The service is meant to be moved to a thread of its own, and its slots invoked through queued calls. Everything
+	 * that waits on the network happens there: logging in when the session has expired, the lookups themselves, which
+	 * are spread over the configured number of workers, and bio downloads. Results, progress and errors are reported
+	 * through signals, which reach receivers on the GUI thread as queued calls, so the table and the map are only ever
+	 * touched from there.
+	 *
+	 * Work handed over with queueCallsigns(), queueBio(), queueRefresh() and queuePrefetch() goes through a
+	 * LookupScheduler, so it is done most urgent first rather than in the order it arrived, and a flood of stations
+	 * heard by JS8Call cannot hold up a lookup the user typed in.
+	 *
+	 * The service reads nothing from the configuration, since that belongs to the GUI thread. Whatever a lookup needs
+	 * from it is passed along with the request.
+	 */
+	class LookupService : public QObject
+	{
+		Q_OBJECT
+
+	public:
+		typedef std::function<Callsign(const std::string &call, LookupPriority priority)> CallsignLookup;
+
+		/**
+		 * @brief Constructs a LookupService.
+		 *
+		 * @param client The client to look records up with. Has to outlive the service, and is shared with the GUI
+		 *        thread, which only reads its state.
+		 * @param lookup Looks up a single callsign. It is called concurrently from the lookup workers.
+		 * @param maxFailedCallCount The maximum number of consecutive authentication failures before giving up.
+		 */
+		LookupService(QRZClient &client, CallsignLookup lookup, int maxFailedCallCount);
+
+		/**
+		 * @brief Fetches the callsign records for the given callsigns, blocking the calling thread until all are done.
+		 *
+		 * Errors are collected and reported once for the whole batch through lookupFailed, in the same way
+		 * AppController has always reported them.
+		 *
+		 * @param terms The callsigns to look up.
+		 * @param priority The priority of the lookups.
+		 * @param credentials The account to log in with if the session has expired.
+		 * @param workers The maximum number of lookups to run at once.
+		 * @param onFound Called with each record as soon as it has been fetched, or with null for a lookup that
+		 *        failed, along with the number of callsigns done so far. It is called from the worker that made the
+		 *        lookup. May be null.
+		 * @return The records fetched, in the same order as the callsigns.
+		 */
+		std::vector<Callsign> fetchCallsignRecords(const std::vector<std::string> &terms, LookupPriority priority,
+												   const LookupCredentials &credentials, int workers,
+												   const std::function<void(const Callsign *callsign, int done)> &onFound = nullptr);
+
+		/**
+		 * @brief Schedules a batch of callsign lookups to run on the thread of the service.
+		 *
+		 * May be called from any thread. The batch runs as lookupCallsigns() once everything more urgent is done. A
+		 * background batch dropped to relieve the queue is reported through lookupsFinished without any records.
+		 *
+		 * @see lookupCallsigns()
+		 */
+		void queueCallsigns(quint64 requestId, const std::vector<std::string> &terms, LookupPriority priority,
+							const LookupCredentials &credentials, int workers);
+
+		/**
+		 * @brief Schedules a bio download to run on the thread of the service, after any interactive lookups.
+		 *
+		 * May be called from any thread.
+		 *
+		 * @see fetchBio()
+		 */
+		void queueBio(const std::string &call, const std::shared_ptr<net::CancellationToken> &cancel);
+
+		/**
+		 * @brief Schedules a check of a record against QRZ, at background priority.
+		 *
+		 * May be called from any thread. A check dropped to relieve the queue is simply lost.
+		 *
+		 * @see refreshCallsign()
+		 */
+		void queueRefresh(const std::string &call, const LookupCredentials &credentials);
+
+		/**
+		 * @brief Schedules records to be fetched into the caches ahead of need, at background priority.
+		 *
+		 * May be called from any thread. Prefetches dropped to relieve the queue are simply lost.
+		 *
+		 * @see prefetchCallsign()
+		 */
+		void queuePrefetch(const std::vector<std::string> &calls, const LookupCredentials &credentials);
+
+		/**
+		 * @brief Schedules a connection to QRZ to be opened ahead of a lookup the user is about to make.
+		 *
+		 * May be called from any thread. Runs with the interactive lookups, since one is expected shortly.
+		 */
+		void queuePrewarm();
+
+		/**
+		 * @brief Schedules a lookup of a callsign the user is still typing, ahead of it being asked for.
+		 *
+		 * May be called from any thread. Runs after interactive lookups but before background ones.
+		 *
+		 * @see fetchSpeculative()
+		 */
+		void queueSpeculative(const std::string &call, const std::shared_ptr<net::CancellationToken> &cancel,
+							  const LookupCredentials &credentials);
+
+		/**
+		 * @brief Sets the number of background batches that may wait at once.
+		 *
+		 * @param depth The queue depth.
+		 */
+		void setBackgroundQueueDepth(std::size_t depth);
+
+		/**
+		 * @brief Returns the depths and wait times of the queue of scheduled work.
+		 *
+		 * @return The scheduler statistics.
+		 */
+		LookupSchedulerStats getQueueStats() const;
+
+	public slots:
+		/**
+		 * @brief Looks up a batch of callsigns, reporting each record as it arrives.
+		 *
+		 * The session is renewed first if it has expired. callsignFound and progress are emitted as the lookups finish,
+		 * and lookupsFinished once the whole batch is done, whether or not anything was found.
+		 *
+		 * @param requestId Identifies the batch in the signals.
+		 * @param terms The callsigns to look up.
+		 * @param priority The priority of the lookups.
+		 * @param credentials The account to log in with if the session has expired.
+		 * @param workers The maximum number of lookups to run at once.
+		 */
+		void lookupCallsigns(quint64 requestId, const std::vector<std::string> &terms, LookupPriority priority,
+							 const LookupCredentials &credentials, int workers);
+
+		/**
+		 * @brief Downloads the bio of a callsign, emitting bioFetched once it is here.
+		 *
+		 * Nothing is emitted if the download was cancelled.
+		 *
+		 * @param call The callsign.
+		 * @param cancel Cancels the download. May be null.
+		 */
+		void fetchBio(const std::string &call, const std::shared_ptr<net::CancellationToken> &cancel);
+
+		/**
+		 * @brief Fetches the current record of a callsign from QRZ, emitting callsignRefreshed once it is here.
+		 *
+		 * The check is made in the background, so failures are only logged, and an expired session is only renewed if
+		 * there is an account to log in with.
+		 *
+		 * @param call The callsign.
+		 * @param credentials The account to log in with if the session has expired.
+		 */
+		void refreshCallsign(const std::string &call, const LookupCredentials &credentials);
+
+		/**
+		 * @brief Fetches the record of a callsign into the caches, so a later lookup of it is answered locally.
+		 *
+		 * Nothing is emitted, and failures are only logged. A record already cached costs no request.
+		 *
+		 * @param call The callsign.
+		 * @param credentials The account to log in with if the session has expired.
+		 */
+		void prefetchCallsign(const std::string &call, const LookupCredentials &credentials);
+
+		/**
+		 * @brief Looks up a callsign the user is still typing, emitting speculativeFetched once the record is here.
+		 *
+		 * The lookup counts as a background lookup against the quota, since the user may never ask for it. Nothing is
+		 * emitted if it was cancelled or failed.
+		 *
+		 * @param call The callsign.
+		 * @param cancel Cancels the lookup once the user has typed something else. May be null.
+		 * @param credentials The account to log in with if the session has expired.
+		 */
+		void fetchSpeculative(const std::string &call, const std::shared_ptr<net::CancellationToken> &cancel,
+							  const LookupCredentials &credentials);
+
+	signals:
+		/**
+		 * @brief Emitted for each record fetched by lookupCallsigns().
+		 */
+		void callsignFound(quint64 requestId, const qrz::Callsign &callsign);
+
+		/**
+		 * @brief Emitted each time a lookup of a batch has finished, successfully or not.
+		 */
+		void progress(quint64 requestId, int done, int total);
+
+		/**
+		 * @brief Emitted once a batch started by lookupCallsigns() is done.
+		 */
+		void lookupsFinished(quint64 requestId, int found);
+
+		/**
+		 * @brief Emitted with the errors of a batch, or of a bio download, that the user should see.
+		 */
+		void lookupFailed(const std::string &msg);
+
+		/**
+		 * @brief Emitted for each lookup of a batch refused because QRZ is unreachable, so it can be made later.
+		 */
+		void lookupUnavailable(const std::string &call);
+
+		/**
+		 * @brief Emitted when the session expired and there is no account to log in with.
+		 */
+		void credentialsNeeded();
+
+		/**
+		 * @brief Emitted with the bio of a callsign fetched by fetchBio().
+		 */
+		void bioFetched(const std::string &call, const std::string &html);
+
+		/**
+		 * @brief Emitted with the record fetched by refreshCallsign().
+		 */
+		void callsignRefreshed(const qrz::Callsign &callsign);
+
+		/**
+		 * @brief Emitted with the record fetched by fetchSpeculative().
+		 */
+		void speculativeFetched(const std::string &call, const qrz::Callsign &callsign);
+
+	private:
+		// The client whose session and caches are used, shared with the GUI thread
+		QRZClient &m_client;
+
+		// Looks up a single callsign
+		CallsignLookup m_lookup;
+
+		// Maximum number of consecutive authentication failures before a batch gives up
+		int m_maxFailedCallCount;
+
+		// Orders the scheduled work by priority
+		LookupScheduler m_scheduler;
+
+		/**
+		 * @brief Asks the thread of the service to run the most urgent job waiting.
+		 */
+		void schedule();
+
+		/**
+		 * @brief Renews an expired session for work nobody is waiting on, without asking for credentials.
+		 *
+		 * @return False if the session has expired and there is no account to renew it with.
+		 */
+		bool ensureSessionQuietly(const LookupCredentials &credentials);
+
+		/**
+		 * @brief Logs in with the given account.
+		 *
+		 * @return True if a session was started. False if there is no account, in which case credentialsNeeded has
+		 *         been emitted.
+		 */
+		bool login(const LookupCredentials &credentials);
+	};
+}
+
+#endif //QRZ_LOOKUPSERVICE_H
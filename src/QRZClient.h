@@ -2,15 +2,21 @@
 #define QRZ_QRZCLIENT_H
 
 #include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 
 #include <Poco/DateTimeFormatter.h>
 #include <Poco/DateTimeParser.h>
 #include <Poco/Exception.h>
+#include <Poco/InflatingStream.h>
 #include <Poco/LocalDateTime.h>
-#include <Poco/StreamCopier.h>
+#include <Poco/String.h>
 #include <Poco/URI.h>
 #include <Poco/DOM/Document.h>
 #include <Poco/DOM/DOMParser.h>
@@ -25,12 +31,35 @@
 #include <Poco/Net/SSLManager.h>
 #include <Poco/SAX/SAXException.h>
 
+#include "CallsignCanonicalizer.h"
+#include "Configuration.h"
+#include "LookupPriority.h"
+#include "LookupProvider.h"
+#include "SingleFlight.h"
+#include "cache/AliasIndex.h"
+#include "cache/BioCache.h"
+#include "cache/CallsignCache.h"
+#include "cache/LruCache.h"
 #include "exception/AuthenticationException.h"
+#include "exception/CancelledException.h"
+#include "exception/CircuitOpenException.h"
 #include "model/Callsign.h"
-#include "model/CallsignMarshaler.h"
 #include "model/DXCC.h"
-#include "model/DXCCMarshaler.h"
+#include "model/QrzXmlDecoder.h"
 #include "exception/NotFoundException.h"
+#include "exception/RateLimitException.h"
+#include "exception/TimeoutException.h"
+#include "exception/TransportException.h"
+#include "model/QuotaStatus.h"
+#include "net/CancellationToken.h"
+#include "net/CircuitBreaker.h"
+#include "net/HTTPSessionPool.h"
+#include "net/QuotaRateLimiter.h"
+#include "net/RequestDeadlines.h"
+#include "net/RetryPolicy.h"
+#include "net/SharedTLSContext.h"
+#include "net/TrafficArchive.h"
+#include "net/TransferCounter.h"
 
 namespace qrz
 {
@@ -80,7 +109,7 @@ namespace qrz
 	 * The QRZClient class provides methods for fetching callsign information, biography information, and DXCC information for a given query.
 	 * It also provides a method for fetching a session token for authentication with the API.
 	 */
-	class QRZClient
+	class QRZClient : public LookupProvider
 	{
 	public:
 		QRZClient() = default;
@@ -99,6 +128,15 @@ namespace qrz
 			setPassword(config.getPassword());
 			setSessionKey(config.getSessionKey());
 			setSessionExpiration(config.getSessionExpiration());
+			setDailyLookupLimit(config.getDailyLookupLimit());
+			setBackgroundLookupRate(config.getBackgroundLookupRate());
+			setRequestDeadlines({std::chrono::seconds(config.getConnectTimeout()), std::chrono::seconds(config.getReadTimeout()),
+								 std::chrono::seconds(config.getRequestTimeout())});
+			setRetryPolicy({config.getRetryAttempts()});
+			m_circuitBreaker->setFailureThreshold(config.getBreakerFailureThreshold());
+			m_circuitBreaker->setOpenDuration(std::chrono::seconds(config.getBreakerOpenTime()));
+			setMemoryCacheLimits(config.getMemoryCacheSize(), std::chrono::hours(config.getCallsignCacheTtl()),
+								 std::chrono::minutes(config.getNotFoundTtl()));
 		}
 
 		/**
@@ -121,15 +159,71 @@ namespace qrz
 			setSessionExpiration(sessionExpiration);
 		}
 
+		/**
+		 * @brief Constructs a QRZClient object with the same settings and session state as another client.
+		 *
+		 * The new client shares the other client's connection pool, rate limiter, caches and in-flight lookups.
+		 *
+		 * @param other The client to copy.
+		 */
+		QRZClient(const QRZClient &other)
+		{
+			*this = other;
+		}
+
+		/**
+		 * @brief Copies the settings and session state of another client.
+		 *
+		 * @param other The client to copy.
+		 * @return A reference to this client.
+		 */
+		QRZClient &operator=(const QRZClient &other)
+		{
+			if (this == &other)
+			{
+				return *this;
+			}
+
+			std::scoped_lock lock(m_stateMutex, other.m_stateMutex);
+
+			m_username = other.m_username;
+			m_password = other.m_password;
+			m_baseUrl = other.m_baseUrl;
+			m_sessionPool = other.m_sessionPool;
+			m_sessionKey = other.m_sessionKey;
+			m_sessionTimestamp = other.m_sessionTimestamp;
+			m_rateLimiter = other.m_rateLimiter;
+			m_quota = other.m_quota;
+			m_deadlines = other.m_deadlines;
+			m_retryPolicy = other.m_retryPolicy;
+			m_circuitBreaker = other.m_circuitBreaker;
+			m_transferCounter = other.m_transferCounter;
+			m_callsignFlights = other.m_callsignFlights;
+			m_tokenFlights = other.m_tokenFlights;
+			m_callsignCache = other.m_callsignCache;
+			m_recordCache = other.m_recordCache;
+			m_notFoundCache = other.m_notFoundCache;
+			m_aliasIndex = other.m_aliasIndex;
+			m_bioCache = other.m_bioCache;
+			m_trafficArchive = other.m_trafficArchive;
+
+			return *this;
+		}
+
+		virtual ~QRZClient() = default;
+
 		/**
 		 * @brief Get the username currently used for authentication with the QRZ API.
 		 *
 		 * This method returns the username that is currently used for authentication with the QRZ API.
 		 *
-		 * @return A constant reference to a string representing the username.
+		 * A copy is returned, since the username may be changed by another thread at any time.
+		 *
+		 * @return A string representing the username.
 		 */
-		const std::string &getUsername() const
+		std::string getUsername() const
 		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
 			return m_username;
 		}
 
@@ -143,6 +237,7 @@ namespace qrz
 		*/
 		void setUsername(const std::string &username)
 		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
 			m_username = username;
 		}
 
@@ -151,10 +246,13 @@ namespace qrz
 		 *
 		 * This method returns the password that is currently used for authentication with the QRZ API.
 		 *
-		 * @return A constant reference to a string representing the password.
+		 * A copy is returned, since the password may be changed by another thread at any time.
+		 *
+		 * @return A string representing the password.
 		 */
-		const std::string &getPassword() const
+		std::string getPassword() const
 		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
 			return m_password;
 		}
 
@@ -168,18 +266,32 @@ namespace qrz
 		 */
 		void setPassword(const std::string &password)
 		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
 			m_password = password;
 		}
 
+		/**
+		 * @brief Whether both a username and a password are set, so a token can be requested.
+		 *
+		 * @return True if credentials are set.
+		 */
+		bool hasCredentials() const
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			return !m_username.empty() && !m_password.empty();
+		}
+
 		/**
 		 * @brief Get the session key currently used for authentication with the QRZ API.
 		 *
 		 * This method returns the session key that is currently used for authentication with the QRZ API.
+		 * A copy is returned, since the key may be replaced by another thread at any time.
 		 *
-		 * @return A constant reference to a string representing the session key.
+		 * @return A string representing the session key.
 		 */
-		const std::string &getSessionKey() const
+		std::string getSessionKey() const
 		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
 			return m_sessionKey;
 		}
 
@@ -193,6 +305,7 @@ namespace qrz
 		 */
 		void setSessionKey(const std::string &sessionKey)
 		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
 			m_sessionKey = sessionKey;
 		}
 
@@ -205,10 +318,24 @@ namespace qrz
 		 */
 		const std::string getSessionExpiration() const
 		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
 			Poco::DateTime dt(m_sessionTimestamp);
 			return Poco::DateTimeFormatter::format(dt, m_timeFormat);
 		}
 
+		/**
+		 * @brief Get how long the session token remains valid.
+		 *
+		 * @return The time until the session expires, zero or negative if it already has.
+		 */
+		std::chrono::milliseconds getTokenTimeRemaining() const
+		{
+			Poco::Timestamp now;
+
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			return std::chrono::milliseconds((m_sessionTimestamp - now) / 1000);
+		}
+
 		/**
 		 * @brief Sets the session expiration date and time based on the provided sessionExpiration.
 		 *
@@ -228,379 +355,1599 @@ namespace qrz
 			int tzd = 0;
 			Poco::DateTime dt;
 			Poco::DateTimeParser::parse(m_timeFormat, sessionExpiration, dt, tzd);
+
+			std::lock_guard<std::mutex> lock(m_stateMutex);
 			m_sessionTimestamp = dt.timestamp();
 		}
 
 		/**
-		 * @brief Sends a request to the QRZ API and returns the response.
+		 * @brief Get the base URL of the QRZ API.
 		 *
-		 * This method sends a request to the QRZ API with the specified URI and returns the response as a QrzResponse
-		 * object.
+		 * A copy is returned, since the client may be pointed elsewhere by another thread at any time.
 		 *
-		 * @param uri The URI of the API endpoint to send the request to.
-		 * @return A QrzResponse object containing the HTTP response and body.
+		 * @return A string representing the base URL.
 		 */
-		virtual QrzResponse sendRequest(Poco::URI &uri)
+		std::string getBaseUrl() const
 		{
-			std::string path = Poco::format("/xml/%s/", m_apiVersion);
-			uri.setPath(path);
-			uri.addQueryParameter("agent", m_userAgent);
-
-			// Create a session
-			const Poco::Net::Context::Ptr ptrContext = new Poco::Net::Context(Poco::Net::Context::CLIENT_USE, "", "", "", Poco::Net::Context::VERIFY_NONE, 9, false, "ALL:!ADH:!LOW:!EXP:!MD5:@STRENGTH");
-			Poco::Net::HTTPSClientSession session(uri.getHost(), uri.getPort(), ptrContext);
-
-			// Prepare a GET request
-			Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, uri.toString());
-
-			// Send Request
-			session.sendRequest(request);
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			return m_baseUrl;
+		}
 
-			// Get the response
-			Poco::Net::HTTPResponse response;
+		/**
+		 * @brief Sets the base URL of the QRZ API.
+		 *
+		 * This method points the client at a different server, such as a local stand-in used for testing.
+		 * Any pooled connections to the previous server are dropped.
+		 *
+		 * @param baseUrl A constant reference to a string representing the scheme, host and port of the API server.
+		 */
+		void setBaseUrl(const std::string &baseUrl)
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			m_baseUrl = baseUrl;
+			m_sessionPool.reset();
+		}
 
-			std::istream& rs = session.receiveResponse(response);
-			std::string body;
-			Poco::StreamCopier::copyToString(rs, body);
+		/**
+		 * @brief Returns the pool of keep-alive sessions used to talk to the QRZ API.
+		 *
+		 * The pool is created on first use for the current base URL. Changing the base URL replaces the pool, so a
+		 * request holds on to the pool it got for as long as it runs.
+		 *
+		 * @return The session pool, shared by copies of this client.
+		 */
+		std::shared_ptr<net::HTTPSessionPool> getSessionPool()
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
 
-			// Check HTTP response status
-			if (response.getStatus() != Poco::Net::HTTPResponse::HTTP_OK)
+			if (!m_sessionPool)
 			{
-				std::cerr << "HTTP error: " << response.getStatus() << ' ' << response.getReason() << std::endl;
+				m_sessionPool = std::make_shared<net::HTTPSessionPool>(Poco::URI(m_baseUrl), m_maxIdleSessions, m_keepAliveTimeout);
 			}
 
-			QrzResponse output{response, body};
-
-			return output;
+			return m_sessionPool;
 		}
 
 		/**
-		 * @brief Fetches a Callsign object for a given callsign string.
-		 *
-		 * This function fetches the callsign information for a given callsign by making a request to the QRZ API.
-		 * If the session key is not valid, it fetches a new token before making the request.
-		 * If the response status is not HTTP_OK, it prints the HTTP error message to standard error output.
-		 * If any Poco exception occurs during the process, it prints the Poco error message to standard error output.
+		 * @brief Opens a connection to QRZ ahead of a lookup, so the lookup does not wait for the TLS handshake.
 		 *
-		 * @param call The callsign to fetch information for.
-		 * @return The Callsign object containing the fetched callsign information.
+		 * Nothing is done if an idle connection is already waiting, while the circuit breaker is open, or while
+		 * responses are replayed from an archive. A failure is only logged, since the lookup that follows will
+		 * connect and report the problem itself.
 		 */
-		Callsign fetchCallsign(const std::string call)
+		void prewarmConnection()
 		{
-			Callsign callsign;
-			callsign.setCall(call);
-
-			if (!tokenIsValid())
+			if (getCircuitBreaker().getState() == net::CircuitState::OPEN || isReplaying())
 			{
-				fetchToken();
+				return;
 			}
 
 			try
 			{
-				Poco::URI uri(m_baseUrl);
-
-				uri.addQueryParameter("callsign", call);
-				uri.addQueryParameter("s", m_sessionKey);
-
-				QrzResponse response = sendRequest(uri);
-				const Poco::Net::HTTPResponse &httpResponse = response.getHttpResponse();
-
-				if (httpResponse.getStatus() == Poco::Net::HTTPResponse::HTTP_OK)
-				{
-					validateResponse(response.getBody());
-
-					CallsignMarshaler marshaler;
-					callsign = marshaler.FromXml(response.getBody());
-				}
-				else
-				{
-					std::cerr << "HTTP error: " << httpResponse.getReason() << std::endl;
-				}
+				getSessionPool()->prewarm(Poco::Timespan(getRequestDeadlines().connect.count() * 1000));
 			}
-			catch (Poco::Exception& ex)
+			catch (Poco::Exception &e)
 			{
-				std::cerr << "Poco error: " << ex.displayText() << std::endl;
+				std::cerr << "Unable to connect to QRZ: " << e.displayText() << std::endl;
 			}
-
-			return callsign;
 		}
 
 		/**
-		 * @brief Fetches the biography information for a given callsign.
+		 * @brief Get how long requests to the QRZ API may take.
 		 *
-		 * This method fetches the biography information for the specified callsign by making a request to the QRZ API.
-		 * If the session key is not valid, it fetches a new token before making the request.
-		 * If the response status is not HTTP_OK, it prints an HTTP error message to standard error output.
-		 * If any Poco exception occurs during the process, it prints a Poco error message to standard error output.
-		 *
-		 * @param call The callsign for which to fetch the biography information.
-		 * @return A string containing the fetched biography information.
+		 * @return The request deadlines.
 		 */
-		std::string fetchBio(const std::string call)
+		net::RequestDeadlines getRequestDeadlines() const
 		{
-			if (!tokenIsValid())
-			{
-				fetchToken();
-			}
-
-			std::string output;
-
-			try
-			{
-				Poco::URI uri(m_baseUrl);
-
-				uri.addQueryParameter("html", call);
-				uri.addQueryParameter("s", m_sessionKey);
-
-				QrzResponse response = sendRequest(uri);
-				const Poco::Net::HTTPResponse &httpResponse = response.getHttpResponse();
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			return m_deadlines;
+		}
 
-				if (httpResponse.getStatus() == Poco::Net::HTTPResponse::HTTP_OK)
-				{
-					output = response.getBody();
-				}
-				else
-				{
-					std::cerr << "HTTP error: " << httpResponse.getReason() << std::endl;
-				}
-			}
-			catch (Poco::Exception& ex)
-			{
-				std::cerr << "Poco error: " << ex.displayText() << std::endl;
-			}
+		/**
+		 * @brief Sets how long requests to the QRZ API may take.
+		 *
+		 * @param deadlines The request deadlines.
+		 */
+		void setRequestDeadlines(const net::RequestDeadlines &deadlines)
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			m_deadlines = deadlines;
+		}
 
-			return output;
+		/**
+		 * @brief Get the lookup quota most recently reported by the QRZ API.
+		 *
+		 * The quota is updated from the Session element of every token and lookup response.
+		 *
+		 * @return A copy of the quota status.
+		 */
+		QuotaStatus getQuotaStatus() const
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			return m_quota;
 		}
 
 		/**
-		 * @brief Fetches the DXCC information for a given query string.
+		 * @brief Sets the number of lookups the account may make in a 24 hour period.
 		 *
-		 * This function fetches the DXCC information for the specified query by making a request to the QRZ API.
-		 * If the session key is not valid, it fetches a new token before making the request.
-		 * If the response status is not HTTP_OK, it prints an HTTP error message to standard error output.
-		 * If any Poco exception occurs during the process, it prints a Poco error message to standard error output.
+		 * QRZ only reports how many lookups have been made, the limit is needed to work out how many are left.
 		 *
-		 * @param query The query string for which to fetch the DXCC information.
-		 * @return The DXCC object containing the fetched DXCC information if successful, otherwise an empty DXCC object.
+		 * @param limit The daily lookup limit.
 		 */
-		DXCC fetchDXCC(const std::string query)
+		void setDailyLookupLimit(int limit)
 		{
-			DXCC dxcc;
+			double fraction;
 
-			if (!tokenIsValid())
 			{
-				fetchToken();
+				std::lock_guard<std::mutex> lock(m_stateMutex);
+				m_quota.setDailyLimit(limit);
+				fraction = m_quota.getRemainingFraction();
 			}
 
-			try
-			{
-				Poco::URI uri(m_baseUrl);
-
-				uri.addQueryParameter("dxcc", query);
-				uri.addQueryParameter("s", m_sessionKey);
-
-				QrzResponse response = sendRequest(uri);
-				const Poco::Net::HTTPResponse &httpResponse = response.getHttpResponse();
-
-				if (httpResponse.getStatus() == Poco::Net::HTTPResponse::HTTP_OK)
-				{
-					validateResponse(response.getBody());
+			m_rateLimiter->setRemainingFraction(fraction);
+		}
 
-					DXCCMarshaler marshaler;
-					dxcc = marshaler.FromXml(response.getBody());
-				}
-				else
-				{
-					std::cerr << "HTTP error: " << httpResponse.getReason() << std::endl;
-				}
-			}
-			catch (Poco::Exception& ex)
-			{
-				std::cerr << "Poco error: " << ex.displayText() << std::endl;
-			}
+		/**
+		 * @brief Sets the number of background lookups allowed per minute while the daily quota is untouched.
+		 *
+		 * @param rate The background lookup rate.
+		 */
+		void setBackgroundLookupRate(int rate)
+		{
+			m_rateLimiter->setRate(rate);
+		}
 
-			return dxcc;
+		/**
+		 * @brief Returns the rate limiter that paces lookups against the daily quota.
+		 *
+		 * @return A reference to the rate limiter.
+		 */
+		net::QuotaRateLimiter &getRateLimiter()
+		{
+			return *m_rateLimiter;
 		}
 
 		/**
-		 * @brief Fetches a token from a QRZ API.
+		 * @brief Sends a request to the QRZ API and returns the response.
 		 *
-		 * This function sends a request to the QRZ API to fetch a token. The token is used for authentication to access
-		 * the API's resources. The token is obtained by sending a POST request to the API's endpoint with the username and password
-		 * as query parameters. If the request is successful, the function parses the response to extract the token, and sets the
-		 * session key with the obtained token. The function also sets the session timeout to the current time plus 24 hours.
+		 * This method sends a request to the QRZ API with the specified URI and returns the response as a QrzResponse
+		 * object.
 		 *
-		 * @note The function uses the Poco library for sending HTTP requests and parsing XML responses.
+		 * The request is sent over a pooled keep-alive session, so consecutive lookups share one TCP connection and TLS
+		 * handshake. If a reused session turns out to have been closed by the server while it sat idle, the request is
+		 * transparently retried once on a fresh connection.
 		 *
-		 * @throws std::runtime_error If an invalid XML response is received from the QRZ API.
+		 * The request is bounded by the connect, read and total deadlines, so a server that stops responding cannot
+		 * hold the caller for longer than the total deadline. Cancelling the token shuts the connection down, which
+		 * aborts a request blocked waiting on the server.
 		 *
-		 * @throws Poco::XML::SAXException If an error occurs during XML parsing.
+		 * Transport errors, timeouts and 5xx responses are retried after a jittered, exponentially growing delay, as
+		 * long as the retry fits before the total deadline. Every attempt is reported to the circuit breaker, and while
+		 * the breaker is open the request fails straight away.
+		 *
+		 * Responses are requested gzip or deflate compressed and inflated as they are read, and the bytes received are
+		 * counted per endpoint.
+		 *
+		 * With a traffic archive set, the response handed back is recorded to it, or when it is replaying, the request
+		 * is answered from it instead of by QRZ.
+		 *
+		 * @param uri The URI of the API endpoint to send the request to.
+		 * @param cancel Cancels the request from another thread. May be null.
+		 * @return A QrzResponse object containing the HTTP response and body.
 		 *
-		 * @throws Poco::Net::HTTPException If an error occurs during the HTTP request.
+		 * @throws TimeoutException If a deadline passed before the response was complete.
+		 * @throws CancelledException If the request was cancelled.
+		 * @throws CircuitOpenException If QRZ has been failing and requests are paused.
 		 */
-		void fetchToken()
+		virtual QrzResponse sendRequest(Poco::URI &uri, const std::shared_ptr<net::CancellationToken> &cancel = nullptr)
 		{
-			Poco::URI uri(m_baseUrl);
+			std::string endpoint = endpointOf(uri);
+
+			std::string path = Poco::format("/xml/%s/", m_apiVersion);
+			uri.setPath(path);
+			uri.addQueryParameter("agent", m_userAgent);
+
+			std::shared_ptr<net::TrafficArchive> archive = getTrafficArchive();
+			if (archive && archive->isReplaying())
+			{
+				return replayRequest(*archive, uri, cancel);
+			}
+
+			std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
 
-			uri.addQueryParameter("username", m_username);
-			uri.addQueryParameter("password", m_password);
+			// Prepare a GET request, the pooled session already knows which host it is connected to
+			Poco::Net::HTTPRequest request(Poco::Net::HTTPRequest::HTTP_GET, uri.getPathAndQuery(), Poco::Net::HTTPMessage::HTTP_1_1);
+			request.setKeepAlive(true);
+			request.set("Accept-Encoding", "gzip, deflate");
 
-			QrzResponse response = sendRequest(uri);
-			const Poco::Net::HTTPResponse &httpResponse = response.getHttpResponse();
+			net::RequestDeadlines deadlines = getRequestDeadlines();
+			std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + deadlines.total;
 
-			if (httpResponse.getStatus() == Poco::Net::HTTPResponse::HTTP_OK)
+			net::RetryPolicy retryPolicy = getRetryPolicy();
+
+			for (int attempt = 1;; attempt++)
 			{
-				bool validToken = false;
+				if (!m_circuitBreaker->allowRequest())
+				{
+					throw CircuitOpenException();
+				}
 
 				try
 				{
-					Poco::XML::DOMParser parser;
-					Poco::AutoPtr<Poco::XML::Document> doc = parser.parseString(response.getBody());
-					Poco::XML::Element* rootElement = doc->documentElement();
+					QrzResponse response = exchange(request, endpoint, deadlines, deadline, cancel);
 
-					if (rootElement->tagName() != "QRZDatabase")
+					if (!isServerError(response.getHttpResponse().getStatus()))
 					{
-						throw std::runtime_error("Invalid XML");
+						m_circuitBreaker->recordSuccess();
+						recordResponse(archive.get(), uri, started, response);
+						return response;
 					}
 
-					Poco::XML::NodeList* sessionElements = rootElement->getElementsByTagName("Session");
-					if (sessionElements->length() == 0)
+					m_circuitBreaker->recordFailure();
+
+					// Out of retries, hand the error response to the caller as before
+					if (!waitToRetry(retryPolicy, attempt, deadline, cancel))
 					{
-						throw std::runtime_error("Invalid XML");
+						recordResponse(archive.get(), uri, started, response);
+						return response;
 					}
+				}
+				catch (TimeoutException &)
+				{
+					m_circuitBreaker->recordFailure();
 
-					Poco::XML::Element* sessionElement = static_cast<Poco::XML::Element*>(sessionElements->item(0));
-					Poco::XML::Node* currChild = sessionElement->firstChild();
-
-					while (currChild)
+					if (!waitToRetry(retryPolicy, attempt, deadline, cancel))
 					{
-						if (currChild->nodeType() == Poco::XML::Node::ELEMENT_NODE)
-						{
-							Poco::XML::Element* currentElement = static_cast<Poco::XML::Element*>(currChild);
-							std::string name = currentElement->nodeName();
-							std::string value = currentElement->innerText();
-							if (name == "Key")
-							{
-								setSessionKey(value);
-								validToken = true;
-							}
-						}
-
-						currChild = currChild->nextSibling();
+						throw;
 					}
 				}
-				catch (const Poco::XML::SAXException &e)
+				catch (Poco::IOException &)
 				{
-					std::cerr << e.what() << std::endl;
-				}
+					m_circuitBreaker->recordFailure();
 
-				if(validToken)
+					if (!waitToRetry(retryPolicy, attempt, deadline, cancel))
+					{
+						throw;
+					}
+				}
+				catch (...)
 				{
-					Poco::Timestamp now;
-
-					now += std::chrono::hours(24);
-
-					m_sessionTimestamp = now;
+					// Cancelled, or an error that says nothing about the health of the server
+					m_circuitBreaker->recordAbandoned();
+					throw;
 				}
 			}
-			else
-			{
-				std::cerr << "HTTP error: " << httpResponse.getReason() << std::endl;
-			}
 		}
 
 		/**
-		 * @brief Checks if the token is valid.
-		 *
-		 * This function checks if the session timestamp is greater than the current timestamp.
-		 * If it is, then the token is valid, otherwise it is not.
+		 * @brief Returns the circuit breaker that pauses requests while QRZ keeps failing.
 		 *
-		 * @return True if the token is valid, false otherwise.
+		 * @return A reference to the circuit breaker, shared by copies of this client.
 		 */
-		bool tokenIsValid()
+		net::CircuitBreaker &getCircuitBreaker()
 		{
-			Poco::Timestamp now;
-
-			return (m_sessionTimestamp > now);
+			return *m_circuitBreaker;
 		}
 
-	protected:
-		// Time format used by the QRZ API
-		static inline const std::string m_timeFormat = "%Y-%m-%d %H:%M:%S";
-
-		// User agent string sent to the QRZ API
-		static inline const std::string m_userAgent = "qrzclnt1.0";
-
-		// Base URL of the QRZ API
-		static inline const std::string m_baseUrl = "https://xmldata.qrz.com";
-
-		// Version of the QRZ API to call
-		static inline const std::string m_apiVersion = "current";
-
-		// Username (user callsign) used for API authentication
-		std::string m_username;
-
-		// QRZ password used for API authentication
-		std::string m_password;
-
-		// Session key returned from the QRZ token API endpoint, used for all other API calls
-		std::string m_sessionKey;
-
-		// Expiration time for the session token. Estimated to be 24 hours
-		Poco::Timestamp m_sessionTimestamp;
+		/**
+		 * @brief Returns the counters of the bytes received from each endpoint of the QRZ API.
+		 *
+		 * @return The counters, keyed by endpoint: "login", "callsign", "bio" or "dxcc".
+		 */
+		std::map<std::string, net::TransferStats> getTransferStats() const
+		{
+			return m_transferCounter->getStats();
+		}
 
 		/**
-		 * @brief This function validates the response from the QRZDatabase API.
+		 * @brief Get how requests that failed for a transient reason are retried.
 		 *
-		 * Parse the response body as XML and perform various checks to ensure the response is valid.
+		 * @return The retry policy.
+		 */
+		net::RetryPolicy getRetryPolicy() const
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			return m_retryPolicy;
+		}
+
+		/**
+		 * @brief Sets how requests that failed for a transient reason are retried.
 		 *
-		 * @param responseBody The response body returned by the API.
-		 * @throws std::runtime_error if the XML response is invalid, the session element is not found,
-		 *         or an error element is found with either "Session Timeout" or "Invalid session key" text.
+		 * @param retryPolicy The retry policy.
 		 */
-		static void validateResponse(const std::string &responseBody)
+		void setRetryPolicy(const net::RetryPolicy &retryPolicy)
 		{
-			try
-			{
-				Poco::XML::DOMParser parser;
-				Poco::AutoPtr<Poco::XML::Document> doc = parser.parseString(responseBody);
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			m_retryPolicy = retryPolicy;
+		}
 
-				auto *rootElement = doc->documentElement();
-				if (rootElement == nullptr || rootElement->nodeName() != "QRZDatabase")
-				{
-					throw std::runtime_error("Invalid XML Response");
+		/**
+		 * @brief Fetches a Callsign object for a given callsign string.
+		 *
+		 * This function fetches the callsign information for a given callsign by making a request to the QRZ API.
+		 * Recently fetched records are answered from memory, and callsigns QRZ recently reported as not found fail
+		 * straight away. Otherwise a fresh record in the callsign cache, if one is set, is returned without going to
+		 * the network. A callsign known to be an alias of a record, such as a former callsign, is answered with that
+		 * record wherever it is cached. A portable callsign is looked up by the callsign of the station, and input that
+		 * cannot be a callsign fails without a request being made.
+		 * If a lookup for the same callsign is already in flight, for example because a station was heard several
+		 * times in a row, the caller waits for that lookup and shares its result rather than making another request.
+		 * A caller only joins a lookup at least as urgent as its own, so an interactive lookup is never held back by the
+		 * quota of a background one. A shared lookup is only cancelled once every caller waiting for it has cancelled,
+		 * a caller that cancels earlier stops waiting while the lookup carries on for the rest.
+		 *
+		 * @param call The callsign to fetch information for.
+		 * @param priority How urgently the record is needed.
+		 * @param cancel Cancels the lookup from another thread. May be null.
+		 * @return The Callsign object containing the fetched callsign information.
+		 *
+		 * @throws NotFoundException If QRZ has no record for the callsign, or the input cannot be a callsign.
+		 * @throws RateLimitException If a background lookup was held back to save quota.
+		 * @throws TimeoutException If QRZ did not answer in time.
+		 * @throws TransportException If QRZ could not be reached or answered with an HTTP error.
+		 * @throws CancelledException If the lookup was cancelled.
+		 */
+		Callsign fetchCallsign(const std::string call, LookupPriority priority = LookupPriority::INTERACTIVE,
+							   const std::shared_ptr<net::CancellationToken> &cancel = nullptr) override
+		{
+			std::string key = canonicalKey(call);
+
+			std::optional<Callsign> remembered = findRememberedRecord(key);
+			if (remembered.has_value())
+			{
+				return remembered.value();
+			}
+
+			std::optional<std::string> notFound = m_notFoundCache->get(key);
+			if (notFound.has_value())
+			{
+				throw NotFoundException{notFound.value()};
+			}
+
+			std::optional<Callsign> cached = findCachedRecord(key);
+			if (cached.has_value())
+			{
+				return cached.value();
+			}
+
+			try
+			{
+				return m_callsignFlights->run(key, priority, cancel, [this, &key, priority](const auto &flight)
+				{
+					return lookupCallsign(key, priority, flight);
+				});
+			}
+			catch (NotFoundException &e)
+			{
+				m_notFoundCache->put(key, e.what());
+				throw;
+			}
+		}
+
+		/**
+		 * @brief Returns the base URL of the API, which tells clients pointed at different endpoints apart.
+		 */
+		std::string getProviderName() const override
+		{
+			return getBaseUrl();
+		}
+
+		/**
+		 * @brief Answers a lookup from the record caches in memory and on disk, without going to QRZ.
+		 *
+		 * @param call The callsign.
+		 * @return The record, or nothing if it is not cached or the input cannot be a callsign.
+		 */
+		std::optional<Callsign> findLocalCallsign(const std::string &call) override
+		{
+			std::string key = CallsignCanonicalizer::canonicalize(call);
+			if (key.empty())
+			{
+				return std::nullopt;
+			}
+
+			std::optional<Callsign> remembered = findRememberedRecord(key);
+			if (remembered.has_value())
+			{
+				return remembered;
+			}
+
+			return findCachedRecord(key);
+		}
+
+		/**
+		 * @brief Fetches the current record of a callsign from QRZ, skipping the caches.
+		 *
+		 * Used to check a record that has been on display for a long time. The fresh record replaces the cached one.
+		 * A lookup for the same callsign already in flight is shared, as with fetchCallsign().
+		 *
+		 * @param call The callsign.
+		 * @param priority How urgently the record is needed.
+		 * @param cancel Cancels the lookup from another thread. May be null.
+		 * @return The record.
+		 *
+		 * @throws NotFoundException If QRZ no longer has a record for the callsign, or the input cannot be a callsign.
+		 * @throws RateLimitException If a background lookup was held back to save quota.
+		 * @throws TimeoutException If QRZ did not answer in time.
+		 * @throws TransportException If QRZ could not be reached or answered with an HTTP error.
+		 * @throws CancelledException If the lookup was cancelled.
+		 */
+		Callsign refreshCallsign(const std::string &call, LookupPriority priority = LookupPriority::BACKGROUND,
+								 const std::shared_ptr<net::CancellationToken> &cancel = nullptr)
+		{
+			std::string key = canonicalKey(call);
+
+			return m_callsignFlights->run(key, priority, cancel, [this, &key, priority](const auto &flight)
+			{
+				return lookupCallsign(key, priority, flight);
+			});
+		}
+
+		/**
+		 * @brief Checks whether QRZ recently reported that it has no record for a callsign.
+		 *
+		 * @param call The callsign.
+		 * @return True if the callsign is in the not found cache and has not expired.
+		 */
+		bool isKnownNotFound(const std::string &call)
+		{
+			return m_notFoundCache->get(CallsignCanonicalizer::canonicalize(call)).has_value();
+		}
+
+		/**
+		 * @brief Sets the size of the in-memory record cache and how long its entries are kept.
+		 *
+		 * @param records The maximum number of records kept in memory.
+		 * @param recordTtl How long a record is kept in memory.
+		 * @param notFoundTtl How long a callsign QRZ has no record for is remembered.
+		 */
+		void setMemoryCacheLimits(std::size_t records, std::chrono::steady_clock::duration recordTtl,
+								  std::chrono::steady_clock::duration notFoundTtl)
+		{
+			m_recordCache->setCapacity(records);
+			m_recordCache->setTtl(recordTtl);
+			m_notFoundCache->setTtl(notFoundTtl);
+		}
+
+		/**
+		 * @brief Returns the counters of the in-memory record cache.
+		 *
+		 * @return A snapshot of the record cache statistics.
+		 */
+		cache::LruCacheStats getRecordCacheStats() const
+		{
+			return m_recordCache->getStats();
+		}
+
+		/**
+		 * @brief Returns the counters of the not found cache.
+		 *
+		 * @return A snapshot of the not found cache statistics.
+		 */
+		cache::LruCacheStats getNotFoundCacheStats() const
+		{
+			return m_notFoundCache->getStats();
+		}
+
+		/**
+		 * @brief Returns the index of the callsigns known to resolve to another record.
+		 *
+		 * @return The alias index, shared by copies of this client.
+		 */
+		cache::AliasIndex &getAliasIndex() const
+		{
+			return *m_aliasIndex;
+		}
+
+		/**
+		 * @brief Returns the persistent callsign cache consulted before going to the network.
+		 *
+		 * @return The cache, or nullptr if records are not cached.
+		 */
+		std::shared_ptr<cache::CallsignCache> getCallsignCache() const
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			return m_callsignCache;
+		}
+
+		/**
+		 * @brief Sets the persistent callsign cache consulted before going to the network.
+		 *
+		 * Records fetched from the QRZ API are written to the cache.
+		 *
+		 * @param callsignCache The cache, or nullptr to stop caching.
+		 */
+		void setCallsignCache(std::shared_ptr<cache::CallsignCache> callsignCache)
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			m_callsignCache = std::move(callsignCache);
+		}
+
+		/**
+		 * @brief Returns the bio cache consulted before downloading a bio.
+		 *
+		 * @return The cache, or nullptr if bios are not cached.
+		 */
+		std::shared_ptr<cache::BioCache> getBioCache() const
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			return m_bioCache;
+		}
+
+		/**
+		 * @brief Sets the bio cache consulted before downloading a bio.
+		 *
+		 * @param bioCache The cache, or nullptr to stop caching.
+		 */
+		void setBioCache(std::shared_ptr<cache::BioCache> bioCache)
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			m_bioCache = std::move(bioCache);
+		}
+
+		/**
+		 * @brief Returns the archive responses are recorded to or replayed from.
+		 *
+		 * @return The archive, or nullptr if requests go to QRZ unrecorded.
+		 */
+		std::shared_ptr<net::TrafficArchive> getTrafficArchive() const
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			return m_trafficArchive;
+		}
+
+		/**
+		 * @brief Whether requests are answered from a traffic archive instead of by QRZ.
+		 */
+		bool isReplaying() const
+		{
+			std::shared_ptr<net::TrafficArchive> archive = getTrafficArchive();
+			return archive && archive->isReplaying();
+		}
+
+		/**
+		 * @brief Sets an archive to record responses to, or to replay them from instead of sending requests to QRZ.
+		 *
+		 * @param trafficArchive The archive, or nullptr to stop recording or replaying.
+		 */
+		void setTrafficArchive(std::shared_ptr<net::TrafficArchive> trafficArchive)
+		{
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			m_trafficArchive = std::move(trafficArchive);
+		}
+
+		/**
+		 * @brief Returns the number of callsign lookups that were saved by joining a lookup already in flight.
+		 *
+		 * @return The number of requests saved.
+		 */
+		std::uint64_t getCoalescedLookupCount() const
+		{
+			return m_callsignFlights->getCoalescedCount();
+		}
+
+		/**
+		 * @brief Fetches the biography information for a given callsign.
+		 *
+		 * This method fetches the biography information for the specified callsign by making a request to the QRZ API.
+		 * If the session key is not valid, it fetches a new token before making the request.
+		 * If QRZ cannot be reached or does not answer with HTTP_OK, a TransportException is thrown.
+		 *
+		 * If a bio cache is set, a bio cached for the same biodate is returned without going to the network. When no
+		 * biodate is given it is taken from the cached callsign record, if there is one.
+		 *
+		 * @param call The callsign for which to fetch the biography information.
+		 * @param biodate The biodate of the callsign record.
+		 * @param cancel Cancels the download from another thread. May be null.
+		 * @return A string containing the fetched biography information.
+		 *
+		 * @throws TimeoutException If QRZ did not answer in time.
+		 * @throws TransportException If QRZ could not be reached or answered with an HTTP error.
+		 * @throws CancelledException If the download was cancelled.
+		 */
+		std::string fetchBio(const std::string call, std::string biodate = "",
+							 const std::shared_ptr<net::CancellationToken> &cancel = nullptr)
+		{
+			std::shared_ptr<cache::BioCache> bioCache = getBioCache();
+
+			if (bioCache && biodate.empty())
+			{
+				biodate = findBiodate(call);
+			}
+
+			if (bioCache && !biodate.empty())
+			{
+				std::optional<std::string> cached = bioCache->get(call, biodate);
+				if (cached.has_value())
+				{
+					return cached.value();
+				}
+			}
+
+			if (!tokenIsValid())
+			{
+				fetchToken();
+			}
+
+			std::string output;
+
+			try
+			{
+				Poco::URI uri(getBaseUrl());
+
+				uri.addQueryParameter("html", call);
+				uri.addQueryParameter("s", getSessionKey());
+
+				QrzResponse response = sendRequest(uri, cancel);
+				const Poco::Net::HTTPResponse &httpResponse = response.getHttpResponse();
+
+				throwIfFailed(httpResponse);
+
+				output = response.getBody();
+
+				if (bioCache && !biodate.empty() && !output.empty())
+				{
+					storeBioInCache(*bioCache, call, biodate, output);
+				}
+			}
+			catch (Poco::Exception& ex)
+			{
+				throw TransportException("QRZ could not be reached: " + ex.displayText());
+			}
+
+			return output;
+		}
+
+		/**
+		 * @brief Fetches the DXCC information for a given query string.
+		 *
+		 * This function fetches the DXCC information for the specified query by making a request to the QRZ API.
+		 * If the session key is not valid, it fetches a new token before making the request.
+		 * If QRZ cannot be reached or does not answer with HTTP_OK, a TransportException is thrown.
+		 *
+		 * @param query The query string for which to fetch the DXCC information.
+		 * @return The DXCC object containing the fetched DXCC information.
+		 *
+		 * @throws TransportException If QRZ could not be reached or answered with an HTTP error.
+		 */
+		DXCC fetchDXCC(const std::string query)
+		{
+			DXCC dxcc;
+
+			if (!tokenIsValid())
+			{
+				fetchToken();
+			}
+
+			try
+			{
+				Poco::URI uri(getBaseUrl());
+
+				uri.addQueryParameter("dxcc", query);
+				uri.addQueryParameter("s", getSessionKey());
+
+				QrzResponse response = sendRequest(uri);
+				const Poco::Net::HTTPResponse &httpResponse = response.getHttpResponse();
+
+				throwIfFailed(httpResponse);
+
+				updateQuota(QrzXmlDecoder::decodeDXCC(response.getBody(), dxcc));
+			}
+			catch (Poco::Exception& ex)
+			{
+				throw TransportException("QRZ could not be reached: " + ex.displayText());
+			}
+
+			return dxcc;
+		}
+
+		/**
+		 * @brief Fetches a token from a QRZ API.
+		 *
+		 * This function sends a request to the QRZ API to fetch a token. The token is used for authentication to access
+		 * the API's resources. The token is obtained by sending a POST request to the API's endpoint with the username and password
+		 * as query parameters. If the request is successful, the function parses the response to extract the token, and sets the
+		 * session key with the obtained token. The function also sets the session timeout to the current time plus 24 hours,
+		 * and records the lookup quota reported alongside the token.
+		 *
+		 * The key and its expiration are swapped in together, so lookups running on other threads see either the old
+		 * session or the new one. Callers that ask for a token while one is already being fetched wait for that fetch
+		 * instead of logging in a second time.
+		 *
+		 * @note The function uses the Poco library for sending HTTP requests and parsing XML responses.
+		 *
+		 * @throws std::runtime_error If an invalid XML response is received from the QRZ API.
+		 *
+		 * @throws Poco::XML::SAXException If an error occurs during XML parsing.
+		 *
+		 * @throws TransportException If QRZ could not be reached or answered with an HTTP error.
+		 */
+		void fetchToken()
+		{
+			m_tokenFlights->run(std::string(), [this]()
+			{
+				requestToken();
+				return true;
+			});
+		}
+
+		/**
+		 * @brief Checks if the token is valid.
+		 *
+		 * This function checks if the session timestamp is greater than the current timestamp.
+		 * If it is, then the token is valid, otherwise it is not.
+		 *
+		 * @return True if the token is valid, false otherwise.
+		 */
+		bool tokenIsValid()
+		{
+			Poco::Timestamp now;
+
+			std::lock_guard<std::mutex> lock(m_stateMutex);
+			return (m_sessionTimestamp > now);
+		}
+
+	protected:
+		// Shares the settings, session and caches of the client it is built on
+		friend class AsyncQRZClient;
+
+		// Time format used by the QRZ API
+		static inline const std::string m_timeFormat = "%Y-%m-%d %H:%M:%S";
+
+		// User agent string sent to the QRZ API
+		static inline const std::string m_userAgent = "qrzclnt1.0";
+
+		// Maximum number of idle keep-alive connections kept open to the QRZ API
+		static inline const std::size_t m_maxIdleSessions = 4;
+
+		// How long an idle connection is kept before it is considered stale
+		static inline const Poco::Timespan m_keepAliveTimeout = Poco::Timespan(30, 0);
+
+		// Base URL of the QRZ API
+		std::string m_baseUrl = "https://xmldata.qrz.com";
+
+		// Keep-alive sessions to the QRZ API, created on first use
+		std::shared_ptr<net::HTTPSessionPool> m_sessionPool;
+
+		// Version of the QRZ API to call
+		static inline const std::string m_apiVersion = "current";
+
+		// Username (user callsign) used for API authentication
+		std::string m_username;
+
+		// QRZ password used for API authentication
+		std::string m_password;
+
+		// Session key returned from the QRZ token API endpoint, used for all other API calls
+		std::string m_sessionKey;
+
+		// Expiration time for the session token. Estimated to be 24 hours
+		Poco::Timestamp m_sessionTimestamp;
+
+		// Paces background lookups against the daily quota, shared by copies of this client
+		std::shared_ptr<net::QuotaRateLimiter> m_rateLimiter = std::make_shared<net::QuotaRateLimiter>();
+
+		// Lookup quota most recently reported by the QRZ API
+		QuotaStatus m_quota;
+
+		// How long requests to the QRZ API may take
+		net::RequestDeadlines m_deadlines;
+
+		// How requests that failed for a transient reason are retried
+		net::RetryPolicy m_retryPolicy;
+
+		// Pauses requests while QRZ keeps failing, shared by copies of this client
+		std::shared_ptr<net::CircuitBreaker> m_circuitBreaker = std::make_shared<net::CircuitBreaker>();
+
+		// Bytes received from each endpoint, shared by copies of this client
+		std::shared_ptr<net::TransferCounter> m_transferCounter = std::make_shared<net::TransferCounter>();
+
+		// Persistent cache of callsign records, shared by copies of this client
+		std::shared_ptr<cache::CallsignCache> m_callsignCache;
+
+		// Compressed bio HTML, keyed by callsign and biodate, shared by copies of this client
+		std::shared_ptr<cache::BioCache> m_bioCache;
+
+		// Archive responses are recorded to or replayed from, shared by copies of this client
+		std::shared_ptr<net::TrafficArchive> m_trafficArchive;
+
+		// Recently fetched records, keyed by normalized callsign
+		std::shared_ptr<cache::LruCache<std::string, Callsign>> m_recordCache =
+				std::make_shared<cache::LruCache<std::string, Callsign>>(500, std::chrono::hours(24 * 7));
+
+		// Error messages for callsigns QRZ recently reported as not found, keyed by normalized callsign
+		std::shared_ptr<cache::LruCache<std::string, std::string>> m_notFoundCache =
+				std::make_shared<cache::LruCache<std::string, std::string>>(1000, std::chrono::hours(1));
+
+		// Callsign of the record each known alias resolves to, shared by copies of this client
+		std::shared_ptr<cache::AliasIndex> m_aliasIndex = std::make_shared<cache::AliasIndex>();
+
+		// Callsign lookups in flight, keyed by normalized callsign, shared by copies of this client
+		std::shared_ptr<SingleFlight<std::string, Callsign>> m_callsignFlights = std::make_shared<SingleFlight<std::string, Callsign>>();
+
+		// Token requests in flight, so concurrent refreshes share one login
+		std::shared_ptr<SingleFlight<std::string, bool>> m_tokenFlights = std::make_shared<SingleFlight<std::string, bool>>();
+
+		// Guards the session key, expiration, quota and connection pool, which are shared by concurrent lookups
+		mutable std::mutex m_stateMutex;
+
+		/**
+		 * @brief Requests a token from the QRZ API, without coalescing.
+		 *
+		 * @see fetchToken()
+		 */
+		void requestToken()
+		{
+			Poco::URI uri(getBaseUrl());
+
+			{
+				std::lock_guard<std::mutex> lock(m_stateMutex);
+				uri.addQueryParameter("username", m_username);
+				uri.addQueryParameter("password", m_password);
+			}
+
+			std::string body;
+
+			try
+			{
+				QrzResponse response = sendRequest(uri);
+				const Poco::Net::HTTPResponse &httpResponse = response.getHttpResponse();
+
+				throwIfFailed(httpResponse);
+
+				body = response.getBody();
+			}
+			catch (Poco::Exception& ex)
+			{
+				throw TransportException("QRZ could not be reached: " + ex.displayText());
+			}
+
+			acceptToken(body);
+		}
+
+		/**
+		 * @brief Reads the session key and lookup quota from the response to a login, and starts the new session.
+		 *
+		 * The key and its expiration are swapped in together. A response without a key leaves the session as it was.
+		 *
+		 * @param responseBody The body of the login response.
+		 *
+		 * @throws std::runtime_error If the response is not a QRZ database document or has no Session element.
+		 */
+		void acceptToken(const std::string &responseBody)
+		{
+			std::string sessionKey;
+
+			try
+			{
+				Poco::XML::DOMParser parser;
+				Poco::AutoPtr<Poco::XML::Document> doc = parser.parseString(responseBody);
+				Poco::XML::Element* rootElement = doc->documentElement();
+
+				if (rootElement->tagName() != "QRZDatabase")
+				{
+					throw std::runtime_error("Invalid XML");
+				}
+
+				Poco::XML::NodeList* sessionElements = rootElement->getElementsByTagName("Session");
+				if (sessionElements->length() == 0)
+				{
+					throw std::runtime_error("Invalid XML");
 				}
 
-				auto *sessionElement = rootElement->getChildElement("Session");
-				if (sessionElement == nullptr)
+				Poco::XML::Element* sessionElement = static_cast<Poco::XML::Element*>(sessionElements->item(0));
+				Poco::XML::Node* currChild = sessionElement->firstChild();
+
+				while (currChild)
+				{
+					if (currChild->nodeType() == Poco::XML::Node::ELEMENT_NODE)
+					{
+						Poco::XML::Element* currentElement = static_cast<Poco::XML::Element*>(currChild);
+						std::string name = currentElement->nodeName();
+						std::string value = currentElement->innerText();
+						if (name == "Key")
+						{
+							sessionKey = value;
+						}
+					}
+
+					currChild = currChild->nextSibling();
+				}
+
+				updateQuota(readQuota(sessionElement));
+			}
+			catch (const Poco::XML::SAXException &e)
+			{
+				std::cerr << e.what() << std::endl;
+			}
+
+			if(!sessionKey.empty())
+			{
+				Poco::Timestamp now;
+
+				now += std::chrono::hours(24);
+
+				std::lock_guard<std::mutex> lock(m_stateMutex);
+				m_sessionKey = sessionKey;
+				m_sessionTimestamp = now;
+			}
+		}
+
+		/**
+		 * @brief Makes a single attempt at a request over a pooled session.
+		 *
+		 * A reused session that turns out to have been closed by the server is replaced and the request sent again,
+		 * which does not count as a retry.
+		 *
+		 * @throws TimeoutException If a deadline passed before the response was complete.
+		 * @throws CancelledException If the request was cancelled.
+		 */
+		QrzResponse exchange(Poco::Net::HTTPRequest &request, const std::string &endpoint, const net::RequestDeadlines &deadlines,
+							 std::chrono::steady_clock::time_point deadline, const std::shared_ptr<net::CancellationToken> &cancel)
+		{
+			std::shared_ptr<net::HTTPSessionPool> pool = getSessionPool();
+
+			for (int attempt = 0;; attempt++)
+			{
+				if (cancel)
+				{
+					cancel->throwIfCancelled();
+				}
+
+				net::HTTPSessionPool::Lease lease = pool->acquire();
+
+				// Unblocks the connection if the caller gives up, and is released before the lease
+				net::CancellationToken::Registration registration;
+				if (cancel)
+				{
+					registration = cancel->subscribe([&lease]() { lease.abort(); });
+				}
+
+				try
+				{
+					applyDeadlines(lease, deadlines, deadline);
+
+					// Send Request
+					lease.session().sendRequest(request);
+
+					// Get the response
+					Poco::Net::HTTPResponse response;
+
+					applyDeadlines(lease, deadlines, deadline);
+					std::istream& rs = lease.session().receiveResponse(response);
+					std::uint64_t wireBytes = 0;
+					std::string body = readBody(rs, response.get("Content-Encoding", ""), lease, deadlines, deadline, wireBytes);
+
+					m_transferCounter->record(endpoint, wireBytes, body.size());
+
+					if (cancel && cancel->isCancelled())
+					{
+						lease.discard();
+						throw CancelledException();
+					}
+
+					if (!response.getKeepAlive())
+					{
+						lease.discard();
+					}
+
+					QrzResponse output{response, body};
+
+					return output;
+				}
+				catch (Poco::TimeoutException &)
+				{
+					lease.discard();
+					throw TimeoutException();
+				}
+				catch (Poco::IOException &)
+				{
+					lease.discard();
+
+					if (cancel && cancel->isCancelled())
+					{
+						throw CancelledException();
+					}
+
+					// Only a connection that sat idle in the pool gets a second chance
+					if (!lease.isReused() || attempt > 0)
+					{
+						throw;
+					}
+				}
+			}
+		}
+
+		/**
+		 * @brief Waits before retrying a failed attempt, if another attempt is allowed and fits before the deadline.
+		 *
+		 * @return True if the request should be retried.
+		 *
+		 * @throws CancelledException If the request was cancelled while waiting.
+		 */
+		static bool waitToRetry(const net::RetryPolicy &retryPolicy, int attempt, std::chrono::steady_clock::time_point deadline,
+								const std::shared_ptr<net::CancellationToken> &cancel)
+		{
+			std::chrono::milliseconds delay = retryPolicy.delayFor(attempt - 1);
+
+			if (!shouldRetry(retryPolicy, attempt, delay, deadline))
+			{
+				return false;
+			}
+
+			if (!cancel)
+			{
+				std::this_thread::sleep_for(delay);
+			}
+			else if (cancel->waitFor(delay))
+			{
+				throw CancelledException();
+			}
+
+			return true;
+		}
+
+		/**
+		 * @brief Whether another attempt is allowed after a failed one, and its delay still fits before the deadline.
+		 *
+		 * @param retryPolicy How requests are retried.
+		 * @param attempt The number of the attempt that failed, starting at 1.
+		 * @param delay How long to wait before the next attempt.
+		 * @param deadline When the whole request has to be finished.
+		 * @return True if the request should be retried.
+		 */
+		static bool shouldRetry(const net::RetryPolicy &retryPolicy, int attempt, std::chrono::milliseconds delay,
+								std::chrono::steady_clock::time_point deadline)
+		{
+			if (attempt >= retryPolicy.maxAttempts)
+			{
+				return false;
+			}
+
+			return std::chrono::steady_clock::now() + delay < deadline;
+		}
+
+		/**
+		 * @brief Answers a request with the next response recorded for it, after the recorded latency.
+		 *
+		 * @throws std::runtime_error If nothing was recorded for the request.
+		 * @throws CancelledException If the request was cancelled while waiting.
+		 */
+		static QrzResponse replayRequest(net::TrafficArchive &archive, const Poco::URI &uri,
+										 const std::shared_ptr<net::CancellationToken> &cancel)
+		{
+			net::RecordedExchange exchange = archive.replay(uri);
+			std::chrono::milliseconds delay = archive.getReplayDelay(exchange);
+
+			if (!cancel)
+			{
+				std::this_thread::sleep_for(delay);
+			}
+			else if (cancel->waitFor(delay))
+			{
+				throw CancelledException();
+			}
+
+			return replayedResponse(exchange);
+		}
+
+		/**
+		 * @brief Builds the response a recorded exchange stands for.
+		 */
+		static QrzResponse replayedResponse(const net::RecordedExchange &exchange)
+		{
+			Poco::Net::HTTPResponse response(static_cast<Poco::Net::HTTPResponse::HTTPStatus>(exchange.status));
+
+			return QrzResponse{response, exchange.body};
+		}
+
+		/**
+		 * @brief Records the response handed back for a request, if an archive is recording.
+		 *
+		 * A response that cannot be recorded is still handed back, recording is never a reason for a lookup to fail.
+		 *
+		 * @param archive The archive, or nullptr.
+		 * @param uri The request.
+		 * @param started When the request was first sent.
+		 * @param response The response.
+		 */
+		static void recordResponse(net::TrafficArchive *archive, const Poco::URI &uri,
+								   std::chrono::steady_clock::time_point started, QrzResponse &response)
+		{
+			if (!archive)
+			{
+				return;
+			}
+
+			auto latency = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+
+			try
+			{
+				archive->record(uri, response.getHttpResponse().getStatus(), response.getBody(), latency);
+			}
+			catch (std::exception &e)
+			{
+				std::cerr << "Unable to record QRZ traffic: " << e.what() << std::endl;
+			}
+		}
+
+		/**
+		 * @brief Whether an HTTP status means the server failed, rather than the request being wrong.
+		 */
+		static bool isServerError(Poco::Net::HTTPResponse::HTTPStatus status)
+		{
+			return status >= 500 && status < 600;
+		}
+
+		/**
+		 * @brief Throws unless QRZ answered a request with a success.
+		 *
+		 * @throws TransportException If the response status is anything but 200.
+		 */
+		static void throwIfFailed(const Poco::Net::HTTPResponse &response)
+		{
+			if (response.getStatus() != Poco::Net::HTTPResponse::HTTP_OK)
+			{
+				throw TransportException("QRZ answered with HTTP " + std::to_string(response.getStatus()) + " " +
+										 response.getReason());
+			}
+		}
+
+		/**
+		 * @brief Caps the timeouts of a session by the time left before the request deadline.
+		 *
+		 * @throws TimeoutException If the deadline has already passed.
+		 */
+		static void applyDeadlines(net::HTTPSessionPool::Lease &lease, const net::RequestDeadlines &deadlines,
+								   std::chrono::steady_clock::time_point deadline)
+		{
+			std::chrono::milliseconds connect = net::RequestDeadlines::capped(deadlines.connect, deadline);
+			std::chrono::milliseconds read = net::RequestDeadlines::capped(deadlines.read, deadline);
+
+			if (read.count() == 0)
+			{
+				throw TimeoutException();
+			}
+
+			lease.setTimeouts(Poco::Timespan(connect.count() * 1000), Poco::Timespan(read.count() * 1000));
+		}
+
+		/**
+		 * @brief Reads a response body, checking the request deadline between reads.
+		 *
+		 * A server that trickles the body out a few bytes at a time would otherwise keep every single read inside the
+		 * read timeout while the whole request runs far past the total deadline.
+		 *
+		 * A gzip or deflate encoded body is inflated chunk by chunk as it arrives, so the compressed copy is never held
+		 * in full.
+		 *
+		 * @param rs The response stream.
+		 * @param contentEncoding The Content-Encoding header of the response.
+		 * @param lease The session the response is read from.
+		 * @param deadlines The deadlines of the request.
+		 * @param deadline When the whole request has to be finished.
+		 * @param wireBytes Set to the number of body bytes read from the server, before inflating.
+		 * @return The body, inflated if it was compressed.
+		 *
+		 * @throws TimeoutException If the deadline passed before the body was complete.
+		 * @throws Poco::IOException If the body could not be inflated.
+		 */
+		static std::string readBody(std::istream &rs, const std::string &contentEncoding, net::HTTPSessionPool::Lease &lease,
+									const net::RequestDeadlines &deadlines, std::chrono::steady_clock::time_point deadline,
+									std::uint64_t &wireBytes)
+		{
+			// Let errors from the socket through instead of silently ending the body early
+			rs.exceptions(std::ios::badbit);
+
+			std::ostringstream body;
+			std::ostream *sink = &body;
+
+			std::unique_ptr<Poco::InflatingOutputStream> inflater;
+			if (isCompressed(contentEncoding))
+			{
+				// The zlib window bits plus 32 detect a gzip or zlib header on their own
+				inflater = std::make_unique<Poco::InflatingOutputStream>(body, 15 + 32);
+				inflater->exceptions(std::ios::badbit);
+				sink = inflater.get();
+			}
+
+			char buffer[4096];
+			wireBytes = 0;
+
+			while (true)
+			{
+				applyDeadlines(lease, deadlines, deadline);
+
+				// Wait for at most one read from the server, then take whatever it delivered
+				if (rs.peek() == std::char_traits<char>::eof())
 				{
-					throw std::runtime_error("Session element not found");
+					break;
 				}
 
-				auto *errorElement = sessionElement->getChildElement("Error");
-				if (errorElement != nullptr)
+				std::streamsize read = rs.readsome(buffer, sizeof(buffer));
+				wireBytes += read;
+				sink->write(buffer, read);
+			}
+
+			if (inflater)
+			{
+				inflater->close();
+			}
+
+			return body.str();
+		}
+
+		/**
+		 * @brief Whether a Content-Encoding header names a compression readBody() can inflate.
+		 *
+		 * @throws Poco::IOException If the body is encoded in a way that cannot be read.
+		 */
+		static bool isCompressed(const std::string &contentEncoding)
+		{
+			std::string encoding = Poco::toLower(Poco::trim(contentEncoding));
+
+			if (encoding.empty() || encoding == "identity")
+			{
+				return false;
+			}
+
+			if (encoding == "gzip" || encoding == "x-gzip" || encoding == "deflate")
+			{
+				return true;
+			}
+
+			throw Poco::IOException("Unsupported Content-Encoding: " + contentEncoding);
+		}
+
+		/**
+		 * @brief Names the API endpoint a request is for, after the query parameter that selects it.
+		 *
+		 * @param uri The URI of the request.
+		 * @return "login", "callsign", "bio" or "dxcc", or "other" for anything else.
+		 */
+		static std::string endpointOf(const Poco::URI &uri)
+		{
+			static const std::map<std::string, std::string> endpoints = {
+					{"username", "login"},
+					{"callsign", "callsign"},
+					{"html",     "bio"},
+					{"dxcc",     "dxcc"}};
+
+			for (const auto &[name, value] : uri.getQueryParameters())
+			{
+				auto it = endpoints.find(name);
+				if (it != endpoints.end())
 				{
-					std::string errorText = errorElement->innerText();
+					return it->second;
+				}
+			}
 
-					if (errorText == "Session Timeout" || errorText == "Invalid session key")
-					{
-						throw AuthenticationException{errorText};
-					}
-					else if(errorText.starts_with("Not found"))
-						{
-							throw NotFoundException{errorText};
-						}
-						else
-						{
-							throw std::runtime_error{errorText};
-						}
+			return "other";
+		}
+
+		/**
+		 * @brief Records the lookup quota reported by the QRZ API and adjusts the rate limiter to match.
+		 *
+		 * @param reported The quota read from a response. Ignored if it carries no lookup count.
+		 */
+		void updateQuota(const QuotaStatus &reported)
+		{
+			if (!reported.hasCount())
+			{
+				return;
+			}
+
+			double fraction;
+
+			{
+				std::lock_guard<std::mutex> lock(m_stateMutex);
+
+				m_quota.setCount(reported.getCount());
+				m_quota.setSubscriptionExpiration(reported.getSubscriptionExpiration());
+				m_quota.setServerTime(reported.getServerTime());
+
+				fraction = m_quota.getRemainingFraction();
+			}
+
+			m_rateLimiter->setRemainingFraction(fraction);
+		}
+
+		/**
+		 * @brief Reads the lookup count, subscription expiration and server time from a Session element.
+		 *
+		 * @param sessionElement The Session element of a QRZ API response.
+		 * @return The quota status. The count is left unknown if the element does not carry one.
+		 */
+		static QuotaStatus readQuota(Poco::XML::Element *sessionElement)
+		{
+			QuotaStatus quota;
+
+			auto *countElement = sessionElement->getChildElement("Count");
+			if (countElement != nullptr)
+			{
+				try
+				{
+					quota.setCount(std::stoi(countElement->innerText()));
+				}
+				catch (std::exception &)
+				{
+					// Leave the count unknown rather than guess
 				}
 			}
+
+			auto *subExpElement = sessionElement->getChildElement("SubExp");
+			if (subExpElement != nullptr)
+			{
+				quota.setSubscriptionExpiration(subExpElement->innerText());
+			}
+
+			auto *gmTimeElement = sessionElement->getChildElement("GMTime");
+			if (gmTimeElement != nullptr)
+			{
+				quota.setServerTime(gmTimeElement->innerText());
+			}
+
+			return quota;
+		}
+
+		/**
+		 * @brief Looks up a Callsign object for a given callsign string, without coalescing.
+		 *
+		 * This function fetches the callsign information for a given callsign by making a request to the QRZ API.
+		 * If the session key is not valid, it fetches a new token before making the request.
+		 * If QRZ cannot be reached or does not answer with HTTP_OK, a TransportException is thrown.
+		 *
+		 * Background lookups are checked against the rate limiter first, and are refused while the daily quota is
+		 * running low.
+		 *
+		 * @param call The callsign to fetch information for.
+		 * @param priority How urgently the record is needed.
+		 * @param cancel Cancels the lookup from another thread. May be null.
+		 * @return The Callsign object containing the fetched callsign information.
+		 *
+		 * @throws RateLimitException If a background lookup was held back to save quota.
+		 * @throws TimeoutException If QRZ did not answer in time.
+		 * @throws TransportException If QRZ could not be reached or answered with an HTTP error.
+		 * @throws CancelledException If the lookup was cancelled.
+		 */
+		Callsign lookupCallsign(const std::string &call, LookupPriority priority,
+								const std::shared_ptr<net::CancellationToken> &cancel = nullptr)
+		{
+			Callsign callsign;
+			callsign.setCall(call);
+
+			if (!m_rateLimiter->tryAcquire(priority))
+			{
+				throw RateLimitException();
+			}
+
+			if (!tokenIsValid())
+			{
+				fetchToken();
+			}
+
+			try
+			{
+				Poco::URI uri(getBaseUrl());
+
+				uri.addQueryParameter("callsign", call);
+				uri.addQueryParameter("s", getSessionKey());
+
+				QrzResponse response = sendRequest(uri, cancel);
+				const Poco::Net::HTTPResponse &httpResponse = response.getHttpResponse();
+
+				throwIfFailed(httpResponse);
+
+				updateQuota(QrzXmlDecoder::decodeCallsign(response.getBody(), callsign));
+
+				storeInCache(call, callsign);
+			}
 			catch (Poco::Exception& ex)
 			{
-				throw std::runtime_error{ex.message()};
+				throw TransportException("QRZ could not be reached: " + ex.displayText());
+			}
+
+			return callsign;
+		}
+
+		/**
+		 * @brief Writes a freshly fetched record to the in-memory cache, and to the callsign cache if one is set.
+		 *
+		 * The xref and aliases of the record are indexed, and a record looked up by an alias is stored under its own
+		 * callsign as well, so a lookup of any of them is answered locally. A cache that cannot be written to is
+		 * reported but does not fail the lookup.
+		 *
+		 * @param call The callsign the record was looked up by.
+		 * @param callsign The record.
+		 */
+		void storeInCache(const std::string &call, const Callsign &callsign)
+		{
+			std::string key = CallsignCanonicalizer::canonicalize(call);
+			std::string recordKey = CallsignCanonicalizer::canonicalize(callsign.getCall());
+
+			m_aliasIndex->add(callsign);
+
+			if (!key.empty())
+			{
+				m_recordCache->put(key, callsign);
+			}
+
+			// Looked up by an alias, the record is also remembered under its own callsign
+			if (!recordKey.empty() && recordKey != key)
+			{
+				m_recordCache->put(recordKey, callsign);
+			}
+
+			std::shared_ptr<cache::CallsignCache> callsignCache = getCallsignCache();
+			if (!callsignCache)
+			{
+				return;
+			}
+
+			try
+			{
+				if (!key.empty())
+				{
+					callsignCache->put(key, callsign);
+				}
+
+				if (!recordKey.empty() && recordKey != key)
+				{
+					callsignCache->put(recordKey, callsign);
+				}
+			}
+			catch (std::exception &e)
+			{
+				std::cerr << "Callsign cache error: " << e.what() << std::endl;
+			}
+		}
+
+		/**
+		 * @brief Returns the key a callsign is looked up and cached under, the callsign of the station.
+		 *
+		 * @param call The callsign, possibly with a prefix or suffix.
+		 * @return The key.
+		 *
+		 * @throws NotFoundException If the input cannot be a callsign, so no lookup is spent on it.
+		 */
+		static std::string canonicalKey(const std::string &call)
+		{
+			std::string key = CallsignCanonicalizer::canonicalize(call);
+			if (key.empty())
+			{
+				throw NotFoundException{"Not a valid callsign: " + call};
+			}
+
+			return key;
+		}
+
+		/**
+		 * @brief Finds a record in memory, by the callsign or by the record it is known to be an alias of.
+		 *
+		 * @param key The normalized callsign.
+		 * @return The record, or nothing if it is not in memory.
+		 */
+		std::optional<Callsign> findRememberedRecord(const std::string &key)
+		{
+			std::optional<Callsign> remembered = m_recordCache->get(key);
+			if (remembered.has_value())
+			{
+				return remembered;
+			}
+
+			std::optional<std::string> recordKey = m_aliasIndex->resolve(key);
+			if (!recordKey.has_value())
+			{
+				return std::nullopt;
+			}
+
+			return m_recordCache->get(recordKey.value());
+		}
+
+		/**
+		 * @brief Finds a fresh record in the callsign cache, by the callsign or by the record it is known to be an
+		 *        alias of.
+		 *
+		 * A record found is remembered in memory under the callsign asked for, and its aliases are indexed, so
+		 * records from earlier sessions resolve their aliases as well.
+		 *
+		 * @param key The normalized callsign.
+		 * @return The record, or nothing if there is no callsign cache or no fresh record in it.
+		 */
+		std::optional<Callsign> findCachedRecord(const std::string &key)
+		{
+			std::shared_ptr<cache::CallsignCache> callsignCache = getCallsignCache();
+			if (!callsignCache)
+			{
+				return std::nullopt;
+			}
+
+			std::optional<Callsign> cached = callsignCache->get(key);
+
+			if (!cached.has_value())
+			{
+				std::optional<std::string> recordKey = m_aliasIndex->resolve(key);
+				if (recordKey.has_value())
+				{
+					cached = callsignCache->get(recordKey.value());
+				}
+			}
+
+			if (cached.has_value())
+			{
+				m_aliasIndex->add(cached.value());
+				m_recordCache->put(key, cached.value());
+			}
+
+			return cached;
+		}
+
+		/**
+		 * @brief Finds the biodate of a callsign from the cached records, without going to the network.
+		 *
+		 * @param call The callsign.
+		 * @return The biodate, or an empty string if no record is cached.
+		 */
+		std::string findBiodate(const std::string &call)
+		{
+			std::string key = CallsignCanonicalizer::canonicalize(call);
+			if (key.empty())
+			{
+				return "";
+			}
+
+			std::optional<Callsign> remembered = m_recordCache->peek(key);
+			if (remembered.has_value())
+			{
+				return remembered->getBiodate();
+			}
+
+			std::shared_ptr<cache::CallsignCache> callsignCache = getCallsignCache();
+			if (callsignCache)
+			{
+				std::optional<cache::CallsignCacheEntry> entry = callsignCache->getEntry(key);
+				if (entry.has_value() && entry->callsign.has_value())
+				{
+					return entry->callsign->getBiodate();
+				}
+			}
+
+			return "";
+		}
+
+		/**
+		 * @brief Writes a freshly downloaded bio to the bio cache.
+		 *
+		 * A cache that cannot be written to is reported but does not fail the download.
+		 */
+		static void storeBioInCache(cache::BioCache &bioCache, const std::string &call, const std::string &biodate,
+									const std::string &html)
+		{
+			try
+			{
+				bioCache.put(call, biodate, html);
+			}
+			catch (std::exception &e)
+			{
+				std::cerr << "Bio cache error: " << e.what() << std::endl;
 			}
 		}
+
+		/**
+		 * @brief This function validates the response from the QRZDatabase API.
+		 *
+		 * Scan the response body and perform various checks on its Session element to ensure the response is valid.
+		 * Lookups validate and decode their record in one pass with QrzXmlDecoder instead.
+		 *
+		 * @param responseBody The response body returned by the API.
+		 * @return The lookup quota reported in the session element.
+		 * @throws std::runtime_error if the XML response is invalid, the session element is not found,
+		 *         or an error element is found with either "Session Timeout" or "Invalid session key" text.
+		 */
+		static QuotaStatus validateResponse(const std::string &responseBody)
+		{
+			return QrzXmlDecoder::decodeSession(responseBody);
+		}
 	};
 }
 
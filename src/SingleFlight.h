@@ -0,0 +1,252 @@
+#ifndef QRZ_SINGLEFLIGHT_H
+#define QRZ_SINGLEFLIGHT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "exception/CancelledException.h"
+#include "net/CancellationToken.h"
+
+namespace qrz
+{
+	/**
+	 * @class SingleFlight
+	 *
+	 * @brief Coalesces concurrent calls that ask for the same key into a single call.
+	 *
+	 * The first caller for a key runs the function. Anyone asking for the same key while that call is still in flight
+	 * waits for it and receives the same result, or the same exception. Once the call completes the key is forgotten,
+	 * so later callers start a new call. Nothing is cached.
+	 *
+	 * Each call has a rank, lower being more urgent, and a caller only joins a call at least as urgent as itself. An
+	 * urgent caller is so never held back by whatever a less urgent call is subject to. A call also has a cancellation
+	 * token of its own, which is only cancelled once every caller waiting for it has cancelled theirs. A caller that
+	 * cancels while others still wait stops waiting straight away, and the call carries on for the others.
+	 *
+	 * @tparam K The key type.
+	 * @tparam V The result type.
+	 */
+	template<typename K, typename V>
+	class SingleFlight
+	{
+	public:
+		typedef std::function<V()> Function;
+		typedef std::function<V(const std::shared_ptr<net::CancellationToken> &)> CancellableFunction;
+
+		/**
+		 * @brief Runs the function for the key, or joins the call already in flight for it.
+		 *
+		 * @param key The key identifying the call.
+		 * @param function The function to run if no call for the key is in flight.
+		 * @return The result of the call.
+		 */
+		V run(const K &key, const Function &function)
+		{
+			return run(key, 0, nullptr, [&function](const std::shared_ptr<net::CancellationToken> &)
+			{
+				return function();
+			});
+		}
+
+		/**
+		 * @brief Runs the function for the key, or joins a call in flight for it that is at least as urgent.
+		 *
+		 * @param key The key identifying the call.
+		 * @param rank How urgent the caller is, lower is more urgent.
+		 * @param cancel Stops this caller waiting, and cancels the call once no one else waits for it. May be null.
+		 * @param function The function to run if no call is joined. It is given the token of the call.
+		 * @return The result of the call.
+		 *
+		 * @throws CancelledException If the caller's token was cancelled while it waited for another caller's call.
+		 */
+		V run(const K &key, int rank, const std::shared_ptr<net::CancellationToken> &cancel,
+			  const CancellableFunction &function)
+		{
+			std::shared_ptr<Flight> flight;
+			std::promise<V> promise;
+			bool leader = false;
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto [first, last] = m_inFlight.equal_range(key);
+				for (auto it = first; it != last && !flight; it++)
+				{
+					if (it->second->rank <= rank && it->second->join(cancel != nullptr))
+					{
+						flight = it->second;
+						m_coalesced++;
+					}
+				}
+
+				if (!flight)
+				{
+					flight = std::make_shared<Flight>(rank);
+					flight->future = promise.get_future().share();
+					flight->join(cancel != nullptr);
+					m_inFlight.emplace(key, flight);
+					leader = true;
+				}
+			}
+
+			net::CancellationToken::Registration registration;
+			if (cancel)
+			{
+				registration = cancel->subscribe([flight]() { flight->leave(); });
+			}
+
+			if (!leader)
+			{
+				return flight->wait(cancel);
+			}
+
+			try
+			{
+				promise.set_value(function(flight->token));
+			}
+			catch (...)
+			{
+				promise.set_exception(std::current_exception());
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto [first, last] = m_inFlight.equal_range(key);
+				for (auto it = first; it != last; it++)
+				{
+					if (it->second == flight)
+					{
+						m_inFlight.erase(it);
+						break;
+					}
+				}
+			}
+
+			flight->finish();
+
+			m_calls++;
+
+			return flight->future.get();
+		}
+
+		/**
+		 * @brief Returns the number of calls actually made.
+		 *
+		 * @return The call count.
+		 */
+		std::uint64_t getCallCount() const
+		{
+			return m_calls.load();
+		}
+
+		/**
+		 * @brief Returns the number of callers that joined a call already in flight instead of making their own.
+		 *
+		 * @return The number of calls saved.
+		 */
+		std::uint64_t getCoalescedCount() const
+		{
+			return m_coalesced.load();
+		}
+
+	private:
+		// A call in flight and the callers waiting for it
+		struct Flight
+		{
+			explicit Flight(int rank) : rank(rank)
+			{}
+
+			const int rank;
+			const std::shared_ptr<net::CancellationToken> token = std::make_shared<net::CancellationToken>();
+			std::shared_future<V> future;
+
+			std::mutex mutex;
+			std::condition_variable finished;
+			bool done = false;
+			int waiters = 0;
+			int cancelled = 0;
+			bool abandoned = false;
+
+			// A caller without a token of its own can never give up, so the call cannot be cancelled for it
+			bool cancellable = true;
+
+			// Adds a caller, unless everyone waiting has already given up on the call
+			bool join(bool canCancel)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+
+				if (abandoned)
+				{
+					return false;
+				}
+
+				waiters++;
+				cancellable = cancellable && canCancel;
+
+				return true;
+			}
+
+			// A caller cancelled, the call is cancelled too once no one is left waiting for it
+			void leave()
+			{
+				bool cancelCall = false;
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+
+					cancelled++;
+					cancelCall = cancellable && cancelled == waiters;
+					abandoned = abandoned || cancelCall;
+				}
+
+				finished.notify_all();
+
+				if (cancelCall)
+				{
+					token->cancel();
+				}
+			}
+
+			V wait(const std::shared_ptr<net::CancellationToken> &cancel)
+			{
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					finished.wait(lock, [this, &cancel]() { return done || (cancel && cancel->isCancelled()); });
+				}
+
+				if (cancel && cancel->isCancelled())
+				{
+					throw CancelledException();
+				}
+
+				return future.get();
+			}
+
+			void finish()
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					done = true;
+				}
+
+				finished.notify_all();
+			}
+		};
+
+		std::mutex m_mutex;
+		std::multimap<K, std::shared_ptr<Flight>> m_inFlight;
+
+		std::atomic<std::uint64_t> m_calls = 0;
+		std::atomic<std::uint64_t> m_coalesced = 0;
+	};
+}
+
+#endif //QRZ_SINGLEFLIGHT_H
@@ -0,0 +1,76 @@
+#include "StaleRecordRefresher.h"
+
+#include <algorithm>
+
+using namespace qrz;
+
+StaleRecordRefresher::StaleRecordRefresher(std::chrono::hours maxAge, int lookupsPerHour)
+		: m_maxAge(std::max(maxAge, std::chrono::hours(1))), m_lookupsPerHour(std::max(lookupsPerHour, 1))
+{
+}
+
+void StaleRecordRefresher::track(const std::string &call, Clock::time_point fetchedAt)
+{
+	m_fetchedAt[call] = fetchedAt;
+}
+
+void StaleRecordRefresher::forget(const std::string &call)
+{
+	m_fetchedAt.erase(call);
+}
+
+void StaleRecordRefresher::clear()
+{
+	m_fetchedAt.clear();
+}
+
+/**
+ * @brief Returns the stale record to check next, if the budget allows one now.
+ *
+ * The oldest record is chosen, since it is the one most likely to have changed. It is marked as fetched now, and the
+ * next check is held back for one interval of the budget.
+ *
+ * @param now The current time.
+ * @return The callsign, or nothing if no record is stale or the budget has been spent.
+ */
+std::optional<std::string> StaleRecordRefresher::next(Clock::time_point now)
+{
+	if (now < m_nextAllowed || m_fetchedAt.empty())
+	{
+		return std::nullopt;
+	}
+
+	auto oldest = std::min_element(m_fetchedAt.begin(), m_fetchedAt.end(),
+			[](const auto &a, const auto &b) { return a.second < b.second; });
+
+	if (now - oldest->second < m_maxAge)
+	{
+		return std::nullopt;
+	}
+
+	oldest->second = now;
+	m_nextAllowed = now + getInterval();
+
+	return oldest->first;
+}
+
+std::size_t StaleRecordRefresher::getStaleCount(Clock::time_point now) const
+{
+	return std::count_if(m_fetchedAt.begin(), m_fetchedAt.end(),
+			[this, now](const auto &entry) { return now - entry.second >= m_maxAge; });
+}
+
+void StaleRecordRefresher::setMaxAge(std::chrono::hours maxAge)
+{
+	m_maxAge = std::max(maxAge, std::chrono::hours(1));
+}
+
+void StaleRecordRefresher::setLookupsPerHour(int lookupsPerHour)
+{
+	m_lookupsPerHour = std::max(lookupsPerHour, 1);
+}
+
+StaleRecordRefresher::Clock::duration StaleRecordRefresher::getInterval() const
+{
+	return std::chrono::duration_cast<Clock::duration>(std::chrono::hours(1)) / m_lookupsPerHour;
+}
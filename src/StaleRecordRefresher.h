@@ -0,0 +1,109 @@
+#ifndef QRZ_STALERECORDREFRESHER_H
+#define QRZ_STALERECORDREFRESHER_H
+
+#include <chrono>
+#include <map>
+#include <optional>
+#include <string>
+
+namespace qrz
+{
+	/**
+	 * @class StaleRecordRefresher
+	 *
+	 * @brief Picks which record in the table to check against QRZ next, within a lookups-per-hour budget.
+	 *
+	 * Each record is tracked with the time it was fetched from QRZ. Once a record is older than the maximum age it is
+	 * stale, and next() hands out the oldest stale record, but never more often than the budget allows. The budget is
+	 * spread evenly over the hour rather than spent in a burst, so a session left running overnight checks a few
+	 * records at a time and the quota lasts the day.
+	 *
+	 * A record handed out counts as checked straight away, so a refresh that fails is not retried until the record is
+	 * stale again.
+	 *
+	 * The refresher is not thread safe, it is meant to be driven from the thread that owns the table.
+	 */
+	class StaleRecordRefresher
+	{
+	public:
+		typedef std::chrono::system_clock Clock;
+
+		/**
+		 * @brief Constructs a refresher that tracks no records.
+		 *
+		 * @param maxAge The age after which a record is checked again.
+		 * @param lookupsPerHour The number of records that may be checked per hour.
+		 */
+		explicit StaleRecordRefresher(std::chrono::hours maxAge = std::chrono::hours(12), int lookupsPerHour = 6);
+
+		/**
+		 * @brief Starts tracking a record, or notes that it was fetched again.
+		 *
+		 * @param call The callsign.
+		 * @param fetchedAt When the record was fetched from QRZ.
+		 */
+		void track(const std::string &call, Clock::time_point fetchedAt);
+
+		/**
+		 * @brief Stops tracking a record.
+		 *
+		 * @param call The callsign.
+		 */
+		void forget(const std::string &call);
+
+		/**
+		 * @brief Stops tracking every record.
+		 */
+		void clear();
+
+		/**
+		 * @brief Returns the stale record to check next, if the budget allows one now.
+		 *
+		 * @param now The current time.
+		 * @return The callsign, or nothing if no record is stale or the budget has been spent.
+		 */
+		std::optional<std::string> next(Clock::time_point now = Clock::now());
+
+		/**
+		 * @brief Returns the number of records tracked that are older than the maximum age.
+		 *
+		 * @param now The current time.
+		 * @return The number of stale records.
+		 */
+		std::size_t getStaleCount(Clock::time_point now = Clock::now()) const;
+
+		/**
+		 * @brief Sets the age after which a record is checked again.
+		 *
+		 * @param maxAge The maximum age, at least one hour.
+		 */
+		void setMaxAge(std::chrono::hours maxAge);
+
+		/**
+		 * @brief Sets the number of records that may be checked per hour.
+		 *
+		 * @param lookupsPerHour The budget, at least one.
+		 */
+		void setLookupsPerHour(int lookupsPerHour);
+
+		/**
+		 * @brief Returns the time that must pass between two checks to stay within the budget.
+		 *
+		 * @return The interval between checks.
+		 */
+		Clock::duration getInterval() const;
+
+	private:
+		// When each record was fetched from QRZ, keyed by callsign
+		std::map<std::string, Clock::time_point> m_fetchedAt;
+
+		std::chrono::hours m_maxAge;
+
+		int m_lookupsPerHour;
+
+		// The earliest time the next check may be handed out
+		Clock::time_point m_nextAllowed;
+	};
+}
+
+#endif //QRZ_STALERECORDREFRESHER_H
@@ -0,0 +1,111 @@
+#include "AliasIndex.h"
+
+#include "../CallsignCanonicalizer.h"
+
+using namespace qrz::cache;
+
+/**
+ * @brief Indexes the xref and aliases of a record.
+ *
+ * An alias that was indexed for another record is moved to this one, since QRZ has the final word on where a
+ * callsign belongs. The callsign of the record is never indexed as an alias, so a record fetched under its own
+ * callsign always takes precedence.
+ *
+ * @param callsign The record.
+ */
+void AliasIndex::add(const Callsign &callsign)
+{
+	std::string call = CallsignCanonicalizer::canonicalize(callsign.getCall());
+
+	if (call.empty())
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_aliases.erase(call);
+
+	link(CallsignCanonicalizer::canonicalize(callsign.getXref()), call);
+
+	for (const std::string &alias : splitAliases(callsign.getAliases()))
+	{
+		link(alias, call);
+	}
+}
+
+std::optional<std::string> AliasIndex::resolve(const std::string &call) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto it = m_aliases.find(CallsignCanonicalizer::canonicalize(call));
+	if (it == m_aliases.end())
+	{
+		return std::nullopt;
+	}
+
+	m_resolved++;
+
+	return it->second;
+}
+
+std::string AliasIndex::canonicalize(const std::string &call) const
+{
+	std::optional<std::string> resolved = resolve(call);
+
+	return resolved.has_value() ? resolved.value() : CallsignCanonicalizer::canonicalize(call);
+}
+
+void AliasIndex::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_aliases.clear();
+}
+
+std::size_t AliasIndex::size() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_aliases.size();
+}
+
+std::uint64_t AliasIndex::getResolvedCount() const
+{
+	return m_resolved;
+}
+
+std::vector<std::string> AliasIndex::splitAliases(const std::string &aliases)
+{
+	std::vector<std::string> calls;
+	std::string::size_type start = 0;
+
+	while (start <= aliases.size())
+	{
+		std::string::size_type end = aliases.find(',', start);
+		if (end == std::string::npos)
+		{
+			end = aliases.size();
+		}
+
+		std::string alias = CallsignCanonicalizer::canonicalize(aliases.substr(start, end - start));
+		if (!alias.empty())
+		{
+			calls.push_back(alias);
+		}
+
+		start = end + 1;
+	}
+
+	return calls;
+}
+
+void AliasIndex::link(const std::string &alias, const std::string &call)
+{
+	if (alias.empty() || alias == call)
+	{
+		return;
+	}
+
+	m_aliases[alias] = call;
+}
@@ -0,0 +1,96 @@
+#ifndef QRZ_ALIASINDEX_H
+#define QRZ_ALIASINDEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../model/Callsign.h"
+
+namespace qrz::cache
+{
+	/**
+	 * @class AliasIndex
+	 *
+	 * @brief Maps the other callsigns that resolve to a QRZ record onto the callsign of the record itself.
+	 *
+	 * QRZ answers a lookup of a portable callsign, a former callsign or an alias with the record of the operator, and
+	 * says so in two fields: xref holds the callsign that was asked for, and aliases lists the other callsigns known to
+	 * resolve to the record. Every record fetched is added here, so a later lookup of any of those callsigns can be
+	 * answered from the record already cached instead of going back to QRZ.
+	 *
+	 * All callsigns are keyed by CallsignCanonicalizer::canonicalize(), so a portable callsign resolves the same as the
+	 * callsign of its station, and input that cannot be a callsign is never indexed. The index is safe to use from
+	 * several threads at once.
+	 */
+	class AliasIndex
+	{
+	public:
+		AliasIndex() = default;
+
+		/**
+		 * @brief Indexes the xref and aliases of a record.
+		 *
+		 * @param callsign The record.
+		 */
+		void add(const Callsign &callsign);
+
+		/**
+		 * @brief Returns the callsign of the record a callsign resolves to.
+		 *
+		 * @param call The callsign.
+		 * @return The callsign of the record, or nothing if the callsign is not known to be an alias.
+		 */
+		std::optional<std::string> resolve(const std::string &call) const;
+
+		/**
+		 * @brief Returns the callsign a lookup of the given callsign is answered under.
+		 *
+		 * @param call The callsign.
+		 * @return The callsign of the record it resolves to, or the callsign itself, canonicalized.
+		 */
+		std::string canonicalize(const std::string &call) const;
+
+		/**
+		 * @brief Forgets every alias.
+		 */
+		void clear();
+
+		/**
+		 * @brief Returns the number of aliases known.
+		 */
+		std::size_t size() const;
+
+		/**
+		 * @brief Returns the number of times resolve() found an alias.
+		 */
+		std::uint64_t getResolvedCount() const;
+
+		/**
+		 * @brief Splits the aliases field of a record into callsigns.
+		 *
+		 * @param aliases The comma separated aliases, as QRZ sends them.
+		 * @return The canonical callsigns, without entries that cannot be a callsign.
+		 */
+		static std::vector<std::string> splitAliases(const std::string &aliases);
+
+	private:
+		mutable std::mutex m_mutex;
+
+		// Callsign of the record, keyed by alias
+		std::unordered_map<std::string, std::string> m_aliases;
+
+		mutable std::atomic<std::uint64_t> m_resolved = 0;
+
+		/**
+		 * @brief Maps an alias onto a record. Must be called with the mutex held.
+		 */
+		void link(const std::string &alias, const std::string &call);
+	};
+}
+
+#endif //QRZ_ALIASINDEX_H
@@ -0,0 +1,243 @@
+#include "BioCache.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <Poco/DeflatingStream.h>
+#include <Poco/InflatingStream.h>
+#include <Poco/StreamCopier.h>
+
+#include "../CallsignCanonicalizer.h"
+
+using namespace qrz::cache;
+
+BioCache::BioCache(const std::filesystem::path &directory, std::size_t memoryBudget)
+		: m_directory(directory), m_memoryBudget(memoryBudget)
+{
+	std::filesystem::create_directories(m_directory);
+}
+
+/**
+ * @brief Returns the cached bio for a callsign, if it is still current.
+ *
+ * Memory is checked first. A bio read from disk is kept in memory for next time.
+ *
+ * @param call The callsign.
+ * @param biodate The biodate of the callsign record.
+ * @return The bio HTML, or nothing if it is not cached for this biodate.
+ */
+std::optional<std::string> BioCache::get(const std::string &call, const std::string &biodate)
+{
+	std::string key = CallsignCanonicalizer::canonicalize(call);
+	if (key.empty())
+	{
+		return std::nullopt;
+	}
+
+	std::string compressed;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto it = m_memoryIndex.find(key);
+		if (it != m_memoryIndex.end() && it->second->biodate == biodate)
+		{
+			m_memory.splice(m_memory.begin(), m_memory, it->second);
+			m_memoryHits++;
+
+			compressed = it->second->compressed;
+		}
+		else
+		{
+			std::optional<std::string> stored = readFile(pathFor(call), biodate);
+			if (!stored.has_value())
+			{
+				m_misses++;
+				return std::nullopt;
+			}
+
+			m_diskHits++;
+
+			compressed = stored.value();
+			remember(key, biodate, compressed);
+		}
+	}
+
+	return decompress(compressed);
+}
+
+/**
+ * @brief Stores the bio for a callsign, replacing any older one.
+ *
+ * @param call The callsign.
+ * @param biodate The biodate of the callsign record.
+ * @param html The bio HTML.
+ */
+void BioCache::put(const std::string &call, const std::string &biodate, const std::string &html)
+{
+	std::string key = CallsignCanonicalizer::canonicalize(call);
+	if (key.empty())
+	{
+		return;
+	}
+
+	std::string compressed = compress(html);
+
+	std::filesystem::path path = pathFor(call);
+	std::filesystem::path tempPath = path;
+	tempPath += ".tmp";
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			throw std::runtime_error("Unable to write bio cache file " + tempPath.string());
+		}
+
+		out << m_magic << '\t' << m_version << '\t' << biodate << '\n';
+		out.write(compressed.data(), static_cast<std::streamsize>(compressed.size()));
+	}
+
+	std::filesystem::rename(tempPath, path);
+
+	remember(key, biodate, std::move(compressed));
+}
+
+void BioCache::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_memory.clear();
+	m_memoryIndex.clear();
+	m_memoryBytes = 0;
+
+	for (const auto &file : std::filesystem::directory_iterator(m_directory))
+	{
+		if (file.path().extension() == m_extension)
+		{
+			std::error_code ec;
+			std::filesystem::remove(file.path(), ec);
+		}
+	}
+}
+
+BioCacheStats BioCache::getStats() const
+{
+	BioCacheStats stats;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		stats.memoryHits = m_memoryHits;
+		stats.diskHits = m_diskHits;
+		stats.misses = m_misses;
+		stats.memoryEntries = m_memory.size();
+		stats.memoryBytes = m_memoryBytes;
+	}
+
+	// The disk is scanned without the lock, so lookups are not held up by it. A file removed by a concurrent put or
+	// clear is skipped rather than failing the scan.
+	std::error_code ec;
+	for (std::filesystem::directory_iterator it(m_directory, ec), end; !ec && it != end; it.increment(ec))
+	{
+		if (it->path().extension() != m_extension)
+		{
+			continue;
+		}
+
+		std::error_code sizeError;
+		std::uintmax_t size = it->file_size(sizeError);
+		if (!sizeError)
+		{
+			stats.diskBytes += size;
+		}
+	}
+
+	return stats;
+}
+
+std::string BioCache::compress(const std::string &data)
+{
+	std::ostringstream out;
+
+	Poco::DeflatingOutputStream deflater(out, Poco::DeflatingStreamBuf::STREAM_ZLIB);
+	deflater.write(data.data(), static_cast<std::streamsize>(data.size()));
+	deflater.close();
+
+	return out.str();
+}
+
+std::string BioCache::decompress(const std::string &data)
+{
+	std::istringstream in(data);
+	std::string out;
+
+	Poco::InflatingInputStream inflater(in, Poco::InflatingStreamBuf::STREAM_ZLIB);
+	Poco::StreamCopier::copyToString(inflater, out);
+
+	return out;
+}
+
+std::filesystem::path BioCache::pathFor(const std::string &call) const
+{
+	// The key of a portable callsign is the callsign of the station, so no slash ends up in the file name
+	return m_directory / (CallsignCanonicalizer::canonicalize(call) + m_extension);
+}
+
+/**
+ * @brief Reads the compressed bio from disk if it was stored for the given biodate.
+ */
+std::optional<std::string> BioCache::readFile(const std::filesystem::path &path, const std::string &biodate) const
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+	{
+		return std::nullopt;
+	}
+
+	std::string header;
+	std::getline(in, header);
+
+	if (header != m_magic + '\t' + std::to_string(m_version) + '\t' + biodate)
+	{
+		// Either an older bio, or a file we do not recognize, it will be replaced by the next put
+		return std::nullopt;
+	}
+
+	std::ostringstream compressed;
+	compressed << in.rdbuf();
+
+	return compressed.str();
+}
+
+void BioCache::remember(const std::string &key, const std::string &biodate, std::string compressed)
+{
+	// Drop the previous bio for this callsign, it is either the same one or out of date
+	auto it = m_memoryIndex.find(key);
+	if (it != m_memoryIndex.end())
+	{
+		m_memoryBytes -= it->second->compressed.size();
+		m_memory.erase(it->second);
+		m_memoryIndex.erase(it);
+	}
+
+	// A single bio larger than the whole budget is only kept on disk
+	if (compressed.size() > m_memoryBudget)
+	{
+		return;
+	}
+
+	m_memoryBytes += compressed.size();
+	m_memory.push_front({key, biodate, std::move(compressed)});
+	m_memoryIndex.emplace(key, m_memory.begin());
+
+	while (m_memoryBytes > m_memoryBudget)
+	{
+		m_memoryBytes -= m_memory.back().compressed.size();
+		m_memoryIndex.erase(m_memory.back().key);
+		m_memory.pop_back();
+	}
+}
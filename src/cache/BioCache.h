@@ -0,0 +1,153 @@
+#ifndef QRZ_BIOCACHE_H
+#define QRZ_BIOCACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace qrz::cache
+{
+	/**
+	 * @brief Snapshot of the counters kept by a BioCache.
+	 */
+	struct BioCacheStats
+	{
+		// Bios answered from memory
+		std::uint64_t memoryHits = 0;
+
+		// Bios answered from disk
+		std::uint64_t diskHits = 0;
+
+		// Bios that had to be downloaded, including ones whose biodate changed
+		std::uint64_t misses = 0;
+
+		// Bios held in memory
+		std::size_t memoryEntries = 0;
+
+		// Compressed bytes held in memory
+		std::size_t memoryBytes = 0;
+
+		// Compressed bytes stored on disk
+		std::uintmax_t diskBytes = 0;
+
+		/**
+		 * @brief Share of lookups answered from the cache.
+		 *
+		 * @return A value between 0.0 and 1.0, or 0.0 before the first lookup.
+		 */
+		double getHitRate() const
+		{
+			std::uint64_t total = memoryHits + diskHits + misses;
+			return (total == 0) ? 0.0 : static_cast<double>(memoryHits + diskHits) / total;
+		}
+	};
+
+	/**
+	 * @class BioCache
+	 *
+	 * @brief Cache of QRZ bio HTML, keyed by callsign and the biodate of the callsign record.
+	 *
+	 * QRZ changes the biodate of a record whenever its bio is edited, so a bio is only downloaded again once the
+	 * record says it has changed. Bios are deflated, both on disk and in memory. The most recently used bios are kept
+	 * in memory up to a byte budget, and every bio is kept on disk, one file per callsign holding the latest biodate.
+	 *
+	 * The cache is safe to use from several threads at once.
+	 */
+	class BioCache
+	{
+	public:
+		/**
+		 * @brief Constructs a cache stored in the given directory, creating it if needed.
+		 *
+		 * @param directory The directory holding the cache files.
+		 * @param memoryBudget The maximum number of compressed bytes held in memory.
+		 */
+		BioCache(const std::filesystem::path &directory, std::size_t memoryBudget);
+
+		/**
+		 * @brief Returns the cached bio for a callsign, if it is still current.
+		 *
+		 * @param call The callsign.
+		 * @param biodate The biodate of the callsign record.
+		 * @return The bio HTML, or nothing if it is not cached for this biodate.
+		 */
+		std::optional<std::string> get(const std::string &call, const std::string &biodate);
+
+		/**
+		 * @brief Stores the bio for a callsign, replacing any older one.
+		 *
+		 * @param call The callsign.
+		 * @param biodate The biodate of the callsign record.
+		 * @param html The bio HTML.
+		 */
+		void put(const std::string &call, const std::string &biodate, const std::string &html);
+
+		/**
+		 * @brief Removes every bio, from memory and from disk.
+		 */
+		void clear();
+
+		/**
+		 * @brief Returns the current counters and sizes.
+		 *
+		 * @return A snapshot of the cache statistics.
+		 */
+		BioCacheStats getStats() const;
+
+		/**
+		 * @brief Deflates a string.
+		 */
+		static std::string compress(const std::string &data);
+
+		/**
+		 * @brief Inflates a string produced by compress().
+		 */
+		static std::string decompress(const std::string &data);
+
+	private:
+		struct MemoryEntry
+		{
+			std::string key;
+			std::string biodate;
+			std::string compressed;
+		};
+
+		std::filesystem::path m_directory;
+		std::size_t m_memoryBudget;
+
+		mutable std::mutex m_mutex;
+
+		// Most recently used first, keyed by canonical callsign
+		std::list<MemoryEntry> m_memory;
+		std::unordered_map<std::string, std::list<MemoryEntry>::iterator> m_memoryIndex;
+		std::size_t m_memoryBytes = 0;
+
+		std::uint64_t m_memoryHits = 0;
+		std::uint64_t m_diskHits = 0;
+		std::uint64_t m_misses = 0;
+
+		// Identifies the file format, bump the version when the header changes
+		static inline const std::string m_magic = "QRZBUDDY-BIO";
+		static inline const int m_version = 1;
+
+		static inline const std::string m_extension = ".bio";
+
+		std::filesystem::path pathFor(const std::string &call) const;
+
+		/**
+		 * @brief Reads the compressed bio from disk if it was stored for the given biodate.
+		 */
+		std::optional<std::string> readFile(const std::filesystem::path &path, const std::string &biodate) const;
+
+		/**
+		 * @brief Adds a compressed bio to memory and evicts old ones to stay in budget. Must be called with the mutex held.
+		 */
+		void remember(const std::string &key, const std::string &biodate, std::string compressed);
+	};
+}
+
+#endif //QRZ_BIOCACHE_H
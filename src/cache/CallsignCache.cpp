@@ -0,0 +1,242 @@
+#include "CallsignCache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "../model/CallsignMarshaler.h"
+
+using namespace qrz::cache;
+
+CallsignCache::CallsignCache(const std::filesystem::path &directory, std::chrono::seconds ttl)
+		: m_directory(directory), m_ttl(ttl)
+{
+	std::filesystem::create_directories(m_directory);
+}
+
+std::optional<qrz::Callsign> CallsignCache::get(const std::string &call)
+{
+	std::optional<CallsignCacheEntry> entry = readEntry(pathFor(normalize(call)), true);
+
+	if (!entry.has_value())
+	{
+		m_misses++;
+		return std::nullopt;
+	}
+
+	if (!isFresh(entry.value()))
+	{
+		m_expired++;
+		return std::nullopt;
+	}
+
+	m_hits++;
+
+	return entry->callsign;
+}
+
+std::optional<CallsignCacheEntry> CallsignCache::getEntry(const std::string &call)
+{
+	return readEntry(pathFor(normalize(call)), true);
+}
+
+/**
+ * @brief Stores a record under the given callsign.
+ *
+ * The file is written under a temporary name and then renamed, so a reader never sees a half written record.
+ *
+ * @param call The callsign the record was looked up by.
+ * @param callsign The record to store.
+ * @param storedAt When the record was fetched from QRZ.
+ */
+void CallsignCache::put(const std::string &call, const Callsign &callsign, std::chrono::system_clock::time_point storedAt)
+{
+	std::string key = normalize(call);
+	std::filesystem::path path = pathFor(key);
+	std::filesystem::path tempPath = path;
+	tempPath += ".tmp";
+
+	auto seconds = std::chrono::duration_cast<std::chrono::seconds>(storedAt.time_since_epoch()).count();
+
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+
+	{
+		std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+		if (!out)
+		{
+			throw std::runtime_error("Unable to write callsign cache file " + tempPath.string());
+		}
+
+		out << m_magic << '\t' << m_version << '\t' << seconds << '\t' << key << '\t' << callsign.getSerial() << '\t'
+			<< callsign.getModdate() << '\n';
+		out << CallsignMarshaler::ToXML({callsign});
+	}
+
+	std::filesystem::rename(tempPath, path);
+
+	m_writes++;
+}
+
+void CallsignCache::remove(const std::string &call)
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+
+	std::error_code ec;
+	std::filesystem::remove(pathFor(normalize(call)), ec);
+}
+
+void CallsignCache::clear()
+{
+	std::lock_guard<std::mutex> lock(m_writeMutex);
+
+	for (const auto &file : std::filesystem::directory_iterator(m_directory))
+	{
+		if (file.path().extension() == m_extension)
+		{
+			std::error_code ec;
+			std::filesystem::remove(file.path(), ec);
+		}
+	}
+}
+
+/**
+ * @brief Lists the records that are older than the TTL, oldest first.
+ *
+ * Only the header of each file is read, the returned entries do not hold the record itself.
+ *
+ * @param limit The maximum number of entries to return.
+ * @return The stale entries.
+ */
+std::vector<CallsignCacheEntry> CallsignCache::findStale(std::size_t limit)
+{
+	std::vector<CallsignCacheEntry> stale;
+
+	for (const auto &file : std::filesystem::directory_iterator(m_directory))
+	{
+		if (file.path().extension() != m_extension)
+		{
+			continue;
+		}
+
+		std::optional<CallsignCacheEntry> entry = readEntry(file.path(), false);
+		if (entry.has_value() && !isFresh(entry.value()))
+		{
+			stale.push_back(std::move(entry.value()));
+		}
+	}
+
+	std::sort(stale.begin(), stale.end(), [](const CallsignCacheEntry &a, const CallsignCacheEntry &b)
+	{
+		return a.storedAt < b.storedAt;
+	});
+
+	if (stale.size() > limit)
+	{
+		stale.resize(limit);
+	}
+
+	return stale;
+}
+
+CallsignCacheStats CallsignCache::getStats() const
+{
+	return {m_hits.load(), m_misses.load(), m_expired.load(), m_writes.load()};
+}
+
+const std::filesystem::path &CallsignCache::getDirectory() const
+{
+	return m_directory;
+}
+
+std::chrono::seconds CallsignCache::getTtl() const
+{
+	return m_ttl;
+}
+
+std::string CallsignCache::normalize(const std::string &call)
+{
+	auto begin = std::find_if_not(call.begin(), call.end(), [](unsigned char c) { return std::isspace(c); });
+	auto end = std::find_if_not(call.rbegin(), call.rend(), [](unsigned char c) { return std::isspace(c); }).base();
+
+	std::string key = (begin < end) ? std::string(begin, end) : std::string();
+	std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return std::toupper(c); });
+
+	return key;
+}
+
+std::filesystem::path CallsignCache::pathFor(const std::string &key) const
+{
+	// Portable callsigns contain a slash, which cannot appear in a file name
+	std::string name = key;
+	std::replace_if(name.begin(), name.end(), [](unsigned char c) { return !std::isalnum(c); }, '_');
+
+	return m_directory / (name + m_extension);
+}
+
+/**
+ * @brief Reads a cache file, optionally with the record.
+ *
+ * Unreadable files are removed and reported as missing.
+ */
+std::optional<CallsignCacheEntry> CallsignCache::readEntry(const std::filesystem::path &path, bool withRecord)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+	{
+		return std::nullopt;
+	}
+
+	try
+	{
+		std::string header;
+		std::getline(in, header);
+
+		std::istringstream fields(header);
+		std::string magic, version, seconds;
+		CallsignCacheEntry entry;
+
+		std::getline(fields, magic, '\t');
+		std::getline(fields, version, '\t');
+		std::getline(fields, seconds, '\t');
+		std::getline(fields, entry.key, '\t');
+		std::getline(fields, entry.serial, '\t');
+		std::getline(fields, entry.moddate);
+
+		if (magic != m_magic || version != std::to_string(m_version))
+		{
+			throw std::runtime_error("Unrecognized cache file header");
+		}
+
+		entry.storedAt = std::chrono::system_clock::time_point(std::chrono::seconds(std::stoll(seconds)));
+
+		if (withRecord)
+		{
+			std::ostringstream xml;
+			xml << in.rdbuf();
+
+			entry.callsign = CallsignMarshaler::FromXml(xml.str());
+		}
+
+		return entry;
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << "Discarding callsign cache file " << path.string() << ": " << e.what() << std::endl;
+
+		in.close();
+
+		std::lock_guard<std::mutex> lock(m_writeMutex);
+
+		std::error_code ec;
+		std::filesystem::remove(path, ec);
+
+		return std::nullopt;
+	}
+}
+
+bool CallsignCache::isFresh(const CallsignCacheEntry &entry) const
+{
+	return std::chrono::system_clock::now() - entry.storedAt < m_ttl;
+}
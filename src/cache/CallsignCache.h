@@ -0,0 +1,184 @@
+#ifndef QRZ_CALLSIGNCACHE_H
+#define QRZ_CALLSIGNCACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../model/Callsign.h"
+
+namespace qrz::cache
+{
+	/**
+	 * @brief A cached callsign record, along with when it was stored.
+	 */
+	struct CallsignCacheEntry
+	{
+		// The normalized callsign the record was stored under
+		std::string key;
+
+		// When the record was fetched from QRZ
+		std::chrono::system_clock::time_point storedAt;
+
+		// QRZ db serial number of the record
+		std::string serial;
+
+		// QRZ last modified date of the record
+		std::string moddate;
+
+		// The record itself, empty when only the header was read
+		std::optional<Callsign> callsign;
+	};
+
+	/**
+	 * @brief Snapshot of the counters kept by a CallsignCache.
+	 */
+	struct CallsignCacheStats
+	{
+		// Lookups answered from the cache
+		std::uint64_t hits = 0;
+
+		// Lookups with no cached record
+		std::uint64_t misses = 0;
+
+		// Lookups whose cached record was older than the TTL
+		std::uint64_t expired = 0;
+
+		// Records written to the cache
+		std::uint64_t writes = 0;
+	};
+
+	/**
+	 * @class CallsignCache
+	 *
+	 * @brief Persistent cache of callsign records, one file per callsign.
+	 *
+	 * Each file starts with a single header line holding the time the record was stored, and the QRZ serial and
+	 * moddate of the record, followed by the record in the same XML format CallsignMarshaler produces. The header can
+	 * be read on its own, so stale records can be found without parsing every record.
+	 *
+	 * Records older than the TTL are not returned by get(), but are kept on disk until they are replaced, so a refresh
+	 * can compare the moddate of the new record against the old one.
+	 *
+	 * The cache is safe to use from several threads at once.
+	 */
+	class CallsignCache
+	{
+	public:
+		/**
+		 * @brief Constructs a cache stored in the given directory, creating it if needed.
+		 *
+		 * @param directory The directory holding the cache files.
+		 * @param ttl How long a record is considered fresh.
+		 */
+		CallsignCache(const std::filesystem::path &directory, std::chrono::seconds ttl);
+
+		/**
+		 * @brief Returns the fresh cached record for a callsign.
+		 *
+		 * @param call The callsign to look up.
+		 * @return The record, or nothing if there is no record or it is older than the TTL.
+		 */
+		std::optional<Callsign> get(const std::string &call);
+
+		/**
+		 * @brief Returns the cached record for a callsign, however old it is.
+		 *
+		 * @param call The callsign to look up.
+		 * @return The cache entry, or nothing if there is no readable record.
+		 */
+		std::optional<CallsignCacheEntry> getEntry(const std::string &call);
+
+		/**
+		 * @brief Stores a record under the given callsign.
+		 *
+		 * The file is written under a temporary name and then renamed, so a reader never sees a half written record.
+		 *
+		 * @param call The callsign the record was looked up by.
+		 * @param callsign The record to store.
+		 * @param storedAt When the record was fetched from QRZ.
+		 */
+		void put(const std::string &call, const Callsign &callsign,
+				 std::chrono::system_clock::time_point storedAt = std::chrono::system_clock::now());
+
+		/**
+		 * @brief Removes the record for a callsign.
+		 *
+		 * @param call The callsign to remove.
+		 */
+		void remove(const std::string &call);
+
+		/**
+		 * @brief Removes every record.
+		 */
+		void clear();
+
+		/**
+		 * @brief Lists the records that are older than the TTL, oldest first.
+		 *
+		 * Only the header of each file is read, the returned entries do not hold the record itself.
+		 *
+		 * @param limit The maximum number of entries to return.
+		 * @return The stale entries.
+		 */
+		std::vector<CallsignCacheEntry> findStale(std::size_t limit = SIZE_MAX);
+
+		/**
+		 * @brief Returns the current counters.
+		 *
+		 * @return A snapshot of the cache statistics.
+		 */
+		CallsignCacheStats getStats() const;
+
+		const std::filesystem::path &getDirectory() const;
+
+		std::chrono::seconds getTtl() const;
+
+		/**
+		 * @brief Normalizes a callsign for use as a cache key.
+		 *
+		 * @param call The callsign.
+		 * @return The callsign in upper case with surrounding whitespace removed.
+		 */
+		static std::string normalize(const std::string &call);
+
+	private:
+		std::filesystem::path m_directory;
+		std::chrono::seconds m_ttl;
+
+		// Serializes writes and removals, reads rely on the atomic rename
+		std::mutex m_writeMutex;
+
+		std::atomic<std::uint64_t> m_hits = 0;
+		std::atomic<std::uint64_t> m_misses = 0;
+		std::atomic<std::uint64_t> m_expired = 0;
+		std::atomic<std::uint64_t> m_writes = 0;
+
+		// Identifies the file format, bump the version when the header changes
+		static inline const std::string m_magic = "QRZBUDDY-CALLSIGN";
+		static inline const int m_version = 1;
+
+		static inline const std::string m_extension = ".xml";
+
+		/**
+		 * @brief Returns the file a callsign is stored in.
+		 */
+		std::filesystem::path pathFor(const std::string &key) const;
+
+		/**
+		 * @brief Reads a cache file, optionally with the record.
+		 *
+		 * Unreadable files are removed and reported as missing.
+		 */
+		std::optional<CallsignCacheEntry> readEntry(const std::filesystem::path &path, bool withRecord);
+
+		bool isFresh(const CallsignCacheEntry &entry) const;
+	};
+}
+
+#endif //QRZ_CALLSIGNCACHE_H
@@ -0,0 +1,227 @@
+#include "DeferredLookupQueue.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "../CallsignCanonicalizer.h"
+
+using namespace qrz::cache;
+
+DeferredLookupQueue::DeferredLookupQueue(const std::filesystem::path &path, std::size_t capacity)
+		: m_path(path), m_capacity(std::max<std::size_t>(capacity, 1))
+{
+	if (m_path.has_parent_path())
+	{
+		std::filesystem::create_directories(m_path.parent_path());
+	}
+
+	load();
+}
+
+/**
+ * @brief Adds a callsign to the back of the queue.
+ *
+ * A callsign already queued keeps its place, so one heard over and over is still looked up in the order it was first
+ * missed. If the queue is full, the oldest callsign is dropped to make room.
+ *
+ * @param call The callsign.
+ * @return True if the callsign was added, false if it was empty or already queued.
+ */
+bool DeferredLookupQueue::add(const std::string &call)
+{
+	std::string key = CallsignCanonicalizer::canonicalize(call);
+	if (key.empty())
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_index.contains(key))
+	{
+		return false;
+	}
+
+	while (m_entries.size() >= m_capacity)
+	{
+		m_index.erase(m_entries.front().call);
+		m_entries.pop_front();
+	}
+
+	m_entries.push_back(Entry{key, Clock::now()});
+	m_index[key] = std::prev(m_entries.end());
+
+	save();
+
+	return true;
+}
+
+std::optional<DeferredLookupQueue::Entry> DeferredLookupQueue::take()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_entries.empty())
+	{
+		return std::nullopt;
+	}
+
+	Entry entry = m_entries.front();
+
+	m_index.erase(entry.call);
+	m_entries.pop_front();
+
+	save();
+
+	return entry;
+}
+
+/**
+ * @brief Moves the callsign at the front of the queue to the back, and returns it.
+ *
+ * The callsign keeps the time it was first queued.
+ *
+ * @return The callsign, or nothing if the queue is empty.
+ */
+std::optional<DeferredLookupQueue::Entry> DeferredLookupQueue::rotate()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_entries.empty())
+	{
+		return std::nullopt;
+	}
+
+	// Splicing keeps the iterator held by the index valid
+	m_entries.splice(m_entries.end(), m_entries, m_entries.begin());
+
+	save();
+
+	return m_entries.back();
+}
+
+bool DeferredLookupQueue::remove(const std::string &call)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto it = m_index.find(CallsignCanonicalizer::canonicalize(call));
+	if (it == m_index.end())
+	{
+		return false;
+	}
+
+	m_entries.erase(it->second);
+	m_index.erase(it);
+
+	save();
+
+	return true;
+}
+
+bool DeferredLookupQueue::contains(const std::string &call) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_index.contains(CallsignCanonicalizer::canonicalize(call));
+}
+
+std::vector<DeferredLookupQueue::Entry> DeferredLookupQueue::getEntries() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return {m_entries.begin(), m_entries.end()};
+}
+
+std::size_t DeferredLookupQueue::size() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return m_entries.size();
+}
+
+void DeferredLookupQueue::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_entries.clear();
+	m_index.clear();
+
+	save();
+}
+
+void DeferredLookupQueue::load()
+{
+	std::ifstream in(m_path);
+	if (!in)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::string line;
+	while (std::getline(in, line))
+	{
+		std::size_t tab = line.find('\t');
+		if (tab == std::string::npos)
+		{
+			continue;
+		}
+
+		std::string key = CallsignCanonicalizer::canonicalize(line.substr(0, tab));
+
+		long long seconds = 0;
+		try
+		{
+			seconds = std::stoll(line.substr(tab + 1));
+		}
+		catch (std::exception &)
+		{
+			continue;
+		}
+
+		if (key.empty() || m_index.contains(key))
+		{
+			continue;
+		}
+
+		m_entries.push_back(Entry{key, Clock::time_point(std::chrono::seconds(seconds))});
+		m_index[key] = std::prev(m_entries.end());
+	}
+
+	// The capacity may have been lowered since the file was written
+	while (m_entries.size() > m_capacity)
+	{
+		m_index.erase(m_entries.front().call);
+		m_entries.pop_front();
+	}
+}
+
+/**
+ * @brief Writes the queue to its file. Must be called with the mutex held.
+ *
+ * The queue is written to a temporary file that then replaces the old one, so a crash part way through leaves the
+ * previous queue intact.
+ */
+void DeferredLookupQueue::save() const
+{
+	std::filesystem::path tempPath = m_path;
+	tempPath += ".tmp";
+
+	{
+		std::ofstream out(tempPath, std::ios::trunc);
+		if (!out)
+		{
+			throw std::runtime_error("Unable to write deferred lookup queue " + tempPath.string());
+		}
+
+		for (const Entry &entry : m_entries)
+		{
+			auto seconds = std::chrono::duration_cast<std::chrono::seconds>(entry.queued.time_since_epoch()).count();
+			out << entry.call << '\t' << seconds << '\n';
+		}
+	}
+
+	std::filesystem::rename(tempPath, m_path);
+}
@@ -0,0 +1,131 @@
+#ifndef QRZ_DEFERREDLOOKUPQUEUE_H
+#define QRZ_DEFERREDLOOKUPQUEUE_H
+
+#include <chrono>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace qrz::cache
+{
+	/**
+	 * @class DeferredLookupQueue
+	 *
+	 * @brief Callsigns that could not be looked up while QRZ was out of reach, kept on disk until they can be.
+	 *
+	 * Callsigns are held oldest first, each one only once, along with the time it was first queued. The queue is
+	 * written back to its file on every change, one callsign and its queued time per line, so lookups deferred when the
+	 * application is closed are picked up again the next time it starts. Once the capacity is reached, the oldest
+	 * callsign makes way for the newest.
+	 *
+	 * All callsigns are keyed by CallsignCanonicalizer::canonicalize(). The queue is safe to use from several threads at
+	 * once.
+	 */
+	class DeferredLookupQueue
+	{
+	public:
+		typedef std::chrono::system_clock Clock;
+
+		/**
+		 * @brief A callsign waiting to be looked up.
+		 */
+		struct Entry
+		{
+			std::string call;
+			Clock::time_point queued;
+		};
+
+		/**
+		 * @brief Constructs a queue stored in the given file, loading the callsigns already in it.
+		 *
+		 * @param path The file holding the queue. Its directory is created if needed.
+		 * @param capacity The maximum number of callsigns held.
+		 */
+		DeferredLookupQueue(const std::filesystem::path &path, std::size_t capacity = DEFAULT_CAPACITY);
+
+		DeferredLookupQueue(const DeferredLookupQueue &) = delete;
+
+		DeferredLookupQueue &operator=(const DeferredLookupQueue &) = delete;
+
+		/**
+		 * @brief Adds a callsign to the back of the queue.
+		 *
+		 * @param call The callsign.
+		 * @return True if the callsign was added, false if it was empty or already queued.
+		 */
+		bool add(const std::string &call);
+
+		/**
+		 * @brief Removes the callsign at the front of the queue and returns it.
+		 *
+		 * @return The callsign, or nothing if the queue is empty.
+		 */
+		std::optional<Entry> take();
+
+		/**
+		 * @brief Moves the callsign at the front of the queue to the back, and returns it.
+		 *
+		 * The callsign stays queued, so it is only gone once it is removed.
+		 *
+		 * @return The callsign, or nothing if the queue is empty.
+		 */
+		std::optional<Entry> rotate();
+
+		/**
+		 * @brief Removes a callsign from the queue, wherever it is.
+		 *
+		 * @param call The callsign.
+		 * @return True if the callsign was queued.
+		 */
+		bool remove(const std::string &call);
+
+		/**
+		 * @brief Returns whether a callsign is queued.
+		 */
+		bool contains(const std::string &call) const;
+
+		/**
+		 * @brief Returns the queued callsigns, oldest first.
+		 */
+		std::vector<Entry> getEntries() const;
+
+		/**
+		 * @brief Returns the number of callsigns queued.
+		 */
+		std::size_t size() const;
+
+		/**
+		 * @brief Removes every callsign.
+		 */
+		void clear();
+
+		// Enough for a long evening of band activity
+		static constexpr std::size_t DEFAULT_CAPACITY = 1000;
+
+	private:
+		std::filesystem::path m_path;
+		std::size_t m_capacity;
+
+		mutable std::mutex m_mutex;
+
+		// Oldest first, indexed by canonical callsign
+		std::list<Entry> m_entries;
+		std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+
+		/**
+		 * @brief Reads the queue from its file, skipping lines it does not recognize.
+		 */
+		void load();
+
+		/**
+		 * @brief Writes the queue to its file. Must be called with the mutex held.
+		 */
+		void save() const;
+	};
+}
+
+#endif //QRZ_DEFERREDLOOKUPQUEUE_H
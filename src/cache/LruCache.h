@@ -0,0 +1,275 @@
+#ifndef QRZ_LRUCACHE_H
+#define QRZ_LRUCACHE_H
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace qrz::cache
+{
+	/**
+	 * @brief Snapshot of the counters kept by an LruCache.
+	 */
+	struct LruCacheStats
+	{
+		// Lookups answered from the cache
+		std::uint64_t hits = 0;
+
+		// Lookups with no entry, or only an expired one
+		std::uint64_t misses = 0;
+
+		// Entries dropped to make room for newer ones
+		std::uint64_t evictions = 0;
+
+		// Entries dropped because they outlived the TTL
+		std::uint64_t expirations = 0;
+	};
+
+	/**
+	 * @class LruCache
+	 *
+	 * @brief Size bounded in-memory cache that drops the least recently used entry when full.
+	 *
+	 * Entries can also be given a time to live, after which they are treated as missing and dropped.
+	 *
+	 * The cache is safe to use from several threads at once.
+	 *
+	 * @tparam K The key type, which must be hashable.
+	 * @tparam V The value type.
+	 */
+	template<typename K, typename V>
+	class LruCache
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		/**
+		 * @brief Constructs an empty cache.
+		 *
+		 * @param capacity The maximum number of entries.
+		 * @param ttl How long an entry is kept, by default for as long as there is room for it.
+		 */
+		explicit LruCache(std::size_t capacity, Clock::duration ttl = Clock::duration::max())
+				: m_capacity(capacity), m_ttl(ttl)
+		{}
+
+		/**
+		 * @brief Returns the value for a key and marks it as recently used.
+		 *
+		 * @param key The key to look up.
+		 * @return The value, or nothing if there is no live entry for the key.
+		 */
+		std::optional<V> get(const K &key)
+		{
+			return get(key, Clock::now());
+		}
+
+		/**
+		 * @brief Returns the value for a key at the given time and marks it as recently used.
+		 *
+		 * @param key The key to look up.
+		 * @param now The current time.
+		 * @return The value, or nothing if there is no live entry for the key.
+		 */
+		std::optional<V> get(const K &key, Clock::time_point now)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto it = m_index.find(key);
+			if (it == m_index.end())
+			{
+				m_stats.misses++;
+				return std::nullopt;
+			}
+
+			if (it->second->expires <= now)
+			{
+				m_entries.erase(it->second);
+				m_index.erase(it);
+
+				m_stats.expirations++;
+				m_stats.misses++;
+
+				return std::nullopt;
+			}
+
+			// Move to the front of the list, the most recently used end
+			m_entries.splice(m_entries.begin(), m_entries, it->second);
+			m_stats.hits++;
+
+			return it->second->value;
+		}
+
+		/**
+		 * @brief Returns the value for a key without marking it as used or touching the counters.
+		 *
+		 * @param key The key to look up.
+		 * @return The value, or nothing if there is no live entry for the key.
+		 */
+		std::optional<V> peek(const K &key) const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto it = m_index.find(key);
+			if (it == m_index.end() || it->second->expires <= Clock::now())
+			{
+				return std::nullopt;
+			}
+
+			return it->second->value;
+		}
+
+		/**
+		 * @brief Stores a value, replacing any existing entry for the key.
+		 *
+		 * @param key The key.
+		 * @param value The value.
+		 */
+		void put(const K &key, V value)
+		{
+			put(key, std::move(value), Clock::now());
+		}
+
+		/**
+		 * @brief Stores a value at the given time, replacing any existing entry for the key.
+		 *
+		 * @param key The key.
+		 * @param value The value.
+		 * @param now The current time.
+		 */
+		void put(const K &key, V value, Clock::time_point now)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			if (m_capacity == 0)
+			{
+				return;
+			}
+
+			Clock::time_point expires = (m_ttl == Clock::duration::max()) ? Clock::time_point::max() : now + m_ttl;
+
+			auto it = m_index.find(key);
+			if (it != m_index.end())
+			{
+				it->second->value = std::move(value);
+				it->second->expires = expires;
+				m_entries.splice(m_entries.begin(), m_entries, it->second);
+
+				return;
+			}
+
+			m_entries.push_front({key, std::move(value), expires});
+			m_index.emplace(key, m_entries.begin());
+
+			evictOverflow();
+		}
+
+		/**
+		 * @brief Removes the entry for a key, if there is one.
+		 *
+		 * @param key The key.
+		 */
+		void remove(const K &key)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			auto it = m_index.find(key);
+			if (it != m_index.end())
+			{
+				m_entries.erase(it->second);
+				m_index.erase(it);
+			}
+		}
+
+		/**
+		 * @brief Removes every entry.
+		 */
+		void clear()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_entries.clear();
+			m_index.clear();
+		}
+
+		/**
+		 * @brief Changes the maximum number of entries, evicting the least recently used ones if needed.
+		 *
+		 * @param capacity The maximum number of entries.
+		 */
+		void setCapacity(std::size_t capacity)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_capacity = capacity;
+			evictOverflow();
+		}
+
+		/**
+		 * @brief Changes how long new entries are kept. Existing entries keep their expiry.
+		 *
+		 * @param ttl The time to live.
+		 */
+		void setTtl(Clock::duration ttl)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_ttl = ttl;
+		}
+
+		std::size_t size() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_entries.size();
+		}
+
+		/**
+		 * @brief Returns the current counters.
+		 *
+		 * @return A snapshot of the cache statistics.
+		 */
+		LruCacheStats getStats() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_stats;
+		}
+
+	private:
+		struct Entry
+		{
+			K key;
+			V value;
+			Clock::time_point expires;
+		};
+
+		mutable std::mutex m_mutex;
+
+		std::size_t m_capacity;
+		Clock::duration m_ttl;
+
+		// Most recently used first
+		std::list<Entry> m_entries;
+		std::unordered_map<K, typename std::list<Entry>::iterator> m_index;
+
+		LruCacheStats m_stats;
+
+		/**
+		 * @brief Drops least recently used entries until the cache fits its capacity. Must be called with the mutex held.
+		 */
+		void evictOverflow()
+		{
+			while (m_entries.size() > m_capacity)
+			{
+				m_index.erase(m_entries.back().key);
+				m_entries.pop_back();
+
+				m_stats.evictions++;
+			}
+		}
+	};
+}
+
+#endif //QRZ_LRUCACHE_H
@@ -0,0 +1,6 @@
+#include "CancelledException.h"
+
+const char* qrz::CancelledException::what() const noexcept
+{
+	return m_message.c_str();
+};
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef QRZ_CANCELLEDEXCEPTION_H
+#define QRZ_CANCELLEDEXCEPTION_H
+
+#include <exception>
+#include <string>
+
+namespace qrz
+{
+	/**
+	 * @class CancelledException
+	 * @brief Represents an exception that is thrown when an in-flight QRZ API request is cancelled by the caller.
+	 *
+	 * This exception class inherits from std::exception class.
+	 */
+	class CancelledException : public std::exception
+	{
+	public:
+		explicit CancelledException(std::string_view message = "QRZ request cancelled") : m_message(message)
+		{}
+
+		const char *what() const noexcept override;
+
+	private :
+		std::string m_message;
+	};
+}
+#endif //QRZ_CANCELLEDEXCEPTION_H
@@ -0,0 +1,6 @@
+#include "CircuitOpenException.h"
+
+const char* qrz::CircuitOpenException::what() const noexcept
+{
+	return m_message.c_str();
+};
\ No newline at end of file
@@ -0,0 +1,27 @@
+#ifndef QRZ_CIRCUITOPENEXCEPTION_H
+#define QRZ_CIRCUITOPENEXCEPTION_H
+
+#include <exception>
+#include <string>
+
+namespace qrz
+{
+	/**
+	 * @class CircuitOpenException
+	 * @brief Represents an exception that is thrown when a request is refused because QRZ has been failing.
+	 *
+	 * This exception class inherits from std::exception class.
+	 */
+	class CircuitOpenException : public std::exception
+	{
+	public:
+		explicit CircuitOpenException(std::string_view message = "QRZ is not responding, lookups are paused") : m_message(message)
+		{}
+
+		const char *what() const noexcept override;
+
+	private :
+		std::string m_message;
+	};
+}
+#endif //QRZ_CIRCUITOPENEXCEPTION_H
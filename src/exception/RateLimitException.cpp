@@ -0,0 +1,6 @@
+#include "RateLimitException.h"
+
+const char* qrz::RateLimitException::what() const noexcept
+{
+	return m_message.c_str();
+};
\ No newline at end of file
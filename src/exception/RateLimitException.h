@@ -0,0 +1,27 @@
+#ifndef QRZ_RATELIMITEXCEPTION_H
+#define QRZ_RATELIMITEXCEPTION_H
+
+#include <exception>
+#include <string>
+
+namespace qrz
+{
+	/**
+	 * @class RateLimitException
+	 * @brief Represents an exception that is thrown when a background lookup is held back to save QRZ lookup quota.
+	 *
+	 * This exception class inherits from std::exception class.
+	 */
+	class RateLimitException : public std::exception
+	{
+	public:
+		explicit RateLimitException(std::string_view message = "QRZ lookup deferred to save quota") : m_message(message)
+		{}
+
+		const char *what() const noexcept override;
+
+	private :
+		std::string m_message;
+	};
+}
+#endif //QRZ_RATELIMITEXCEPTION_H
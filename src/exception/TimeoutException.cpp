@@ -0,0 +1,6 @@
+#include "TimeoutException.h"
+
+const char* qrz::TimeoutException::what() const noexcept
+{
+	return m_message.c_str();
+};
\ No newline at end of file
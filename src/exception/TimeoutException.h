@@ -0,0 +1,27 @@
+#ifndef QRZ_TIMEOUTEXCEPTION_H
+#define QRZ_TIMEOUTEXCEPTION_H
+
+#include <exception>
+#include <string>
+
+namespace qrz
+{
+	/**
+	 * @class TimeoutException
+	 * @brief Represents an exception that is thrown when a QRZ API request runs past one of its deadlines.
+	 *
+	 * This exception class inherits from std::exception class.
+	 */
+	class TimeoutException : public std::exception
+	{
+	public:
+		explicit TimeoutException(std::string_view message = "QRZ request timed out") : m_message(message)
+		{}
+
+		const char *what() const noexcept override;
+
+	private :
+		std::string m_message;
+	};
+}
+#endif //QRZ_TIMEOUTEXCEPTION_H
@@ -0,0 +1,6 @@
+#include "TransportException.h"
+
+const char* qrz::TransportException::what() const noexcept
+{
+	return m_message.c_str();
+};
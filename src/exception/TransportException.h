@@ -0,0 +1,27 @@
+#ifndef QRZ_TRANSPORTEXCEPTION_H
+#define QRZ_TRANSPORTEXCEPTION_H
+
+#include <exception>
+#include <string>
+
+namespace qrz
+{
+	/**
+	 * @class TransportException
+	 * @brief Represents an exception that is thrown when QRZ could not be reached, or answered with an HTTP error.
+	 *
+	 * This exception class inherits from std::exception class.
+	 */
+	class TransportException : public std::exception
+	{
+	public:
+		explicit TransportException(std::string_view message = "QRZ could not be reached") : m_message(message)
+		{}
+
+		const char *what() const noexcept override;
+
+	private :
+		std::string m_message;
+	};
+}
+#endif //QRZ_TRANSPORTEXCEPTION_H
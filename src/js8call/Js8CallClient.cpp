@@ -6,10 +6,9 @@
 #include <QTcpSocket>
 #include <QTextStream>
 #include <QTimer>
+#include <algorithm>
 #include <random>
 
-#include "Message.h"
-
 Js8CallClient::Js8CallClient(const QString &host, int port, bool enabled) :
 																hostName(host),
 																port(port),
@@ -121,7 +120,7 @@ void Js8CallClient::socketReadyRead()
 
 		if(requestMap.contains(m.id()))
 		{
-			handleResponse(requestMap.at(m.id()), m.value().toStdString());
+			handleResponse(requestMap.at(m.id()), m);
 			requestMap.erase(m.id());
 		}
 
@@ -132,8 +131,9 @@ void Js8CallClient::socketReadyRead()
 void Js8CallClient::socketConnected()
 {
 	qDebug() << "Connected to JS8Call server";
-	emit clientConnected();
+	// Set this before we emit, so handlers may send requests straight away
 	connected = true;
+	emit clientConnected();
 	// Since we've connected successfully, we want to re-enable error alerts
 	hasEmittedSocketError = false;
 }
@@ -218,6 +218,10 @@ void Js8CallClient::sendRequest(Js8CallRequest request)
 	{
 		type = "STATION.GET_GRID";
 	}
+	else if(request.getType() == RX_GET_CALL_ACTIVITY)
+	{
+		type = "RX.GET_CALL_ACTIVITY";
+	}
 	else
 	{
 		throw std::invalid_argument("Invalid request type");
@@ -234,10 +238,51 @@ void Js8CallClient::sendRequest(Js8CallRequest request)
 	socket->flush();
 }
 
-void Js8CallClient::handleResponse(Js8CallRequest &request, std::string responseValue)
+void Js8CallClient::handleResponse(Js8CallRequest &request, const Message &response)
 {
+	if(request.getType() == RX_GET_CALL_ACTIVITY)
+	{
+		Js8CallActivityCallback callback = request.getActivityCallback();
+		callback(readCallActivity(response.params()));
+		return;
+	}
+
 	Js8CallResponseCallback callback = request.getCallback();
-	callback(responseValue);
+	callback(response.value().toStdString());
+}
+
+// RX.CALL_ACTIVITY carries one parameter per station heard, keyed by callsign, with the time it was last heard.
+// Stations without a time are skipped, so a malformed entry cannot jump the queue.
+std::vector<std::string> Js8CallClient::readCallActivity(const QMap<QString, QVariant> &params)
+{
+	std::vector<std::pair<qint64, std::string>> heard;
+
+	for(auto it = params.constBegin(); it != params.constEnd(); ++it)
+	{
+		if(it.key().startsWith("_") || it.key().startsWith("@"))
+		{
+			continue;
+		}
+
+		bool hasTime = false;
+		qint64 utc = it.value().toMap().value("UTC").toLongLong(&hasTime);
+		if(!hasTime || it.key().trimmed().isEmpty())
+		{
+			continue;
+		}
+
+		heard.emplace_back(utc, it.key().trimmed().toUpper().toStdString());
+	}
+
+	std::sort(heard.begin(), heard.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+
+	std::vector<std::string> calls;
+	for(auto &[utc, call] : heard)
+	{
+		calls.push_back(call);
+	}
+
+	return calls;
 }
 
 void Js8CallClient::getCallsign(Js8CallResponseCallback &callback)
@@ -256,3 +301,9 @@ void Js8CallClient::getGrid(Js8CallResponseCallback &callback)
 	sendRequest(request);
 }
 
+void Js8CallClient::getCallActivity(Js8CallActivityCallback callback)
+{
+	Js8CallRequest request(RX_GET_CALL_ACTIVITY, callback);
+
+	sendRequest(request);
+}
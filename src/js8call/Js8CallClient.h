@@ -6,6 +6,7 @@
 
 #include "../Configuration.h"
 #include "Js8CallRequest.h"
+#include "Message.h"
 
 class Js8CallClient : public QObject
 {
@@ -25,6 +26,11 @@ public slots:
 	void sendRequest(Js8CallRequest request);
 	void getCallsign(Js8CallResponseCallback &callback);
 	void getGrid(Js8CallResponseCallback &callback);
+	void getCallActivity(Js8CallActivityCallback callback);
+
+public:
+	// Reads the callsigns of an RX.CALL_ACTIVITY response, most recently heard first
+	static std::vector<std::string> readCallActivity(const QMap<QString, QVariant> &params);
 
 private slots:
 	void socketConnected();
@@ -49,7 +55,7 @@ private:
 	std::map<int, Js8CallRequest> requestMap;
 	bool connected = false;
 
-	void handleResponse(Js8CallRequest &request, std::string responseValue);
+	void handleResponse(Js8CallRequest &request, const Message &response);
 };
 
 
@@ -4,6 +4,10 @@ Js8CallRequest::Js8CallRequest(Js8CallRequestType type, Js8CallResponseCallback
 {
 }
 
+Js8CallRequest::Js8CallRequest(Js8CallRequestType type, Js8CallActivityCallback callback) : m_type(type), m_activityCallback(callback)
+{
+}
+
 Js8CallRequestType Js8CallRequest::getType()
 {
 	return m_type;
@@ -18,3 +22,8 @@ Js8CallResponseCallback Js8CallRequest::getCallback()
 {
 	return m_callback;
 }
+
+Js8CallActivityCallback Js8CallRequest::getActivityCallback()
+{
+	return m_activityCallback;
+}
@@ -7,21 +7,28 @@
 
 #include <string>
 #include <functional>
+#include <vector>
 #include "Js8CallRequestType.h"
 
 typedef std::function<void(const std::string &value)> Js8CallResponseCallback;
 
+// Receives the callsigns JS8Call has heard, most recently heard first
+typedef std::function<void(const std::vector<std::string> &calls)> Js8CallActivityCallback;
+
 class Js8CallRequest{
 public:
 	Js8CallRequest(Js8CallRequestType type, Js8CallResponseCallback callback);
+	Js8CallRequest(Js8CallRequestType type, Js8CallActivityCallback callback);
 	~Js8CallRequest() = default;
 	Js8CallRequestType getType();
 	Js8CallResponseCallback getCallback();
+	Js8CallActivityCallback getActivityCallback();
 	void handleResponse(const std::string &responseValue);
 
 private:
 	Js8CallRequestType m_type;
 	Js8CallResponseCallback m_callback;
+	Js8CallActivityCallback m_activityCallback;
 };
 
 #endif //QRZBUDDY_JS8CALLREQUEST_H
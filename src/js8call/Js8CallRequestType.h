@@ -10,6 +10,7 @@
 enum Js8CallRequestType
 {
 	STATION_GET_GRID,
-	STATION_GET_CALLSIGN
+	STATION_GET_CALLSIGN,
+	RX_GET_CALL_ACTIVITY
 };
 #endif //QRZBUDDY_JS8CALLREQUESTTYPE_H
@@ -19,6 +19,7 @@
 #include "ui_mainwindow.h"
 #include "tablemodel.h"
 #include "Util.h"
+#include "CallsignCanonicalizer.h"
 #include "SettingsDialog.h"
 #include "LoginDialog.h"
 #include "DetailDialog.h"
@@ -51,7 +52,9 @@ MainWindow::MainWindow(QWidget *parent) :
 	mapWindow = new mapwindow(this);
 	settingsDialog = new SettingsDialog(this, &config, js8CallClient);
 
-	// Add permanent status widget
+	// Add permanent status widgets
+	ui->statusbar->addPermanentWidget(&connectionStatusWidget);
+	ui->statusbar->addPermanentWidget(&quotaStatusWidget);
 	ui->statusbar->addPermanentWidget(&permanentStatusWidget);
 
 	ui->callsignTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
@@ -79,23 +82,45 @@ MainWindow::MainWindow(QWidget *parent) :
 
 	connect(controller, &AppController::credentialsNeeded, this, &MainWindow::collectCredentials);
 	connect(controller, &AppController::displayError, this, &MainWindow::showErrorDialog);
+	connect(controller, &AppController::sessionRefreshed, this, &MainWindow::updateStatusBar);
+	connect(controller, &AppController::serviceStateChanged, this, &MainWindow::updateStatusBar);
+	connect(controller, &AppController::lookupProgress, this, &MainWindow::onLookupProgress);
+	connect(controller, &AppController::lookupsFinished, this, &MainWindow::onLookupsFinished);
+	connect(controller, &AppController::bioFetched, this, &MainWindow::showCallsignBio);
 
 	controller->initialize();
 
+	ui->actionOfflineMode->setChecked(controller->isOfflineMode());
+	connect(ui->actionOfflineMode, &QAction::toggled, controller, &AppController::setOfflineMode);
+
+	updateStatusBar();
+
 	connect(js8CallClient, &Js8CallClient::messageReceived, this, &MainWindow::onJs8CallMessageReceived);
 	connect(js8CallClient, &Js8CallClient::error, this, &MainWindow::displaySocketError);
 	connect(js8CallClient, &Js8CallClient::clientConnected, this, &MainWindow::onJs8CallSocketConnected);
 	connect(js8CallClient, &Js8CallClient::clientDisconnected, this, &MainWindow::onJs8CallSocketDisconnected);
 	connect(&config, &Configuration::js8CallEnabledStateChange, js8CallClient, &Js8CallClient::changeState);
+	connect(&js8CallActivityTimer, &QTimer::timeout, this, &MainWindow::pollJs8CallActivity);
 	connect(&config, &Configuration::gridChanged, mapWindow, &mapwindow::setStationGrid);
 	connect(&config, &Configuration::coordsChanged, mapWindow, &mapwindow::setStationCoords);
 
 	connect(settingsDialog, &SettingsDialog::fetchCallsign, controller, &AppController::fetchCallsign);
 
+	callsignEntryTimer.setSingleShot(true);
+	callsignEntryTimer.setInterval(config.getTypeAheadDelay());
+	connect(&callsignEntryTimer, &QTimer::timeout, this, &MainWindow::onCallsignEntryPaused);
+	connect(ui->callsignEntry, &QLineEdit::textChanged, this, &MainWindow::onCallsignEntryTextChanged);
+
 	connect(mapWindow, &mapwindow::showDetailForCall, this, &MainWindow::showCallsignDetail);
 
 	connect(&tableModel, &TableModel::callsignAdded, mapWindow, &mapwindow::addCallsign);
+	connect(&tableModel, &TableModel::callsignAdded, this, &MainWindow::onCallsignAdded);
+	connect(&tableModel, &TableModel::callsignUpdated, mapWindow, &mapwindow::addCallsign);
 	connect(&tableModel, &TableModel::callsignRemoved, mapWindow, &mapwindow::removeCallsign);
+	connect(&tableModel, &TableModel::callsignRemoved, controller,
+			[this](const Callsign &callsign) { controller->cancelLookup(callsign.getCall()); });
+
+	connect(detailDialog, &DetailDialog::closed, controller, &AppController::cancelBioFetch);
 
 	printHandler.setView(&printView);
 
@@ -228,11 +253,12 @@ void MainWindow::showCallsignDetail(const QString &call)
 		Callsign callsign = tableModel.getCallsign(call.toStdString());
 
 		detailDialog->setCallsign(callsign);
+		detailDialog->ui.bioBrowser->clear();
 		detailDialog->show();
 
-		// Load bio after we show the window so we don't hold up the dialog
-		std::string bioHTML = controller->fetchBio(call.toStdString());
-		detailDialog->ui.bioBrowser->setHtml(bioHTML.c_str());
+		// The bio arrives later through showCallsignBio, so the dialog is not held up
+		detailCall = call;
+		controller->fetchBio(call.toStdString());
 	}
 	catch(std::exception &e)
 	{
@@ -240,6 +266,17 @@ void MainWindow::showCallsignDetail(const QString &call)
 	}
 }
 
+void MainWindow::showCallsignBio(const std::string &call, const std::string &html)
+{
+	// The dialog may have moved on to another callsign while this bio was downloading
+	if (detailCall.toStdString() != call)
+	{
+		return;
+	}
+
+	detailDialog->ui.bioBrowser->setHtml(html.c_str());
+}
+
 void MainWindow::showMapWindow()
 {
 	mapWindow->show();
@@ -305,31 +342,230 @@ void MainWindow::saveSettings() const
 	settings.sync();
 }
 
+void MainWindow::updateStatusBar()
+{
+	updateConnectionStatus();
+
+	QuotaStatus quota = controller->getQuotaStatus();
+	cache::BioCacheStats bioStats = controller->getBioCacheStats();
+
+	QString saved = QString("Duplicate lookups saved: %1\nBio cache: %2 KB on disk, %3 KB in memory, %4% hit rate")
+			.arg(controller->getCoalescedLookupCount())
+			.arg(bioStats.diskBytes / 1024)
+			.arg(bioStats.memoryBytes / 1024)
+			.arg(qRound(bioStats.getHitRate() * 100));
+
+	// Bytes on the wire matter on metered links, so show what compression saved
+	net::TransferStats total;
+	for (const auto &[endpoint, transfer] : controller->getTransferStats())
+	{
+		total += transfer;
+		saved += QString("\n%1: %2 KB received, %3 KB inflated")
+				.arg(QString::fromStdString(endpoint))
+				.arg(transfer.wireBytes / 1024)
+				.arg(transfer.bodyBytes / 1024);
+	}
+
+	saved += QString("\nData received: %1 KB, %2% saved by compression")
+			.arg(total.wireBytes / 1024)
+			.arg(qRound(total.getSavedFraction() * 100));
+
+	// Shows whether background traffic is keeping up, and what it costs the lookups the user asked for
+	LookupSchedulerStats queue = controller->getLookupQueueStats();
+	saved += QString("\nLookups waiting: %1 interactive, %2 detail, %3 background (%4 dropped, %5 merged)")
+			.arg(queue.queued[LookupPriority::INTERACTIVE])
+			.arg(queue.queued[LookupPriority::DETAIL])
+			.arg(queue.queued[LookupPriority::BACKGROUND])
+			.arg(queue.shed)
+			.arg(queue.merged);
+	saved += QString("\nAverage wait: %1 ms interactive, %2 ms detail, %3 ms background (longest %4 ms)")
+			.arg(queue.getAverageWait(LookupPriority::INTERACTIVE).count())
+			.arg(queue.getAverageWait(LookupPriority::DETAIL).count())
+			.arg(queue.getAverageWait(LookupPriority::BACKGROUND).count())
+			.arg(queue.maxWait[LookupPriority::BACKGROUND].count());
+
+	// Latency of each lookup provider, the numbers the hedge delay is tuned from
+	for (const LookupProviderStats &provider : controller->getLookupProviderStats())
+	{
+		saved += QString("\n%1: %2 lookups, %3 failed, p50 %4 ms, p90 %5 ms, p99 %6 ms")
+				.arg(QString::fromStdString(provider.name))
+				.arg(provider.lookups)
+				.arg(provider.failures)
+				.arg(provider.p50.count())
+				.arg(provider.p90.count())
+				.arg(provider.p99.count());
+
+		if (provider.hedgesWon > 0)
+		{
+			saved += QString(", %1 races won").arg(provider.hedgesWon);
+		}
+	}
+
+	if(!quota.hasCount())
+	{
+		quotaStatusWidget.setText("QRZ Lookups: --");
+		quotaStatusWidget.setToolTip("No lookup count has been received from QRZ yet\n" + saved);
+		quotaStatusWidget.setStyleSheet("color: #999999");
+
+		return;
+	}
+
+	quotaStatusWidget.setText(QString("QRZ Lookups Left: %1").arg(quota.getRemaining()));
+	quotaStatusWidget.setToolTip(QString("%1 of %2 lookups used today\nSubscription expires: %3\nQRZ server time: %4\n%5")
+										 .arg(quota.getCount())
+										 .arg(quota.getDailyLimit())
+										 .arg(QString::fromStdString(quota.getSubscriptionExpiration()))
+										 .arg(QString::fromStdString(quota.getServerTime()))
+										 .arg(saved));
+
+	// Background lookups start to slow down well before the quota is used up
+	if(quota.getRemainingFraction() < 0.1)
+	{
+		quotaStatusWidget.setStyleSheet("color: #FF0000");
+	}
+	else if(quota.getRemainingFraction() < 0.5)
+	{
+		quotaStatusWidget.setStyleSheet("color: #CC8800");
+	}
+	else
+	{
+		quotaStatusWidget.setStyleSheet("");
+	}
+}
+
+void MainWindow::updateConnectionStatus()
+{
+	net::CircuitBreakerStats breaker = controller->getCircuitBreakerStats();
+
+	// Lookups missed while offline are made again once QRZ is back, a few a minute
+	std::size_t deferred = controller->getDeferredLookupCount();
+	QString pending = (deferred > 0) ? QString(" (%1 deferred)").arg(deferred) : QString();
+
+	if (controller->isOfflineMode())
+	{
+		connectionStatusWidget.setText("QRZ: Offline" + pending);
+		connectionStatusWidget.setToolTip("Lookups are answered from local data only\n"
+										  "Turn off File > Work Offline to look up the deferred callsigns");
+		connectionStatusWidget.setStyleSheet("color: #999999");
+		return;
+	}
+
+	switch (breaker.state)
+	{
+		case net::CircuitState::CLOSED:
+			connectionStatusWidget.setText("QRZ: Online" + pending);
+			connectionStatusWidget.setToolTip(deferred > 0 ? "Looking up the callsigns missed while offline" : "");
+			connectionStatusWidget.setStyleSheet("");
+			break;
+		case net::CircuitState::OPEN:
+		{
+			qint64 seconds = (breaker.retryIn.count() + 999) / 1000;
+			QString retry = (seconds > 0) ? QString("Retrying in %1 s").arg(seconds) : QString("Retrying with the next lookup");
+
+			connectionStatusWidget.setText("QRZ: Unreachable" + pending);
+			connectionStatusWidget.setToolTip(QString("Lookups are answered from local data after %1 failed requests\n%2")
+													  .arg(breaker.consecutiveFailures)
+													  .arg(retry));
+			connectionStatusWidget.setStyleSheet("color: #FF0000");
+
+			// Nothing else happens while the pause runs out, so count it down here
+			if (seconds > 0)
+			{
+				QTimer::singleShot(1000, this, &MainWindow::updateConnectionStatus);
+			}
+			break;
+		}
+		case net::CircuitState::HALF_OPEN:
+			connectionStatusWidget.setText("QRZ: Reconnecting");
+			connectionStatusWidget.setToolTip("Trying QRZ again before resuming lookups");
+			connectionStatusWidget.setStyleSheet("color: #CC8800");
+			break;
+	}
+}
+
 void MainWindow::onCallsignEntryReturnPressed()
 {
 	qDebug() << "Callsign from manual input: " << ui->callsignEntry->text().toLocal8Bit().data();
 
+	// The lookup is made now, whatever the speculative lookup has got to
+	callsignEntryTimer.stop();
+
 	QString callsignInput = ui->callsignEntry->text();
 	QList<QString> calls = callsignInput.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
 
+	// The controller turns the terms into callsigns, and reports any that cannot be one
 	std::set<std::basic_string<char>> terms;
 	foreach(auto &call, calls)
 	{
-		std::string callStr = call.toStdString();
-		ToUpper(callStr);
-
-		terms.insert(callStr);
+		terms.insert(call.toStdString());
 	}
 
 	AppCommand cmd;
 	cmd.setSearchTerms(terms);
 
+	// The records are added to the table as they arrive, see onLookupsFinished
 	if(controller->handleCommand(cmd))
 	{
 		ui->callsignEntry->clear();
+	}
+
+	updateStatusBar();
+}
+
+void MainWindow::onCallsignEntryTextChanged(const QString &text)
+{
+	// The connection is opened while the user is still typing, the lookup itself waits for a pause
+	if(!text.trimmed().isEmpty())
+	{
+		controller->prewarmConnection();
+	}
+
+	callsignEntryTimer.start();
+}
+
+void MainWindow::onCallsignEntryPaused()
+{
+	// Only a single complete callsign is worth looking up before Enter is pressed, anything else cancels the lookup
+	controller->speculateCallsign(ui->callsignEntry->text().toStdString());
+}
+
+void MainWindow::onLookupProgress(int done, int total)
+{
+	LookupSchedulerStats queue = controller->getLookupQueueStats();
+	std::size_t waiting = queue.queued[LookupPriority::INTERACTIVE] + queue.queued[LookupPriority::DETAIL]
+						  + queue.queued[LookupPriority::BACKGROUND];
+
+	QString msg = QString("Looking up callsigns: %1 of %2").arg(done).arg(total);
+
+	if (waiting > 0)
+	{
+		msg += QString(", %1 more waiting").arg(waiting);
+	}
+
+	ui->statusbar->showMessage(msg);
+}
+
+void MainWindow::onLookupsFinished(int found)
+{
+	ui->statusbar->clearMessage();
+
+	if (found > 0)
+	{
 		ui->callsignTable->resizeColumnsToContents();
 		ui->callsignTable->horizontalHeader()->setStretchLastSection(true);
 	}
+
+	updateStatusBar();
+}
+
+void MainWindow::onCallsignAdded(const Callsign &callsign)
+{
+	QString call = QString::fromStdString(callsign.getCall());
+
+	if (pendingJs8CallActivity.contains(call))
+	{
+		applyJs8CallActivity(call, pendingJs8CallActivity.take(call));
+	}
 }
 
 void MainWindow::onJs8CallMessageReceived(QString msg)
@@ -367,73 +603,91 @@ void MainWindow::onJs8CallMessageReceived(QString msg)
 			{
 				qDebug() << "Callsign from JS8Call: " << from;
 
-				//Normalize compound callsigns like K4RWR/P
-				auto fromParts = from.split("/");
+				//Compound callsigns like VE3/K4RWR/P are looked up by the callsign of the station
+				std::string call = CallsignCanonicalizer::canonicalize(from.toStdString());
+				if (call.empty())
+				{
+					return;
+				}
 
 				std::set<std::basic_string<char>> terms;
-				terms.insert(fromParts.at(0).toStdString());
+				terms.insert(call);
 
+				// Stations heard on the air are looked up in the background, so they give way when quota runs low
 				AppCommand cmd;
 				cmd.setSearchTerms(terms);
+				cmd.setPriority(LookupPriority::BACKGROUND);
 
-				if(controller->handleCommand(cmd))
-				{
-					ui->callsignEntry->clear();
-					ui->callsignTable->resizeColumnsToContents();
-				}
+				bool queued = controller->handleCommand(cmd);
 
-				try
-				{
-					Callsign *callsign = tableModel.getCallsignPtr(from.toStdString());
+				updateStatusBar();
 
-					if (callsign == nullptr)
-					{
-						return;
-					}
+				// A station heard for the first time is still being looked up, so its activity waits for the record
+				if (!applyJs8CallActivity(from, params) && queued)
+				{
+					pendingJs8CallActivity.insert(QString::fromStdString(controller->resolveCallsign(call)), params);
+				}
+			}
+		}
+	}
+}
 
-					QDateTime now = QDateTime::currentDateTime();
-					QString datestamp = now.toString("yyyy-MM-dd hh:mm");
+bool MainWindow::applyJs8CallActivity(const QString &from, const QJsonObject &params)
+{
+	try
+	{
+		// The row is under the callsign of the record, which a portable or former callsign resolves to
+		Callsign *callsign = tableModel.getCallsignPtr(controller->resolveCallsign(from.toStdString()));
 
-					callsign->setLastHeard(datestamp.toStdString());
+		if (callsign == nullptr)
+		{
+			return false;
+		}
 
-					if (params.contains("SNR"))
-					{
-						auto snr = params.value("SNR").toInt();
-						qDebug() << from << "SNR: " << snr;
+		QDateTime now = QDateTime::currentDateTime();
+		QString datestamp = now.toString("yyyy-MM-dd hh:mm");
 
-						callsign->setSnr(snr);
-					}
+		callsign->setLastHeard(datestamp.toStdString());
 
-					if (params.contains("CMD"))
-					{
-						QString cmd = params.value("CMD").toString();
+		if (params.contains("SNR"))
+		{
+			auto snr = params.value("SNR").toInt();
+			qDebug() << from << "SNR: " << snr;
 
-						if (cmd.contains("SNR") && cmd.contains("SNR") && params.contains("EXTRA"))
-						{
-							QString recipCall = params.value("TO").toString();
-							int reportedSNR = params.value("EXTRA").toString().toInt();
+			callsign->setSnr(snr);
+		}
 
-							qDebug() << "Signal report to " << recipCall << " from " << from << ": " << reportedSNR;
+		if (params.contains("CMD"))
+		{
+			QString cmd = params.value("CMD").toString();
 
-							// If this is a signal report to us...
-							if (config.getUsername() == recipCall.toStdString())
-							{
-								qDebug() << "My signal report from " << from << ": " << reportedSNR;
+			if (cmd.contains("SNR") && cmd.contains("SNR") && params.contains("EXTRA"))
+			{
+				QString recipCall = params.value("TO").toString();
+				int reportedSNR = params.value("EXTRA").toString().toInt();
 
-								callsign->setReportedSnr(reportedSNR);
-							}
-						}
-					}
+				qDebug() << "Signal report to " << recipCall << " from " << from << ": " << reportedSNR;
 
-					mapWindow->addCallsign(*callsign);
-				}
-				catch(std::runtime_error &e)
+				// If this is a signal report to us...
+				if (config.getUsername() == recipCall.toStdString())
 				{
-					qDebug() << e.what();
+					qDebug() << "My signal report from " << from << ": " << reportedSNR;
+
+					callsign->setReportedSnr(reportedSNR);
 				}
 			}
 		}
+
+		mapWindow->addCallsign(*callsign);
+	}
+	catch(std::runtime_error &e)
+	{
+		qDebug() << e.what();
+
+		return false;
 	}
+
+	return true;
 }
 
 void MainWindow::onJs8CallSocketConnected()
@@ -442,10 +696,29 @@ void MainWindow::onJs8CallSocketConnected()
 	permanentStatusWidget.setStyleSheet("color: #00AA00");
 
 	settingsDialog->enableJs8CallPopulation();
+
+	// Stations heard before we connected are worth prefetching straight away
+	pollJs8CallActivity();
+	js8CallActivityTimer.start(std::chrono::seconds(config.getJs8CallActivityPoll()));
+}
+
+void MainWindow::pollJs8CallActivity()
+{
+	if(!js8CallClient->isConnected())
+	{
+		return;
+	}
+
+	js8CallClient->getCallActivity([this](const std::vector<std::string> &calls)
+	{
+		controller->prefetchCallsigns(calls);
+	});
 }
 
 void MainWindow::onJs8CallSocketDisconnected()
 {
+	js8CallActivityTimer.stop();
+
 	if(config.getJs8CallEnabled())
 	{
 		permanentStatusWidget.setText("JS8Call Disconnected");
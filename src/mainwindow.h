@@ -11,6 +11,9 @@
 #include <QSortFilterProxyModel>
 #include <QStringLiteral>
 #include <QLabel>
+#include <QJsonObject>
+#include <QMap>
+#include <QTimer>
 #include "tablemodel.h"
 #include "AppController.h"
 #include "js8call/Js8CallClient.h"
@@ -36,8 +39,11 @@ public:
 public slots:
 	//bool openFile(const QString &fileName);
 	void onCallsignEntryReturnPressed();
+	void onCallsignEntryTextChanged(const QString &text);
+	void onCallsignEntryPaused();
 	void onJs8CallMessageReceived(QString msg);
 	void showCallsignDetail(const QString &call);
+	void showCallsignBio(const std::string &call, const std::string &html);
 	bool collectCredentials();
 	void showErrorDialog(const std::string &msg);
 	void displaySocketError(int socketError, const QString &message);
@@ -53,10 +59,17 @@ private slots:
 	void onActionSaveJsonTriggered();
 	void onActionSaveMarkdownTriggered();
 	void showMapWindow();
+	void onLookupProgress(int done, int total);
+	void onLookupsFinished(int found);
+	void onCallsignAdded(const Callsign &callsign);
+	void pollJs8CallActivity();
 
 private:
 	void readSettings();
 	void saveSettings() const;
+	void updateStatusBar();
+	void updateConnectionStatus();
+	bool applyJs8CallActivity(const QString &from, const QJsonObject &params);
 	/*void restoreViewerSettings();
 	void resetViewer() const;
 	void saveViewerSettings() const;*/
@@ -70,11 +83,25 @@ private:
 	TableModel tableModel;
 	QSortFilterProxyModel proxyModel;
 	QLabel permanentStatusWidget;
+	QLabel quotaStatusWidget;
+	QLabel connectionStatusWidget;
 
 	Configuration config;
 	AppController *controller;
 	Js8CallClient *js8CallClient;
 
+	// The callsign shown in the detail dialog, whose bio is on its way
+	QString detailCall;
+
+	// JS8Call activity for stations whose records were still being looked up, keyed by callsign
+	QMap<QString, QJsonObject> pendingJs8CallActivity;
+
+	// Asks JS8Call for the stations it has heard, so their records can be prefetched
+	QTimer js8CallActivityTimer;
+
+	// Waits for a pause in typing before the callsign being typed is looked up speculatively
+	QTimer callsignEntryTimer;
+
 	QWebEngineView printView;
 	PrintHandler printHandler;
 
@@ -1,22 +1,22 @@
 #include "CallsignMarshaler.h"
 
-#include <format>
 #include <sstream>
 
 #include <Poco/DOM/AutoPtr.h>
 #include <Poco/DOM/Document.h>
-#include <Poco/DOM/DOMParser.h>
 #include <Poco/DOM/DOMWriter.h>
 #include <Poco/DOM/Element.h>
-#include <Poco/DOM/ElementsByTagNameList.h>
-#include <Poco/DOM/Node.h>
 #include <Poco/DOM/Text.h>
 #include <Poco/XML/XMLWriter.h>
 
+#include "QrzXmlDecoder.h"
+
 using namespace qrz;
 
 /**
- * @brief Converts an XML string representation of a callsign to a Callsign object using the POCO XML library.
+ * @brief Converts an XML string representation of a callsign to a Callsign object.
+ *
+ * The document is read in a single pass by QrzXmlDecoder, the same decoder used for QRZ API responses.
  *
  * @param xml_str The XML string representation of a callsign.
  *
@@ -26,103 +26,7 @@ using namespace qrz;
  */
 Callsign CallsignMarshaler::FromXml(const std::string &xml_str)
 {
-	Poco::XML::DOMParser parser;
-	Poco::AutoPtr<Poco::XML::Document> pDoc;
-
-	try
-	{
-		pDoc = parser.parseString(xml_str);
-	}
-	catch (Poco::Exception& e)
-	{
-		throw std::runtime_error(std::format("XML Parse error: {:s}", e.message()));
-	}
-
-	Poco::XML::Element* rootElement = pDoc->documentElement();
-	if (rootElement->nodeName() != "QRZDatabase")
-	{
-		throw std::runtime_error("Invalid XML - root not is not QRZDatabase");
-	}
-
-	Poco::XML::Element* dxccElement = rootElement->getChildElement("Callsign");
-	if (dxccElement == nullptr)
-	{
-		throw std::runtime_error("Invalid XML - no Callsign child");
-	}
-
-	Poco::XML::Node* currChild = dxccElement->firstChild();
-
-	Callsign callsign;
-
-	while (currChild != nullptr)
-	{
-		if (currChild->nodeType() == Poco::XML::Node::ELEMENT_NODE)
-		{
-			Poco::XML::Element *currentElement = static_cast<Poco::XML::Element *>(currChild);
-
-			const std::string name = currentElement->nodeName();
-			const std::string value = currentElement->innerText();
-
-			if (!name.empty() && !value.empty())
-			{
-				if (name == "call") callsign.setCall(value);
-				else if (name == "xref") callsign.setXref(value);
-				else if (name == "aliases") callsign.setAliases(value);
-				else if (name == "dxcc") callsign.setDxcc(value);
-				else if (name == "fname") callsign.setFname(value);
-				else if (name == "name") callsign.setName(value);
-				else if (name == "addr1") callsign.setAddr1(value);
-				else if (name == "addr2") callsign.setCity(value); // QRZ Schema sends city in addr
-				else if (name == "city") callsign.setCity(value); // In case QRZ ever fixes their API...
-				else if (name == "state") callsign.setState(value);
-				else if (name == "zip") callsign.setZip(value);
-				else if (name == "country") callsign.setCountry(value);
-				else if (name == "ccode") callsign.setCcode(value);
-				else if (name == "lat") callsign.setLat(value);
-				else if (name == "lon") callsign.setLon(value);
-				else if (name == "grid") callsign.setGrid(value);
-				else if (name == "county") callsign.setCounty(value);
-				else if (name == "fips") callsign.setFips(value);
-				else if (name == "land") callsign.setLand(value);
-				else if (name == "efdate") callsign.setEfdate(value);
-				else if (name == "expdate") callsign.setExpdate(value);
-				else if (name == "p_call") callsign.setPcall(value);
-				else if (name == "class") callsign.setClass(value);
-				else if (name == "codes") callsign.setCodes(value);
-				else if (name == "qslmgr") callsign.setQslmgr(value);
-				else if (name == "email") callsign.setEmail(value);
-				else if (name == "url") callsign.setUrl(value);
-				else if (name == "u_views") callsign.setUViews(atoi(value.c_str()));
-				else if (name == "bio") callsign.setBio(atoi(value.c_str()));
-				else if (name == "biodate") callsign.setBiodate(value);
-				else if (name == "image") callsign.setImage(value);
-				else if (name == "imageinfo") callsign.setImageinfo(value);
-				else if (name == "serial") callsign.setSerial(value);
-				else if (name == "moddate") callsign.setModdate(value);
-				else if (name == "MSA") callsign.setMsa(value);
-				else if (name == "AreaCode") callsign.setAreaCode(value);
-				else if (name == "TimeZone") callsign.setTimeZone(value);
-				else if (name == "GMTOffset") callsign.setGmtOffset(atoi(value.c_str()));
-				else if (name == "DST") callsign.setDst(value);
-				else if (name == "eqsl") callsign.setEqsl(value);
-				else if (name == "mqsl") callsign.setMqsl(value);
-				else if (name == "cqzone") callsign.setCqzone(atoi(value.c_str()));
-				else if (name == "ituzone") callsign.setItuzone(atoi(value.c_str()));
-				else if (name == "born") callsign.setBorn(value);
-				else if (name == "user") callsign.setUser(value);
-				else if (name == "lotw") callsign.setLotw(value);
-				else if (name == "iota") callsign.setIota(value);
-				else if (name == "geoloc") callsign.setGeoloc(value);
-				else if (name == "attn") callsign.setAttn(value);
-				else if (name == "nickname") callsign.setNickname(value);
-				else if (name == "name_fmt") callsign.setNameFmt(value);
-			}
-		}
-
-		currChild = currChild->nextSibling();
-	}
-
-	return callsign;
+	return QrzXmlDecoder::readCallsign(xml_str);
 }
 
 /**
@@ -158,7 +62,7 @@ std::string CallsignMarshaler::ToXML(const std::vector<Callsign> &callsigns)
 		pCallsignElement->appendChild(pDoc->createElement("state"))->appendChild(pDoc->createTextNode(callsign.getState()));
 		pCallsignElement->appendChild(pDoc->createElement("zip"))->appendChild(pDoc->createTextNode(callsign.getZip()));
 		pCallsignElement->appendChild(pDoc->createElement("country"))->appendChild(pDoc->createTextNode(callsign.getCountry()));
-		pCallsignElement->appendChild(pDoc->createElement("ccode"))->appendChild(pDoc->createTextNode(callsign.getCodes()));
+		pCallsignElement->appendChild(pDoc->createElement("ccode"))->appendChild(pDoc->createTextNode(callsign.getCcode()));
 		pCallsignElement->appendChild(pDoc->createElement("lat"))->appendChild(pDoc->createTextNode(callsign.getLat()));
 		pCallsignElement->appendChild(pDoc->createElement("lon"))->appendChild(pDoc->createTextNode(callsign.getLon()));
 		pCallsignElement->appendChild(pDoc->createElement("grid"))->appendChild(pDoc->createTextNode(callsign.getGrid()));
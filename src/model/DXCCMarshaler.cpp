@@ -1,26 +1,23 @@
 #include "DXCCMarshaler.h"
 
-#include <format>
 #include <sstream>
 #include <stdexcept>
 
 #include <Poco/DOM/AutoPtr.h>
 #include <Poco/DOM/Document.h>
-#include <Poco/DOM/DOMParser.h>
 #include <Poco/DOM/DOMWriter.h>
 #include <Poco/DOM/Element.h>
-#include <Poco/DOM/ElementsByTagNameList.h>
-#include <Poco/DOM/Node.h>
 #include <Poco/DOM/Text.h>
 #include <Poco/XML/XMLWriter.h>
 
+#include "QrzXmlDecoder.h"
+
 using namespace qrz;
 
 /**
  * @brief Converts an XML string representation of a DXCC record to a DXCC object.
  *
- * This function uses the Poco XML parser to parse the XML string and then extracts the relevant data from it to
- * populate the DXCC object.
+ * The document is read in a single pass by QrzXmlDecoder, the same decoder used for QRZ API responses.
  *
  * @param xml_str The XML string representation of a DXCC record.
  *
@@ -30,63 +27,7 @@ using namespace qrz;
  */
 DXCC DXCCMarshaler::FromXml(const std::string& xml_str)
 {
-	Poco::XML::DOMParser parser;
-	Poco::AutoPtr<Poco::XML::Document> pDoc;
-
-	try
-	{
-		pDoc = parser.parseString(xml_str);
-	}
-	catch (Poco::Exception& e)
-	{
-		throw std::runtime_error(std::format("XML Parse error: {:s}", e.message()));
-	}
-
-	Poco::XML::Element* rootElement = pDoc->documentElement();
-	if (rootElement->nodeName() != "QRZDatabase")
-	{
-		throw std::runtime_error("Invalid XML - root not is not QRZDatabase");
-	}
-
-	Poco::XML::Element* dxccElement = rootElement->getChildElement("DXCC");
-	if (dxccElement == nullptr)
-	{
-		throw std::runtime_error("Invalid XML - no DXCC child");
-	}
-
-	Poco::XML::Node* currChild = dxccElement->firstChild();
-
-	DXCC dxcc;
-
-	while (currChild)
-	{
-		if (currChild->nodeType() == Poco::XML::Node::ELEMENT_NODE)
-		{
-			Poco::XML::Element *currentElement = static_cast<Poco::XML::Element *>(currChild);
-
-			const std::string name = currentElement->nodeName();
-			const std::string value = currentElement->innerText();
-
-			if (!name.empty() && !value.empty())
-			{
-				if (name == "dxcc") dxcc.setDxcc(value);
-				else if (name == "cc") dxcc.setCc(value);
-				else if (name == "ccc") dxcc.setCcc(value);
-				else if (name == "name") dxcc.setName(value);
-				else if (name == "continent") dxcc.setContinent(value);
-				else if (name == "ituzone") dxcc.setItuzone(value);
-				else if (name == "cqzone") dxcc.setCqzone(value);
-				else if (name == "timezone") dxcc.setTimezone(value);
-				else if (name == "lat") dxcc.setLat(value);
-				else if (name == "lon") dxcc.setLon(value);
-				else if (name == "notes") dxcc.setNotes(value);
-			}
-		}
-
-		currChild = currChild->nextSibling();
-	}
-
-	return dxcc;
+	return QrzXmlDecoder::readDXCC(xml_str);
 }
 
 /**
@@ -0,0 +1,931 @@
+#include "QrzXmlDecoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+#include <string>
+
+#include "../exception/AuthenticationException.h"
+#include "../exception/NotFoundException.h"
+
+using namespace qrz;
+
+namespace
+{
+	// Deepest nesting an ignored element may have before the document is rejected
+	const int maxDepth = 64;
+
+	/**
+	 * @brief Reads XML markup from a buffer, one token at a time, without copying anything it does not have to.
+	 */
+	class Scanner
+	{
+	public:
+		/**
+		 * @brief A start tag. Its attributes are skipped.
+		 */
+		struct Tag
+		{
+			std::string_view name;
+
+			// Whether the tag closes itself, as in <xref/>
+			bool empty = false;
+		};
+
+		explicit Scanner(std::string_view xml) : m_xml(xml)
+		{}
+
+		/**
+		 * @brief Skips the XML declaration, comments, processing instructions and doctype before the root element.
+		 *
+		 * @throws std::runtime_error If the document is declared in an encoding the scanner cannot read.
+		 */
+		void skipProlog()
+		{
+			skipWhitespace();
+
+			if (startsWith("<?xml"))
+			{
+				std::size_t end = m_xml.find("?>", m_pos);
+				if (end == std::string_view::npos)
+				{
+					fail("unterminated XML declaration");
+				}
+
+				readEncoding(m_xml.substr(m_pos, end - m_pos));
+				m_pos = end + 2;
+			}
+
+			while (true)
+			{
+				skipMisc();
+
+				if (!startsWith("<!DOCTYPE"))
+				{
+					return;
+				}
+
+				skipPast(">");
+			}
+		}
+
+		/**
+		 * @brief Skips text, comments, CDATA sections and processing instructions up to the next tag.
+		 */
+		void skipToTag()
+		{
+			while (true)
+			{
+				std::size_t next = m_xml.find('<', m_pos);
+				if (next == std::string_view::npos)
+				{
+					fail("unexpected end of document");
+				}
+
+				m_pos = next;
+
+				if (startsWith("<!--"))
+				{
+					skipPast("-->");
+				}
+				else if (startsWith("<![CDATA["))
+				{
+					skipPast("]]>");
+				}
+				else if (startsWith("<?"))
+				{
+					skipPast("?>");
+				}
+				else
+				{
+					return;
+				}
+			}
+		}
+
+		/**
+		 * @brief Whether the scanner is at an end tag.
+		 */
+		bool atEndTag() const
+		{
+			return startsWith("</");
+		}
+
+		/**
+		 * @brief Reads a start tag.
+		 */
+		Tag readStartTag()
+		{
+			if (m_pos >= m_xml.size() || m_xml[m_pos] != '<')
+			{
+				fail("expected an element");
+			}
+
+			std::size_t start = ++m_pos;
+			skipName();
+
+			if (m_pos == start)
+			{
+				fail("expected an element name");
+			}
+
+			Tag tag;
+			tag.name = m_xml.substr(start, m_pos - start);
+
+			// Attribute values are quoted and may contain '>', so step over them whole
+			while (m_pos < m_xml.size())
+			{
+				char c = m_xml[m_pos];
+
+				if (c == '"' || c == '\'')
+				{
+					std::size_t close = m_xml.find(c, m_pos + 1);
+					if (close == std::string_view::npos)
+					{
+						fail("unterminated attribute value");
+					}
+
+					m_pos = close + 1;
+				}
+				else if (c == '>')
+				{
+					m_pos++;
+					return tag;
+				}
+				else if (c == '/' && startsWith("/>"))
+				{
+					m_pos += 2;
+					tag.empty = true;
+					return tag;
+				}
+				else
+				{
+					m_pos++;
+				}
+			}
+
+			fail("unterminated start tag");
+		}
+
+		/**
+		 * @brief Reads the end tag of an element.
+		 *
+		 * @param name The name of the element.
+		 */
+		void readEndTag(std::string_view name)
+		{
+			if (!atEndTag())
+			{
+				fail("expected an end tag");
+			}
+
+			std::size_t start = m_pos += 2;
+			skipName();
+
+			if (m_xml.substr(start, m_pos - start) != name)
+			{
+				fail(std::format("mismatched end tag, expected </{:s}>", name));
+			}
+
+			skipWhitespace();
+
+			if (m_pos >= m_xml.size() || m_xml[m_pos] != '>')
+			{
+				fail("unterminated end tag");
+			}
+
+			m_pos++;
+		}
+
+		/**
+		 * @brief Reads the text of an element, up to and including its end tag.
+		 *
+		 * Plain text comes back as a view into the buffer. Text that needs work, because it holds entity references
+		 * or CDATA, or has to be converted from ISO-8859-1, is decoded into a scratch buffer the view then points to,
+		 * so it is only valid until the next call. Markup nested inside the text is skipped.
+		 *
+		 * @param tag The start tag of the element, which has just been read.
+		 * @return The text.
+		 */
+		std::string_view readText(const Tag &tag)
+		{
+			if (tag.empty)
+			{
+				return {};
+			}
+
+			std::size_t next = m_xml.find('<', m_pos);
+			if (next == std::string_view::npos)
+			{
+				fail("unterminated element");
+			}
+
+			std::string_view text = m_xml.substr(m_pos, next - m_pos);
+			m_pos = next;
+
+			if (atEndTag() && isPlain(text))
+			{
+				readEndTag(tag.name);
+				return text;
+			}
+
+			m_scratch.clear();
+			appendText(text);
+
+			while (!atEndTag())
+			{
+				if (startsWith("<![CDATA["))
+				{
+					std::size_t end = m_xml.find("]]>", m_pos);
+					if (end == std::string_view::npos)
+					{
+						fail("unterminated CDATA section");
+					}
+
+					appendRaw(m_xml.substr(m_pos + 9, end - m_pos - 9));
+					m_pos = end + 3;
+				}
+				else if (startsWith("<!--"))
+				{
+					skipPast("-->");
+				}
+				else if (startsWith("<?"))
+				{
+					skipPast("?>");
+				}
+				else
+				{
+					skipElement(readStartTag());
+				}
+
+				next = m_xml.find('<', m_pos);
+				if (next == std::string_view::npos)
+				{
+					fail("unterminated element");
+				}
+
+				appendText(m_xml.substr(m_pos, next - m_pos));
+				m_pos = next;
+			}
+
+			readEndTag(tag.name);
+
+			return m_scratch;
+		}
+
+		/**
+		 * @brief Skips an element and everything in it.
+		 *
+		 * @param tag The start tag of the element, which has just been read.
+		 * @param depth How deeply the element is nested in other skipped elements.
+		 */
+		void skipElement(const Tag &tag, int depth = 0)
+		{
+			if (tag.empty)
+			{
+				return;
+			}
+
+			if (depth > maxDepth)
+			{
+				fail("elements nested too deeply");
+			}
+
+			while (true)
+			{
+				skipToTag();
+
+				if (atEndTag())
+				{
+					readEndTag(tag.name);
+					return;
+				}
+
+				skipElement(readStartTag(), depth + 1);
+			}
+		}
+
+		/**
+		 * @brief Checks that nothing but comments and whitespace follow the root element.
+		 */
+		void expectEnd()
+		{
+			skipMisc();
+
+			if (m_pos != m_xml.size())
+			{
+				fail("content after the root element");
+			}
+		}
+
+	private:
+		std::string_view m_xml;
+		std::size_t m_pos = 0;
+
+		// Whether the document is declared as ISO-8859-1, and so has to be converted to UTF-8
+		bool m_latin1 = false;
+
+		// Holds text that had to be decoded
+		std::string m_scratch;
+
+		[[noreturn]] void fail(std::string_view what) const
+		{
+			throw std::runtime_error(std::format("XML Parse error: {:s} at offset {:d}", what, m_pos));
+		}
+
+		bool startsWith(std::string_view prefix) const
+		{
+			return m_xml.substr(std::min(m_pos, m_xml.size())).starts_with(prefix);
+		}
+
+		static bool isSpace(char c)
+		{
+			return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+		}
+
+		void skipWhitespace()
+		{
+			while (m_pos < m_xml.size() && isSpace(m_xml[m_pos]))
+			{
+				m_pos++;
+			}
+		}
+
+		void skipName()
+		{
+			while (m_pos < m_xml.size() && !isSpace(m_xml[m_pos]) && m_xml[m_pos] != '>' && m_xml[m_pos] != '/')
+			{
+				m_pos++;
+			}
+		}
+
+		void skipPast(std::string_view terminator)
+		{
+			std::size_t end = m_xml.find(terminator, m_pos);
+			if (end == std::string_view::npos)
+			{
+				fail("unterminated markup");
+			}
+
+			m_pos = end + terminator.size();
+		}
+
+		/**
+		 * @brief Skips whitespace, comments and processing instructions.
+		 */
+		void skipMisc()
+		{
+			while (true)
+			{
+				skipWhitespace();
+
+				if (startsWith("<!--"))
+				{
+					skipPast("-->");
+				}
+				else if (startsWith("<?"))
+				{
+					skipPast("?>");
+				}
+				else
+				{
+					return;
+				}
+			}
+		}
+
+		void readEncoding(std::string_view declaration)
+		{
+			std::size_t at = declaration.find("encoding");
+			if (at == std::string_view::npos)
+			{
+				return;
+			}
+
+			std::size_t open = declaration.find_first_of("\"'", at);
+			std::size_t close = (open == std::string_view::npos) ? open : declaration.find(declaration[open], open + 1);
+			if (close == std::string_view::npos)
+			{
+				fail("malformed XML declaration");
+			}
+
+			std::string encoding(declaration.substr(open + 1, close - open - 1));
+			std::transform(encoding.begin(), encoding.end(), encoding.begin(), [](unsigned char c) { return std::tolower(c); });
+
+			if (encoding == "iso-8859-1" || encoding == "latin1")
+			{
+				m_latin1 = true;
+			}
+			else if (encoding != "utf-8" && encoding != "us-ascii")
+			{
+				throw std::runtime_error(std::format("Unsupported XML encoding: {:s}", encoding));
+			}
+		}
+
+		/**
+		 * @brief Whether text can be used exactly as it appears in the buffer.
+		 */
+		bool isPlain(std::string_view text) const
+		{
+			if (text.find('&') != std::string_view::npos)
+			{
+				return false;
+			}
+
+			return !m_latin1 || std::none_of(text.begin(), text.end(), [](char c) { return static_cast<unsigned char>(c) >= 0x80; });
+		}
+
+		/**
+		 * @brief Appends text to the scratch buffer, resolving entity and character references.
+		 */
+		void appendText(std::string_view text)
+		{
+			std::size_t pos = 0;
+
+			while (pos < text.size())
+			{
+				std::size_t amp = text.find('&', pos);
+				if (amp == std::string_view::npos)
+				{
+					appendRaw(text.substr(pos));
+					return;
+				}
+
+				appendRaw(text.substr(pos, amp - pos));
+
+				std::size_t semicolon = text.find(';', amp);
+				if (semicolon == std::string_view::npos)
+				{
+					fail("unterminated entity reference");
+				}
+
+				appendEntity(text.substr(amp + 1, semicolon - amp - 1));
+				pos = semicolon + 1;
+			}
+		}
+
+		/**
+		 * @brief Appends text that needs no entity resolution, converting it from ISO-8859-1 if necessary.
+		 */
+		void appendRaw(std::string_view text)
+		{
+			if (!m_latin1)
+			{
+				m_scratch.append(text);
+				return;
+			}
+
+			for (char c : text)
+			{
+				appendCodePoint(static_cast<unsigned char>(c));
+			}
+		}
+
+		void appendEntity(std::string_view name)
+		{
+			if (name == "amp") m_scratch += '&';
+			else if (name == "lt") m_scratch += '<';
+			else if (name == "gt") m_scratch += '>';
+			else if (name == "quot") m_scratch += '"';
+			else if (name == "apos") m_scratch += '\'';
+			else if (name.starts_with('#'))
+			{
+				bool hex = name.starts_with("#x");
+				std::string_view digits = name.substr(hex ? 2 : 1);
+
+				std::uint32_t codePoint = 0;
+				auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.size(), codePoint, hex ? 16 : 10);
+
+				if (digits.empty() || error != std::errc() || end != digits.data() + digits.size() || codePoint == 0 ||
+					codePoint > 0x10FFFF)
+				{
+					fail("invalid character reference");
+				}
+
+				appendCodePoint(codePoint);
+			}
+			else
+			{
+				fail(std::format("unknown entity &{:s};", name));
+			}
+		}
+
+		void appendCodePoint(std::uint32_t codePoint)
+		{
+			if (codePoint < 0x80)
+			{
+				m_scratch += static_cast<char>(codePoint);
+			}
+			else if (codePoint < 0x800)
+			{
+				m_scratch += static_cast<char>(0xC0 | (codePoint >> 6));
+				m_scratch += static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			else if (codePoint < 0x10000)
+			{
+				m_scratch += static_cast<char>(0xE0 | (codePoint >> 12));
+				m_scratch += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				m_scratch += static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			else
+			{
+				m_scratch += static_cast<char>(0xF0 | (codePoint >> 18));
+				m_scratch += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+				m_scratch += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				m_scratch += static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+		}
+	};
+
+	/**
+	 * @brief Maps an element name to the code that stores its text in a record.
+	 */
+	template<typename T>
+	struct Field
+	{
+		std::string_view name;
+		void (*apply)(T &record, std::string_view value);
+	};
+
+	/**
+	 * @brief Sorts a field table by name at compile time, so it can be searched with a binary search.
+	 */
+	template<typename T, std::size_t N>
+	consteval std::array<Field<T>, N> sortByName(std::array<Field<T>, N> fields)
+	{
+		std::sort(fields.begin(), fields.end(), [](const Field<T> &a, const Field<T> &b) { return a.name < b.name; });
+		return fields;
+	}
+
+	template<typename T, std::size_t N>
+	const Field<T> *findField(const std::array<Field<T>, N> &fields, std::string_view name)
+	{
+		auto it = std::lower_bound(fields.begin(), fields.end(), name,
+								   [](const Field<T> &field, std::string_view value) { return field.name < value; });
+
+		return (it != fields.end() && it->name == name) ? &*it : nullptr;
+	}
+
+	/**
+	 * @brief Reads a number the way atoi() does: leading whitespace and a plus sign are skipped, anything after the
+	 * digits is ignored, and text that does not start with a number gives 0.
+	 */
+	int toInt(std::string_view value)
+	{
+		std::size_t start = value.find_first_not_of(" \t\r\n");
+		if (start == std::string_view::npos)
+		{
+			return 0;
+		}
+
+		value.remove_prefix(start);
+		if (value.starts_with('+'))
+		{
+			value.remove_prefix(1);
+		}
+
+		int number = 0;
+		std::from_chars(value.data(), value.data() + value.size(), number);
+
+		return number;
+	}
+
+	template<typename T, void (T::*Setter)(const std::string &)>
+	void setText(T &record, std::string_view value)
+	{
+		(record.*Setter)(std::string(value));
+	}
+
+	template<typename T, void (T::*Setter)(int)>
+	void setNumber(T &record, std::string_view value)
+	{
+		(record.*Setter)(toInt(value));
+	}
+
+	/**
+	 * @brief The parts of a Session element the decoder cares about.
+	 */
+	struct Session
+	{
+		bool present = false;
+		std::string error;
+		QuotaStatus quota;
+	};
+
+	/**
+	 * @brief Stands in for the record when only the Session element is wanted.
+	 */
+	struct NoRecord
+	{
+	};
+
+	constexpr auto sessionFields = sortByName(std::array<Field<Session>, 4>{{
+			{"Count", [](Session &session, std::string_view value)
+			{
+				int count = 0;
+				auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), count);
+
+				// Leave the count unknown rather than guess
+				if (error == std::errc() && end == value.data() + value.size())
+				{
+					session.quota.setCount(count);
+				}
+			}},
+			{"Error", [](Session &session, std::string_view value) { session.error = value; }},
+			{"GMTime", [](Session &session, std::string_view value) { session.quota.setServerTime(std::string(value)); }},
+			{"SubExp", [](Session &session, std::string_view value) { session.quota.setSubscriptionExpiration(std::string(value)); }},
+	}});
+
+	constexpr auto callsignFields = sortByName(std::array<Field<Callsign>, 51>{{
+			{"call", setText<Callsign, &Callsign::setCall>},
+			{"xref", setText<Callsign, &Callsign::setXref>},
+			{"aliases", setText<Callsign, &Callsign::setAliases>},
+			{"dxcc", setText<Callsign, &Callsign::setDxcc>},
+			{"fname", setText<Callsign, &Callsign::setFname>},
+			{"name", setText<Callsign, &Callsign::setName>},
+			{"addr1", setText<Callsign, &Callsign::setAddr1>},
+			{"addr2", setText<Callsign, &Callsign::setCity>}, // QRZ Schema sends city in addr
+			{"city", setText<Callsign, &Callsign::setCity>}, // In case QRZ ever fixes their API...
+			{"state", setText<Callsign, &Callsign::setState>},
+			{"zip", setText<Callsign, &Callsign::setZip>},
+			{"country", setText<Callsign, &Callsign::setCountry>},
+			{"ccode", setText<Callsign, &Callsign::setCcode>},
+			{"lat", setText<Callsign, &Callsign::setLat>},
+			{"lon", setText<Callsign, &Callsign::setLon>},
+			{"grid", setText<Callsign, &Callsign::setGrid>},
+			{"county", setText<Callsign, &Callsign::setCounty>},
+			{"fips", setText<Callsign, &Callsign::setFips>},
+			{"land", setText<Callsign, &Callsign::setLand>},
+			{"efdate", setText<Callsign, &Callsign::setEfdate>},
+			{"expdate", setText<Callsign, &Callsign::setExpdate>},
+			{"p_call", setText<Callsign, &Callsign::setPcall>},
+			{"class", setText<Callsign, &Callsign::setClass>},
+			{"codes", setText<Callsign, &Callsign::setCodes>},
+			{"qslmgr", setText<Callsign, &Callsign::setQslmgr>},
+			{"email", setText<Callsign, &Callsign::setEmail>},
+			{"url", setText<Callsign, &Callsign::setUrl>},
+			{"u_views", setNumber<Callsign, &Callsign::setUViews>},
+			{"bio", setNumber<Callsign, &Callsign::setBio>},
+			{"biodate", setText<Callsign, &Callsign::setBiodate>},
+			{"image", setText<Callsign, &Callsign::setImage>},
+			{"imageinfo", setText<Callsign, &Callsign::setImageinfo>},
+			{"serial", setText<Callsign, &Callsign::setSerial>},
+			{"moddate", setText<Callsign, &Callsign::setModdate>},
+			{"MSA", setText<Callsign, &Callsign::setMsa>},
+			{"AreaCode", setText<Callsign, &Callsign::setAreaCode>},
+			{"TimeZone", setText<Callsign, &Callsign::setTimeZone>},
+			{"GMTOffset", setNumber<Callsign, &Callsign::setGmtOffset>},
+			{"DST", setText<Callsign, &Callsign::setDst>},
+			{"eqsl", setText<Callsign, &Callsign::setEqsl>},
+			{"mqsl", setText<Callsign, &Callsign::setMqsl>},
+			{"cqzone", setNumber<Callsign, &Callsign::setCqzone>},
+			{"ituzone", setNumber<Callsign, &Callsign::setItuzone>},
+			{"born", setText<Callsign, &Callsign::setBorn>},
+			{"user", setText<Callsign, &Callsign::setUser>},
+			{"lotw", setText<Callsign, &Callsign::setLotw>},
+			{"iota", setText<Callsign, &Callsign::setIota>},
+			{"geoloc", setText<Callsign, &Callsign::setGeoloc>},
+			{"attn", setText<Callsign, &Callsign::setAttn>},
+			{"nickname", setText<Callsign, &Callsign::setNickname>},
+			{"name_fmt", setText<Callsign, &Callsign::setNameFmt>},
+	}});
+
+	constexpr auto dxccFields = sortByName(std::array<Field<DXCC>, 11>{{
+			{"dxcc", setText<DXCC, &DXCC::setDxcc>},
+			{"cc", setText<DXCC, &DXCC::setCc>},
+			{"ccc", setText<DXCC, &DXCC::setCcc>},
+			{"name", setText<DXCC, &DXCC::setName>},
+			{"continent", setText<DXCC, &DXCC::setContinent>},
+			{"ituzone", setText<DXCC, &DXCC::setItuzone>},
+			{"cqzone", setText<DXCC, &DXCC::setCqzone>},
+			{"timezone", setText<DXCC, &DXCC::setTimezone>},
+			{"lat", setText<DXCC, &DXCC::setLat>},
+			{"lon", setText<DXCC, &DXCC::setLon>},
+			{"notes", setText<DXCC, &DXCC::setNotes>},
+	}});
+
+	constexpr std::array<Field<NoRecord>, 0> noFields = {};
+
+	static_assert(std::adjacent_find(callsignFields.begin(), callsignFields.end(),
+									 [](const auto &a, const auto &b) { return a.name == b.name; }) == callsignFields.end(),
+				  "Callsign fields must be unique");
+
+	/**
+	 * @brief Reads the child elements of a record or Session element into the matching fields.
+	 *
+	 * Elements without a field, and elements with no text, are skipped.
+	 */
+	template<typename T, std::size_t N>
+	void readFields(Scanner &scanner, const Scanner::Tag &parent, const std::array<Field<T>, N> &fields, T &record)
+	{
+		if (parent.empty)
+		{
+			return;
+		}
+
+		while (true)
+		{
+			scanner.skipToTag();
+
+			if (scanner.atEndTag())
+			{
+				scanner.readEndTag(parent.name);
+				return;
+			}
+
+			Scanner::Tag tag = scanner.readStartTag();
+			const Field<T> *field = findField(fields, tag.name);
+
+			if (field == nullptr)
+			{
+				scanner.skipElement(tag);
+				continue;
+			}
+
+			std::string_view value = scanner.readText(tag);
+			if (!value.empty())
+			{
+				field->apply(record, value);
+			}
+		}
+	}
+
+	/**
+	 * @brief Walks a QRZDatabase document once, reading its Session element and the record element named recordTag.
+	 *
+	 * @return True if the record element was found.
+	 */
+	template<typename T, std::size_t N>
+	bool decode(std::string_view xml, std::string_view recordTag, const std::array<Field<T>, N> &fields, T &record,
+				Session &session)
+	{
+		Scanner scanner(xml);
+		scanner.skipProlog();
+
+		Scanner::Tag root = scanner.readStartTag();
+		if (root.name != "QRZDatabase")
+		{
+			throw std::runtime_error("Invalid XML Response");
+		}
+
+		bool found = false;
+
+		if (!root.empty)
+		{
+			while (true)
+			{
+				scanner.skipToTag();
+
+				if (scanner.atEndTag())
+				{
+					scanner.readEndTag(root.name);
+					break;
+				}
+
+				Scanner::Tag tag = scanner.readStartTag();
+
+				if (tag.name == "Session")
+				{
+					session.present = true;
+					readFields(scanner, tag, sessionFields, session);
+				}
+				else if (tag.name == recordTag && !found)
+				{
+					found = true;
+					readFields(scanner, tag, fields, record);
+				}
+				else
+				{
+					scanner.skipElement(tag);
+				}
+			}
+		}
+
+		scanner.expectEnd();
+
+		return found;
+	}
+
+	/**
+	 * @brief Throws the exception matching the error QRZ reported in the Session element, if any.
+	 */
+	void checkSession(const Session &session)
+	{
+		if (!session.present)
+		{
+			throw std::runtime_error("Session element not found");
+		}
+
+		if (session.error.empty())
+		{
+			return;
+		}
+
+		if (session.error == "Session Timeout" || session.error == "Invalid session key")
+		{
+			throw AuthenticationException{session.error};
+		}
+		else if (session.error.starts_with("Not found"))
+		{
+			throw NotFoundException{session.error};
+		}
+		else
+		{
+			throw std::runtime_error{session.error};
+		}
+	}
+}
+
+/**
+ * @brief Decodes the response to a callsign lookup.
+ *
+ * An error reported in the Session element takes precedence over a missing record, since QRZ leaves the record out
+ * when it reports one.
+ *
+ * @param xml The response body.
+ * @param callsign Filled with the record from the response.
+ * @return The lookup quota reported in the Session element.
+ */
+QuotaStatus QrzXmlDecoder::decodeCallsign(std::string_view xml, Callsign &callsign)
+{
+	Session session;
+	Callsign record;
+
+	bool found = decode(xml, "Callsign", callsignFields, record, session);
+	checkSession(session);
+
+	if (!found)
+	{
+		throw std::runtime_error("Invalid XML - no Callsign child");
+	}
+
+	callsign = std::move(record);
+
+	return session.quota;
+}
+
+/**
+ * @brief Decodes the response to a DXCC lookup.
+ *
+ * @param xml The response body.
+ * @param dxcc Filled with the record from the response.
+ * @return The lookup quota reported in the Session element.
+ */
+QuotaStatus QrzXmlDecoder::decodeDXCC(std::string_view xml, DXCC &dxcc)
+{
+	Session session;
+	DXCC record;
+
+	bool found = decode(xml, "DXCC", dxccFields, record, session);
+	checkSession(session);
+
+	if (!found)
+	{
+		throw std::runtime_error("Invalid XML - no DXCC child");
+	}
+
+	dxcc = std::move(record);
+
+	return session.quota;
+}
+
+QuotaStatus QrzXmlDecoder::decodeSession(std::string_view xml)
+{
+	Session session;
+	NoRecord record;
+
+	decode(xml, "", noFields, record, session);
+	checkSession(session);
+
+	return session.quota;
+}
+
+Callsign QrzXmlDecoder::readCallsign(std::string_view xml)
+{
+	Session session;
+	Callsign callsign;
+
+	if (!decode(xml, "Callsign", callsignFields, callsign, session))
+	{
+		throw std::runtime_error("Invalid XML - no Callsign child");
+	}
+
+	return callsign;
+}
+
+DXCC QrzXmlDecoder::readDXCC(std::string_view xml)
+{
+	Session session;
+	DXCC dxcc;
+
+	if (!decode(xml, "DXCC", dxccFields, dxcc, session))
+	{
+		throw std::runtime_error("Invalid XML - no DXCC child");
+	}
+
+	return dxcc;
+}
@@ -0,0 +1,91 @@
+#ifndef QRZ_QRZXMLDECODER_H
+#define QRZ_QRZXMLDECODER_H
+
+#include <string_view>
+
+#include "Callsign.h"
+#include "DXCC.h"
+#include "QuotaStatus.h"
+
+namespace qrz
+{
+	/**
+	 * @class QrzXmlDecoder
+	 *
+	 * @brief Decodes QRZ XML responses in a single pass straight from the response buffer.
+	 *
+	 * The decoder walks the document once, without building a DOM. The Session block is checked and the record is
+	 * filled in the same pass, and element names are matched against field tables built at compile time. Text without
+	 * entity references is handed to the record as a view into the buffer, so each value is copied exactly once, into
+	 * the record itself.
+	 *
+	 * Only the subset of XML the QRZ API produces is understood: elements, attributes, entity and character
+	 * references, CDATA sections, comments and the XML declaration. Documents declared as UTF-8, US-ASCII or
+	 * ISO-8859-1 are accepted, and values are always returned as UTF-8.
+	 */
+	class QrzXmlDecoder
+	{
+	public:
+		/**
+		 * @brief Decodes the response to a callsign lookup.
+		 *
+		 * @param xml The response body.
+		 * @param callsign Filled with the record from the response.
+		 * @return The lookup quota reported in the Session element.
+		 *
+		 * @throws AuthenticationException If the session key was rejected.
+		 * @throws NotFoundException If QRZ has no record for the callsign.
+		 * @throws std::runtime_error If the XML is malformed, has no Session or Callsign element, or reports any
+		 *         other error.
+		 */
+		static QuotaStatus decodeCallsign(std::string_view xml, Callsign &callsign);
+
+		/**
+		 * @brief Decodes the response to a DXCC lookup.
+		 *
+		 * @param xml The response body.
+		 * @param dxcc Filled with the record from the response.
+		 * @return The lookup quota reported in the Session element.
+		 *
+		 * @throws AuthenticationException If the session key was rejected.
+		 * @throws NotFoundException If QRZ has no record for the query.
+		 * @throws std::runtime_error If the XML is malformed, has no Session or DXCC element, or reports any other
+		 *         error.
+		 */
+		static QuotaStatus decodeDXCC(std::string_view xml, DXCC &dxcc);
+
+		/**
+		 * @brief Checks the Session element of a response, ignoring any record it carries.
+		 *
+		 * @param xml The response body.
+		 * @return The lookup quota reported in the Session element.
+		 *
+		 * @throws AuthenticationException If the session key was rejected.
+		 * @throws NotFoundException If QRZ reported that nothing was found.
+		 * @throws std::runtime_error If the XML is malformed, has no Session element, or reports any other error.
+		 */
+		static QuotaStatus decodeSession(std::string_view xml);
+
+		/**
+		 * @brief Reads a Callsign record from a document that need not carry a Session element.
+		 *
+		 * @param xml The XML document, such as one written by CallsignMarshaler.
+		 * @return The record.
+		 *
+		 * @throws std::runtime_error If the XML is malformed or has no Callsign element.
+		 */
+		static Callsign readCallsign(std::string_view xml);
+
+		/**
+		 * @brief Reads a DXCC record from a document that need not carry a Session element.
+		 *
+		 * @param xml The XML document, such as one written by DXCCMarshaler.
+		 * @return The record.
+		 *
+		 * @throws std::runtime_error If the XML is malformed or has no DXCC element.
+		 */
+		static DXCC readDXCC(std::string_view xml);
+	};
+}
+
+#endif //QRZ_QRZXMLDECODER_H
@@ -0,0 +1,157 @@
+#ifndef QRZ_QUOTASTATUS_H
+#define QRZ_QUOTASTATUS_H
+
+#include <algorithm>
+#include <string>
+
+namespace qrz
+{
+	/**
+	 * @class QuotaStatus
+	 *
+	 * @brief The QuotaStatus class represents the lookup quota reported in the Session element of a QRZ API response.
+	 *
+	 * QRZ reports how many lookups the account has made in the current 24 hour period, when the subscription expires
+	 * and the server time. Together with the configured daily limit this tells us how many lookups are left.
+	 */
+	class QuotaStatus
+	{
+	public:
+		QuotaStatus() = default;
+
+		/**
+		 * @brief Whether a lookup count has been received from QRZ.
+		 *
+		 * @return True if the count is known.
+		 */
+		bool hasCount() const
+		{
+			return m_count >= 0;
+		}
+
+		/**
+		 * @brief Gets the number of lookups made in the current 24 hour period.
+		 *
+		 * @return The lookup count, or -1 if it is not known.
+		 */
+		int getCount() const
+		{
+			return m_count;
+		}
+
+		/**
+		 * @brief Sets the number of lookups made in the current 24 hour period.
+		 *
+		 * @param count The lookup count.
+		 */
+		void setCount(int count)
+		{
+			m_count = count;
+		}
+
+		/**
+		 * @brief Gets the subscription expiration date.
+		 *
+		 * @return The subscription expiration as reported by QRZ, or "non-subscriber".
+		 */
+		const std::string &getSubscriptionExpiration() const
+		{
+			return m_subscriptionExpiration;
+		}
+
+		/**
+		 * @brief Sets the subscription expiration date.
+		 *
+		 * @param subscriptionExpiration The subscription expiration as reported by QRZ.
+		 */
+		void setSubscriptionExpiration(const std::string &subscriptionExpiration)
+		{
+			m_subscriptionExpiration = subscriptionExpiration;
+		}
+
+		/**
+		 * @brief Gets the QRZ server time at which the count was reported.
+		 *
+		 * @return The server time in GMT.
+		 */
+		const std::string &getServerTime() const
+		{
+			return m_serverTime;
+		}
+
+		/**
+		 * @brief Sets the QRZ server time at which the count was reported.
+		 *
+		 * @param serverTime The server time in GMT.
+		 */
+		void setServerTime(const std::string &serverTime)
+		{
+			m_serverTime = serverTime;
+		}
+
+		/**
+		 * @brief Gets the number of lookups the account may make in a 24 hour period.
+		 *
+		 * @return The daily lookup limit.
+		 */
+		int getDailyLimit() const
+		{
+			return m_dailyLimit;
+		}
+
+		/**
+		 * @brief Sets the number of lookups the account may make in a 24 hour period.
+		 *
+		 * @param dailyLimit The daily lookup limit.
+		 */
+		void setDailyLimit(int dailyLimit)
+		{
+			m_dailyLimit = dailyLimit;
+		}
+
+		/**
+		 * @brief Gets the number of lookups left in the current 24 hour period.
+		 *
+		 * @return The remaining lookups, or the full daily limit if the count is not known.
+		 */
+		int getRemaining() const
+		{
+			if (!hasCount())
+			{
+				return m_dailyLimit;
+			}
+
+			return std::max(m_dailyLimit - m_count, 0);
+		}
+
+		/**
+		 * @brief Gets the share of the daily limit that is still available.
+		 *
+		 * @return A value between 0.0 (quota used up) and 1.0 (nothing used, or count not known).
+		 */
+		double getRemainingFraction() const
+		{
+			if (m_dailyLimit <= 0)
+			{
+				return 1.0;
+			}
+
+			return static_cast<double>(getRemaining()) / m_dailyLimit;
+		}
+
+	private:
+		// Lookups made in the current 24 hour period, -1 until QRZ has reported it
+		int m_count = -1;
+
+		// Subscription expiration date, or "non-subscriber"
+		std::string m_subscriptionExpiration;
+
+		// QRZ server time when the count was reported
+		std::string m_serverTime;
+
+		// Number of lookups the account may make in a 24 hour period
+		int m_dailyLimit = 5000;
+	};
+}
+
+#endif //QRZ_QUOTASTATUS_H
@@ -0,0 +1,141 @@
+#include "CancellationToken.h"
+
+#include "../exception/CancelledException.h"
+
+using namespace qrz::net;
+
+CancellationToken::Registration::Registration(CancellationToken *token, std::uint64_t id) : m_token(token), m_id(id)
+{
+}
+
+CancellationToken::Registration::Registration(Registration &&other) noexcept : m_token(other.m_token), m_id(other.m_id)
+{
+	other.m_token = nullptr;
+}
+
+CancellationToken::Registration &CancellationToken::Registration::operator=(Registration &&other) noexcept
+{
+	if (this != &other)
+	{
+		reset();
+
+		m_token = other.m_token;
+		m_id = other.m_id;
+		other.m_token = nullptr;
+	}
+
+	return *this;
+}
+
+CancellationToken::Registration::~Registration()
+{
+	reset();
+}
+
+void CancellationToken::Registration::reset()
+{
+	if (m_token != nullptr)
+	{
+		m_token->unsubscribe(m_id);
+		m_token = nullptr;
+	}
+}
+
+/**
+ * @brief Cancels the token and runs the subscribed callbacks. Does nothing if already cancelled.
+ *
+ * The callbacks are taken out of the token one at a time and run without holding the lock, so a callback may take
+ * other locks or touch the token without deadlocking. A registration being destroyed on another thread waits for its
+ * callback to finish rather than freeing something the callback is still using.
+ */
+void CancellationToken::cancel()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (m_cancelled.exchange(true))
+	{
+		return;
+	}
+
+	m_cancelledCondition.notify_all();
+	m_cancellingThread = std::this_thread::get_id();
+
+	while (!m_callbacks.empty())
+	{
+		auto node = m_callbacks.extract(m_callbacks.begin());
+		m_runningId = node.key();
+
+		lock.unlock();
+		node.mapped()();
+		lock.lock();
+
+		m_runningId = 0;
+		m_callbackFinished.notify_all();
+	}
+
+	m_cancellingThread = std::thread::id();
+}
+
+bool CancellationToken::isCancelled() const
+{
+	return m_cancelled.load();
+}
+
+void CancellationToken::throwIfCancelled() const
+{
+	if (isCancelled())
+	{
+		throw CancelledException();
+	}
+}
+
+/**
+ * @brief Sleeps for the given time, waking early if the token is cancelled.
+ *
+ * @param duration How long to sleep.
+ * @return True if the token was cancelled.
+ */
+bool CancellationToken::waitFor(std::chrono::milliseconds duration) const
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	return m_cancelledCondition.wait_for(lock, duration, [this]() { return m_cancelled.load(); });
+}
+
+/**
+ * @brief Subscribes a callback to run when the token is cancelled.
+ *
+ * @param callback The callback.
+ * @return A registration that unsubscribes the callback when it goes out of scope.
+ */
+CancellationToken::Registration CancellationToken::subscribe(Callback callback)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	if (m_cancelled.load())
+	{
+		lock.unlock();
+		callback();
+
+		return {};
+	}
+
+	std::uint64_t id = m_nextId++;
+	m_callbacks.emplace(id, std::move(callback));
+
+	return {this, id};
+}
+
+/**
+ * @brief Removes a callback, waiting for it to finish if cancel() is running it on another thread.
+ */
+void CancellationToken::unsubscribe(std::uint64_t id)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_callbacks.erase(id);
+
+	// A callback dropping its own registration must not wait for itself
+	if (m_cancellingThread != std::this_thread::get_id())
+	{
+		m_callbackFinished.wait(lock, [this, id]() { return m_runningId != id; });
+	}
+}
@@ -0,0 +1,115 @@
+#ifndef QRZ_CANCELLATIONTOKEN_H
+#define QRZ_CANCELLATIONTOKEN_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace qrz::net
+{
+	/**
+	 * @class CancellationToken
+	 *
+	 * @brief Lets one thread abort requests another thread is making.
+	 *
+	 * The requesting side checks the token between steps and subscribes a callback that unblocks whatever it is
+	 * waiting on, such as a socket read. Cancelling runs every subscribed callback on the cancelling thread. A token
+	 * cannot be reset, so use a new one for each operation.
+	 *
+	 * The token is safe to use from several threads at once.
+	 */
+	class CancellationToken
+	{
+	public:
+		typedef std::function<void()> Callback;
+
+		/**
+		 * @class Registration
+		 *
+		 * @brief Keeps a callback subscribed until it goes out of scope.
+		 */
+		class Registration
+		{
+		public:
+			Registration() = default;
+			Registration(CancellationToken *token, std::uint64_t id);
+			Registration(Registration &&other) noexcept;
+			Registration &operator=(Registration &&other) noexcept;
+			Registration(const Registration &) = delete;
+			Registration &operator=(const Registration &) = delete;
+			~Registration();
+
+		private:
+			CancellationToken *m_token = nullptr;
+			std::uint64_t m_id = 0;
+
+			void reset();
+		};
+
+		CancellationToken() = default;
+
+		CancellationToken(const CancellationToken &) = delete;
+
+		CancellationToken &operator=(const CancellationToken &) = delete;
+
+		/**
+		 * @brief Cancels the token and runs the subscribed callbacks. Does nothing if already cancelled.
+		 */
+		void cancel();
+
+		/**
+		 * @brief Whether the token has been cancelled.
+		 *
+		 * @return True once cancel() has been called.
+		 */
+		bool isCancelled() const;
+
+		/**
+		 * @brief Throws a CancelledException if the token has been cancelled.
+		 *
+		 * @throws CancelledException If the token has been cancelled.
+		 */
+		void throwIfCancelled() const;
+
+		/**
+		 * @brief Sleeps for the given time, waking early if the token is cancelled.
+		 *
+		 * @param duration How long to sleep.
+		 * @return True if the token was cancelled.
+		 */
+		bool waitFor(std::chrono::milliseconds duration) const;
+
+		/**
+		 * @brief Subscribes a callback to run when the token is cancelled.
+		 *
+		 * If the token is already cancelled the callback runs straight away. Callbacks run without the token being
+		 * locked, so they may subscribe to or unsubscribe from the same token.
+		 *
+		 * @param callback The callback.
+		 * @return A registration that unsubscribes the callback when it goes out of scope. Once it is gone the callback
+		 *         is guaranteed not to be running.
+		 */
+		Registration subscribe(Callback callback);
+
+	private:
+		mutable std::mutex m_mutex;
+		mutable std::condition_variable m_cancelledCondition;
+		std::condition_variable m_callbackFinished;
+		std::atomic<bool> m_cancelled = false;
+		std::map<std::uint64_t, Callback> m_callbacks;
+		std::uint64_t m_nextId = 1;
+
+		// The callback cancel() is running, and the thread running it, so unsubscribe() can wait for it to finish
+		std::uint64_t m_runningId = 0;
+		std::thread::id m_cancellingThread;
+
+		void unsubscribe(std::uint64_t id);
+	};
+}
+
+#endif //QRZ_CANCELLATIONTOKEN_H
@@ -0,0 +1,203 @@
+#include "CircuitBreaker.h"
+
+#include <algorithm>
+
+using namespace qrz::net;
+
+CircuitBreaker::CircuitBreaker(int failureThreshold, std::chrono::milliseconds openDuration,
+							   std::chrono::milliseconds maxOpenDuration)
+		: m_failureThreshold(std::max(failureThreshold, 1)), m_openDuration(openDuration),
+		  m_maxOpenDuration(std::max(maxOpenDuration, openDuration)), m_currentOpenDuration(openDuration)
+{
+}
+
+bool CircuitBreaker::allowRequest()
+{
+	return allowRequest(Clock::now());
+}
+
+/**
+ * @brief Asks whether a request may be sent at the given time.
+ *
+ * An open breaker whose cool down has passed moves to half open and lets the caller through as the trial request.
+ * Everyone else is refused until the trial has reported back.
+ *
+ * @param now The current time.
+ * @return True if the request may be sent.
+ */
+bool CircuitBreaker::allowRequest(Clock::time_point now)
+{
+	Listener listener;
+	bool allowed;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (m_state == CircuitState::OPEN && now >= m_openUntil)
+		{
+			m_state = CircuitState::HALF_OPEN;
+			m_trialInFlight = false;
+			listener = m_listener;
+		}
+
+		if (m_state == CircuitState::CLOSED)
+		{
+			allowed = true;
+		}
+		else if (m_state == CircuitState::HALF_OPEN && !m_trialInFlight)
+		{
+			m_trialInFlight = true;
+			allowed = true;
+		}
+		else
+		{
+			m_rejected++;
+			allowed = false;
+		}
+	}
+
+	if (listener)
+	{
+		listener(CircuitState::HALF_OPEN);
+	}
+
+	return allowed;
+}
+
+/**
+ * @brief Reports that a request reached the server and got a sensible answer.
+ *
+ * Closes the breaker, and resets the cool down to its initial length.
+ */
+void CircuitBreaker::recordSuccess()
+{
+	Listener listener;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_consecutiveFailures = 0;
+		m_trialInFlight = false;
+		m_currentOpenDuration = m_openDuration;
+
+		if (m_state != CircuitState::CLOSED)
+		{
+			m_state = CircuitState::CLOSED;
+			listener = m_listener;
+		}
+	}
+
+	if (listener)
+	{
+		listener(CircuitState::CLOSED);
+	}
+}
+
+void CircuitBreaker::recordFailure()
+{
+	recordFailure(Clock::now());
+}
+
+/**
+ * @brief Reports that a request failed at the given time.
+ *
+ * A failed trial opens the breaker again for twice as long as before. Otherwise the breaker opens once the failure
+ * threshold is reached.
+ *
+ * @param now The current time.
+ */
+void CircuitBreaker::recordFailure(Clock::time_point now)
+{
+	Listener listener;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		m_consecutiveFailures++;
+
+		if (m_state == CircuitState::HALF_OPEN)
+		{
+			m_trialInFlight = false;
+			m_currentOpenDuration = std::min(m_currentOpenDuration * 2, m_maxOpenDuration);
+			listener = open(now, m_currentOpenDuration);
+		}
+		else if (m_state == CircuitState::CLOSED && m_consecutiveFailures >= m_failureThreshold)
+		{
+			listener = open(now, m_currentOpenDuration);
+		}
+	}
+
+	if (listener)
+	{
+		listener(CircuitState::OPEN);
+	}
+}
+
+/**
+ * @brief Reports that a request ended without saying anything about the server.
+ *
+ * Lets another caller make the trial request if this one was it.
+ */
+void CircuitBreaker::recordAbandoned()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_trialInFlight = false;
+}
+
+void CircuitBreaker::setFailureThreshold(int failureThreshold)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_failureThreshold = std::max(failureThreshold, 1);
+}
+
+void CircuitBreaker::setOpenDuration(std::chrono::milliseconds openDuration)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_openDuration = openDuration;
+	m_currentOpenDuration = openDuration;
+	m_maxOpenDuration = std::max(m_maxOpenDuration, openDuration);
+}
+
+void CircuitBreaker::setListener(Listener listener)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_listener = std::move(listener);
+}
+
+CircuitState CircuitBreaker::getState() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_state;
+}
+
+CircuitBreakerStats CircuitBreaker::getStats() const
+{
+	return getStats(Clock::now());
+}
+
+CircuitBreakerStats CircuitBreaker::getStats(Clock::time_point now) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	CircuitBreakerStats stats;
+	stats.state = m_state;
+	stats.consecutiveFailures = m_consecutiveFailures;
+	stats.opened = m_opened;
+	stats.rejected = m_rejected;
+
+	if (m_state == CircuitState::OPEN && m_openUntil > now)
+	{
+		stats.retryIn = std::chrono::duration_cast<std::chrono::milliseconds>(m_openUntil - now);
+	}
+
+	return stats;
+}
+
+CircuitBreaker::Listener CircuitBreaker::open(Clock::time_point now, std::chrono::milliseconds duration)
+{
+	m_state = CircuitState::OPEN;
+	m_openUntil = now + duration;
+	m_opened++;
+
+	return m_listener;
+}
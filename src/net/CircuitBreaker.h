@@ -0,0 +1,176 @@
+#ifndef QRZ_CIRCUITBREAKER_H
+#define QRZ_CIRCUITBREAKER_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+namespace qrz::net
+{
+	/**
+	 * @brief The states of a CircuitBreaker.
+	 */
+	enum class CircuitState
+	{
+		// Requests flow normally
+		CLOSED,
+
+		// Requests fail straight away until the cool down has passed
+		OPEN,
+
+		// A single trial request is let through to see whether the server has recovered
+		HALF_OPEN
+	};
+
+	/**
+	 * @brief Snapshot of the state and counters kept by a CircuitBreaker.
+	 */
+	struct CircuitBreakerStats
+	{
+		// The current state
+		CircuitState state = CircuitState::CLOSED;
+
+		// Failures since the last success
+		int consecutiveFailures = 0;
+
+		// Number of times the breaker has opened
+		std::uint64_t opened = 0;
+
+		// Requests refused while the breaker was open
+		std::uint64_t rejected = 0;
+
+		// Time left before an open breaker lets a trial request through
+		std::chrono::milliseconds retryIn = std::chrono::milliseconds(0);
+	};
+
+	/**
+	 * @class CircuitBreaker
+	 *
+	 * @brief Stops sending requests to a server that keeps failing, and checks now and then whether it has recovered.
+	 *
+	 * After the configured number of consecutive failures the breaker opens, and requests are refused without
+	 * touching the network. Once the cool down has passed a single trial request is let through. If it succeeds the
+	 * breaker closes again, and if it fails the breaker opens for twice as long, up to a maximum.
+	 *
+	 * The breaker is safe to use from several threads at once.
+	 */
+	class CircuitBreaker
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+		typedef std::function<void(CircuitState state)> Listener;
+
+		/**
+		 * @brief Constructs a closed breaker.
+		 *
+		 * @param failureThreshold The number of consecutive failures that opens the breaker.
+		 * @param openDuration How long the breaker stays open the first time.
+		 * @param maxOpenDuration The longest the breaker stays open after repeated failed trials.
+		 */
+		explicit CircuitBreaker(int failureThreshold = 5, std::chrono::milliseconds openDuration = std::chrono::seconds(30),
+								std::chrono::milliseconds maxOpenDuration = std::chrono::minutes(5));
+
+		/**
+		 * @brief Asks whether a request may be sent now.
+		 *
+		 * @return True if the request may be sent. The caller must then report how it went.
+		 */
+		bool allowRequest();
+
+		/**
+		 * @brief Asks whether a request may be sent at the given time.
+		 */
+		bool allowRequest(Clock::time_point now);
+
+		/**
+		 * @brief Reports that a request reached the server and got a sensible answer.
+		 */
+		void recordSuccess();
+
+		/**
+		 * @brief Reports that a request failed because of the server or the network.
+		 */
+		void recordFailure();
+
+		/**
+		 * @brief Reports that a request failed at the given time.
+		 */
+		void recordFailure(Clock::time_point now);
+
+		/**
+		 * @brief Reports that a request ended without saying anything about the server, for example because the caller
+		 * cancelled it.
+		 */
+		void recordAbandoned();
+
+		/**
+		 * @brief Sets the number of consecutive failures that opens the breaker.
+		 *
+		 * @param failureThreshold The failure threshold.
+		 */
+		void setFailureThreshold(int failureThreshold);
+
+		/**
+		 * @brief Sets how long the breaker stays open the first time.
+		 *
+		 * @param openDuration The open duration.
+		 */
+		void setOpenDuration(std::chrono::milliseconds openDuration);
+
+		/**
+		 * @brief Sets the function called whenever the breaker changes state.
+		 *
+		 * The listener is called on whichever thread caused the change, without the breaker locked.
+		 *
+		 * @param listener The listener.
+		 */
+		void setListener(Listener listener);
+
+		/**
+		 * @brief Returns the current state.
+		 *
+		 * @return The state.
+		 */
+		CircuitState getState() const;
+
+		/**
+		 * @brief Returns the current state and counters.
+		 *
+		 * @return A snapshot of the breaker statistics.
+		 */
+		CircuitBreakerStats getStats() const;
+
+		/**
+		 * @brief Returns the current state and counters as of the given time.
+		 */
+		CircuitBreakerStats getStats(Clock::time_point now) const;
+
+	private:
+		int m_failureThreshold;
+		std::chrono::milliseconds m_openDuration;
+		std::chrono::milliseconds m_maxOpenDuration;
+
+		mutable std::mutex m_mutex;
+
+		CircuitState m_state = CircuitState::CLOSED;
+		int m_consecutiveFailures = 0;
+		bool m_trialInFlight = false;
+		std::chrono::milliseconds m_currentOpenDuration;
+		Clock::time_point m_openUntil;
+
+		std::uint64_t m_opened = 0;
+		std::uint64_t m_rejected = 0;
+
+		Listener m_listener;
+
+		/**
+		 * @brief Opens the breaker for the given time.
+		 *
+		 * @return The listener to notify once the lock is released.
+		 */
+		Listener open(Clock::time_point now, std::chrono::milliseconds duration);
+	};
+}
+
+#endif //QRZ_CIRCUITBREAKER_H
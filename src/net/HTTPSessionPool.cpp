@@ -0,0 +1,266 @@
+#include "HTTPSessionPool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <Poco/Exception.h>
+#include <Poco/Net/HTTPSClientSession.h>
+#include <Poco/Net/SecureStreamSocket.h>
+#include <Poco/Net/Socket.h>
+#include <Poco/Net/SocketAddress.h>
+#include <Poco/Net/SocketImpl.h>
+
+#include "SharedTLSContext.h"
+
+using namespace qrz::net;
+
+HTTPSessionPool::Lease::Lease(std::shared_ptr<HTTPSessionPool> pool, std::unique_ptr<Poco::Net::HTTPClientSession> session,
+							  bool reused)
+		: m_pool(std::move(pool)), m_session(std::move(session)), m_reused(reused)
+{
+}
+
+HTTPSessionPool::Lease::Lease(Lease &&other) noexcept
+		: m_pool(std::move(other.m_pool)), m_session(std::move(other.m_session)), m_reused(other.m_reused),
+		  m_discard(other.m_discard)
+{
+}
+
+HTTPSessionPool::Lease::~Lease()
+{
+	if (m_pool != nullptr && m_session)
+	{
+		m_pool->release(std::move(m_session), m_reused, m_discard);
+	}
+}
+
+Poco::Net::HTTPClientSession &HTTPSessionPool::Lease::session()
+{
+	return *m_session;
+}
+
+bool HTTPSessionPool::Lease::isReused() const
+{
+	return m_reused;
+}
+
+void HTTPSessionPool::Lease::discard()
+{
+	m_discard = true;
+}
+
+void HTTPSessionPool::Lease::setTimeouts(const Poco::Timespan &connect, const Poco::Timespan &io)
+{
+	m_session->setTimeout(connect, io, io);
+
+	if (m_session->connected())
+	{
+		m_session->socket().setReceiveTimeout(io);
+		m_session->socket().setSendTimeout(io);
+	}
+}
+
+/**
+ * @brief Shuts the connection down, so a send or receive blocked on it returns at once.
+ *
+ * Only the underlying socket is shut down. Any TLS layer on top is skipped on purpose, since it is not safe to touch
+ * from another thread, and the session is thrown away afterwards anyway.
+ */
+void HTTPSessionPool::Lease::abort()
+{
+	try
+	{
+		m_session->socket().impl()->Poco::Net::SocketImpl::shutdown();
+	}
+	catch (Poco::Exception &)
+	{
+		// Not connected yet, or already closed
+	}
+}
+
+HTTPSessionPool::HTTPSessionPool(const Poco::URI &baseUri, std::size_t maxIdleSessions,
+								 const Poco::Timespan &keepAliveTimeout)
+		: m_scheme(baseUri.getScheme()), m_host(baseUri.getHost()), m_port(baseUri.getPort()),
+		  m_maxIdleSessions(maxIdleSessions), m_keepAliveTimeout(keepAliveTimeout)
+{
+	if (m_scheme != "http" && m_scheme != "https")
+	{
+		throw std::invalid_argument("Unsupported URI scheme: " + m_scheme);
+	}
+}
+
+/**
+ * @brief Hands out a session, reusing an idle one when possible.
+ *
+ * The most recently used idle session is tried first, since it is the least likely to have been closed by the server.
+ * Stale sessions found along the way are closed and counted. If no idle session is usable a new one is created.
+ *
+ * @return A Lease holding the session, and the pool along with it.
+ */
+HTTPSessionPool::Lease HTTPSessionPool::acquire()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		while (!m_idle.empty())
+		{
+			IdleSession idle = std::move(m_idle.back());
+			m_idle.pop_back();
+
+			if (isUsable(idle))
+			{
+				m_reused++;
+				return {shared_from_this(), std::move(idle.session), true};
+			}
+
+			idle.session->reset();
+			m_stale++;
+		}
+	}
+
+	return {shared_from_this(), createSession(), false};
+}
+
+/**
+ * @brief Opens a connection ahead of the next request, unless an idle one is already waiting.
+ *
+ * The new session goes through release() like any other, so its TLS session is recorded for resumption and it joins
+ * the idle list, where the next acquire() finds it already connected.
+ *
+ * @param connectTimeout The longest wait for the connection, including the TLS handshake.
+ * @return True if a connection was opened and added to the idle list.
+ */
+bool HTTPSessionPool::prewarm(const Poco::Timespan &connectTimeout)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (std::any_of(m_idle.begin(), m_idle.end(), [this](const IdleSession &idle) { return isUsable(idle); }))
+		{
+			return false;
+		}
+	}
+
+	std::unique_ptr<Poco::Net::HTTPClientSession> session = createSession();
+
+	// HTTPSClientSession only offers the TLS session for resumption, and names the host for SNI and certificate
+	// verification, when it connects itself. Without the name the certificate would be checked against the address.
+	if (m_scheme == "https")
+	{
+		Poco::Net::SecureStreamSocket socket(session->socket());
+		socket.setPeerHostName(m_host);
+		socket.useSession(SharedTLSContext::instance().getSession(m_host, m_port));
+	}
+
+	session->socket().connect(Poco::Net::SocketAddress(m_host, m_port), connectTimeout);
+
+	m_prewarmed++;
+
+	release(std::move(session), false, false);
+
+	return true;
+}
+
+void HTTPSessionPool::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	for (IdleSession &idle : m_idle)
+	{
+		idle.session->reset();
+	}
+
+	m_idle.clear();
+}
+
+HTTPSessionPoolStats HTTPSessionPool::getStats() const
+{
+	return {m_created.load(), m_reused.load(), m_stale.load(), m_prewarmed.load()};
+}
+
+const std::string &HTTPSessionPool::getScheme() const
+{
+	return m_scheme;
+}
+
+const std::string &HTTPSessionPool::getHost() const
+{
+	return m_host;
+}
+
+std::uint16_t HTTPSessionPool::getPort() const
+{
+	return m_port;
+}
+
+std::unique_ptr<Poco::Net::HTTPClientSession> HTTPSessionPool::createSession()
+{
+	std::unique_ptr<Poco::Net::HTTPClientSession> session;
+
+	if (m_scheme == "https")
+	{
+		SharedTLSContext &tls = SharedTLSContext::instance();
+		session = std::make_unique<Poco::Net::HTTPSClientSession>(m_host, m_port, tls.getClientContext(), tls.getSession(m_host, m_port));
+	}
+	else
+	{
+		session = std::make_unique<Poco::Net::HTTPClientSession>(m_host, m_port);
+	}
+
+	session->setKeepAlive(true);
+	session->setKeepAliveTimeout(m_keepAliveTimeout);
+
+	m_created++;
+
+	return session;
+}
+
+bool HTTPSessionPool::isUsable(const IdleSession &idle) const
+{
+	if (!idle.session->connected())
+	{
+		return false;
+	}
+
+	if (idle.idleSince.isElapsed(m_keepAliveTimeout.totalMicroseconds()))
+	{
+		return false;
+	}
+
+	try
+	{
+		return !idle.session->socket().poll(Poco::Timespan(0), Poco::Net::Socket::SELECT_READ | Poco::Net::Socket::SELECT_ERROR);
+	}
+	catch (Poco::Exception &)
+	{
+		return false;
+	}
+}
+
+void HTTPSessionPool::release(std::unique_ptr<Poco::Net::HTTPClientSession> session, bool reused, bool discard)
+{
+	if (!reused && session->connected())
+	{
+		auto *secureSession = dynamic_cast<Poco::Net::HTTPSClientSession *>(session.get());
+		if (secureSession != nullptr)
+		{
+			SharedTLSContext::instance().recordHandshake(*secureSession);
+		}
+	}
+
+	if (discard || !session->connected())
+	{
+		session->reset();
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_idle.size() >= m_maxIdleSessions)
+	{
+		session->reset();
+		return;
+	}
+
+	m_idle.push_back({std::move(session), Poco::Timestamp()});
+}
@@ -0,0 +1,209 @@
+#ifndef QRZ_HTTPSESSIONPOOL_H
+#define QRZ_HTTPSESSIONPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <Poco/Timespan.h>
+#include <Poco/Timestamp.h>
+#include <Poco/URI.h>
+#include <Poco/Net/HTTPClientSession.h>
+
+namespace qrz::net
+{
+	/**
+	 * @brief Snapshot of the connection counters kept by an HTTPSessionPool.
+	 */
+	struct HTTPSessionPoolStats
+	{
+		// Number of sessions (TCP connections) opened by the pool
+		std::uint64_t created = 0;
+
+		// Number of times an idle keep-alive session was handed out again
+		std::uint64_t reused = 0;
+
+		// Number of idle sessions thrown away because the server had already closed them or they sat idle too long
+		std::uint64_t stale = 0;
+
+		// Number of sessions connected ahead of a request by prewarm()
+		std::uint64_t prewarmed = 0;
+	};
+
+	/**
+	 * @class HTTPSessionPool
+	 *
+	 * @brief Keeps a small set of keep-alive HTTP(S) sessions to a single host so requests can skip the TCP and TLS
+	 * handshake.
+	 *
+	 * Sessions are handed out as Leases. A Lease returns its session to the pool when it goes out of scope, unless it
+	 * has been discarded because the request failed or the server asked to close the connection. Idle sessions are
+	 * checked before they are handed out again, and ones the server has already hung up on are dropped so the caller
+	 * gets a fresh connection instead. HTTPS sessions are built on the process-wide SharedTLSContext, so a replacement
+	 * connection can resume the TLS session of the one it replaces.
+	 *
+	 * A pool is always owned by a std::shared_ptr, since every Lease holds on to it until its session has been
+	 * returned. A pool replaced while requests are still using it is so only destroyed after the last of them.
+	 *
+	 * The pool is safe to use from several threads at once.
+	 */
+	class HTTPSessionPool : public std::enable_shared_from_this<HTTPSessionPool>
+	{
+	public:
+		/**
+		 * @class Lease
+		 *
+		 * @brief Exclusive use of one pooled session for the duration of a request.
+		 */
+		class Lease
+		{
+		public:
+			Lease(std::shared_ptr<HTTPSessionPool> pool, std::unique_ptr<Poco::Net::HTTPClientSession> session,
+				  bool reused);
+			Lease(Lease &&other) noexcept;
+			Lease(const Lease &) = delete;
+			Lease &operator=(const Lease &) = delete;
+			~Lease();
+
+			/**
+			 * @brief Returns the leased session.
+			 *
+			 * @return A reference to the session, valid for the lifetime of the lease.
+			 */
+			Poco::Net::HTTPClientSession &session();
+
+			/**
+			 * @brief Whether the session was taken from the idle list rather than freshly created.
+			 *
+			 * A request that fails on a reused session most likely hit a connection the server closed while it was
+			 * idle, and is safe to retry on a new one.
+			 *
+			 * @return True if the session was previously used for another request.
+			 */
+			bool isReused() const;
+
+			/**
+			 * @brief Marks the session as unusable so it is closed rather than returned to the pool.
+			 */
+			void discard();
+
+			/**
+			 * @brief Sets how long the session may wait to connect, and to send or receive anything.
+			 *
+			 * The connect timeout applies the next time the session connects. The others take effect straight away.
+			 *
+			 * @param connect The connect timeout, including the TLS handshake.
+			 * @param io The send and receive timeout.
+			 */
+			void setTimeouts(const Poco::Timespan &connect, const Poco::Timespan &io);
+
+			/**
+			 * @brief Shuts the connection down, so a send or receive blocked on it returns at once.
+			 *
+			 * This is the one call that may be made from another thread while the session is in use. The session
+			 * must be discarded afterwards.
+			 */
+			void abort();
+
+		private:
+			std::shared_ptr<HTTPSessionPool> m_pool;
+			std::unique_ptr<Poco::Net::HTTPClientSession> m_session;
+			bool m_reused;
+			bool m_discard = false;
+		};
+
+		/**
+		 * @brief Constructs a pool for the scheme, host and port of the given URI.
+		 *
+		 * @param baseUri The URI of the server the pooled sessions connect to. Only http and https are supported.
+		 * @param maxIdleSessions The maximum number of idle sessions kept open between requests.
+		 * @param keepAliveTimeout How long an idle session may be kept before it is considered stale.
+		 */
+		explicit HTTPSessionPool(const Poco::URI &baseUri, std::size_t maxIdleSessions = 4,
+								 const Poco::Timespan &keepAliveTimeout = Poco::Timespan(30, 0));
+
+		/**
+		 * @brief Hands out a session, reusing an idle one when possible.
+		 *
+		 * @return A Lease holding the session, and the pool along with it.
+		 */
+		Lease acquire();
+
+		/**
+		 * @brief Opens a connection ahead of the next request, unless an idle one is already waiting.
+		 *
+		 * Blocks for the TCP connect and TLS handshake, so it belongs on a worker thread.
+		 *
+		 * @param connectTimeout The longest wait for the connection, including the TLS handshake.
+		 * @return True if a connection was opened and added to the idle list.
+		 *
+		 * @throws Poco::Exception If the host could not be reached.
+		 */
+		bool prewarm(const Poco::Timespan &connectTimeout);
+
+		/**
+		 * @brief Closes all idle sessions.
+		 */
+		void clear();
+
+		/**
+		 * @brief Returns the current connection counters.
+		 *
+		 * @return A snapshot of the pool statistics.
+		 */
+		HTTPSessionPoolStats getStats() const;
+
+		const std::string &getScheme() const;
+
+		const std::string &getHost() const;
+
+		std::uint16_t getPort() const;
+
+	private:
+		struct IdleSession
+		{
+			std::unique_ptr<Poco::Net::HTTPClientSession> session;
+			Poco::Timestamp idleSince;
+		};
+
+		std::string m_scheme;
+		std::string m_host;
+		std::uint16_t m_port;
+		std::size_t m_maxIdleSessions;
+		Poco::Timespan m_keepAliveTimeout;
+
+		mutable std::mutex m_mutex;
+		std::deque<IdleSession> m_idle;
+
+		std::atomic<std::uint64_t> m_created = 0;
+		std::atomic<std::uint64_t> m_reused = 0;
+		std::atomic<std::uint64_t> m_stale = 0;
+		std::atomic<std::uint64_t> m_prewarmed = 0;
+
+		/**
+		 * @brief Opens a new keep-alive session to the pool's host.
+		 */
+		std::unique_ptr<Poco::Net::HTTPClientSession> createSession();
+
+		/**
+		 * @brief Checks whether an idle session can carry another request.
+		 *
+		 * An idle keep-alive socket should have nothing to read. If it is readable the server has either closed it or
+		 * sent something we did not ask for, and either way it cannot be trusted with a new request.
+		 */
+		bool isUsable(const IdleSession &idle) const;
+
+		/**
+		 * @brief Returns a session to the idle list, or closes it.
+		 *
+		 * The first time an HTTPS session comes back its TLS handshake is recorded with the SharedTLSContext, so the
+		 * negotiated TLS session can be resumed by the next connection.
+		 */
+		void release(std::unique_ptr<Poco::Net::HTTPClientSession> session, bool reused, bool discard);
+	};
+}
+
+#endif //QRZ_HTTPSESSIONPOOL_H
@@ -0,0 +1,103 @@
+#include "QuotaRateLimiter.h"
+
+#include <algorithm>
+
+using namespace qrz::net;
+
+QuotaRateLimiter::QuotaRateLimiter(double lookupsPerMinute, double burst)
+		: m_lookupsPerMinute(lookupsPerMinute), m_burst(std::max(burst, 1.0)), m_tokens(m_burst)
+{
+}
+
+bool QuotaRateLimiter::tryAcquire(LookupPriority priority)
+{
+	return tryAcquire(priority, Clock::now());
+}
+
+/**
+ * @brief Asks for permission to make a lookup at the given time.
+ *
+ * Interactive and detail lookups are always allowed and take a token if there is one. Background lookups need a whole
+ * token, and are refused outright once the daily quota is used up.
+ *
+ * @param priority The priority of the lookup.
+ * @param now The current time.
+ * @return True if the lookup may be made, always true for interactive lookups.
+ */
+bool QuotaRateLimiter::tryAcquire(LookupPriority priority, Clock::time_point now)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	refill(now);
+
+	if (priority != LookupPriority::BACKGROUND)
+	{
+		m_tokens = std::max(m_tokens - 1.0, 0.0);
+		m_stats.interactive++;
+
+		return true;
+	}
+
+	if (m_remainingFraction <= 0.0 || m_tokens < 1.0)
+	{
+		m_stats.deferred++;
+
+		return false;
+	}
+
+	m_tokens -= 1.0;
+	m_stats.granted++;
+
+	return true;
+}
+
+void QuotaRateLimiter::setRemainingFraction(double fraction)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Tokens earned so far were earned at the old rate
+	refill(Clock::now());
+
+	m_remainingFraction = std::clamp(fraction, 0.0, 1.0);
+}
+
+double QuotaRateLimiter::getRemainingFraction() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_remainingFraction;
+}
+
+void QuotaRateLimiter::setRate(double lookupsPerMinute)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	refill(Clock::now());
+
+	m_lookupsPerMinute = lookupsPerMinute;
+}
+
+QuotaRateLimiterStats QuotaRateLimiter::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+void QuotaRateLimiter::refill(Clock::time_point now)
+{
+	if (!m_started)
+	{
+		m_started = true;
+		m_lastRefill = now;
+		return;
+	}
+
+	if (now <= m_lastRefill)
+	{
+		return;
+	}
+
+	std::chrono::duration<double, std::ratio<60>> elapsed = now - m_lastRefill;
+
+	m_tokens = std::min(m_tokens + elapsed.count() * m_lookupsPerMinute * m_remainingFraction, m_burst);
+	m_lastRefill = now;
+}
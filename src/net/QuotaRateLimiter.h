@@ -0,0 +1,113 @@
+#ifndef QRZ_QUOTARATELIMITER_H
+#define QRZ_QUOTARATELIMITER_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+#include "../LookupPriority.h"
+
+namespace qrz::net
+{
+	/**
+	 * @brief Snapshot of the counters kept by a QuotaRateLimiter.
+	 */
+	struct QuotaRateLimiterStats
+	{
+		// Background lookups allowed through
+		std::uint64_t granted = 0;
+
+		// Interactive lookups, which are never held back
+		std::uint64_t interactive = 0;
+
+		// Background lookups held back to save quota
+		std::uint64_t deferred = 0;
+	};
+
+	/**
+	 * @class QuotaRateLimiter
+	 *
+	 * @brief Token bucket that paces background QRZ lookups according to how much of the daily quota is left.
+	 *
+	 * The bucket refills at the configured background rate scaled by the share of the daily quota that remains, so
+	 * background traffic slows down as the quota runs low and stops altogether once it is used up. Interactive lookups
+	 * always get through, but they take a token when one is available, so a busy user also slows the background.
+	 *
+	 * The limiter never blocks. A background lookup that finds the bucket empty is refused and should be dropped or
+	 * retried later by the caller.
+	 *
+	 * The limiter is safe to use from several threads at once.
+	 */
+	class QuotaRateLimiter
+	{
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		/**
+		 * @brief Constructs a limiter with a full bucket.
+		 *
+		 * @param lookupsPerMinute The background lookup rate while the whole daily quota is available.
+		 * @param burst The number of background lookups that may be made back to back.
+		 */
+		explicit QuotaRateLimiter(double lookupsPerMinute = 30, double burst = 5);
+
+		/**
+		 * @brief Asks for permission to make a lookup now.
+		 *
+		 * @param priority The priority of the lookup.
+		 * @return True if the lookup may be made, always true for interactive lookups.
+		 */
+		bool tryAcquire(LookupPriority priority);
+
+		/**
+		 * @brief Asks for permission to make a lookup at the given time.
+		 *
+		 * @param priority The priority of the lookup.
+		 * @param now The current time.
+		 * @return True if the lookup may be made, always true for interactive lookups.
+		 */
+		bool tryAcquire(LookupPriority priority, Clock::time_point now);
+
+		/**
+		 * @brief Sets the share of the daily quota that is still available.
+		 *
+		 * @param fraction A value between 0.0 (quota used up) and 1.0 (nothing used).
+		 */
+		void setRemainingFraction(double fraction);
+
+		double getRemainingFraction() const;
+
+		/**
+		 * @brief Sets the background lookup rate while the whole daily quota is available.
+		 *
+		 * @param lookupsPerMinute The background lookup rate.
+		 */
+		void setRate(double lookupsPerMinute);
+
+		/**
+		 * @brief Returns the current counters.
+		 *
+		 * @return A snapshot of the limiter statistics.
+		 */
+		QuotaRateLimiterStats getStats() const;
+
+	private:
+		mutable std::mutex m_mutex;
+
+		double m_lookupsPerMinute;
+		double m_burst;
+		double m_tokens;
+		double m_remainingFraction = 1.0;
+		bool m_started = false;
+		Clock::time_point m_lastRefill;
+
+		QuotaRateLimiterStats m_stats;
+
+		/**
+		 * @brief Adds the tokens earned since the last refill. Must be called with the mutex held.
+		 */
+		void refill(Clock::time_point now);
+	};
+}
+
+#endif //QRZ_QUOTARATELIMITER_H
@@ -0,0 +1,44 @@
+#ifndef QRZ_REQUESTDEADLINES_H
+#define QRZ_REQUESTDEADLINES_H
+
+#include <algorithm>
+#include <chrono>
+
+namespace qrz::net
+{
+	/**
+	 * @brief How long a request to the QRZ API may wait at each stage before it is given up on.
+	 */
+	struct RequestDeadlines
+	{
+		// Longest wait for a new connection, including the TLS handshake
+		std::chrono::milliseconds connect = std::chrono::seconds(5);
+
+		// Longest wait for the server to send anything at all
+		std::chrono::milliseconds read = std::chrono::seconds(10);
+
+		// Longest a whole request may take, including a retry on a fresh connection
+		std::chrono::milliseconds total = std::chrono::seconds(20);
+
+		/**
+		 * @brief Caps a stage timeout by the time left before the total deadline.
+		 *
+		 * @param timeout The timeout of the stage.
+		 * @param deadline When the whole request has to be finished.
+		 * @return The timeout to use, never less than a millisecond. Zero if the deadline has already passed.
+		 */
+		static std::chrono::milliseconds capped(std::chrono::milliseconds timeout, std::chrono::steady_clock::time_point deadline)
+		{
+			auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+
+			if (left.count() <= 0)
+			{
+				return std::chrono::milliseconds(0);
+			}
+
+			return std::clamp(timeout, std::chrono::milliseconds(1), left);
+		}
+	};
+}
+
+#endif //QRZ_REQUESTDEADLINES_H
@@ -0,0 +1,37 @@
+#include "RetryPolicy.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace qrz::net;
+
+std::chrono::milliseconds RetryPolicy::delayFor(int retry) const
+{
+	thread_local std::mt19937 generator(std::random_device{}());
+	std::uniform_real_distribution<double> distribution(0.0, 1.0);
+
+	return delayFor(retry, distribution(generator));
+}
+
+/**
+ * @brief Works out the delay before a retry for a given random value.
+ *
+ * The bound doubles with every retry, starting from the base delay and capped at the maximum delay.
+ *
+ * @param retry The number of the retry, starting at 0 for the first one.
+ * @param random A value between 0.0 and 1.0.
+ * @return The delay.
+ */
+std::chrono::milliseconds RetryPolicy::delayFor(int retry, double random) const
+{
+	double bound = static_cast<double>(baseDelay.count());
+
+	for (int i = 0; i < retry && bound < maxDelay.count(); i++)
+	{
+		bound *= 2;
+	}
+
+	bound = std::min(bound, static_cast<double>(maxDelay.count()));
+
+	return std::chrono::milliseconds(static_cast<long long>(bound * std::clamp(random, 0.0, 1.0)));
+}
@@ -0,0 +1,44 @@
+#ifndef QRZ_RETRYPOLICY_H
+#define QRZ_RETRYPOLICY_H
+
+#include <chrono>
+
+namespace qrz::net
+{
+	/**
+	 * @brief How often, and how far apart, a request that failed for a transient reason is tried again.
+	 *
+	 * Delays grow exponentially from the base delay and are fully jittered, so clients that failed together do not
+	 * all come back at the same moment.
+	 */
+	struct RetryPolicy
+	{
+		// Attempts in total, including the first
+		int maxAttempts = 3;
+
+		// Upper bound of the delay before the first retry
+		std::chrono::milliseconds baseDelay = std::chrono::milliseconds(250);
+
+		// Upper bound of the delay before any retry
+		std::chrono::milliseconds maxDelay = std::chrono::seconds(4);
+
+		/**
+		 * @brief Picks the delay before a retry.
+		 *
+		 * @param retry The number of the retry, starting at 0 for the first one.
+		 * @return A random delay between zero and the exponential bound for this retry.
+		 */
+		std::chrono::milliseconds delayFor(int retry) const;
+
+		/**
+		 * @brief Works out the delay before a retry for a given random value.
+		 *
+		 * @param retry The number of the retry, starting at 0 for the first one.
+		 * @param random A value between 0.0 and 1.0.
+		 * @return The delay.
+		 */
+		std::chrono::milliseconds delayFor(int retry, double random) const;
+	};
+}
+
+#endif //QRZ_RETRYPOLICY_H
@@ -0,0 +1,91 @@
+#include "SharedTLSContext.h"
+
+#include <Poco/Exception.h>
+#include <Poco/Net/SecureStreamSocket.h>
+
+using namespace qrz::net;
+
+SharedTLSContext &SharedTLSContext::instance()
+{
+	static SharedTLSContext context;
+
+	return context;
+}
+
+SharedTLSContext::SharedTLSContext()
+{
+	m_context = new Poco::Net::Context(Poco::Net::Context::CLIENT_USE, "", "", "", Poco::Net::Context::VERIFY_NONE, 9, false, "ALL:!ADH:!LOW:!EXP:!MD5:@STRENGTH");
+
+	// Keep negotiated sessions around on the client side so reconnects can resume them
+	m_context->enableSessionCache(true);
+}
+
+Poco::Net::Context::Ptr SharedTLSContext::getClientContext() const
+{
+	return m_context;
+}
+
+Poco::Net::Session::Ptr SharedTLSContext::getSession(const std::string &host, std::uint16_t port)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto it = m_sessions.find(sessionKey(host, port));
+	if (it == m_sessions.end())
+	{
+		return nullptr;
+	}
+
+	return it->second;
+}
+
+/**
+ * @brief Records the handshake performed by a newly connected session.
+ *
+ * The TLS session is read from the socket rather than from HTTPSClientSession::sslSession(), because the latter is
+ * captured right after connecting, before a TLS 1.3 server has sent the ticket that makes the session resumable.
+ *
+ * @param session A connected HTTPS session.
+ */
+void SharedTLSContext::recordHandshake(Poco::Net::HTTPSClientSession &session)
+{
+	try
+	{
+		Poco::Net::SecureStreamSocket socket(session.socket());
+
+		if (socket.sessionWasReused())
+		{
+			m_resumedHandshakes++;
+		}
+		else
+		{
+			m_fullHandshakes++;
+		}
+
+		Poco::Net::Session::Ptr tlsSession = socket.currentSession();
+		if (tlsSession)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_sessions[sessionKey(session.getHost(), session.getPort())] = tlsSession;
+		}
+	}
+	catch (Poco::Exception &)
+	{
+		// The socket was already closed, there is nothing to record
+	}
+}
+
+void SharedTLSContext::clearSessions()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_sessions.clear();
+}
+
+TLSHandshakeStats SharedTLSContext::getStats() const
+{
+	return {m_fullHandshakes.load(), m_resumedHandshakes.load()};
+}
+
+std::string SharedTLSContext::sessionKey(const std::string &host, std::uint16_t port)
+{
+	return host + ":" + std::to_string(port);
+}
@@ -0,0 +1,101 @@
+#ifndef QRZ_SHAREDTLSCONTEXT_H
+#define QRZ_SHAREDTLSCONTEXT_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <Poco/Net/Context.h>
+#include <Poco/Net/HTTPSClientSession.h>
+#include <Poco/Net/Session.h>
+
+namespace qrz::net
+{
+	/**
+	 * @brief Snapshot of the TLS handshake counters kept by SharedTLSContext.
+	 */
+	struct TLSHandshakeStats
+	{
+		// Handshakes that negotiated a brand new TLS session
+		std::uint64_t full = 0;
+
+		// Abbreviated handshakes that resumed a previous TLS session from a session ticket or session ID
+		std::uint64_t resumed = 0;
+	};
+
+	/**
+	 * @class SharedTLSContext
+	 *
+	 * @brief Process-wide TLS client context with session resumption.
+	 *
+	 * Every HTTPS connection to the QRZ API is built on the same Poco::Net::Context, which has the client session
+	 * cache enabled. The most recent TLS session negotiated with each host is remembered, and handed to the next
+	 * connection opened to that host so it can resume instead of performing a full handshake. This matters most when
+	 * a pooled keep-alive connection has been closed by the server after an idle period.
+	 *
+	 * The instance is safe to use from several threads at once.
+	 */
+	class SharedTLSContext
+	{
+	public:
+		/**
+		 * @brief Returns the process-wide instance.
+		 */
+		static SharedTLSContext &instance();
+
+		SharedTLSContext(const SharedTLSContext &) = delete;
+		SharedTLSContext &operator=(const SharedTLSContext &) = delete;
+
+		/**
+		 * @brief Returns the TLS client context shared by all QRZ API connections.
+		 */
+		Poco::Net::Context::Ptr getClientContext() const;
+
+		/**
+		 * @brief Returns the last TLS session negotiated with the given host, if any.
+		 *
+		 * @param host The host name of the server.
+		 * @param port The port of the server.
+		 * @return The session to resume, or a null pointer if there is none.
+		 */
+		Poco::Net::Session::Ptr getSession(const std::string &host, std::uint16_t port);
+
+		/**
+		 * @brief Records the handshake performed by a newly connected session.
+		 *
+		 * This counts the handshake as full or resumed, and keeps the session's current TLS session for the next
+		 * connection to the same host. It should be called once a response has been read, since TLS 1.3 servers only
+		 * send their session tickets after the handshake has completed.
+		 *
+		 * @param session A connected HTTPS session.
+		 */
+		void recordHandshake(Poco::Net::HTTPSClientSession &session);
+
+		/**
+		 * @brief Forgets all remembered TLS sessions, forcing full handshakes for new connections.
+		 */
+		void clearSessions();
+
+		/**
+		 * @brief Returns the current handshake counters.
+		 */
+		TLSHandshakeStats getStats() const;
+
+	private:
+		SharedTLSContext();
+
+		Poco::Net::Context::Ptr m_context;
+
+		std::mutex m_mutex;
+		std::map<std::string, Poco::Net::Session::Ptr> m_sessions;
+
+		std::atomic<std::uint64_t> m_fullHandshakes = 0;
+		std::atomic<std::uint64_t> m_resumedHandshakes = 0;
+
+		static std::string sessionKey(const std::string &host, std::uint16_t port);
+	};
+}
+
+#endif //QRZ_SHAREDTLSCONTEXT_H
@@ -0,0 +1,328 @@
+#ifndef QRZ_TASK_H
+#define QRZ_TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include <QEventLoop>
+
+namespace qrz::net
+{
+	template<typename T>
+	class Task;
+
+	namespace detail
+	{
+		/**
+		 * @brief The part of a Task promise that does not depend on the result type.
+		 */
+		struct TaskPromiseBase
+		{
+			// The coroutine awaiting this task, resumed once it finishes
+			std::coroutine_handle<> continuation;
+
+			// Set when the task was started with Task::start(), called once it finishes
+			std::function<void()> onDone;
+
+			// The exception the coroutine finished with, if any
+			std::exception_ptr error;
+
+			/**
+			 * @brief Resumes whoever is waiting for the task, or hands the result to the callbacks of a started task.
+			 */
+			struct FinalAwaiter
+			{
+				bool await_ready() noexcept
+				{
+					return false;
+				}
+
+				template<typename Promise>
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+				{
+					TaskPromiseBase &promise = handle.promise();
+
+					if (promise.continuation)
+					{
+						return promise.continuation;
+					}
+
+					// A started task owns itself, so it goes away once the callbacks have the result
+					if (promise.onDone)
+					{
+						promise.onDone();
+						handle.destroy();
+					}
+
+					return std::noop_coroutine();
+				}
+
+				void await_resume() noexcept
+				{}
+			};
+
+			// Tasks are lazy, nothing runs until the task is awaited or started
+			std::suspend_always initial_suspend() noexcept
+			{
+				return {};
+			}
+
+			FinalAwaiter final_suspend() noexcept
+			{
+				return {};
+			}
+
+			void unhandled_exception() noexcept
+			{
+				error = std::current_exception();
+			}
+		};
+
+		template<typename T>
+		struct TaskPromise : TaskPromiseBase
+		{
+			std::optional<T> value;
+
+			Task<T> get_return_object() noexcept;
+
+			template<typename U>
+			void return_value(U &&result)
+			{
+				value.emplace(std::forward<U>(result));
+			}
+
+			T takeResult()
+			{
+				if (error)
+				{
+					std::rethrow_exception(error);
+				}
+
+				return std::move(*value);
+			}
+		};
+
+		template<>
+		struct TaskPromise<void> : TaskPromiseBase
+		{
+			Task<void> get_return_object() noexcept;
+
+			void return_void() noexcept
+			{}
+
+			void takeResult()
+			{
+				if (error)
+				{
+					std::rethrow_exception(error);
+				}
+			}
+		};
+	}
+
+	/**
+	 * @class Task
+	 *
+	 * @brief The result of a coroutine, which can be awaited by another coroutine or started from ordinary code.
+	 *
+	 * A task does nothing until it is awaited or started. Whatever wakes it, such as a finished network reply or a
+	 * timer, resumes it on the thread running the event loop, so tasks need no locking among themselves and many can
+	 * be waiting at once without a thread each.
+	 *
+	 * @tparam T The result type, void for a task that only finishes.
+	 */
+	template<typename T = void>
+	class [[nodiscard]] Task
+	{
+	public:
+		typedef detail::TaskPromise<T> promise_type;
+
+		explicit Task(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle)
+		{}
+
+		Task(Task &&other) noexcept : m_handle(std::exchange(other.m_handle, {}))
+		{}
+
+		Task &operator=(Task &&other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				m_handle = std::exchange(other.m_handle, {});
+			}
+
+			return *this;
+		}
+
+		Task(const Task &) = delete;
+
+		Task &operator=(const Task &) = delete;
+
+		/**
+		 * @brief Destroys the coroutine, unless it has been started and owns itself.
+		 */
+		~Task()
+		{
+			reset();
+		}
+
+		/**
+		 * @brief Runs the task until it suspends, and resumes the awaiting coroutine with its result once it finishes.
+		 *
+		 * @throws Whatever the coroutine of the task threw.
+		 */
+		auto operator co_await() && noexcept
+		{
+			struct Awaiter
+			{
+				std::coroutine_handle<promise_type> handle;
+
+				bool await_ready() noexcept
+				{
+					return false;
+				}
+
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+				{
+					handle.promise().continuation = awaiting;
+					return handle;
+				}
+
+				T await_resume()
+				{
+					return handle.promise().takeResult();
+				}
+			};
+
+			return Awaiter{m_handle};
+		}
+
+		/**
+		 * @brief Runs the task from code that is not a coroutine itself, handing the outcome to a callback.
+		 *
+		 * The task runs until it first suspends before this returns, and finishes later from the event loop. It owns
+		 * itself from now on, so the Task object may go away straight after.
+		 *
+		 * @param onResult Called with the result, or without arguments for a Task<void>. Must not throw.
+		 * @param onError Called with the exception the task failed with. Must not throw.
+		 */
+		template<typename OnResult, typename OnError>
+		void start(OnResult onResult, OnError onError) &&
+		{
+			std::coroutine_handle<promise_type> handle = std::exchange(m_handle, {});
+
+			handle.promise().onDone = [handle, onResult = std::move(onResult), onError = std::move(onError)]() mutable
+			{
+				promise_type &promise = handle.promise();
+
+				if (promise.error)
+				{
+					onError(promise.error);
+				}
+				else if constexpr (std::is_void_v<T>)
+				{
+					onResult();
+				}
+				else
+				{
+					onResult(std::move(*promise.value));
+				}
+			};
+
+			handle.resume();
+		}
+
+	private:
+		std::coroutine_handle<promise_type> m_handle;
+
+		void reset()
+		{
+			if (m_handle)
+			{
+				m_handle.destroy();
+				m_handle = {};
+			}
+		}
+	};
+
+	namespace detail
+	{
+		template<typename T>
+		Task<T> TaskPromise<T>::get_return_object() noexcept
+		{
+			return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+		}
+
+		inline Task<void> TaskPromise<void>::get_return_object() noexcept
+		{
+			return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+		}
+	}
+
+	/**
+	 * @brief Runs a task to completion from ordinary code, running a local event loop while it waits.
+	 *
+	 * The caller does not return until the task has finished, but the event loop keeps running in the meantime, so
+	 * windows are still painted and other tasks carry on.
+	 *
+	 * @param task The task.
+	 * @return The result of the task.
+	 *
+	 * @throws Whatever the coroutine of the task threw.
+	 */
+	template<typename T>
+	T blockingWait(Task<T> task)
+	{
+		QEventLoop loop;
+		bool finished = false;
+		std::exception_ptr error;
+		std::conditional_t<std::is_void_v<T>, bool, std::optional<T>> result{};
+
+		auto finish = [&loop, &finished]()
+		{
+			finished = true;
+			loop.quit();
+		};
+
+		auto fail = [&error, &finish](std::exception_ptr e)
+		{
+			error = e;
+			finish();
+		};
+
+		if constexpr (std::is_void_v<T>)
+		{
+			std::move(task).start(finish, fail);
+		}
+		else
+		{
+			std::move(task).start([&result, &finish](T value)
+			{
+				result.emplace(std::move(value));
+				finish();
+			}, fail);
+		}
+
+		// A task that never had to wait has already finished
+		if (!finished)
+		{
+			loop.exec();
+		}
+
+		if (error)
+		{
+			std::rethrow_exception(error);
+		}
+
+		if constexpr (!std::is_void_v<T>)
+		{
+			return std::move(*result);
+		}
+	}
+}
+
+#endif //QRZ_TASK_H
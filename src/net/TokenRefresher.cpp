@@ -0,0 +1,206 @@
+#include "TokenRefresher.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+using namespace qrz::net;
+
+TokenRefresher::TokenRefresher(RemainingFunction remaining, RefreshFunction refresh, std::chrono::milliseconds leadTime,
+							   std::chrono::milliseconds retryDelay)
+		: m_remaining(std::move(remaining)), m_refresh(std::move(refresh)), m_leadTime(leadTime),
+		  m_retryDelay(std::max(retryDelay, std::chrono::milliseconds(1)))
+{
+}
+
+/**
+ * @brief Stops the refresher, waiting for a refresh in progress to finish.
+ */
+TokenRefresher::~TokenRefresher()
+{
+	stop();
+}
+
+/**
+ * @brief Starts the background thread. Does nothing if it is already running.
+ */
+void TokenRefresher::start()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_running)
+	{
+		return;
+	}
+
+	m_running = true;
+	m_stopping = false;
+	m_thread = std::thread(&TokenRefresher::run, this);
+}
+
+/**
+ * @brief Stops the background thread, waiting for a refresh in progress to finish.
+ */
+void TokenRefresher::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (!m_running)
+		{
+			return;
+		}
+
+		m_stopping = true;
+	}
+
+	m_wakeup.notify_all();
+	m_thread.join();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_running = false;
+}
+
+/**
+ * @brief Makes the refresher look at the token again now, for example after the credentials changed.
+ */
+void TokenRefresher::wake()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_woken = true;
+	}
+
+	m_wakeup.notify_all();
+}
+
+/**
+ * @brief Sets the function called on the background thread after every refresh attempt.
+ *
+ * @param callback The callback, told whether the attempt produced a valid token.
+ */
+void TokenRefresher::setCallback(Callback callback)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_callback = std::move(callback);
+}
+
+/**
+ * @brief Sets how long before expiry the token is renewed.
+ *
+ * @param leadTime The lead time.
+ */
+void TokenRefresher::setLeadTime(std::chrono::milliseconds leadTime)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_leadTime = leadTime;
+		m_woken = true;
+	}
+
+	m_wakeup.notify_all();
+}
+
+/**
+ * @brief Whether the background thread is running.
+ *
+ * @return True if started and not stopped.
+ */
+bool TokenRefresher::isRunning() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_running && !m_stopping;
+}
+
+/**
+ * @brief Returns the current counters.
+ *
+ * @return A snapshot of the refresher statistics.
+ */
+TokenRefresherStats TokenRefresher::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+/**
+ * @brief Works out how long to sleep before the token should be renewed.
+ *
+ * @param remaining How long the token remains valid.
+ * @param leadTime How long before expiry the token is renewed.
+ * @return The time to sleep, zero if the token should be renewed now.
+ */
+std::chrono::milliseconds TokenRefresher::delayUntilRefresh(std::chrono::milliseconds remaining, std::chrono::milliseconds leadTime)
+{
+	return std::max(remaining - leadTime, std::chrono::milliseconds(0));
+}
+
+/**
+ * @brief Body of the background thread.
+ *
+ * Sleeps until the token is due for renewal, renews it, and goes back to sleep. Failed attempts back off
+ * exponentially, and a successful one resets the backoff.
+ */
+void TokenRefresher::run()
+{
+	std::chrono::milliseconds retryDelay = m_retryDelay;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (!m_stopping)
+	{
+		m_woken = false;
+
+		std::chrono::milliseconds leadTime = m_leadTime;
+
+		lock.unlock();
+		std::chrono::milliseconds delay = delayUntilRefresh(m_remaining(), leadTime);
+		lock.lock();
+
+		if (delay.count() > 0)
+		{
+			m_wakeup.wait_for(lock, delay, [this]() { return m_stopping || m_woken; });
+			continue;
+		}
+
+		lock.unlock();
+
+		bool refreshed = false;
+
+		try
+		{
+			refreshed = m_refresh() && delayUntilRefresh(m_remaining(), leadTime).count() > 0;
+		}
+		catch (std::exception &e)
+		{
+			std::cerr << "Token refresh failed: " << e.what() << std::endl;
+		}
+
+		lock.lock();
+
+		Callback callback = m_callback;
+
+		if (refreshed)
+		{
+			m_stats.refreshes++;
+			retryDelay = m_retryDelay;
+		}
+		else
+		{
+			m_stats.failures++;
+		}
+
+		if (callback)
+		{
+			lock.unlock();
+			callback(refreshed);
+			lock.lock();
+		}
+
+		if (!refreshed)
+		{
+			m_wakeup.wait_for(lock, retryDelay, [this]() { return m_stopping || m_woken; });
+			retryDelay = std::min(retryDelay * 2, m_maxRetryDelay);
+		}
+	}
+}
@@ -0,0 +1,142 @@
+#ifndef QRZ_TOKENREFRESHER_H
+#define QRZ_TOKENREFRESHER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace qrz::net
+{
+	/**
+	 * @brief Snapshot of the counters kept by a TokenRefresher.
+	 */
+	struct TokenRefresherStats
+	{
+		// Tokens renewed ahead of expiry
+		std::uint64_t refreshes = 0;
+
+		// Attempts that did not produce a valid token
+		std::uint64_t failures = 0;
+	};
+
+	/**
+	 * @class TokenRefresher
+	 *
+	 * @brief Renews the QRZ session token on a background thread shortly before it expires.
+	 *
+	 * The refresher sleeps until the token is within the lead time of its expiry, then asks for a new one. Lookups keep
+	 * using the old token until the new one is swapped in, so none of them wait on the login round trip. A refresh that
+	 * fails is retried after a delay that doubles on each failure, up to a maximum.
+	 *
+	 * How long the token has left and how it is renewed are supplied as functions, so the refresher does not depend on
+	 * the client.
+	 */
+	class TokenRefresher
+	{
+	public:
+		typedef std::function<std::chrono::milliseconds()> RemainingFunction;
+		typedef std::function<bool()> RefreshFunction;
+		typedef std::function<void(bool refreshed)> Callback;
+
+		/**
+		 * @brief Constructs a refresher. It does nothing until started.
+		 *
+		 * @param remaining Returns how long the current token remains valid.
+		 * @param refresh Renews the token. Returns false if no valid token was obtained, for example because no
+		 *        credentials are configured.
+		 * @param leadTime How long before expiry the token is renewed.
+		 * @param retryDelay How long to wait after the first failed refresh.
+		 */
+		TokenRefresher(RemainingFunction remaining, RefreshFunction refresh, std::chrono::milliseconds leadTime,
+					   std::chrono::milliseconds retryDelay = std::chrono::seconds(30));
+
+		/**
+		 * @brief Stops the refresher, waiting for a refresh in progress to finish.
+		 */
+		~TokenRefresher();
+
+		TokenRefresher(const TokenRefresher &) = delete;
+
+		TokenRefresher &operator=(const TokenRefresher &) = delete;
+
+		/**
+		 * @brief Starts the background thread. Does nothing if it is already running.
+		 */
+		void start();
+
+		/**
+		 * @brief Stops the background thread, waiting for a refresh in progress to finish.
+		 */
+		void stop();
+
+		/**
+		 * @brief Makes the refresher look at the token again now, for example after the credentials changed.
+		 */
+		void wake();
+
+		/**
+		 * @brief Sets the function called on the background thread after every refresh attempt.
+		 *
+		 * @param callback The callback, told whether the attempt produced a valid token.
+		 */
+		void setCallback(Callback callback);
+
+		/**
+		 * @brief Sets how long before expiry the token is renewed.
+		 *
+		 * @param leadTime The lead time.
+		 */
+		void setLeadTime(std::chrono::milliseconds leadTime);
+
+		/**
+		 * @brief Whether the background thread is running.
+		 *
+		 * @return True if started and not stopped.
+		 */
+		bool isRunning() const;
+
+		/**
+		 * @brief Returns the current counters.
+		 *
+		 * @return A snapshot of the refresher statistics.
+		 */
+		TokenRefresherStats getStats() const;
+
+		/**
+		 * @brief Works out how long to sleep before the token should be renewed.
+		 *
+		 * @param remaining How long the token remains valid.
+		 * @param leadTime How long before expiry the token is renewed.
+		 * @return The time to sleep, zero if the token should be renewed now.
+		 */
+		static std::chrono::milliseconds delayUntilRefresh(std::chrono::milliseconds remaining, std::chrono::milliseconds leadTime);
+
+	private:
+		RemainingFunction m_remaining;
+		RefreshFunction m_refresh;
+		Callback m_callback;
+
+		std::chrono::milliseconds m_leadTime;
+		std::chrono::milliseconds m_retryDelay;
+
+		// Failed refreshes are retried no less often than this
+		static inline const std::chrono::milliseconds m_maxRetryDelay = std::chrono::minutes(10);
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_wakeup;
+		std::thread m_thread;
+
+		bool m_running = false;
+		bool m_stopping = false;
+		bool m_woken = false;
+
+		TokenRefresherStats m_stats;
+
+		void run();
+	};
+}
+
+#endif //QRZ_TOKENREFRESHER_H
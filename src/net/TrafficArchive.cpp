@@ -0,0 +1,309 @@
+#include "TrafficArchive.h"
+
+#include <algorithm>
+#include <cctype>
+#include <set>
+#include <stdexcept>
+#include <utility>
+
+#include <Poco/Exception.h>
+#include <Poco/InflatingStream.h>
+
+using namespace qrz::net;
+
+namespace
+{
+	// Elements of a response holding the session key or the credentials of the account, in lower case
+	const std::set<std::string> credentialElements = {"key", "username", "password"};
+
+	bool isCredentialElement(std::string name)
+	{
+		std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+
+		return credentialElements.contains(name);
+	}
+}
+
+TrafficArchive::TrafficArchive(const std::filesystem::path &path, Mode mode) : m_mode(mode), m_path(path)
+{
+	if (m_mode == Mode::REPLAY)
+	{
+		load();
+		return;
+	}
+
+	if (m_path.has_parent_path())
+	{
+		std::filesystem::create_directories(m_path.parent_path());
+	}
+
+	m_file.open(m_path, std::ios::binary | std::ios::trunc);
+	if (!m_file)
+	{
+		throw std::runtime_error("Unable to write traffic archive " + m_path.string());
+	}
+
+	m_out = std::make_unique<Poco::DeflatingOutputStream>(m_file, Poco::DeflatingStreamBuf::STREAM_GZIP);
+	*m_out << m_header << '\n';
+	m_out->flush();
+}
+
+/**
+ * @brief Finishes the compressed stream of an archive being recorded.
+ */
+TrafficArchive::~TrafficArchive()
+{
+	if (!m_out)
+	{
+		return;
+	}
+
+	try
+	{
+		m_out->close();
+	}
+	catch (Poco::Exception &)
+	{
+		// Everything up to the last response was already flushed
+	}
+}
+
+TrafficArchive::Mode TrafficArchive::getMode() const
+{
+	return m_mode;
+}
+
+bool TrafficArchive::isReplaying() const
+{
+	return m_mode == Mode::REPLAY;
+}
+
+/**
+ * @brief Records the response to a request. Does nothing when replaying.
+ *
+ * Each response is flushed to the file as it is recorded, so an archive cut short by a crash still holds everything
+ * recorded before it.
+ *
+ * @param uri The request, including its query parameters.
+ * @param status HTTP status of the response.
+ * @param body Response body, decompressed.
+ * @param latency How long the response took.
+ */
+void TrafficArchive::record(const Poco::URI &uri, int status, const std::string &body, std::chrono::milliseconds latency)
+{
+	if (m_mode != Mode::RECORD)
+	{
+		return;
+	}
+
+	std::string request = requestOf(uri);
+	std::string scrubbed = scrub(body);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	*m_out << status << '\t' << latency.count() << '\t' << request << '\t' << scrubbed.size() << '\n' << scrubbed << '\n';
+	m_out->flush();
+
+	m_size++;
+}
+
+RecordedExchange TrafficArchive::replay(const Poco::URI &uri)
+{
+	std::string request = requestOf(uri);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto it = m_exchanges.find(request);
+	if (it == m_exchanges.end())
+	{
+		throw std::runtime_error("No recorded response for " + request);
+	}
+
+	std::size_t &next = m_next[request];
+	const RecordedExchange &exchange = it->second[next];
+	next = (next + 1) % it->second.size();
+
+	return exchange;
+}
+
+std::chrono::milliseconds TrafficArchive::getReplayDelay(const RecordedExchange &exchange) const
+{
+	double speed = getReplaySpeed();
+	if (speed <= 0.0)
+	{
+		return std::chrono::milliseconds(0);
+	}
+
+	return std::chrono::milliseconds(static_cast<std::chrono::milliseconds::rep>(exchange.latency.count() / speed));
+}
+
+double TrafficArchive::getReplaySpeed() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_replaySpeed;
+}
+
+void TrafficArchive::setReplaySpeed(double speed)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_replaySpeed = std::max(speed, 0.0);
+}
+
+std::size_t TrafficArchive::size() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_size;
+}
+
+/**
+ * @brief Returns a request the way it is recorded.
+ *
+ * The host, port and path are kept, so requests to different servers are never answered with each other's responses.
+ * Of the query parameters, the session key and agent are left out, the username and password are kept without their
+ * values, and the rest are sorted by name, so the same lookup is recorded the same way whichever session made it.
+ *
+ * @param uri The request.
+ * @return The server, path and query parameters, as in a URL without its scheme.
+ */
+std::string TrafficArchive::requestOf(const Poco::URI &uri)
+{
+	std::vector<std::pair<std::string, std::string>> parameters;
+
+	for (const auto &[name, value] : uri.getQueryParameters())
+	{
+		if (name == "s" || name == "agent")
+		{
+			continue;
+		}
+
+		parameters.emplace_back(name, (name == "username" || name == "password") ? std::string() : value);
+	}
+
+	std::sort(parameters.begin(), parameters.end());
+
+	std::string request = uri.getHost() + ':' + std::to_string(uri.getPort()) + uri.getPath() + '?';
+	for (const auto &[name, value] : parameters)
+	{
+		if (request.back() != '?')
+		{
+			request += '&';
+		}
+
+		request += name + '=';
+		Poco::URI::encode(value, "&=+", request);
+	}
+
+	return request;
+}
+
+/**
+ * @brief Removes the session key, and any credentials echoed back, from a response body.
+ *
+ * Only the contents of the elements known to hold them are replaced, whatever their text and however it is escaped, so
+ * nothing else in the response is touched.
+ *
+ * @param body The response body.
+ * @return The body with the contents of every Key, Username and Password element replaced with SCRUBBED_KEY.
+ */
+std::string TrafficArchive::scrub(const std::string &body)
+{
+	std::string scrubbed = body;
+
+	for (std::size_t pos = scrubbed.find('<'); pos != std::string::npos; pos = scrubbed.find('<', pos + 1))
+	{
+		std::size_t nameEnd = scrubbed.find_first_of(" \t\r\n/>", pos + 1);
+		if (nameEnd == std::string::npos)
+		{
+			break;
+		}
+
+		std::string name = scrubbed.substr(pos + 1, nameEnd - pos - 1);
+		if (name.empty() || !isCredentialElement(name))
+		{
+			continue;
+		}
+
+		std::size_t start = scrubbed.find('>', nameEnd);
+		if (start == std::string::npos)
+		{
+			break;
+		}
+
+		// An empty element has nothing to scrub
+		if (scrubbed[start - 1] == '/')
+		{
+			continue;
+		}
+
+		start++;
+
+		std::size_t end = scrubbed.find("</" + name + ">", start);
+		if (end == std::string::npos)
+		{
+			break;
+		}
+
+		scrubbed.replace(start, end - start, SCRUBBED_KEY);
+		pos = start;
+	}
+
+	return scrubbed;
+}
+
+/**
+ * @brief Reads every recorded response from the file.
+ *
+ * An archive cut short while it was being recorded is read up to its last complete response.
+ */
+void TrafficArchive::load()
+{
+	std::ifstream file(m_path, std::ios::binary);
+	if (!file)
+	{
+		throw std::runtime_error("Unable to read traffic archive " + m_path.string());
+	}
+
+	Poco::InflatingInputStream in(file, Poco::InflatingStreamBuf::STREAM_GZIP);
+
+	std::string line;
+	if (!std::getline(in, line) || line != m_header)
+	{
+		throw std::runtime_error("Not a traffic archive: " + m_path.string());
+	}
+
+	try
+	{
+		while (std::getline(in, line))
+		{
+			std::size_t first = line.find('\t');
+			std::size_t second = line.find('\t', first + 1);
+			std::size_t third = line.find('\t', second + 1);
+			if (first == std::string::npos || second == std::string::npos || third == std::string::npos)
+			{
+				break;
+			}
+
+			RecordedExchange exchange;
+			exchange.status = std::stoi(line.substr(0, first));
+			exchange.latency = std::chrono::milliseconds(std::stoll(line.substr(first + 1, second - first - 1)));
+			exchange.request = line.substr(second + 1, third - second - 1);
+
+			exchange.body.resize(std::stoull(line.substr(third + 1)));
+			if (!in.read(exchange.body.data(), static_cast<std::streamsize>(exchange.body.size())) || in.get() != '\n')
+			{
+				break;
+			}
+
+			m_exchanges[exchange.request].push_back(std::move(exchange));
+			m_size++;
+		}
+	}
+	catch (Poco::Exception &)
+	{
+		// The compressed stream ends part way through a response
+	}
+	catch (std::logic_error &)
+	{
+		// A record header was cut short
+	}
+}
@@ -0,0 +1,174 @@
+#ifndef QRZ_TRAFFICARCHIVE_H
+#define QRZ_TRAFFICARCHIVE_H
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <Poco/DeflatingStream.h>
+#include <Poco/URI.h>
+
+namespace qrz::net
+{
+	/**
+	 * @brief A response to a QRZ API request, as it was recorded.
+	 */
+	struct RecordedExchange
+	{
+		// The server, path and query parameters of the request, without credentials or session key
+		std::string request;
+
+		// HTTP status of the response
+		int status = 200;
+
+		// How long the response took, retries included
+		std::chrono::milliseconds latency{0};
+
+		// Response body, decompressed, with the session key and any echoed credentials scrubbed
+		std::string body;
+	};
+
+	/**
+	 * @class TrafficArchive
+	 *
+	 * @brief Records QRZ API responses to a compressed file, or serves them back from one.
+	 *
+	 * A client given an archive in RECORD mode writes every response it hands to its caller, along with how long it
+	 * took. A client given an archive in REPLAY mode sends nothing over the network, it answers every request with
+	 * the next response recorded for it, after the recorded latency divided by the replay speed. Lookups of captured
+	 * traffic can so be repeated exactly, for benchmarks that do not depend on the network or spend the lookup quota.
+	 *
+	 * Responses are recorded per server, so the primary provider and a fallback sharing an archive are not mixed up.
+	 * Usernames, passwords and session keys never reach the file: they are left out of the recorded requests, and the
+	 * Key, Username and Password elements of the responses are replaced with SCRUBBED_KEY.
+	 *
+	 * The archive is safe to use from several threads at once.
+	 */
+	class TrafficArchive
+	{
+	public:
+		enum class Mode
+		{
+			RECORD,
+			REPLAY
+		};
+
+		// Takes the place of session keys and credentials in recorded responses
+		static inline const std::string SCRUBBED_KEY = "00000000000000000000000000000000";
+
+		/**
+		 * @brief Opens an archive to record to, replacing any file at the path, or one to replay.
+		 *
+		 * @param path The archive file.
+		 * @param mode Whether responses are recorded to the file or replayed from it.
+		 *
+		 * @throws std::runtime_error If the file cannot be opened, or is not a traffic archive.
+		 */
+		TrafficArchive(const std::filesystem::path &path, Mode mode);
+
+		~TrafficArchive();
+
+		TrafficArchive(const TrafficArchive &) = delete;
+		TrafficArchive &operator=(const TrafficArchive &) = delete;
+
+		Mode getMode() const;
+
+		bool isReplaying() const;
+
+		/**
+		 * @brief Records the response to a request. Does nothing when replaying.
+		 *
+		 * @param uri The request, including its query parameters.
+		 * @param status HTTP status of the response.
+		 * @param body Response body, decompressed.
+		 * @param latency How long the response took.
+		 */
+		void record(const Poco::URI &uri, int status, const std::string &body, std::chrono::milliseconds latency);
+
+		/**
+		 * @brief Returns the next recorded response to a request.
+		 *
+		 * Responses recorded for the same request are handed out in the order they were recorded, starting over once
+		 * all of them have been used.
+		 *
+		 * @param uri The request, including its query parameters.
+		 * @return The recorded response.
+		 *
+		 * @throws std::runtime_error If nothing was recorded for the request, or the archive is recording.
+		 */
+		RecordedExchange replay(const Poco::URI &uri);
+
+		/**
+		 * @brief Returns how long to wait before handing out a replayed response.
+		 *
+		 * @param exchange The replayed response.
+		 * @return The recorded latency divided by the replay speed, or zero if the speed is zero.
+		 */
+		std::chrono::milliseconds getReplayDelay(const RecordedExchange &exchange) const;
+
+		double getReplaySpeed() const;
+
+		/**
+		 * @brief Sets how much faster than recorded responses are replayed.
+		 *
+		 * @param speed 1.0 for the recorded latency, 2.0 for half of it, 0.0 to answer without waiting.
+		 */
+		void setReplaySpeed(double speed);
+
+		/**
+		 * @brief Returns the number of responses recorded, or loaded for replay.
+		 */
+		std::size_t size() const;
+
+		/**
+		 * @brief Returns a request the way it is recorded.
+		 *
+		 * The host, port and path are kept. Of the query parameters, the session key and agent are left out, the
+		 * username and password are kept without their values, and the rest are sorted by name, so the same lookup is
+		 * recorded the same way whichever session made it.
+		 *
+		 * @param uri The request.
+		 * @return The server, path and query parameters, as in a URL without its scheme.
+		 */
+		static std::string requestOf(const Poco::URI &uri);
+
+		/**
+		 * @brief Removes the session key, and any credentials echoed back, from a response body.
+		 *
+		 * Only the contents of the elements known to hold them are replaced, so the rest of the response is recorded
+		 * exactly as it was sent, however its text happens to read.
+		 *
+		 * @param body The response body.
+		 * @return The body with the contents of every Key, Username and Password element replaced with SCRUBBED_KEY.
+		 */
+		static std::string scrub(const std::string &body);
+
+	private:
+		void load();
+
+		// Written at the start of every archive, followed by one record per response
+		static inline const std::string m_header = "QRZBUDDY-TRAFFIC 2";
+
+		Mode m_mode;
+		std::filesystem::path m_path;
+
+		mutable std::mutex m_mutex;
+		double m_replaySpeed = 1.0;
+		std::size_t m_size = 0;
+
+		// Recording
+		std::ofstream m_file;
+		std::unique_ptr<Poco::DeflatingOutputStream> m_out;
+
+		// Replaying, the responses recorded for each request and the index of the next one to hand out
+		std::map<std::string, std::vector<RecordedExchange>> m_exchanges;
+		std::map<std::string, std::size_t> m_next;
+	};
+}
+
+#endif //QRZ_TRAFFICARCHIVE_H
@@ -0,0 +1,63 @@
+#include "TransferCounter.h"
+
+using namespace qrz::net;
+
+TransferStats &TransferStats::operator+=(const TransferStats &other)
+{
+	responses += other.responses;
+	wireBytes += other.wireBytes;
+	bodyBytes += other.bodyBytes;
+
+	return *this;
+}
+
+/**
+ * @brief Returns the fraction of the body bytes that compression kept off the wire.
+ *
+ * @return A value between 0.0 and 1.0, or 0.0 if nothing has been received.
+ */
+double TransferStats::getSavedFraction() const
+{
+	if (bodyBytes == 0 || wireBytes >= bodyBytes)
+	{
+		return 0.0;
+	}
+
+	return static_cast<double>(bodyBytes - wireBytes) / static_cast<double>(bodyBytes);
+}
+
+/**
+ * @brief Records a response received from an endpoint.
+ *
+ * @param endpoint The endpoint, such as "callsign" or "bio".
+ * @param wireBytes The size of the body as it came over the wire.
+ * @param bodyBytes The size of the body after decompression.
+ */
+void TransferCounter::record(const std::string &endpoint, std::uint64_t wireBytes, std::uint64_t bodyBytes)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	TransferStats &stats = m_stats[endpoint];
+	stats.responses++;
+	stats.wireBytes += wireBytes;
+	stats.bodyBytes += bodyBytes;
+}
+
+std::map<std::string, TransferStats> TransferCounter::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_stats;
+}
+
+TransferStats TransferCounter::getTotal() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	TransferStats total;
+	for (const auto &[endpoint, stats] : m_stats)
+	{
+		total += stats;
+	}
+
+	return total;
+}
@@ -0,0 +1,77 @@
+#ifndef QRZ_TRANSFERCOUNTER_H
+#define QRZ_TRANSFERCOUNTER_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace qrz::net
+{
+	/**
+	 * @brief Snapshot of the bytes received from one endpoint of the QRZ API.
+	 */
+	struct TransferStats
+	{
+		// Responses received
+		std::uint64_t responses = 0;
+
+		// Response body bytes as they came over the wire, compressed or not
+		std::uint64_t wireBytes = 0;
+
+		// Response body bytes after decompression
+		std::uint64_t bodyBytes = 0;
+
+		/**
+		 * @brief Adds the counters of another snapshot to this one.
+		 */
+		TransferStats &operator+=(const TransferStats &other);
+
+		/**
+		 * @brief Returns the fraction of the body bytes that compression kept off the wire.
+		 *
+		 * @return A value between 0.0 and 1.0, or 0.0 if nothing has been received.
+		 */
+		double getSavedFraction() const;
+	};
+
+	/**
+	 * @class TransferCounter
+	 *
+	 * @brief Counts the compressed and uncompressed bytes received from each endpoint of the QRZ API.
+	 *
+	 * The counter is safe to use from several threads at once.
+	 */
+	class TransferCounter
+	{
+	public:
+		/**
+		 * @brief Records a response received from an endpoint.
+		 *
+		 * @param endpoint The endpoint, such as "callsign" or "bio".
+		 * @param wireBytes The size of the body as it came over the wire.
+		 * @param bodyBytes The size of the body after decompression.
+		 */
+		void record(const std::string &endpoint, std::uint64_t wireBytes, std::uint64_t bodyBytes);
+
+		/**
+		 * @brief Returns the counters of every endpoint that has been used.
+		 *
+		 * @return The counters, keyed by endpoint.
+		 */
+		std::map<std::string, TransferStats> getStats() const;
+
+		/**
+		 * @brief Returns the counters of all endpoints added together.
+		 *
+		 * @return The counters.
+		 */
+		TransferStats getTotal() const;
+
+	private:
+		mutable std::mutex m_mutex;
+		std::map<std::string, TransferStats> m_stats;
+	};
+}
+
+#endif //QRZ_TRANSFERCOUNTER_H
@@ -92,7 +92,7 @@ void TableModel::addCallsigns(const std::vector<Callsign> &calls)
 	{
 		if(callIndex.contains(currCall.getCall()))
 		{
-			return;
+			continue;
 		}
 
 		callsigns.push_back(currCall);
@@ -104,6 +104,80 @@ void TableModel::addCallsigns(const std::vector<Callsign> &calls)
 	emit layoutChanged();
 }
 
+bool TableModel::updateCallsign(const Callsign &callsign)
+{
+	for(int row = 0; row < callsigns.size(); row++)
+	{
+		Callsign &currCall = callsigns.at(row);
+
+		if (currCall.getCall() != callsign.getCall())
+		{
+			continue;
+		}
+
+		// What JS8Call reported about the station is not part of the QRZ record, keep it
+		Callsign updated = callsign;
+		updated.setSnr(currCall.getSnr());
+		updated.setReportedSnr(currCall.getReportedSnr());
+		updated.setLastHeard(currCall.getLastHeard());
+
+		currCall = updated;
+
+		emit dataChanged(index(row, 0), index(row, columnCount() - 1));
+
+		emit callsignUpdated(updated);
+
+		return true;
+	}
+
+	return false;
+}
+
+// Fills in the row of one callsign with the record of another, such as a former callsign with the record it now points to.
+// If the record already has a row of its own, that row is updated and the other one goes away.
+bool TableModel::replaceCallsign(const std::string &call, const Callsign &callsign)
+{
+	if(call == callsign.getCall())
+	{
+		return updateCallsign(callsign);
+	}
+
+	for(int row = 0; row < callsigns.size(); row++)
+	{
+		Callsign &currCall = callsigns.at(row);
+
+		if (currCall.getCall() != call)
+		{
+			continue;
+		}
+
+		if(callIndex.contains(callsign.getCall()))
+		{
+			removeRows(row, 1);
+			return updateCallsign(callsign);
+		}
+
+		// What JS8Call reported about the station is not part of the QRZ record, keep it
+		Callsign replaced = currCall;
+		Callsign updated = callsign;
+		updated.setSnr(replaced.getSnr());
+		updated.setReportedSnr(replaced.getReportedSnr());
+		updated.setLastHeard(replaced.getLastHeard());
+
+		currCall = updated;
+		callIndex.erase(call);
+		callIndex.insert(updated.getCall());
+
+		emit dataChanged(index(row, 0), index(row, columnCount() - 1));
+		emit callsignRemoved(replaced);
+		emit callsignAdded(updated);
+
+		return true;
+	}
+
+	return false;
+}
+
 bool TableModel::removeRows(int row, int count, const QModelIndex &parent)
 {
 	emit layoutAboutToBeChanged();
@@ -131,6 +205,13 @@ bool TableModel::removeRows(int row, int count, const QModelIndex &parent)
 	return true;
 }
 
+bool TableModel::containsCallsign(std::string call) const
+{
+	ToUpper(call);
+
+	return callIndex.contains(call);
+}
+
 std::vector<Callsign> TableModel::getCallsigns()
 {
 	return callsigns;
@@ -26,13 +26,17 @@ public:
 	bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
 	void addCallsign(const Callsign &callsign);
 	void addCallsigns(const std::vector<Callsign> &callsigns);
+	bool updateCallsign(const Callsign &callsign);
+	bool replaceCallsign(const std::string &call, const Callsign &callsign);
 	Callsign getCallsign(int index);
 	Callsign getCallsign(std::string call);
 	Callsign *getCallsignPtr(std::string call);
+	bool containsCallsign(std::string call) const;
 	std::vector<Callsign> getCallsigns();
 signals:
 	void callsignAdded(Callsign callsign);
 	void callsignRemoved(Callsign callsign);
+	void callsignUpdated(Callsign callsign);
 
 private:
 	std::vector<Callsign> callsigns;
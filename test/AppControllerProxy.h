@@ -1,6 +1,8 @@
 #ifndef QRZ_APPCONTROLLERPROXY_H
 #define QRZ_APPCONTROLLERPROXY_H
 
+#include <filesystem>
+
 #include "../src/AppController.h"
 
 namespace qrz
@@ -10,6 +12,9 @@ namespace qrz
 	public:
 		AppControllerProxy() = default;
 
+		AppControllerProxy(Configuration *config, TableModel *tableModel) : AppController(config, tableModel)
+		{}
+
 		std::vector<Callsign> proxyFetchCallsignRecords(const std::set<std::string> &searchTerms)
 		{
 			return fetchCallsignRecords(searchTerms);
@@ -24,6 +29,31 @@ namespace qrz
 		{
 			return fetchBios(searchTerms);
 		}
+
+		LookupSchedulerStats proxyGetQueueStats() const
+		{
+			return m_lookupService->getQueueStats();
+		}
+
+		void proxySetBaseUrl(const std::string &baseUrl)
+		{
+			client.setBaseUrl(baseUrl);
+		}
+
+		void proxyUseDeferredLookups(const std::filesystem::path &path)
+		{
+			m_deferredLookups = std::make_unique<cache::DeferredLookupQueue>(path);
+		}
+
+		void proxyDeferLookup(const std::string &call)
+		{
+			deferLookup(call);
+		}
+
+		void proxyAddRecord(const Callsign &callsign, const std::string &requested)
+		{
+			addRecord(callsign, requested);
+		}
 	};
 }
 
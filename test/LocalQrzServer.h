@@ -0,0 +1,136 @@
+#ifndef QRZ_LOCALQRZSERVER_H
+#define QRZ_LOCALQRZSERVER_H
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <Poco/Net/Context.h>
+#include <Poco/Net/HTTPRequestHandler.h>
+#include <Poco/Net/HTTPRequestHandlerFactory.h>
+#include <Poco/Net/HTTPServer.h>
+#include <Poco/Net/HTTPServerParams.h>
+#include <Poco/Net/HTTPServerRequest.h>
+#include <Poco/Net/HTTPServerResponse.h>
+#include <Poco/Net/SecureServerSocket.h>
+#include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/SocketAddress.h>
+
+namespace qrz
+{
+	/**
+	 * @class LocalQrzServer
+	 *
+	 * @brief A local HTTP(S) stand-in for xmldata.qrz.com used by the tests.
+	 *
+	 * Every request is passed to the handler supplied by the test. The server listens on the loopback interface, on an
+	 * ephemeral port unless one is given, and in secure mode uses the self-signed certificate in test/certs.
+	 */
+	class LocalQrzServer
+	{
+	public:
+		typedef std::function<void(Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)> Handler;
+
+		explicit LocalQrzServer(Handler handler, bool secure = true, const Poco::Timespan &keepAliveTimeout = Poco::Timespan(10, 0),
+								Poco::UInt16 port = 0, int maxThreads = 32)
+				: m_secure(secure), m_handler(std::move(handler))
+		{
+			Poco::Net::SocketAddress address("127.0.0.1", port);
+
+			if (m_secure)
+			{
+				std::string certDir = QRZ_TEST_CERT_DIR;
+				m_context = new Poco::Net::Context(Poco::Net::Context::SERVER_USE, certDir + "/localhost.key",
+												   certDir + "/localhost.pem", "", Poco::Net::Context::VERIFY_NONE, 9,
+												   false, "ALL:!ADH:!LOW:!EXP:!MD5:@STRENGTH");
+				m_context->enableSessionCache(true, "qrzbuddy-test");
+
+				m_socket = std::make_unique<Poco::Net::SecureServerSocket>(address, 64, m_context);
+			}
+			else
+			{
+				m_socket = std::make_unique<Poco::Net::ServerSocket>(address, 64);
+			}
+
+			Poco::Net::HTTPServerParams::Ptr params = new Poco::Net::HTTPServerParams;
+			params->setKeepAlive(true);
+			params->setKeepAliveTimeout(keepAliveTimeout);
+			params->setMaxThreads(maxThreads);
+			params->setMaxQueued(maxThreads * 4);
+
+			m_server = std::make_unique<Poco::Net::HTTPServer>(new HandlerFactory(this), *m_socket, params);
+			m_server->start();
+		}
+
+		~LocalQrzServer()
+		{
+			m_server->stopAll(true);
+		}
+
+		/**
+		 * @brief Returns the base URL a client should use to reach this server.
+		 */
+		std::string getBaseUrl() const
+		{
+			return std::string(m_secure ? "https" : "http") + "://127.0.0.1:" + std::to_string(m_socket->address().port());
+		}
+
+		/**
+		 * @brief Returns the number of connections the server has accepted so far.
+		 */
+		int getTotalConnections() const
+		{
+			return m_server->totalConnections();
+		}
+
+		/**
+		 * @brief Returns the number of requests the server has handled so far.
+		 */
+		int getRequestCount() const
+		{
+			return m_requestCount.load();
+		}
+
+	private:
+		class RequestHandler : public Poco::Net::HTTPRequestHandler
+		{
+		public:
+			explicit RequestHandler(LocalQrzServer *server) : m_server(server)
+			{}
+
+			void handleRequest(Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response) override
+			{
+				m_server->m_requestCount++;
+				m_server->m_handler(request, response);
+			}
+
+		private:
+			LocalQrzServer *m_server;
+		};
+
+		class HandlerFactory : public Poco::Net::HTTPRequestHandlerFactory
+		{
+		public:
+			explicit HandlerFactory(LocalQrzServer *server) : m_server(server)
+			{}
+
+			Poco::Net::HTTPRequestHandler *createRequestHandler(const Poco::Net::HTTPServerRequest &request) override
+			{
+				return new RequestHandler(m_server);
+			}
+
+		private:
+			LocalQrzServer *m_server;
+		};
+
+		bool m_secure;
+		Handler m_handler;
+		std::atomic<int> m_requestCount = 0;
+		Poco::Net::Context::Ptr m_context;
+		std::unique_ptr<Poco::Net::ServerSocket> m_socket;
+		std::unique_ptr<Poco::Net::HTTPServer> m_server;
+	};
+}
+
+#endif //QRZ_LOCALQRZSERVER_H
@@ -0,0 +1,40 @@
+#ifndef QRZ_MOCKASYNCCLIENT_H
+#define QRZ_MOCKASYNCCLIENT_H
+
+#include "../src/AsyncQRZClient.h"
+#include "MockClient.h"
+
+namespace qrz
+{
+	/**
+	 * Answers requests with the canned responses of a MockClient, delivered from the event loop the way a network
+	 * reply would be.
+	 */
+	class MockAsyncClient : public AsyncQRZClient
+	{
+	public:
+		explicit MockAsyncClient(MockClient &client) : AsyncQRZClient(client), m_mock(client)
+		{}
+
+		// Number of requests that reached the mock server
+		int requestCount = 0;
+
+		// How long the mock server takes to answer
+		std::chrono::milliseconds latency{0};
+
+	protected:
+		net::Task<QrzResponse> sendRequest(Poco::URI uri, std::shared_ptr<net::CancellationToken> cancel = nullptr) override
+		{
+			requestCount++;
+
+			co_await sleepFor(latency);
+
+			co_return m_mock.sendRequest(uri, cancel);
+		}
+
+	private:
+		MockClient &m_mock;
+	};
+}
+
+#endif //QRZ_MOCKASYNCCLIENT_H
@@ -1,6 +1,8 @@
 #ifndef QRZ_MOCKCLIENT_H
 #define QRZ_MOCKCLIENT_H
 
+#include <Poco/Net/NetException.h>
+
 #include "../src/QRZClient.h"
 
 namespace qrz
@@ -18,14 +20,14 @@ namespace qrz
 			setSessionExpiration(config.getSessionExpiration());
 		}
 
-		QrzResponse sendRequest(Poco::URI &uri) override
+		QrzResponse sendRequest(Poco::URI &uri, const std::shared_ptr<net::CancellationToken> &cancel = nullptr) override
 		{
 			std::string path = Poco::format("/xml/%s/", m_apiVersion);
 			uri.setPath(path);
 			uri.addQueryParameter("agent", m_userAgent);
 
 			// Create a session
-			const Poco::Net::Context::Ptr ptrContext = new Poco::Net::Context(Poco::Net::Context::CLIENT_USE, "", "", "", Poco::Net::Context::VERIFY_NONE, 9, false, "ALL:!ADH:!LOW:!EXP:!MD5:@STRENGTH");
+			const Poco::Net::Context::Ptr ptrContext = net::SharedTLSContext::instance().getClientContext();
 			Poco::Net::HTTPSClientSession session(uri.getHost(), uri.getPort(), ptrContext);
 
 			// Prepare a GET request
@@ -90,6 +92,11 @@ namespace qrz
 			}
 			else if(action == "password")
 			{
+				if(loginUnreachable)
+				{
+					throw Poco::Net::ConnectionRefusedException(uri.getHost());
+				}
+
 				body = sessionResponse;
 			}
 
@@ -98,6 +105,9 @@ namespace qrz
 			return output;
 		}
 
+		// Makes logins fail the way they do when QRZ cannot be reached
+		bool loginUnreachable = false;
+
 		bool testValidateResponse(const std::string &responseBody)
 		{
 			try
@@ -0,0 +1,614 @@
+#ifndef QRZ_MOCKQRZSERVER_H
+#define QRZ_MOCKQRZSERVER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <Poco/DateTime.h>
+#include <Poco/DateTimeFormatter.h>
+#include <Poco/DeflatingStream.h>
+#include <Poco/Net/HTMLForm.h>
+#include <Poco/Net/HTTPServerRequest.h>
+#include <Poco/Net/HTTPServerRequestImpl.h>
+#include <Poco/Net/HTTPServerResponse.h>
+#include <Poco/URI.h>
+
+#include "LocalQrzServer.h"
+
+namespace qrz
+{
+	/**
+	 * @brief The faults a MockQrzServer injects, each rate being the share of requests it applies to.
+	 */
+	struct MockQrzFaults
+	{
+		// Added to every response
+		std::chrono::milliseconds latency{0};
+
+		// The latency varies by up to this much either way
+		std::chrono::milliseconds jitter{0};
+
+		// Lookups answered with "Session Timeout", which also ends the session
+		double sessionTimeoutRate = 0.0;
+
+		// Lookups answered with "Not found", whether the record exists or not
+		double notFoundRate = 0.0;
+
+		// Requests answered with 503 Service Unavailable
+		double serverErrorRate = 0.0;
+
+		// Requests whose connection is closed without any response
+		double dropRate = 0.0;
+	};
+
+	/**
+	 * @brief Counts of what a MockQrzServer has answered.
+	 */
+	struct MockQrzStats
+	{
+		std::uint64_t logins = 0;
+		std::uint64_t callsigns = 0;
+		std::uint64_t bios = 0;
+		std::uint64_t dxccs = 0;
+		std::uint64_t sessionTimeouts = 0;
+		std::uint64_t notFounds = 0;
+		std::uint64_t serverErrors = 0;
+		std::uint64_t drops = 0;
+	};
+
+	/**
+	 * @class MockQrzServer
+	 *
+	 * @brief Answers the xmldata.qrz.com XML protocol from a corpus of fixtures, with configurable faults.
+	 *
+	 * Logins with any username and password are given a session key, and lookups must present a key that was given
+	 * out, or one accepted with acceptSessionKey(). Callsign, bio and DXCC lookups are answered from the corpus. With
+	 * synthesized records turned on, a callsign missing from the corpus is answered with a record made up for it, so
+	 * a load test can look up as many distinct callsigns as it likes without any of them being cached by the client.
+	 *
+	 * Responses are compressed when the client asks for it, as QRZ does. The faults are rolled for every request, and
+	 * can be changed while the server is running.
+	 *
+	 * The handler is meant to be served by a LocalQrzServer, and may be called from many server threads at once.
+	 */
+	class MockQrzServer
+	{
+	public:
+		explicit MockQrzServer(const MockQrzFaults &faults = MockQrzFaults(), unsigned int seed = std::random_device()())
+				: m_faults(faults), m_random(seed)
+		{}
+
+		/**
+		 * @brief Returns a handler for a LocalQrzServer that answers with this mock.
+		 */
+		LocalQrzServer::Handler getHandler()
+		{
+			return [this](Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)
+			{
+				handle(request, response);
+			};
+		}
+
+		/**
+		 * @brief Replaces the faults injected from the next request on.
+		 */
+		void setFaults(const MockQrzFaults &faults)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_faults = faults;
+		}
+
+		MockQrzFaults getFaults() const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_faults;
+		}
+
+		/**
+		 * @brief Answers callsigns missing from the corpus with a record made up for them, instead of "Not found".
+		 */
+		void setSynthesizeRecords(bool enabled)
+		{
+			m_synthesize = enabled;
+		}
+
+		/**
+		 * @brief Lets lookups use a session key that was not given out by a login, such as one a test starts with.
+		 */
+		void acceptSessionKey(const std::string &key)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_sessionKeys.insert(key);
+		}
+
+		/**
+		 * @brief Adds the record of a callsign to the corpus.
+		 *
+		 * @param xml A whole response as QRZ sends it, or just its Callsign element.
+		 */
+		void addCallsign(const std::string &xml)
+		{
+			std::string element = extractElement(xml, "Callsign");
+			std::string call = extractElement(element, "call", false);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_callsigns[normalize(call)] = element;
+		}
+
+		/**
+		 * @brief Adds the bio of a callsign to the corpus.
+		 */
+		void addBio(const std::string &call, const std::string &html)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_bios[normalize(call)] = html;
+		}
+
+		/**
+		 * @brief Adds a DXCC entity to the corpus.
+		 *
+		 * @param xml A whole response as QRZ sends it, or just its DXCC element.
+		 */
+		void addDXCC(const std::string &xml)
+		{
+			std::string element = extractElement(xml, "DXCC");
+			std::string entity = extractElement(element, "dxcc", false);
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_dxccs[entity] = element;
+		}
+
+		/**
+		 * @brief Adds every fixture in a directory to the corpus.
+		 *
+		 * Files ending in .xml hold a callsign or DXCC response, told apart by their content. Files ending in .html
+		 * hold the bio of the callsign they are named after.
+		 *
+		 * @return The number of fixtures added.
+		 */
+		int loadCorpus(const std::filesystem::path &directory)
+		{
+			int loaded = 0;
+
+			for (const auto &file : std::filesystem::directory_iterator(directory))
+			{
+				std::ifstream in(file.path(), std::ios::binary);
+				std::ostringstream content;
+				content << in.rdbuf();
+
+				if (file.path().extension() == ".html")
+				{
+					addBio(file.path().stem().string(), content.str());
+					loaded++;
+				}
+				else if (file.path().extension() == ".xml" && content.str().find("<DXCC>") != std::string::npos)
+				{
+					addDXCC(content.str());
+					loaded++;
+				}
+				else if (file.path().extension() == ".xml" && content.str().find("<Callsign>") != std::string::npos)
+				{
+					addCallsign(content.str());
+					loaded++;
+				}
+			}
+
+			return loaded;
+		}
+
+		MockQrzStats getStats() const
+		{
+			MockQrzStats stats;
+			stats.logins = m_logins;
+			stats.callsigns = m_callsignCount;
+			stats.bios = m_bioCount;
+			stats.dxccs = m_dxccCount;
+			stats.sessionTimeouts = m_sessionTimeouts;
+			stats.notFounds = m_notFounds;
+			stats.serverErrors = m_serverErrors;
+			stats.drops = m_drops;
+
+			return stats;
+		}
+
+		/**
+		 * @brief Answers one request of the XML protocol.
+		 */
+		void handle(Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)
+		{
+			MockQrzFaults faults = getFaults();
+
+			std::chrono::milliseconds delay = pickDelay(faults);
+			if (delay.count() > 0)
+			{
+				std::this_thread::sleep_for(delay);
+			}
+
+			if (roll(faults.dropRate))
+			{
+				m_drops++;
+
+				// The client sees the connection close before any response arrives
+				static_cast<Poco::Net::HTTPServerRequestImpl &>(request).socket().shutdown();
+				response.setKeepAlive(false);
+				return;
+			}
+
+			if (roll(faults.serverErrorRate))
+			{
+				m_serverErrors++;
+
+				response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_SERVICE_UNAVAILABLE);
+				response.setContentLength(0);
+				response.send();
+				return;
+			}
+
+			if (!Poco::URI(request.getURI()).getPath().starts_with("/xml/"))
+			{
+				response.setStatusAndReason(Poco::Net::HTTPResponse::HTTP_NOT_FOUND);
+				response.setContentLength(0);
+				response.send();
+				return;
+			}
+
+			Poco::Net::HTMLForm form(request);
+
+			if (form.has("username"))
+			{
+				login(request, response, form.get("username"), form.get("password", ""));
+				return;
+			}
+
+			std::string key = form.get("s", "");
+
+			if (!isSessionKey(key))
+			{
+				sendBody(request, response, session("", "Invalid session key"), "text/xml");
+				return;
+			}
+
+			if (roll(faults.sessionTimeoutRate))
+			{
+				m_sessionTimeouts++;
+
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_sessionKeys.erase(key);
+
+				sendBody(request, response, session("", "Session Timeout"), "text/xml");
+				return;
+			}
+
+			if (form.has("callsign"))
+			{
+				lookupCallsign(request, response, key, normalize(form.get("callsign")), roll(faults.notFoundRate));
+			}
+			else if (form.has("html"))
+			{
+				lookupBio(request, response, key, normalize(form.get("html")), roll(faults.notFoundRate));
+			}
+			else if (form.has("dxcc"))
+			{
+				lookupDXCC(request, response, key, form.get("dxcc"), roll(faults.notFoundRate));
+			}
+			else
+			{
+				sendBody(request, response, session(key, ""), "text/xml");
+			}
+		}
+
+	private:
+		mutable std::mutex m_mutex;
+
+		MockQrzFaults m_faults;
+		std::mt19937 m_random;
+		std::atomic<bool> m_synthesize = false;
+
+		std::set<std::string> m_sessionKeys;
+		std::map<std::string, std::string> m_callsigns;
+		std::map<std::string, std::string> m_bios;
+		std::map<std::string, std::string> m_dxccs;
+
+		std::atomic<std::uint64_t> m_logins = 0;
+		std::atomic<std::uint64_t> m_callsignCount = 0;
+		std::atomic<std::uint64_t> m_bioCount = 0;
+		std::atomic<std::uint64_t> m_dxccCount = 0;
+		std::atomic<std::uint64_t> m_sessionTimeouts = 0;
+		std::atomic<std::uint64_t> m_notFounds = 0;
+		std::atomic<std::uint64_t> m_serverErrors = 0;
+		std::atomic<std::uint64_t> m_drops = 0;
+
+		// Lookups counted against the daily quota, as reported in the Count element
+		std::atomic<std::uint64_t> m_lookupCount = 0;
+
+		void login(Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response,
+				   const std::string &username, const std::string &password)
+		{
+			if (username.empty() || password.empty())
+			{
+				sendBody(request, response, session("", "Username/password incorrect"), "text/xml");
+				return;
+			}
+
+			m_logins++;
+
+			std::string key;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				static const char hex[] = "0123456789abcdef";
+				std::uniform_int_distribution<int> digit(0, 15);
+				for (int i = 0; i < 32; i++)
+				{
+					key += hex[digit(m_random)];
+				}
+
+				m_sessionKeys.insert(key);
+			}
+
+			sendBody(request, response, session(key, ""), "text/xml");
+		}
+
+		void lookupCallsign(Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response,
+							const std::string &key, const std::string &call, bool notFound)
+		{
+			m_callsignCount++;
+
+			std::string element;
+			if (!notFound)
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto it = m_callsigns.find(call);
+				if (it != m_callsigns.end())
+				{
+					element = it->second;
+				}
+				else if (m_synthesize)
+				{
+					element = synthesizeCallsign(call);
+				}
+			}
+
+			if (element.empty())
+			{
+				m_notFounds++;
+				sendBody(request, response, session(key, "Not found: " + call), "text/xml");
+				return;
+			}
+
+			m_lookupCount++;
+
+			sendBody(request, response, "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n"
+										"<QRZDatabase version=\"1.34\" xmlns=\"http://xmldata.qrz.com\">\n" + element +
+										"\n" + sessionElement(key, "") + "\n</QRZDatabase>\n", "text/xml");
+		}
+
+		void lookupBio(Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response,
+					   const std::string &key, const std::string &call, bool notFound)
+		{
+			m_bioCount++;
+
+			std::string html;
+			if (!notFound)
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto it = m_bios.find(call);
+				if (it != m_bios.end())
+				{
+					html = it->second;
+				}
+				else if (m_synthesize)
+				{
+					html = "<html><body><div id=\"biodata\"><p>Bio of " + call + ".</p></div></body></html>";
+				}
+			}
+
+			if (html.empty())
+			{
+				m_notFounds++;
+				sendBody(request, response, session(key, "Not found: " + call), "text/xml");
+				return;
+			}
+
+			sendBody(request, response, html, "text/html");
+		}
+
+		void lookupDXCC(Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response,
+						const std::string &key, const std::string &entity, bool notFound)
+		{
+			m_dxccCount++;
+
+			std::string element;
+			if (!notFound)
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+
+				auto it = m_dxccs.find(entity);
+				if (it != m_dxccs.end())
+				{
+					element = it->second;
+				}
+			}
+
+			if (element.empty())
+			{
+				m_notFounds++;
+				sendBody(request, response, session(key, "Not found: " + entity), "text/xml");
+				return;
+			}
+
+			sendBody(request, response, "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n"
+										"<QRZDatabase version=\"1.34\" xmlns=\"http://xmldata.qrz.com\">\n" + element +
+										"\n" + sessionElement(key, "") + "\n</QRZDatabase>\n", "text/xml");
+		}
+
+		bool isSessionKey(const std::string &key) const
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_sessionKeys.contains(key);
+		}
+
+		std::string sessionElement(const std::string &key, const std::string &error) const
+		{
+			std::string element = "<Session>\n";
+
+			if (!error.empty())
+			{
+				element += "<Error>" + error + "</Error>\n";
+			}
+
+			if (!key.empty())
+			{
+				element += "<Key>" + key + "</Key>\n";
+				element += "<Count>" + std::to_string(m_lookupCount.load()) + "</Count>\n";
+				element += "<SubExp>Wed Jan 1 12:34:03 2031</SubExp>\n";
+			}
+
+			element += "<GMTime>" + Poco::DateTimeFormatter::format(Poco::DateTime(), "%w %b %e %H:%M:%S %Y") +
+					   "</GMTime>\n";
+			element += "</Session>";
+
+			return element;
+		}
+
+		std::string session(const std::string &key, const std::string &error) const
+		{
+			return "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n"
+				   "<QRZDatabase version=\"1.34\" xmlns=\"http://xmldata.qrz.com\">\n" + sessionElement(key, error) +
+				   "\n</QRZDatabase>\n";
+		}
+
+		/**
+		 * @brief Sends a body, compressed if the client asked for it.
+		 */
+		static void sendBody(Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response,
+							 const std::string &body, const std::string &contentType)
+		{
+			std::string acceptEncoding = request.get("Accept-Encoding", "");
+			std::string sent = body;
+
+			if (acceptEncoding.find("gzip") != std::string::npos)
+			{
+				sent = compress(body, Poco::DeflatingStreamBuf::STREAM_GZIP);
+				response.set("Content-Encoding", "gzip");
+			}
+			else if (acceptEncoding.find("deflate") != std::string::npos)
+			{
+				sent = compress(body, Poco::DeflatingStreamBuf::STREAM_ZLIB);
+				response.set("Content-Encoding", "deflate");
+			}
+
+			response.setContentType(contentType);
+			response.sendBuffer(sent.data(), sent.size());
+		}
+
+		static std::string compress(const std::string &data, Poco::DeflatingStreamBuf::StreamType type)
+		{
+			std::ostringstream compressed;
+
+			Poco::DeflatingOutputStream deflater(compressed, type);
+			deflater << data;
+			deflater.close();
+
+			return compressed.str();
+		}
+
+		std::chrono::milliseconds pickDelay(const MockQrzFaults &faults)
+		{
+			if (faults.jitter.count() <= 0)
+			{
+				return faults.latency;
+			}
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			std::uniform_int_distribution<std::chrono::milliseconds::rep> jitter(-faults.jitter.count(),
+																				 faults.jitter.count());
+
+			return std::max(faults.latency + std::chrono::milliseconds(jitter(m_random)), std::chrono::milliseconds(0));
+		}
+
+		bool roll(double rate)
+		{
+			if (rate <= 0.0)
+			{
+				return false;
+			}
+
+			if (rate >= 1.0)
+			{
+				return true;
+			}
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			return std::uniform_real_distribution<double>(0.0, 1.0)(m_random) < rate;
+		}
+
+		/**
+		 * @brief Makes up a record for a callsign, so every callsign of a load test costs a lookup.
+		 */
+		static std::string synthesizeCallsign(const std::string &call)
+		{
+			return "<Callsign>\n"
+				   "<call>" + call + "</call>\n"
+				   "<dxcc>291</dxcc>\n"
+				   "<fname>MOCK</fname>\n"
+				   "<name>STATION " + call + "</name>\n"
+				   "<addr2>NEWINGTON</addr2>\n"
+				   "<state>CT</state>\n"
+				   "<country>United States</country>\n"
+				   "<lat>41.714775</lat>\n"
+				   "<lon>-72.727260</lon>\n"
+				   "<grid>FN31pr</grid>\n"
+				   "<class>E</class>\n"
+				   "<bio>512</bio>\n"
+				   "<biodate>2024-01-01 00:00:00</biodate>\n"
+				   "<moddate>2024-01-01 00:00:00</moddate>\n"
+				   "</Callsign>";
+		}
+
+		/**
+		 * @brief Cuts an element out of a response, with or without its own tags.
+		 */
+		static std::string extractElement(const std::string &xml, const std::string &name, bool withTags = true)
+		{
+			std::string open = "<" + name + ">";
+			std::string close = "</" + name + ">";
+
+			std::size_t begin = xml.find(open);
+			std::size_t end = (begin == std::string::npos) ? std::string::npos : xml.find(close, begin);
+
+			if (end == std::string::npos)
+			{
+				return "";
+			}
+
+			return withTags ? xml.substr(begin, end + close.size() - begin)
+							: xml.substr(begin + open.size(), end - begin - open.size());
+		}
+
+		static std::string normalize(std::string call)
+		{
+			std::erase_if(call, [](unsigned char c) { return std::isspace(c); });
+			std::transform(call.begin(), call.end(), call.begin(), [](unsigned char c) { return std::toupper(c); });
+
+			return call;
+		}
+	};
+}
+
+#endif //QRZ_MOCKQRZSERVER_H
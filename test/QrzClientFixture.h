@@ -0,0 +1,91 @@
+#ifndef QRZ_QRZCLIENTFIXTURE_H
+#define QRZ_QRZCLIENTFIXTURE_H
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include <Poco/DateTimeFormatter.h>
+#include <Poco/Timespan.h>
+#include <Poco/Timestamp.h>
+#include <Poco/Net/HTMLForm.h>
+
+#include "../src/QRZClient.h"
+
+#include "LocalQrzServer.h"
+#include "MockClient.h"
+
+namespace qrz
+{
+	/**
+	 * @class QrzClientFixture
+	 *
+	 * @brief Base for tests that point a QRZClient at a LocalQrzServer.
+	 *
+	 * Builds clients that are already logged in, or that have to log in first, and serves the MockClient fixtures.
+	 */
+	class QrzClientFixture : public testing::Test
+	{
+	protected:
+		QrzClientFixture() = default;
+
+		~QrzClientFixture() override = default;
+
+		/**
+		 * @brief Returns a client with a session key that stays valid for the given time.
+		 *
+		 * @param baseUrl The server the client talks to.
+		 * @param remaining How long the session key is good for.
+		 */
+		static QRZClient buildClient(const std::string &baseUrl, Poco::Timespan remaining = Poco::Timespan(0, 24, 0, 0, 0))
+		{
+			Poco::Timestamp expiration;
+			expiration += remaining;
+
+			QRZClient client("W1AW", "password", "c992efd9432fbc4972b36432f822be64",
+							 Poco::DateTimeFormatter::format(expiration, "%Y-%m-%d %H:%M:%S"));
+			client.setBaseUrl(baseUrl);
+
+			return client;
+		}
+
+		/**
+		 * @brief Returns a client that has to log in before its first lookup.
+		 *
+		 * @param baseUrl The server the client talks to.
+		 * @param password The password the client logs in with.
+		 */
+		static QRZClient buildLoggedOutClient(const std::string &baseUrl, const std::string &password = "password")
+		{
+			QRZClient client;
+			client.setUsername("W1AW");
+			client.setPassword(password);
+			client.setBaseUrl(baseUrl);
+
+			return client;
+		}
+
+		/**
+		 * @brief Returns a handler that answers every callsign lookup with the given record, and logins with a session.
+		 *
+		 * @param record The callsign XML to answer lookups with.
+		 */
+		LocalQrzServer::Handler serveRecord(const std::string &record) const
+		{
+			return [record, session = fixtures.sessionResponse](Poco::Net::HTTPServerRequest &request,
+																 Poco::Net::HTTPServerResponse &response)
+			{
+				Poco::Net::HTMLForm form(request);
+
+				const std::string &body = form.has("callsign") ? record : session;
+
+				response.setContentType("text/xml");
+				response.sendBuffer(body.data(), body.size());
+			};
+		}
+
+		MockClient fixtures;
+	};
+}
+
+#endif //QRZ_QRZCLIENTFIXTURE_H
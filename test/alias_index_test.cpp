@@ -0,0 +1,77 @@
+#include "../src/cache/AliasIndex.h"
+#include "../src/QRZClient.h"
+
+#include <gtest/gtest.h>
+
+#include "QrzClientFixture.h"
+
+namespace qrz
+{
+	namespace
+	{
+		class AliasIndexTests : public QrzClientFixture
+		{
+		protected:
+			AliasIndexTests() = default;
+
+			~AliasIndexTests() override = default;
+
+			static Callsign record(const std::string &call, const std::string &xref, const std::string &aliases)
+			{
+				Callsign callsign;
+				callsign.setCall(call);
+				callsign.setXref(xref);
+				callsign.setAliases(aliases);
+
+				return callsign;
+			}
+		};
+
+		TEST_F(AliasIndexTests, TestXrefAndAliasesResolveToTheRecord)
+		{
+			cache::AliasIndex index;
+
+			index.add(record("K4RWR", "ve3/kf4abc", "KI4XYZ, KJ4QRS/M"));
+
+			ASSERT_EQ("K4RWR", index.resolve("KF4ABC/P").value());
+			ASSERT_EQ("K4RWR", index.resolve(" kf4abc ").value());
+			ASSERT_EQ("K4RWR", index.resolve("KI4XYZ").value());
+			ASSERT_EQ("K4RWR", index.resolve("KJ4QRS").value());
+			ASSERT_FALSE(index.resolve("K4RWR/P").has_value()) << "The callsign of the record is not an alias";
+			ASSERT_EQ("W1AW", index.canonicalize("w1aw/p")) << "An unknown callsign stands for its station";
+			ASSERT_EQ(3u, index.size());
+		}
+
+		TEST_F(AliasIndexTests, TestCallsignWithARecordOfItsOwnIsNoLongerAnAlias)
+		{
+			cache::AliasIndex index;
+
+			index.add(record("K4RWR", "", "KF4ABC"));
+			index.add(record("KF4ABC", "", ""));
+
+			ASSERT_FALSE(index.resolve("KF4ABC").has_value());
+		}
+
+		TEST_F(AliasIndexTests, TestSplitAliasesSkipsEntriesThatAreNotCallsigns)
+		{
+			std::vector<std::string> expected = {"W5VE", "KB5ABC"};
+
+			ASSERT_EQ(expected, cache::AliasIndex::splitAliases("w5ve,, KB5ABC/P , Bob,"));
+			ASSERT_TRUE(cache::AliasIndex::splitAliases("").empty());
+		}
+
+		TEST_F(AliasIndexTests, TestClientAnswersAliasFromCachedRecord)
+		{
+			LocalQrzServer server(serveRecord(fixtures.callsignXmlW5YI));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			client.fetchCallsign("W5YI");
+			Callsign alias = client.fetchCallsign("W5VE");
+
+			ASSERT_STREQ("W5YI", alias.getCall().c_str()) << "The alias should resolve to the record of the operator";
+			ASSERT_EQ(1, server.getRequestCount()) << "The alias should be answered without going to QRZ";
+			ASSERT_EQ(1u, client.getAliasIndex().getResolvedCount());
+		}
+	}
+}
@@ -5,6 +5,9 @@
 #include <format>
 #include <filesystem>
 
+#include <QCoreApplication>
+#include <QSettings>
+
 namespace qrz
 {
 	namespace
@@ -156,5 +159,111 @@ namespace qrz
 			foundNeedle = (results.at(1).find(needle) != std::string::npos);
 			ASSERT_TRUE(foundNeedle) << "Expected string should be found in bio HTML";
 		}
+
+		class AppControllerPrefetchTests : public testing::Test
+		{
+		protected:
+			static void SetUpTestSuite()
+			{
+				// The lookup thread and the controller's queued calls need an application object
+				if (QCoreApplication::instance() == nullptr)
+				{
+					static int argc = 1;
+					static char name[] = "qrz_test";
+					static char *argv[] = {name, nullptr};
+					static QCoreApplication application(argc, argv);
+				}
+
+				// Keep the settings of the test away from those of the user
+				QCoreApplication::setOrganizationName("qrzbuddy-test");
+				QSettings::setPath(QSettings::NativeFormat, QSettings::UserScope,
+								   QString::fromStdString((std::filesystem::temp_directory_path() / "qrzbuddy-test").string()));
+			}
+
+			void SetUp() override
+			{
+				config.setUsername("W1AW");
+				config.setPassword("wh15ky7@n60F0x7r07");
+				config.setPrefetchLimit(10);
+				config.setOfflineMode(false);
+
+				controller = std::make_unique<AppControllerProxy>(&config, &table);
+
+				// Prefetches run on the lookup thread, keep them off the real QRZ
+				controller->proxySetBaseUrl("https://127.0.0.1:1");
+			}
+
+			void TearDown() override
+			{
+				controller.reset();
+				QSettings().clear();
+			}
+
+			// Background jobs handed to the lookup service, whether or not the lookup thread has started them yet
+			std::uint64_t backgroundLookups() const
+			{
+				LookupSchedulerStats stats = controller->proxyGetQueueStats();
+				return stats.queued[LookupPriority::BACKGROUND] + stats.started[LookupPriority::BACKGROUND];
+			}
+
+			Configuration config;
+			TableModel table;
+			std::unique_ptr<AppControllerProxy> controller;
+		};
+
+		TEST_F(AppControllerPrefetchTests, TestPrefetchQueuesBackgroundLookups)
+		{
+			controller->prefetchCallsigns({"W1AW", "K1ABC", "VE3/K4RWR"});
+
+			LookupSchedulerStats stats = controller->proxyGetQueueStats();
+
+			ASSERT_EQ(3u, backgroundLookups()) << "Every station heard should be prefetched";
+			ASSERT_EQ(0u, stats.queued[LookupPriority::INTERACTIVE] + stats.started[LookupPriority::INTERACTIVE]);
+			ASSERT_EQ(0u, stats.queued[LookupPriority::DETAIL] + stats.started[LookupPriority::DETAIL])
+										<< "Prefetches should never compete with lookups someone is waiting for";
+		}
+
+		TEST_F(AppControllerPrefetchTests, TestPrefetchSkipsCachedCalls)
+		{
+			Callsign cached;
+			cached.setCall("W1AW");
+			table.addCallsign(cached);
+
+			// W1AW is already in the table, K4RWR/P is the same station as K4RWR
+			controller->prefetchCallsigns({"W1AW", "w1aw/p", "K4RWR", "K4RWR/P", "K1ABC"});
+
+			ASSERT_EQ(2u, backgroundLookups()) << "Only K4RWR and K1ABC should have been prefetched";
+		}
+
+		TEST_F(AppControllerPrefetchTests, TestResolvedAliasLeavesTheDeferredQueue)
+		{
+			std::filesystem::path queuePath = std::filesystem::temp_directory_path() / "qrzbuddy-test-deferred";
+			std::filesystem::remove(queuePath);
+			controller->proxyUseDeferredLookups(queuePath);
+
+			// Deferred under a former callsign and a prefixed one, both answered by the record of W1AW, so each has a
+			// placeholder row of its own
+			controller->proxyDeferLookup("KA1XYZ");
+			controller->proxyDeferLookup("DL/W1AW");
+			ASSERT_EQ(2u, controller->getDeferredLookupCount());
+			ASSERT_TRUE(table.containsCallsign("KA1XYZ")) << "A deferred callsign should get a placeholder row";
+
+			Callsign record;
+			record.setCall("W1AW");
+			record.setName("ARRL HQ OPERATORS CLUB");
+
+			ASSERT_TRUE(table.containsCallsign("W1AW"));
+
+			controller->proxyAddRecord(record, "KA1XYZ");
+
+			ASSERT_EQ(0u, controller->getDeferredLookupCount()) << "Both deferrals should be settled by the record";
+			ASSERT_FALSE(table.containsCallsign("KA1XYZ")) << "The placeholder should have been folded into the record";
+			ASSERT_TRUE(table.containsCallsign("W1AW"));
+			ASSERT_EQ(1u, table.getCallsigns().size());
+			ASSERT_EQ("ARRL HQ OPERATORS CLUB", table.getCallsign("W1AW").getName());
+
+			controller.reset();
+			std::filesystem::remove(queuePath);
+		}
 	}
 }
\ No newline at end of file
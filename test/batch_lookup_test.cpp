@@ -0,0 +1,171 @@
+#include "../src/BatchLookupEngine.h"
+#include "../src/QRZClient.h"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+
+#include <Poco/Net/HTMLForm.h>
+
+#include "QrzClientFixture.h"
+
+namespace qrz
+{
+	namespace
+	{
+		class BatchLookupTests : public QrzClientFixture
+		{
+		protected:
+			BatchLookupTests() = default;
+
+			~BatchLookupTests() override = default;
+		};
+
+		TEST_F(BatchLookupTests, TestOutcomesKeepInputOrder)
+		{
+			std::vector<std::string> terms = {"W1AW", "K1ABC", "N0CALL", "W2XYZ", "KF0ABC", "W1AW/M"};
+
+			BatchLookupEngine<std::string> engine(
+					[](const std::string &term)
+					{
+						// Make the early terms finish last
+						std::this_thread::sleep_for(std::chrono::milliseconds(60 - term.size() * 5));
+
+						if (term == "N0CALL")
+						{
+							throw NotFoundException();
+						}
+
+						return "found " + term;
+					},
+					[]() { return true; },
+					4, 4);
+
+			auto outcomes = engine.run(terms);
+
+			ASSERT_EQ(terms.size(), outcomes.size());
+			for (std::size_t i = 0; i < terms.size(); i++)
+			{
+				ASSERT_STREQ(terms[i].c_str(), outcomes[i].term.c_str()) << "Outcome " << i << " is out of order";
+			}
+
+			ASSERT_FALSE(outcomes[2].result.has_value());
+			ASSERT_TRUE(outcomes[2].notFound);
+			ASSERT_STREQ("found W1AW", outcomes[0].result.value().c_str());
+		}
+
+		TEST_F(BatchLookupTests, TestExpiredTokenIsRefreshedOnce)
+		{
+			std::atomic<int> token = 0;
+			std::atomic<int> refreshes = 0;
+
+			BatchLookupEngine<int> engine(
+					[&token](const std::string &)
+					{
+						std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+						if (token == 0)
+						{
+							throw AuthenticationException("Session Timeout");
+						}
+
+						return token.load();
+					},
+					[&token, &refreshes]()
+					{
+						refreshes++;
+						token = 1;
+						return true;
+					},
+					8, 4);
+
+			auto outcomes = engine.run({"A", "B", "C", "D", "E", "F", "G", "H"});
+
+			for (const auto &outcome : outcomes)
+			{
+				ASSERT_TRUE(outcome.result.has_value()) << outcome.term << " failed: " << outcome.error;
+			}
+
+			ASSERT_EQ(1, refreshes) << "Workers failing on the same token should share one refresh";
+		}
+
+		TEST_F(BatchLookupTests, TestMissingCredentialsReportsErrors)
+		{
+			BatchLookupEngine<int> engine(
+					[](const std::string &) -> int
+					{
+						throw AuthenticationException("Session Timeout");
+					},
+					[]() { return false; },
+					4, 4);
+
+			auto outcomes = engine.run({"A", "B", "C"});
+
+			for (const auto &outcome : outcomes)
+			{
+				ASSERT_FALSE(outcome.result.has_value());
+				ASSERT_STREQ("QRZ API Error: Session Timeout", outcome.error.c_str());
+			}
+		}
+
+		TEST_F(BatchLookupTests, TestParallelLookupsAgainstSlowServer)
+		{
+			std::atomic<int> inFlight = 0;
+			std::atomic<int> peak = 0;
+
+			// Each lookup costs 100ms, roughly a round trip to the real API, so concurrent requests overlap
+			LocalQrzServer server([this, &inFlight, &peak](Poco::Net::HTTPServerRequest &request,
+														   Poco::Net::HTTPServerResponse &response)
+			{
+				Poco::Net::HTMLForm form(request);
+
+				int current = ++inFlight;
+				int highest = peak.load();
+				while (current > highest && !peak.compare_exchange_weak(highest, current))
+				{
+				}
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+				inFlight--;
+
+				std::string body = form.has("callsign") ? fixtures.callsignXmlW1AW : fixtures.sessionResponse;
+
+				response.setContentType("text/xml");
+				response.sendBuffer(body.data(), body.size());
+			});
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			// Distinct terms, so neither the record cache nor lookup coalescing can answer them
+			auto peakOfRun = [&client, &peak](std::size_t workers, const std::string &prefix)
+			{
+				std::vector<std::string> terms;
+				for (int i = 0; i < 16; i++)
+				{
+					terms.push_back(prefix + std::string(1, static_cast<char>('A' + i)));
+				}
+
+				BatchLookupEngine<Callsign> engine(
+						[&client](const std::string &call) { return client.fetchCallsign(call); },
+						[]() { return false; },
+						workers, 4);
+
+				peak = 0;
+
+				auto outcomes = engine.run(terms);
+
+				for (const auto &outcome : outcomes)
+				{
+					EXPECT_TRUE(outcome.result.has_value()) << outcome.error;
+				}
+
+				return peak.load();
+			};
+
+			ASSERT_EQ(1, peakOfRun(1, "W1S")) << "A single worker should never have two requests in flight";
+			ASSERT_GE(peakOfRun(8, "W1P"), 4) << "8 workers should have kept several requests in flight at once";
+		}
+	}
+}
@@ -0,0 +1,159 @@
+#include "../src/cache/BioCache.h"
+#include "../src/QRZClient.h"
+
+#include <filesystem>
+#include <gtest/gtest.h>
+
+#include <Poco/Net/HTMLForm.h>
+
+#include "QrzClientFixture.h"
+
+namespace qrz
+{
+	namespace
+	{
+		class BioCacheTests : public QrzClientFixture
+		{
+		protected:
+			BioCacheTests() = default;
+
+			~BioCacheTests() override = default;
+
+			void SetUp() override
+			{
+				cacheDir = std::filesystem::temp_directory_path() / "qrzbuddy-bio-cache-test";
+				std::filesystem::remove_all(cacheDir);
+			}
+
+			void TearDown() override
+			{
+				std::filesystem::remove_all(cacheDir);
+			}
+
+			// Bios are mostly boilerplate markup, so they compress well
+			std::string buildBio(const std::string &call)
+			{
+				std::string html = "<html><body><h1>" + call + "</h1>";
+				for (int i = 0; i < 200; i++)
+				{
+					html += "<p class=\"bio\">Operating from the club station, QSL via the bureau.</p>";
+				}
+				html += "</body></html>";
+
+				return html;
+			}
+
+			std::filesystem::path cacheDir;
+		};
+
+		TEST_F(BioCacheTests, TestRoundTrip)
+		{
+			cache::BioCache bioCache(cacheDir, 1024 * 1024);
+
+			bioCache.put("w1aw", "2023-01-02 03:04:05", buildBio("W1AW"));
+
+			std::optional<std::string> cached = bioCache.get("W1AW", "2023-01-02 03:04:05");
+
+			ASSERT_TRUE(cached.has_value());
+			ASSERT_EQ(buildBio("W1AW"), cached.value());
+			ASSERT_EQ(1u, bioCache.getStats().memoryHits);
+		}
+
+		TEST_F(BioCacheTests, TestPortableCallsignSharesTheBioOfItsStation)
+		{
+			cache::BioCache bioCache(cacheDir, 1024 * 1024);
+
+			bioCache.put("K4RWR", "1", buildBio("K4RWR"));
+
+			ASSERT_EQ(buildBio("K4RWR"), bioCache.get("k4rwr/p", "1").value());
+			ASSERT_EQ(buildBio("K4RWR"), bioCache.get("VE3/K4RWR", "1").value());
+			ASSERT_FALSE(bioCache.get("not a callsign", "1").has_value());
+		}
+
+		TEST_F(BioCacheTests, TestChangedBiodateIsMiss)
+		{
+			cache::BioCache bioCache(cacheDir, 1024 * 1024);
+
+			bioCache.put("W1AW", "2023-01-02 03:04:05", buildBio("W1AW"));
+
+			ASSERT_FALSE(bioCache.get("W1AW", "2024-06-07 08:09:10").has_value()) << "An edited bio should be downloaded again";
+			ASSERT_EQ(1u, bioCache.getStats().misses);
+		}
+
+		TEST_F(BioCacheTests, TestReopenedCacheReadsFromDisk)
+		{
+			{
+				cache::BioCache bioCache(cacheDir, 1024 * 1024);
+				bioCache.put("W1AW", "2023-01-02 03:04:05", buildBio("W1AW"));
+			}
+
+			cache::BioCache reopened(cacheDir, 1024 * 1024);
+
+			std::optional<std::string> cached = reopened.get("W1AW", "2023-01-02 03:04:05");
+
+			ASSERT_TRUE(cached.has_value());
+			ASSERT_EQ(buildBio("W1AW"), cached.value());
+			ASSERT_EQ(1u, reopened.getStats().diskHits);
+
+			ASSERT_TRUE(reopened.get("W1AW", "2023-01-02 03:04:05").has_value());
+			ASSERT_EQ(1u, reopened.getStats().memoryHits) << "A bio read from disk should be kept in memory";
+		}
+
+		TEST_F(BioCacheTests, TestMemoryBudgetIsRespected)
+		{
+			std::size_t compressedSize = cache::BioCache::compress(buildBio("W1AW")).size();
+
+			// Room for two compressed bios, not three
+			cache::BioCache bioCache(cacheDir, compressedSize * 2 + compressedSize / 2);
+
+			bioCache.put("W1AW", "1", buildBio("W1AW"));
+			bioCache.put("K1ABC", "1", buildBio("K1ABC"));
+			bioCache.put("W5YI", "1", buildBio("W5YI"));
+
+			cache::BioCacheStats stats = bioCache.getStats();
+			ASSERT_EQ(2u, stats.memoryEntries);
+			ASSERT_LE(stats.memoryBytes, compressedSize * 2 + compressedSize / 2);
+
+			ASSERT_TRUE(bioCache.get("W1AW", "1").has_value()) << "Evicted bios should still be on disk";
+			ASSERT_EQ(1u, bioCache.getStats().diskHits);
+		}
+
+		TEST_F(BioCacheTests, TestBiosAreStoredCompressed)
+		{
+			cache::BioCache bioCache(cacheDir, 1024 * 1024);
+
+			std::string html = buildBio("W1AW");
+			bioCache.put("W1AW", "1", html);
+
+			cache::BioCacheStats stats = bioCache.getStats();
+			ASSERT_GT(stats.diskBytes, 0u);
+			ASSERT_LT(stats.diskBytes * 4, html.size()) << "Repetitive HTML should compress at least four to one";
+			ASSERT_EQ(html, cache::BioCache::decompress(cache::BioCache::compress(html)));
+		}
+
+		TEST_F(BioCacheTests, TestClientReusesCachedBio)
+		{
+			LocalQrzServer server([this](Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)
+			{
+				Poco::Net::HTMLForm form(request);
+
+				std::string body = buildBio(form.get("html", ""));
+
+				response.setContentType("text/html");
+				response.sendBuffer(body.data(), body.size());
+			});
+
+			QRZClient client = buildClient(server.getBaseUrl());
+			client.setBioCache(std::make_shared<cache::BioCache>(cacheDir, 1024 * 1024));
+
+			std::string first = client.fetchBio("W1AW", "2023-01-02 03:04:05");
+			std::string second = client.fetchBio("W1AW", "2023-01-02 03:04:05");
+
+			ASSERT_EQ(first, second);
+			ASSERT_EQ(1, server.getRequestCount()) << "An unchanged bio should not be downloaded again";
+
+			client.fetchBio("W1AW", "2024-06-07 08:09:10");
+			ASSERT_EQ(2, server.getRequestCount()) << "A changed biodate should download the bio again";
+		}
+	}
+}
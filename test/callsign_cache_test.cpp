@@ -0,0 +1,132 @@
+#include "../src/cache/CallsignCache.h"
+#include "../src/QRZClient.h"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+#include "MockClient.h"
+
+namespace qrz
+{
+	namespace
+	{
+		class CallsignCacheTests : public testing::Test
+		{
+		protected:
+			CallsignCacheTests() = default;
+
+			~CallsignCacheTests() override = default;
+
+			void SetUp() override
+			{
+				cacheDir = std::filesystem::temp_directory_path() / "qrzbuddy-callsign-cache-test";
+				std::filesystem::remove_all(cacheDir);
+			}
+
+			void TearDown() override
+			{
+				std::filesystem::remove_all(cacheDir);
+			}
+
+			Callsign buildCallsign()
+			{
+				Callsign callsign;
+				callsign.setCall("W1AW");
+				callsign.setName("ARRL HQ OPERATORS CLUB");
+				callsign.setCcode("291");
+				callsign.setCodes("HAB");
+				callsign.setSerial("12345");
+				callsign.setModdate("2023-01-02 03:04:05");
+
+				return callsign;
+			}
+
+			std::filesystem::path cacheDir;
+		};
+
+		TEST_F(CallsignCacheTests, TestRoundTrip)
+		{
+			cache::CallsignCache callsignCache(cacheDir, std::chrono::hours(1));
+
+			callsignCache.put("w1aw ", buildCallsign());
+
+			std::optional<Callsign> cached = callsignCache.get("W1AW");
+
+			ASSERT_TRUE(cached.has_value()) << "Record should be found under the normalized callsign";
+			ASSERT_STREQ("ARRL HQ OPERATORS CLUB", cached->getName().c_str());
+			ASSERT_STREQ("291", cached->getCcode().c_str()) << "ccode should not be replaced by codes";
+			ASSERT_STREQ("HAB", cached->getCodes().c_str());
+			ASSERT_STREQ("2023-01-02 03:04:05", cached->getModdate().c_str());
+
+			ASSERT_EQ(1u, callsignCache.getStats().hits);
+		}
+
+		TEST_F(CallsignCacheTests, TestSurvivesRestart)
+		{
+			{
+				cache::CallsignCache callsignCache(cacheDir, std::chrono::hours(1));
+				callsignCache.put("W1AW/M", buildCallsign());
+			}
+
+			cache::CallsignCache reopened(cacheDir, std::chrono::hours(1));
+
+			ASSERT_TRUE(reopened.get("W1AW/M").has_value()) << "Record should be read back by a new cache instance";
+			ASSERT_FALSE(reopened.get("W1AW").has_value()) << "Portable and home calls should be separate records";
+		}
+
+		TEST_F(CallsignCacheTests, TestExpiredRecordsAreStale)
+		{
+			cache::CallsignCache callsignCache(cacheDir, std::chrono::hours(1));
+
+			auto now = std::chrono::system_clock::now();
+
+			callsignCache.put("W1AW", buildCallsign(), now - std::chrono::hours(3));
+			callsignCache.put("K1ABC", buildCallsign(), now - std::chrono::hours(2));
+			callsignCache.put("W5YI", buildCallsign(), now);
+
+			ASSERT_FALSE(callsignCache.get("W1AW").has_value()) << "Expired record should not be returned";
+			ASSERT_EQ(1u, callsignCache.getStats().expired);
+
+			std::optional<cache::CallsignCacheEntry> entry = callsignCache.getEntry("W1AW");
+			ASSERT_TRUE(entry.has_value()) << "Expired record should still be on disk";
+			ASSERT_STREQ("12345", entry->serial.c_str());
+
+			std::vector<cache::CallsignCacheEntry> stale = callsignCache.findStale();
+
+			ASSERT_EQ(2u, stale.size());
+			ASSERT_STREQ("W1AW", stale[0].key.c_str()) << "Oldest record should come first";
+			ASSERT_STREQ("K1ABC", stale[1].key.c_str());
+			ASSERT_STREQ("2023-01-02 03:04:05", stale[0].moddate.c_str());
+		}
+
+		TEST_F(CallsignCacheTests, TestCorruptFileIsDiscarded)
+		{
+			cache::CallsignCache callsignCache(cacheDir, std::chrono::hours(1));
+
+			{
+				std::ofstream out(cacheDir / "W1AW.xml");
+				out << "not a cache file";
+			}
+
+			ASSERT_FALSE(callsignCache.get("W1AW").has_value());
+			ASSERT_FALSE(std::filesystem::exists(cacheDir / "W1AW.xml")) << "Corrupt file should be removed";
+		}
+
+		TEST_F(CallsignCacheTests, TestClientUsesCache)
+		{
+			MockClient client;
+			client.setCallsignCache(std::make_shared<cache::CallsignCache>(cacheDir, std::chrono::hours(1)));
+			client.fetchToken();
+
+			Callsign first = client.fetchCallsign("W1AW");
+			Callsign second = client.fetchCallsign("w1aw");
+
+			ASSERT_STREQ(first.getName().c_str(), second.getName().c_str());
+
+			cache::CallsignCacheStats stats = client.getCallsignCache()->getStats();
+			ASSERT_EQ(1u, stats.writes) << "Fetched record should be written to the cache";
+			ASSERT_EQ(1u, stats.hits) << "Second lookup should be answered from the cache";
+		}
+	}
+}
@@ -0,0 +1,57 @@
+#include "../src/CallsignCanonicalizer.h"
+
+#include <gtest/gtest.h>
+
+namespace qrz
+{
+	namespace
+	{
+		class CallsignCanonicalizerTests : public testing::Test
+		{
+		protected:
+			CallsignCanonicalizerTests() = default;
+
+			~CallsignCanonicalizerTests() override = default;
+		};
+
+		TEST_F(CallsignCanonicalizerTests, TestStationCallsignsAreRecognized)
+		{
+			for (const char *call : {"W1AW", "K4RWR", "N0CALL", "2E0ABC", "4X1AB", "3DA0RU", "VE3XYZ", "GB100RSGB"})
+			{
+				ASSERT_TRUE(CallsignCanonicalizer::isBaseCallsign(call)) << call;
+			}
+		}
+
+		TEST_F(CallsignCanonicalizerTests, TestImpossibleCallsignsAreRejected)
+		{
+			for (const char *call : {"", "   ", "W", "W1", "1234", "123A", "WAAW", "FN42", "14.078", "W1AW!", "K1ABCDE",
+									 "W1AW//P", "/W1AW", "W1AW/", "W1AW/PORTABLE", "A/B/C/D", "JOHN SMITH"})
+			{
+				ASSERT_FALSE(CallsignCanonicalizer::isValid(call)) << call;
+			}
+		}
+
+		TEST_F(CallsignCanonicalizerTests, TestPortablesCanonicalizeToTheStation)
+		{
+			ASSERT_EQ("K4RWR", CallsignCanonicalizer::canonicalize("VE3/K4RWR"))
+				<< "A prefix portable is not the station before the slash";
+			ASSERT_EQ("K4RWR", CallsignCanonicalizer::canonicalize(" k4rwr/p "));
+			ASSERT_EQ("K4RWR", CallsignCanonicalizer::canonicalize("K4RWR/MM"));
+			ASSERT_EQ("K4RWR", CallsignCanonicalizer::canonicalize("K4RWR/QRP"));
+			ASSERT_EQ("W1AW", CallsignCanonicalizer::canonicalize("W1AW/7"));
+			ASSERT_EQ("W1AW", CallsignCanonicalizer::canonicalize("KH6/W1AW/M"));
+			ASSERT_EQ("", CallsignCanonicalizer::canonicalize("QRP/P"));
+		}
+
+		TEST_F(CallsignCanonicalizerTests, TestPartsAreKept)
+		{
+			std::optional<CanonicalCallsign> canonical = CallsignCanonicalizer::parse("ve3/k4rwr/p");
+
+			ASSERT_TRUE(canonical.has_value());
+			ASSERT_EQ("VE3", canonical->prefix);
+			ASSERT_EQ("K4RWR", canonical->base);
+			ASSERT_EQ("P", canonical->suffix);
+			ASSERT_EQ("VE3/K4RWR/P", canonical->toString());
+		}
+	}
+}
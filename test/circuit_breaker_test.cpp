@@ -0,0 +1,180 @@
+#include "../src/net/CircuitBreaker.h"
+#include "../src/net/RetryPolicy.h"
+#include "../src/QRZClient.h"
+
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "QrzClientFixture.h"
+
+namespace qrz
+{
+	namespace
+	{
+		using namespace std::chrono_literals;
+
+		class CircuitBreakerTests : public QrzClientFixture
+		{
+		protected:
+			CircuitBreakerTests() = default;
+
+			~CircuitBreakerTests() override = default;
+
+			QRZClient buildClient(const std::string &baseUrl)
+			{
+				QRZClient client = QrzClientFixture::buildClient(baseUrl);
+				client.setRetryPolicy({3, 10ms, 50ms});
+
+				return client;
+			}
+
+			// Answers with 503 for the first few requests, then with the W1AW record
+			LocalQrzServer::Handler flakyHandler(int failures)
+			{
+				return [this, failures](Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)
+				{
+					if (m_served++ < failures)
+					{
+						response.setStatus(Poco::Net::HTTPResponse::HTTP_SERVICE_UNAVAILABLE);
+						response.send() << "Down for maintenance";
+						return;
+					}
+
+					response.setContentType("text/xml");
+					response.sendBuffer(fixtures.callsignXmlW1AW.data(), fixtures.callsignXmlW1AW.size());
+				};
+			}
+
+			std::atomic<int> m_served = 0;
+		};
+
+		TEST_F(CircuitBreakerTests, TestOpensAfterThreshold)
+		{
+			net::CircuitBreaker breaker(3, 10s);
+			auto now = net::CircuitBreaker::Clock::now();
+
+			breaker.recordFailure(now);
+			breaker.recordFailure(now);
+			breaker.recordSuccess();
+			breaker.recordFailure(now);
+			breaker.recordFailure(now);
+
+			ASSERT_EQ(net::CircuitState::CLOSED, breaker.getState()) << "A success should reset the failure count";
+			ASSERT_TRUE(breaker.allowRequest(now));
+
+			breaker.recordFailure(now);
+
+			ASSERT_EQ(net::CircuitState::OPEN, breaker.getState());
+			ASSERT_FALSE(breaker.allowRequest(now + 5s)) << "An open breaker should refuse requests";
+
+			net::CircuitBreakerStats stats = breaker.getStats(now + 4s);
+			ASSERT_EQ(1u, stats.opened);
+			ASSERT_EQ(1u, stats.rejected);
+			ASSERT_EQ(3, stats.consecutiveFailures);
+			ASSERT_EQ(6000ms, stats.retryIn);
+		}
+
+		TEST_F(CircuitBreakerTests, TestHalfOpenAllowsOneTrial)
+		{
+			net::CircuitBreaker breaker(1, 10s);
+			auto now = net::CircuitBreaker::Clock::now();
+
+			std::vector<net::CircuitState> changes;
+			breaker.setListener([&changes](net::CircuitState state) { changes.push_back(state); });
+
+			breaker.recordFailure(now);
+
+			ASSERT_TRUE(breaker.allowRequest(now + 10s)) << "The first request after the cool down should be the trial";
+			ASSERT_EQ(net::CircuitState::HALF_OPEN, breaker.getState());
+			ASSERT_FALSE(breaker.allowRequest(now + 10s)) << "Only one trial should be in flight";
+
+			breaker.recordSuccess();
+
+			ASSERT_EQ(net::CircuitState::CLOSED, breaker.getState());
+			ASSERT_TRUE(breaker.allowRequest(now + 10s));
+
+			std::vector<net::CircuitState> expected = {net::CircuitState::OPEN, net::CircuitState::HALF_OPEN,
+													   net::CircuitState::CLOSED};
+			ASSERT_EQ(expected, changes);
+		}
+
+		TEST_F(CircuitBreakerTests, TestFailedTrialDoublesCoolDown)
+		{
+			net::CircuitBreaker breaker(1, 10s, 30s);
+			auto now = net::CircuitBreaker::Clock::now();
+
+			breaker.recordFailure(now);
+
+			ASSERT_TRUE(breaker.allowRequest(now + 10s));
+			breaker.recordFailure(now + 10s);
+
+			ASSERT_FALSE(breaker.allowRequest(now + 29s)) << "A failed trial should pause for twice as long";
+			ASSERT_TRUE(breaker.allowRequest(now + 30s));
+			breaker.recordFailure(now + 30s);
+
+			ASSERT_FALSE(breaker.allowRequest(now + 59s)) << "The cool down should be capped";
+			ASSERT_TRUE(breaker.allowRequest(now + 60s));
+
+			breaker.recordAbandoned();
+			ASSERT_TRUE(breaker.allowRequest(now + 60s)) << "An abandoned trial should let another caller try";
+		}
+
+		TEST_F(CircuitBreakerTests, TestRetryDelayBounds)
+		{
+			net::RetryPolicy policy{5, 100ms, 1s};
+
+			ASSERT_EQ(0ms, policy.delayFor(0, 0.0));
+			ASSERT_EQ(100ms, policy.delayFor(0, 1.0));
+			ASSERT_EQ(200ms, policy.delayFor(1, 1.0));
+			ASSERT_EQ(200ms, policy.delayFor(2, 0.5));
+			ASSERT_EQ(1000ms, policy.delayFor(10, 1.0)) << "The delay should be capped";
+
+			for (int retry = 0; retry < 8; retry++)
+			{
+				std::chrono::milliseconds delay = policy.delayFor(retry);
+
+				ASSERT_GE(delay, 0ms);
+				ASSERT_LE(delay, policy.delayFor(retry, 1.0));
+			}
+		}
+
+		TEST_F(CircuitBreakerTests, TestServerErrorIsRetried)
+		{
+			LocalQrzServer server(flakyHandler(2));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			Callsign callsign = client.fetchCallsign("W1AW");
+
+			ASSERT_EQ("W1AW", callsign.getCall());
+			ASSERT_EQ(3, server.getRequestCount()) << "Two failed attempts should have been retried";
+			ASSERT_EQ(net::CircuitState::CLOSED, client.getCircuitBreaker().getState());
+			ASSERT_EQ(0, client.getCircuitBreaker().getStats().consecutiveFailures);
+		}
+
+		TEST_F(CircuitBreakerTests, TestOpenBreakerFailsFast)
+		{
+			LocalQrzServer server(flakyHandler(1000));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+			client.setRetryPolicy({1});
+			client.getCircuitBreaker().setFailureThreshold(2);
+
+			ASSERT_THROW(client.fetchCallsign("W1AW"), TransportException) << "A 503 should not pass for a record";
+			ASSERT_THROW(client.fetchCallsign("K1ABC"), TransportException);
+
+			ASSERT_EQ(net::CircuitState::OPEN, client.getCircuitBreaker().getState());
+
+			auto start = std::chrono::steady_clock::now();
+			ASSERT_THROW(client.fetchCallsign("N0CALL"), CircuitOpenException);
+
+			ASSERT_LT(std::chrono::steady_clock::now() - start, 100ms) << "An open breaker should not wait on anything";
+			ASSERT_EQ(2, server.getRequestCount()) << "An open breaker should not contact the server";
+
+			QRZClient copy = client;
+			ASSERT_THROW(copy.fetchCallsign("N0CALL"), CircuitOpenException) << "Copies should share the breaker";
+		}
+	}
+}
@@ -0,0 +1,131 @@
+#include "../src/net/TransferCounter.h"
+#include "../src/QRZClient.h"
+
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include <Poco/DeflatingStream.h>
+
+#include "QrzClientFixture.h"
+
+namespace qrz
+{
+	namespace
+	{
+		class CompressionTests : public QrzClientFixture
+		{
+		protected:
+			CompressionTests() = default;
+
+			~CompressionTests() override = default;
+
+			static std::string compress(const std::string &data, Poco::DeflatingStreamBuf::StreamType type)
+			{
+				std::ostringstream compressed;
+
+				Poco::DeflatingOutputStream deflater(compressed, type);
+				deflater << data;
+				deflater.close();
+
+				return compressed.str();
+			}
+
+			// Answers with the W1AW record or bio, compressed the way the client asked for
+			LocalQrzServer::Handler compressingHandler(const std::string &encoding)
+			{
+				return [this, encoding](Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)
+				{
+					m_acceptEncoding = request.get("Accept-Encoding", "");
+
+					bool bio = request.getURI().find("html=") != std::string::npos;
+					std::string body = bio ? fixtures.bioHtmlW1AW : fixtures.callsignXmlW1AW;
+
+					if (encoding == "gzip")
+					{
+						body = compress(body, Poco::DeflatingStreamBuf::STREAM_GZIP);
+						response.set("Content-Encoding", "gzip");
+					}
+					else if (encoding == "deflate")
+					{
+						body = compress(body, Poco::DeflatingStreamBuf::STREAM_ZLIB);
+						response.set("Content-Encoding", "deflate");
+					}
+
+					response.setContentType(bio ? "text/html" : "text/xml");
+					response.sendBuffer(body.data(), body.size());
+				};
+			}
+
+			std::string m_acceptEncoding;
+		};
+
+		TEST_F(CompressionTests, TestGzipResponse)
+		{
+			LocalQrzServer server(compressingHandler("gzip"));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			Callsign callsign = client.fetchCallsign("W1AW");
+
+			ASSERT_EQ("W1AW", callsign.getCall());
+			ASSERT_NE(std::string::npos, m_acceptEncoding.find("gzip")) << "The client should ask for compression";
+
+			net::TransferStats stats = client.getTransferStats()["callsign"];
+			ASSERT_EQ(1u, stats.responses);
+			ASSERT_EQ(fixtures.callsignXmlW1AW.size(), stats.bodyBytes);
+			ASSERT_LT(stats.wireBytes, stats.bodyBytes) << "The record should have come over the wire compressed";
+		}
+
+		TEST_F(CompressionTests, TestDeflateResponse)
+		{
+			LocalQrzServer server(compressingHandler("deflate"));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			std::string bio = client.fetchBio("W1AW", "2024-01-01");
+
+			ASSERT_EQ(fixtures.bioHtmlW1AW, bio);
+
+			net::TransferStats stats = client.getTransferStats()["bio"];
+			ASSERT_EQ(1u, stats.responses);
+			ASSERT_LT(stats.wireBytes, stats.bodyBytes);
+			ASSERT_GT(stats.getSavedFraction(), 0.0);
+		}
+
+		TEST_F(CompressionTests, TestUncompressedResponse)
+		{
+			LocalQrzServer server(compressingHandler("identity"));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			Callsign callsign = client.fetchCallsign("W1AW");
+
+			ASSERT_EQ("W1AW", callsign.getCall()) << "A server that ignores Accept-Encoding should still work";
+
+			net::TransferStats stats = client.getTransferStats()["callsign"];
+			ASSERT_EQ(stats.wireBytes, stats.bodyBytes);
+			ASSERT_EQ(0.0, stats.getSavedFraction());
+		}
+
+		TEST_F(CompressionTests, TestCountersPerEndpoint)
+		{
+			net::TransferCounter counter;
+
+			counter.record("callsign", 400, 1600);
+			counter.record("callsign", 600, 2400);
+			counter.record("bio", 1000, 10000);
+
+			std::map<std::string, net::TransferStats> stats = counter.getStats();
+			ASSERT_EQ(2u, stats.size());
+			ASSERT_EQ(2u, stats["callsign"].responses);
+			ASSERT_EQ(1000u, stats["callsign"].wireBytes);
+			ASSERT_EQ(4000u, stats["callsign"].bodyBytes);
+			ASSERT_DOUBLE_EQ(0.75, stats["callsign"].getSavedFraction());
+
+			net::TransferStats total = counter.getTotal();
+			ASSERT_EQ(3u, total.responses);
+			ASSERT_EQ(2000u, total.wireBytes);
+			ASSERT_EQ(14000u, total.bodyBytes);
+		}
+	}
+}
@@ -0,0 +1,122 @@
+#include "../src/cache/DeferredLookupQueue.h"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+namespace qrz
+{
+	namespace
+	{
+		class DeferredLookupQueueTests : public testing::Test
+		{
+		protected:
+			DeferredLookupQueueTests() = default;
+
+			~DeferredLookupQueueTests() override = default;
+
+			void SetUp() override
+			{
+				queueDir = std::filesystem::temp_directory_path() / "qrzbuddy-deferred-queue-test";
+				std::filesystem::remove_all(queueDir);
+			}
+
+			void TearDown() override
+			{
+				std::filesystem::remove_all(queueDir);
+			}
+
+			std::filesystem::path queueDir;
+		};
+
+		TEST_F(DeferredLookupQueueTests, TestCallsignsAreTakenInTheOrderTheyWereMissed)
+		{
+			cache::DeferredLookupQueue queue(queueDir / "deferred_lookups");
+
+			ASSERT_TRUE(queue.add("w1aw"));
+			ASSERT_TRUE(queue.add("K4RWR"));
+			ASSERT_FALSE(queue.add(" W1AW ")) << "A callsign already queued should keep its place";
+			ASSERT_FALSE(queue.add("w1aw/p")) << "A portable callsign should be queued as its station";
+			ASSERT_FALSE(queue.add(""));
+
+			ASSERT_EQ(2u, queue.size());
+			ASSERT_EQ("W1AW", queue.take()->call);
+			ASSERT_EQ("K4RWR", queue.take()->call);
+			ASSERT_FALSE(queue.take().has_value());
+		}
+
+		TEST_F(DeferredLookupQueueTests, TestRotatedCallsignStaysQueued)
+		{
+			cache::DeferredLookupQueue queue(queueDir / "deferred_lookups");
+
+			queue.add("W1AW");
+			queue.add("K4RWR");
+
+			ASSERT_EQ("W1AW", queue.rotate()->call);
+			ASSERT_EQ(2u, queue.size()) << "A rotated callsign should wait for its record before leaving the queue";
+			ASSERT_EQ("K4RWR", queue.rotate()->call);
+			ASSERT_EQ("W1AW", queue.rotate()->call);
+
+			ASSERT_TRUE(queue.remove("W1AW"));
+			ASSERT_EQ("K4RWR", queue.rotate()->call);
+
+			cache::DeferredLookupQueue reopened(queueDir / "deferred_lookups");
+			ASSERT_EQ("K4RWR", reopened.getEntries().front().call);
+
+			reopened.clear();
+			ASSERT_FALSE(reopened.rotate().has_value());
+		}
+
+		TEST_F(DeferredLookupQueueTests, TestReopenedQueueReadsFromDisk)
+		{
+			{
+				cache::DeferredLookupQueue queue(queueDir / "deferred_lookups");
+				queue.add("W1AW");
+				queue.add("K4RWR");
+				queue.add("N0CALL");
+				queue.remove("k4rwr");
+			}
+
+			cache::DeferredLookupQueue reopened(queueDir / "deferred_lookups");
+
+			std::vector<cache::DeferredLookupQueue::Entry> entries = reopened.getEntries();
+
+			ASSERT_EQ(2u, entries.size());
+			ASSERT_EQ("W1AW", entries[0].call);
+			ASSERT_EQ("N0CALL", entries[1].call);
+			ASSERT_TRUE(reopened.contains("w1aw"));
+			ASSERT_FALSE(reopened.contains("K4RWR"));
+		}
+
+		TEST_F(DeferredLookupQueueTests, TestOldestCallsignMakesWayWhenFull)
+		{
+			cache::DeferredLookupQueue queue(queueDir / "deferred_lookups", 2);
+
+			queue.add("W1AW");
+			queue.add("K4RWR");
+			queue.add("N0CALL");
+
+			ASSERT_EQ(2u, queue.size());
+			ASSERT_FALSE(queue.contains("W1AW"));
+			ASSERT_EQ("K4RWR", queue.take()->call);
+		}
+
+		TEST_F(DeferredLookupQueueTests, TestUnrecognizedLinesAreSkipped)
+		{
+			std::filesystem::create_directories(queueDir);
+			{
+				std::ofstream out(queueDir / "deferred_lookups");
+				out << "W1AW\t1700000000\n" << "garbage\n" << "K4RWR\tnot-a-time\n" << "N0CALL\t1700000060\n";
+			}
+
+			cache::DeferredLookupQueue queue(queueDir / "deferred_lookups");
+
+			ASSERT_EQ(2u, queue.size());
+
+			std::optional<cache::DeferredLookupQueue::Entry> first = queue.take();
+
+			ASSERT_EQ("W1AW", first->call);
+			ASSERT_EQ(1700000000, std::chrono::duration_cast<std::chrono::seconds>(first->queued.time_since_epoch()).count());
+		}
+	}
+}
@@ -0,0 +1,66 @@
+#include "../src/js8call/Js8CallClient.h"
+
+#include <gtest/gtest.h>
+
+#include <QJsonDocument>
+
+namespace qrz
+{
+	namespace
+	{
+		class Js8CallClientTests : public testing::Test
+		{
+		protected:
+			Js8CallClientTests() = default;
+
+			~Js8CallClientTests() override = default;
+
+			// Reads a response the way the client reads one off the socket
+			static std::vector<std::string> readCallActivity(const QByteArray &json)
+			{
+				Message message;
+				message.read(QJsonDocument::fromJson(json).object());
+
+				return Js8CallClient::readCallActivity(message.params());
+			}
+		};
+
+		TEST_F(Js8CallClientTests, TestEmptyCallActivity)
+		{
+			ASSERT_TRUE(readCallActivity(R"({"type":"RX.CALL_ACTIVITY","value":"","params":{"_ID":42}})").empty());
+			ASSERT_TRUE(readCallActivity(R"({"type":"RX.CALL_ACTIVITY","value":""})").empty())
+										<< "A response without parameters has no stations";
+		}
+
+		TEST_F(Js8CallClientTests, TestCallActivityIsMostRecentFirst)
+		{
+			std::vector<std::string> calls = readCallActivity(R"({"type":"RX.CALL_ACTIVITY","value":"","params":{
+				"_ID":42,
+				"k1abc":{"SNR":-12,"GRID":"FN42","UTC":1715012300000},
+				"W1AW":{"SNR":3,"GRID":"FN31","UTC":1715012400000},
+				"VE3/K4RWR":{"SNR":-20,"GRID":"","UTC":1715012200000},
+				"@ALLCALL":{"UTC":1715012500000}
+			}})");
+
+			std::vector<std::string> expected = {"W1AW", "K1ABC", "VE3/K4RWR"};
+
+			ASSERT_EQ(expected, calls) << "Stations should be upper case, most recently heard first, without groups";
+		}
+
+		TEST_F(Js8CallClientTests, TestMalformedCallActivityIsSkipped)
+		{
+			std::vector<std::string> calls = readCallActivity(R"({"type":"RX.CALL_ACTIVITY","value":"","params":{
+				"_ID":42,
+				"W1AW":{"SNR":3,"UTC":1715012400000},
+				"K1ABC":"FN42",
+				"N0CALL":{"SNR":-5},
+				"W5YI":{"UTC":"yesterday"},
+				" ":{"UTC":1715012500000}
+			}})");
+
+			std::vector<std::string> expected = {"W1AW"};
+
+			ASSERT_EQ(expected, calls) << "Stations without a time heard, or without a callsign, should be skipped";
+		}
+	}
+}
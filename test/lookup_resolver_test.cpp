@@ -0,0 +1,173 @@
+#include "../src/LookupResolver.h"
+#include "../src/QRZClient.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <Poco/Net/HTMLForm.h>
+
+#include "QrzClientFixture.h"
+
+namespace qrz
+{
+	namespace
+	{
+		using namespace std::chrono_literals;
+
+		class LookupResolverTests : public QrzClientFixture
+		{
+		protected:
+			LookupResolverTests() = default;
+
+			~LookupResolverTests() override = default;
+
+			// A stand-in for a QRZ endpoint, answering W1AW from the fixtures after a delay, or reporting it not found
+			LocalQrzServer::Handler standIn(std::chrono::milliseconds delay, bool found = true)
+			{
+				return [this, delay, found](Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)
+				{
+					Poco::Net::HTMLForm form(request);
+
+					std::string body = fixtures.sessionResponse;
+
+					if (form.has("callsign"))
+					{
+						std::this_thread::sleep_for(delay);
+						body = found ? fixtures.callsignXmlW1AW : notFoundResponse;
+					}
+
+					response.setContentType("text/xml");
+					response.sendBuffer(body.data(), body.size());
+				};
+			}
+
+			std::string notFoundResponse=R"xml(
+<QRZDatabase version="1.34">
+  <Session>
+    <Error>Not found: W1AW</Error>
+    <Key>c992efd9432fbc4972b36432f822be64</Key>
+  </Session>
+</QRZDatabase>
+)xml";
+		};
+
+		TEST_F(LookupResolverTests, TestLocalStoreIsAskedBeforeAnyProvider)
+		{
+			LocalQrzServer primaryServer(standIn(0ms));
+			LocalQrzServer fallbackServer(standIn(0ms));
+
+			QRZClient primary = buildClient(primaryServer.getBaseUrl());
+			QRZClient fallback = buildClient(fallbackServer.getBaseUrl());
+
+			LookupResolver resolver;
+			resolver.addProvider(primary);
+			resolver.addProvider(fallback);
+
+			fallback.fetchCallsign("W1AW");
+			Callsign callsign = resolver.fetchCallsign("W1AW");
+
+			ASSERT_STREQ("W1AW", callsign.getCall().c_str());
+			ASSERT_EQ(0, primaryServer.getRequestCount()) << "A record the fallback holds should not cost a request";
+			ASSERT_EQ(1, fallbackServer.getRequestCount());
+			ASSERT_EQ(1u, resolver.getLocalHitCount());
+		}
+
+		TEST_F(LookupResolverTests, TestNextProviderAnswersWhenTheFirstHasNoRecord)
+		{
+			LocalQrzServer primaryServer(standIn(0ms, false));
+			LocalQrzServer fallbackServer(standIn(0ms));
+
+			QRZClient primary = buildClient(primaryServer.getBaseUrl());
+			QRZClient fallback = buildClient(fallbackServer.getBaseUrl());
+
+			LookupResolver resolver;
+			resolver.addProvider(primary);
+			resolver.addProvider(fallback);
+
+			Callsign callsign = resolver.fetchCallsign("W1AW", LookupPriority::BACKGROUND);
+
+			ASSERT_STREQ("W1AW", callsign.getCall().c_str());
+
+			std::vector<LookupProviderStats> stats = resolver.getProviderStats();
+
+			ASSERT_EQ(2u, stats.size());
+			ASSERT_EQ(primaryServer.getBaseUrl(), stats[0].name);
+			ASSERT_EQ(1u, stats[0].failures);
+			ASSERT_EQ(1u, stats[1].lookups);
+			ASSERT_EQ(0u, stats[1].failures);
+		}
+
+		TEST_F(LookupResolverTests, TestErrorOfFirstProviderIsReportedWhenAllFail)
+		{
+			LocalQrzServer primaryServer(standIn(0ms, false));
+			LocalQrzServer fallbackServer(standIn(0ms, false));
+
+			QRZClient primary = buildClient(primaryServer.getBaseUrl());
+			QRZClient fallback = buildClient(fallbackServer.getBaseUrl());
+
+			LookupResolver resolver;
+			resolver.addProvider(primary);
+			resolver.addProvider(fallback);
+
+			ASSERT_THROW(resolver.fetchCallsign("W1AW"), NotFoundException);
+			ASSERT_EQ(1, fallbackServer.getRequestCount()) << "Every provider should have been asked";
+		}
+
+		TEST_F(LookupResolverTests, TestHedgeWinsWhenTheFirstProviderIsSlow)
+		{
+			LocalQrzServer primaryServer(standIn(1500ms));
+			LocalQrzServer fallbackServer(standIn(0ms));
+
+			QRZClient primary = buildClient(primaryServer.getBaseUrl());
+			QRZClient fallback = buildClient(fallbackServer.getBaseUrl());
+
+			LookupResolver resolver(100ms);
+			resolver.addProvider(primary);
+			resolver.addProvider(fallback);
+
+			auto start = std::chrono::steady_clock::now();
+			Callsign callsign = resolver.fetchCallsign("W1AW");
+			auto elapsed = std::chrono::steady_clock::now() - start;
+
+			ASSERT_STREQ("W1AW", callsign.getCall().c_str());
+			ASSERT_LT(elapsed, 1000ms) << "The hedge should answer long before the slow provider";
+
+			std::vector<LookupProviderStats> stats = resolver.getProviderStats();
+
+			ASSERT_EQ(1u, stats[1].hedgesWon);
+			ASSERT_EQ(0u, stats[0].lookups) << "The lookup that lost the race was cancelled, not completed";
+		}
+
+		TEST_F(LookupResolverTests, TestBackgroundLookupsAreNotHedged)
+		{
+			LocalQrzServer primaryServer(standIn(300ms));
+			LocalQrzServer fallbackServer(standIn(0ms));
+
+			QRZClient primary = buildClient(primaryServer.getBaseUrl());
+			QRZClient fallback = buildClient(fallbackServer.getBaseUrl());
+
+			LookupResolver resolver(50ms);
+			resolver.addProvider(primary);
+			resolver.addProvider(fallback);
+
+			resolver.fetchCallsign("W1AW", LookupPriority::BACKGROUND);
+
+			ASSERT_EQ(0, fallbackServer.getRequestCount()) << "A background lookup should not spend quota on a race";
+		}
+
+		TEST_F(LookupResolverTests, TestPercentilesUseTheNearestRank)
+		{
+			std::vector<std::chrono::milliseconds> samples;
+			for (int i = 100; i >= 1; i--)
+			{
+				samples.emplace_back(i);
+			}
+
+			ASSERT_EQ(50ms, LookupResolver::percentile(samples, 0.5));
+			ASSERT_EQ(90ms, LookupResolver::percentile(samples, 0.9));
+			ASSERT_EQ(99ms, LookupResolver::percentile(samples, 0.99));
+			ASSERT_EQ(0ms, LookupResolver::percentile({}, 0.5));
+		}
+	}
+}
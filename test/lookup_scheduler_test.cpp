@@ -0,0 +1,126 @@
+#include "../src/LookupScheduler.h"
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace qrz
+{
+	namespace
+	{
+		class LookupSchedulerTests : public testing::Test
+		{
+		protected:
+			LookupSchedulerTests() = default;
+
+			~LookupSchedulerTests() override = default;
+
+			// Returns a job that records its name when it runs
+			LookupScheduler::Job record(const std::string &name)
+			{
+				return [this, name]() { ran.push_back(name); };
+			}
+
+			// Returns a job that records its name when it is dropped
+			LookupScheduler::Job recordDrop(const std::string &name)
+			{
+				return [this, name]() { dropped.push_back(name); };
+			}
+
+			void runAll(LookupScheduler &scheduler)
+			{
+				while (scheduler.runNext())
+				{
+				}
+			}
+
+			std::vector<std::string> ran;
+			std::vector<std::string> dropped;
+		};
+
+		TEST_F(LookupSchedulerTests, TestMostUrgentJobsRunFirst)
+		{
+			LookupScheduler scheduler;
+
+			scheduler.submit(LookupPriority::BACKGROUND, record("K1ABC"), nullptr, "K1ABC");
+			scheduler.submit(LookupPriority::BACKGROUND, record("W2XYZ"), nullptr, "W2XYZ");
+			scheduler.submit(LookupPriority::DETAIL, record("bio"));
+			scheduler.submit(LookupPriority::INTERACTIVE, record("W1AW"));
+
+			runAll(scheduler);
+
+			std::vector<std::string> expected = {"W1AW", "bio", "K1ABC", "W2XYZ"};
+			ASSERT_EQ(expected, ran) << "Jobs should run by priority, then in the order they were submitted";
+		}
+
+		TEST_F(LookupSchedulerTests, TestFullBackgroundQueueDropsOldest)
+		{
+			LookupScheduler scheduler(2);
+
+			scheduler.submit(LookupPriority::BACKGROUND, record("K1ABC"), recordDrop("K1ABC"), "K1ABC");
+			scheduler.submit(LookupPriority::BACKGROUND, record("W2XYZ"), recordDrop("W2XYZ"), "W2XYZ");
+			scheduler.submit(LookupPriority::BACKGROUND, record("KF0ABC"), recordDrop("KF0ABC"), "KF0ABC");
+
+			// Interactive work is never shed, however much of it there is
+			for (int i = 0; i < 5; i++)
+			{
+				scheduler.submit(LookupPriority::INTERACTIVE, record("W1AW"), recordDrop("W1AW"));
+			}
+
+			ASSERT_EQ(std::vector<std::string>{"K1ABC"}, dropped) << "The oldest background job should be dropped";
+
+			LookupSchedulerStats stats = scheduler.getStats();
+			ASSERT_EQ(2, stats.queued[LookupPriority::BACKGROUND]);
+			ASSERT_EQ(5, stats.queued[LookupPriority::INTERACTIVE]);
+			ASSERT_EQ(1, stats.shed);
+
+			runAll(scheduler);
+
+			ASSERT_EQ(7, ran.size());
+			ASSERT_EQ("KF0ABC", ran.back());
+		}
+
+		TEST_F(LookupSchedulerTests, TestStationHeardAgainIsMerged)
+		{
+			LookupScheduler scheduler;
+
+			ASSERT_TRUE(scheduler.submit(LookupPriority::BACKGROUND, record("first"), recordDrop("first"), "K1ABC"));
+			ASSERT_FALSE(scheduler.submit(LookupPriority::BACKGROUND, record("second"), recordDrop("second"), "K1ABC"));
+
+			ASSERT_EQ(std::vector<std::string>{"second"}, dropped) << "The later job should be dropped in favour of the one waiting";
+			ASSERT_EQ(1, scheduler.getStats().merged);
+
+			runAll(scheduler);
+
+			ASSERT_EQ(std::vector<std::string>{"first"}, ran);
+
+			// Once the first lookup has run, the station may be queued again
+			ASSERT_TRUE(scheduler.submit(LookupPriority::BACKGROUND, record("third"), nullptr, "K1ABC"));
+		}
+
+		TEST_F(LookupSchedulerTests, TestWaitTimesAreRecordedPerPriority)
+		{
+			LookupScheduler scheduler;
+			LookupScheduler::Clock::time_point start = LookupScheduler::Clock::now();
+
+			scheduler.submit(LookupPriority::BACKGROUND, record("K1ABC"), nullptr, "K1ABC", start);
+			scheduler.submit(LookupPriority::BACKGROUND, record("W2XYZ"), nullptr, "W2XYZ", start + 100ms);
+			scheduler.submit(LookupPriority::INTERACTIVE, record("W1AW"), nullptr, "", start + 200ms);
+
+			scheduler.runNext(start + 250ms);
+			scheduler.runNext(start + 1000ms);
+			scheduler.runNext(start + 1100ms);
+
+			LookupSchedulerStats stats = scheduler.getStats();
+
+			ASSERT_EQ(50ms, stats.getAverageWait(LookupPriority::INTERACTIVE));
+			ASSERT_EQ(1000ms, stats.maxWait[LookupPriority::BACKGROUND]);
+			ASSERT_EQ(1000ms, stats.getAverageWait(LookupPriority::BACKGROUND));
+			ASSERT_EQ(0ms, stats.getAverageWait(LookupPriority::DETAIL)) << "Nothing waited at detail priority";
+			ASSERT_EQ(0, stats.queued[LookupPriority::BACKGROUND]);
+		}
+	}
+}
@@ -0,0 +1,149 @@
+#include "../src/LookupService.h"
+
+#include <algorithm>
+#include <atomic>
+#include <gtest/gtest.h>
+#include <thread>
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QThread>
+#include <QTimer>
+
+#include <Poco/DateTimeFormatter.h>
+
+#include "MockClient.h"
+
+namespace qrz
+{
+	namespace
+	{
+		class LookupServiceTests : public testing::Test
+		{
+		protected:
+			LookupServiceTests() = default;
+
+			~LookupServiceTests() override = default;
+
+			static void SetUpTestSuite()
+			{
+				// Queued signals are delivered by the event loop, which needs an application object
+				if (QCoreApplication::instance() == nullptr)
+				{
+					static int argc = 1;
+					static char name[] = "qrz_test";
+					static char *argv[] = {name, nullptr};
+					static QCoreApplication application(argc, argv);
+				}
+			}
+
+			void SetUp() override
+			{
+				Poco::Timestamp expiration;
+				expiration += Poco::Timespan(0, 24, 0, 0, 0);
+
+				client.setSessionKey("c992efd9432fbc4972b36432f822be64");
+				client.setSessionExpiration(Poco::DateTimeFormatter::format(expiration, "%Y-%m-%d %H:%M:%S"));
+
+				service = std::make_unique<LookupService>(client,
+						[this](const std::string &call, LookupPriority priority)
+						{
+							if (QThread::currentThread() == QCoreApplication::instance()->thread())
+							{
+								lookupsOnGuiThread++;
+							}
+
+							return client.fetchCallsign(call, priority);
+						},
+						4);
+
+				service->moveToThread(&thread);
+				thread.start();
+			}
+
+			void TearDown() override
+			{
+				thread.quit();
+				thread.wait();
+			}
+
+			// Runs the event loop until the service reports the batch as done, or gives up after a few seconds
+			void waitForBatch(quint64 requestId)
+			{
+				QEventLoop loop;
+
+				QObject::connect(service.get(), &LookupService::lookupsFinished, &loop,
+						[&loop, requestId](quint64 finishedId, int) { if (finishedId == requestId) loop.quit(); });
+				QTimer::singleShot(5000, &loop, &QEventLoop::quit);
+
+				QMetaObject::invokeMethod(service.get(), [this, requestId]()
+				{
+					service->lookupCallsigns(requestId, terms, LookupPriority::INTERACTIVE, credentials, 2);
+				}, Qt::QueuedConnection);
+
+				loop.exec();
+			}
+
+			MockClient client;
+			QThread thread;
+			std::unique_ptr<LookupService> service;
+
+			std::vector<std::string> terms = {"W1AW", "W5YI"};
+			LookupCredentials credentials = {"W1AW", "password"};
+
+			std::atomic<int> lookupsOnGuiThread = 0;
+		};
+
+		TEST_F(LookupServiceTests, TestRecordsArriveOnTheReceiverThread)
+		{
+			QObject receiver;
+			std::vector<std::string> found;
+			int deliveredElsewhere = 0;
+			int lastDone = 0;
+			int finishedWith = -1;
+
+			QObject::connect(service.get(), &LookupService::callsignFound, &receiver,
+					[&found, &deliveredElsewhere](quint64, const Callsign &callsign)
+					{
+						if (QThread::currentThread() != QCoreApplication::instance()->thread())
+						{
+							deliveredElsewhere++;
+						}
+
+						found.push_back(callsign.getCall());
+					});
+			QObject::connect(service.get(), &LookupService::progress, &receiver,
+					[&lastDone](quint64, int done, int) { lastDone = std::max(lastDone, done); });
+			QObject::connect(service.get(), &LookupService::lookupsFinished, &receiver,
+					[&finishedWith](quint64, int count) { finishedWith = count; });
+
+			waitForBatch(1);
+
+			ASSERT_EQ(2, finishedWith) << "The batch should have finished with both records";
+			ASSERT_EQ(2, found.size()) << "Each record should have been reported as it arrived";
+			ASSERT_EQ(2, lastDone) << "Progress should have counted both lookups";
+			ASSERT_EQ(0, deliveredElsewhere) << "Records should be delivered on the thread of the receiver";
+			ASSERT_EQ(0, lookupsOnGuiThread.load()) << "No lookup should have run on the GUI thread";
+		}
+
+		TEST_F(LookupServiceTests, TestExpiredSessionWithoutCredentialsAsksForThem)
+		{
+			client.setSessionExpiration("2000-01-01 00:00:00");
+			credentials = {"", ""};
+
+			QObject receiver;
+			int credentialRequests = 0;
+			int finishedWith = -1;
+
+			QObject::connect(service.get(), &LookupService::credentialsNeeded, &receiver,
+					[&credentialRequests]() { credentialRequests++; });
+			QObject::connect(service.get(), &LookupService::lookupsFinished, &receiver,
+					[&finishedWith](quint64, int count) { finishedWith = count; });
+
+			waitForBatch(1);
+
+			ASSERT_EQ(1, credentialRequests) << "The user should have been asked for credentials once";
+			ASSERT_EQ(0, finishedWith) << "The batch should have finished without records";
+		}
+	}
+}
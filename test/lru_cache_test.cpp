@@ -0,0 +1,119 @@
+#include "../src/cache/LruCache.h"
+#include "../src/QRZClient.h"
+
+#include <gtest/gtest.h>
+
+#include <Poco/Net/HTMLForm.h>
+
+#include "QrzClientFixture.h"
+
+namespace qrz
+{
+	namespace
+	{
+		using namespace std::chrono_literals;
+
+		class LruCacheTests : public QrzClientFixture
+		{
+		protected:
+			LruCacheTests() = default;
+
+			~LruCacheTests() override = default;
+
+			// Answers W1AW from the fixtures and reports every other callsign as not found
+			void serveFixture(Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)
+			{
+				Poco::Net::HTMLForm form(request);
+
+				std::string body = fixtures.sessionResponse;
+
+				if (form.has("callsign"))
+				{
+					body = (form.get("callsign") == "W1AW") ? fixtures.callsignXmlW1AW : notFoundResponse;
+				}
+
+				response.setContentType("text/xml");
+				response.sendBuffer(body.data(), body.size());
+			}
+
+			std::string notFoundResponse=R"xml(
+<QRZDatabase version="1.34">
+  <Session>
+    <Error>Not found: N0CALL</Error>
+    <Key>c992efd9432fbc4972b36432f822be64</Key>
+    <Count>124</Count>
+    <SubExp>Wed Jan 1 12:34:03 2013</SubExp>
+    <GMTime>Sun Aug 16 03:51:47 2012</GMTime>
+  </Session>
+</QRZDatabase>
+)xml";
+		};
+
+		TEST_F(LruCacheTests, TestLeastRecentlyUsedIsEvicted)
+		{
+			cache::LruCache<std::string, int> lru(2);
+
+			lru.put("W1AW", 1);
+			lru.put("K1ABC", 2);
+
+			// Touch W1AW so K1ABC becomes the least recently used
+			ASSERT_EQ(1, lru.get("W1AW"));
+
+			lru.put("W5YI", 3);
+
+			ASSERT_FALSE(lru.get("K1ABC").has_value()) << "Least recently used entry should be evicted";
+			ASSERT_TRUE(lru.get("W1AW").has_value());
+			ASSERT_TRUE(lru.get("W5YI").has_value());
+			ASSERT_EQ(2u, lru.size());
+
+			cache::LruCacheStats stats = lru.getStats();
+			ASSERT_EQ(3u, stats.hits);
+			ASSERT_EQ(1u, stats.misses);
+			ASSERT_EQ(1u, stats.evictions);
+		}
+
+		TEST_F(LruCacheTests, TestEntriesExpire)
+		{
+			cache::LruCache<std::string, int> lru(10, 5min);
+			auto now = cache::LruCache<std::string, int>::Clock::now();
+
+			lru.put("W1AW", 1, now);
+
+			ASSERT_TRUE(lru.get("W1AW", now + 4min).has_value());
+			ASSERT_FALSE(lru.get("W1AW", now + 6min).has_value()) << "Entry should expire after the TTL";
+			ASSERT_EQ(1u, lru.getStats().expirations);
+			ASSERT_EQ(0u, lru.size());
+		}
+
+		TEST_F(LruCacheTests, TestClientRemembersRecords)
+		{
+			LocalQrzServer server([this](auto &request, auto &response) { serveFixture(request, response); });
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			client.fetchCallsign("W1AW");
+			Callsign again = client.fetchCallsign("w1aw");
+
+			ASSERT_STREQ("W1AW", again.getCall().c_str());
+			ASSERT_EQ(1, server.getRequestCount()) << "Second lookup should be answered from memory";
+			ASSERT_EQ(1u, client.getRecordCacheStats().hits);
+		}
+
+		TEST_F(LruCacheTests, TestClientRemembersNotFound)
+		{
+			LocalQrzServer server([this](auto &request, auto &response) { serveFixture(request, response); });
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			ASSERT_THROW(client.fetchCallsign("N0CALL"), NotFoundException);
+			ASSERT_TRUE(client.isKnownNotFound("n0call"));
+			ASSERT_THROW(client.fetchCallsign("N0CALL"), NotFoundException) << "Cached not found should still be reported";
+
+			ASSERT_EQ(1, server.getRequestCount()) << "Not found result should be remembered";
+
+			client.setMemoryCacheLimits(10, 1h, 0s);
+			ASSERT_THROW(client.fetchCallsign("K0NEW"), NotFoundException);
+			ASSERT_FALSE(client.isKnownNotFound("K0NEW")) << "Not found entries should expire";
+		}
+	}
+}
@@ -0,0 +1,150 @@
+/**
+ * A standalone stand-in for xmldata.qrz.com, so the client can be load and latency tested over its real HTTPS,
+ * connection pooling and threading paths without touching the network or the lookup quota.
+ *
+ * qrzbuddy_mock_server [--port N] [--plain] [--threads N] [--corpus DIR] [--strict]
+ *                      [--latency-ms N] [--jitter-ms N]
+ *                      [--timeout-rate R] [--not-found-rate R] [--error-rate R] [--drop-rate R]
+ *
+ * Any username and password log in. Callsigns missing from the corpus are answered with a made up record unless
+ * --strict is given. Rates are between 0.0 and 1.0. Point network/fallback_base_url, or QRZClient::setBaseUrl(), at
+ * the URL it prints, and stop it with Ctrl+C to see what it answered.
+ */
+
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "LocalQrzServer.h"
+#include "MockQrzServer.h"
+
+using namespace qrz;
+
+namespace
+{
+	volatile std::sig_atomic_t stopRequested = 0;
+
+	void requestStop(int)
+	{
+		stopRequested = 1;
+	}
+
+	void usage()
+	{
+		std::cerr << "Usage: qrzbuddy_mock_server [--port N] [--plain] [--threads N] [--corpus DIR] [--strict]\n"
+				  << "                            [--latency-ms N] [--jitter-ms N]\n"
+				  << "                            [--timeout-rate R] [--not-found-rate R] [--error-rate R] [--drop-rate R]\n";
+	}
+}
+
+int main(int argc, char **argv)
+{
+	Poco::UInt16 port = 0;
+	bool secure = true;
+	int threads = 64;
+	bool strict = false;
+	std::string corpus;
+	MockQrzFaults faults;
+
+	try
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+
+			if (arg == "--plain")
+			{
+				secure = false;
+			}
+			else if (arg == "--strict")
+			{
+				strict = true;
+			}
+			else if (arg == "--port" && hasValue)
+			{
+				port = static_cast<Poco::UInt16>(std::stoi(argv[++i]));
+			}
+			else if (arg == "--threads" && hasValue)
+			{
+				threads = std::stoi(argv[++i]);
+			}
+			else if (arg == "--corpus" && hasValue)
+			{
+				corpus = argv[++i];
+			}
+			else if (arg == "--latency-ms" && hasValue)
+			{
+				faults.latency = std::chrono::milliseconds(std::stoi(argv[++i]));
+			}
+			else if (arg == "--jitter-ms" && hasValue)
+			{
+				faults.jitter = std::chrono::milliseconds(std::stoi(argv[++i]));
+			}
+			else if (arg == "--timeout-rate" && hasValue)
+			{
+				faults.sessionTimeoutRate = std::stod(argv[++i]);
+			}
+			else if (arg == "--not-found-rate" && hasValue)
+			{
+				faults.notFoundRate = std::stod(argv[++i]);
+			}
+			else if (arg == "--error-rate" && hasValue)
+			{
+				faults.serverErrorRate = std::stod(argv[++i]);
+			}
+			else if (arg == "--drop-rate" && hasValue)
+			{
+				faults.dropRate = std::stod(argv[++i]);
+			}
+			else
+			{
+				usage();
+				return 1;
+			}
+		}
+	}
+	catch (std::exception &)
+	{
+		usage();
+		return 1;
+	}
+
+	MockQrzServer mock(faults);
+	mock.setSynthesizeRecords(!strict);
+
+	if (!corpus.empty())
+	{
+		std::cout << "Loaded " << mock.loadCorpus(corpus) << " fixtures from " << corpus << std::endl;
+	}
+
+	LocalQrzServer server(mock.getHandler(), secure, Poco::Timespan(10, 0), port, threads);
+
+	std::signal(SIGINT, requestStop);
+	std::signal(SIGTERM, requestStop);
+
+	std::cout << "Serving the QRZ XML API at " << server.getBaseUrl() << ", Ctrl+C to stop" << std::endl;
+
+	while (!stopRequested)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	}
+
+	MockQrzStats stats = mock.getStats();
+
+	std::cout << "\n"
+			  << "Requests:         " << server.getRequestCount() << " over " << server.getTotalConnections()
+			  << " connections\n"
+			  << "Logins:           " << stats.logins << "\n"
+			  << "Callsigns:        " << stats.callsigns << "\n"
+			  << "Bios:             " << stats.bios << "\n"
+			  << "DXCC:             " << stats.dxccs << "\n"
+			  << "Session timeouts: " << stats.sessionTimeouts << "\n"
+			  << "Not found:        " << stats.notFounds << "\n"
+			  << "Server errors:    " << stats.serverErrors << "\n"
+			  << "Dropped:          " << stats.drops << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,161 @@
+#include "../src/QRZClient.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "MockQrzServer.h"
+#include "QrzClientFixture.h"
+
+namespace qrz
+{
+	namespace
+	{
+		using namespace std::chrono_literals;
+
+		class MockQrzServerTests : public QrzClientFixture
+		{
+		protected:
+			MockQrzServerTests() = default;
+
+			~MockQrzServerTests() override = default;
+
+			// A client that has to log in before its first lookup, and retries quickly
+			QRZClient buildClient(const std::string &baseUrl)
+			{
+				QRZClient client = buildLoggedOutClient(baseUrl);
+				client.setRetryPolicy({3, 1ms, 5ms});
+
+				return client;
+			}
+		};
+
+		TEST_F(MockQrzServerTests, TestLookupIsAnsweredFromTheCorpusAfterLogin)
+		{
+			MockQrzServer mock;
+			mock.addCallsign(fixtures.callsignXmlW1AW);
+			mock.addBio("W1AW", fixtures.bioHtmlW1AW);
+
+			LocalQrzServer server(mock.getHandler());
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			Callsign callsign = client.fetchCallsign("w1aw");
+
+			ASSERT_EQ("W1AW", callsign.getCall());
+			ASSERT_FALSE(callsign.getName().empty());
+			ASSERT_EQ(fixtures.bioHtmlW1AW, client.fetchBio("W1AW", "2024-01-01"));
+
+			MockQrzStats stats = mock.getStats();
+
+			ASSERT_EQ(1u, stats.logins);
+			ASSERT_EQ(1u, stats.callsigns);
+			ASSERT_EQ(1u, stats.bios);
+		}
+
+		TEST_F(MockQrzServerTests, TestInjectedErrorsReachTheClient)
+		{
+			MockQrzServer mock;
+			mock.addCallsign(fixtures.callsignXmlW1AW);
+
+			LocalQrzServer server(mock.getHandler());
+
+			QRZClient client = buildClient(server.getBaseUrl());
+			client.fetchToken();
+
+			MockQrzFaults faults;
+			faults.notFoundRate = 1.0;
+			mock.setFaults(faults);
+
+			ASSERT_THROW(client.fetchCallsign("W1AW"), NotFoundException) << "A record in the corpus should still be refused";
+
+			faults.notFoundRate = 0.0;
+			faults.sessionTimeoutRate = 1.0;
+			mock.setFaults(faults);
+
+			// A session timeout is reported before the callsign is even looked at
+			ASSERT_THROW(client.fetchCallsign("K4RWR"), AuthenticationException);
+			ASSERT_EQ(1u, mock.getStats().sessionTimeouts);
+		}
+
+		TEST_F(MockQrzServerTests, TestServerErrorsAndDropsAreRetried)
+		{
+			MockQrzServer mock;
+			mock.setSynthesizeRecords(true);
+
+			LocalQrzServer server(mock.getHandler());
+
+			QRZClient client = buildClient(server.getBaseUrl());
+			client.fetchToken();
+
+			MockQrzFaults faults;
+			faults.serverErrorRate = 1.0;
+			mock.setFaults(faults);
+
+			ASSERT_THROW(client.fetchCallsign("K4RWR"), TransportException);
+
+			ASSERT_EQ(3u, mock.getStats().serverErrors) << "Every attempt of the retry policy should have been made";
+
+			faults.serverErrorRate = 0.0;
+			faults.dropRate = 1.0;
+			mock.setFaults(faults);
+
+			ASSERT_THROW(client.fetchCallsign("N0CALL"), TransportException);
+
+			ASSERT_EQ(3u, mock.getStats().drops);
+		}
+
+		TEST_F(MockQrzServerTests, TestClientKeepsUpUnderLoad)
+		{
+			MockQrzFaults faults;
+			faults.latency = 5ms;
+			faults.jitter = 5ms;
+			faults.serverErrorRate = 0.02;
+			faults.dropRate = 0.01;
+
+			MockQrzServer mock(faults, 42);
+			mock.setSynthesizeRecords(true);
+
+			LocalQrzServer server(mock.getHandler(), true, Poco::Timespan(10, 0), 0, 64);
+
+			QRZClient client = buildClient(server.getBaseUrl());
+			client.setRetryPolicy({5, 1ms, 5ms});
+			client.getCircuitBreaker().setFailureThreshold(1000);
+			client.fetchToken();
+
+			const int threads = 8;
+			const int lookupsPerThread = 50;
+
+			std::atomic<int> found = 0;
+			std::vector<std::thread> workers;
+
+			for (int t = 0; t < threads; t++)
+			{
+				workers.emplace_back([&client, &found, t]()
+				{
+					for (int i = 0; i < lookupsPerThread; i++)
+					{
+						// Every callsign is different, so none of them is answered from the client's cache
+						std::string call = "K" + std::to_string(t) + std::string(1, static_cast<char>('A' + i / 26)) +
+										   std::string(1, static_cast<char>('A' + i % 26));
+
+						if (!client.fetchCallsign(call).getName().empty())
+						{
+							found++;
+						}
+					}
+				});
+			}
+
+			for (std::thread &worker : workers)
+			{
+				worker.join();
+			}
+
+			ASSERT_EQ(threads * lookupsPerThread, found.load());
+			ASSERT_LT(server.getTotalConnections(), server.getRequestCount()) << "Connections should have been reused";
+		}
+	}
+}
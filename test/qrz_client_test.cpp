@@ -4,6 +4,10 @@
 #include <format>
 #include <filesystem>
 
+#include <QCoreApplication>
+#include <QEventLoop>
+
+#include "MockAsyncClient.h"
 #include "MockClient.h"
 
 namespace qrz
@@ -155,6 +159,118 @@ namespace qrz
 )sessionXML";
 		};
 
+		class AsyncClientTests : public QrzClientTests
+		{
+		protected:
+			static void SetUpTestSuite()
+			{
+				// Tasks are resumed from the event loop, which needs an application object
+				if (QCoreApplication::instance() == nullptr)
+				{
+					static int argc = 1;
+					static char name[] = "qrz_test";
+					static char *argv[] = {name, nullptr};
+					static QCoreApplication application(argc, argv);
+				}
+			}
+
+			void SetUp() override
+			{
+				QrzClientTests::SetUp();
+
+				asyncClient = std::make_unique<MockAsyncClient>(client);
+			}
+
+			// Starts a lookup for each callsign and runs the event loop until all of them have finished
+			std::vector<std::string> fetchAll(const std::vector<std::string> &calls, int &requestsBeforeAnswers)
+			{
+				std::vector<std::string> fetched;
+				std::size_t pending = calls.size();
+				QEventLoop loop;
+
+				auto finish = [&pending, &loop]()
+				{
+					if (--pending == 0)
+					{
+						loop.quit();
+					}
+				};
+
+				for (const std::string &call : calls)
+				{
+					asyncClient->fetchCallsign(call).start(
+							[&fetched, &finish](Callsign callsign)
+							{
+								fetched.push_back(callsign.getCall());
+								finish();
+							},
+							[&finish](std::exception_ptr)
+							{
+								finish();
+							});
+				}
+
+				requestsBeforeAnswers = asyncClient->requestCount;
+
+				if (pending > 0)
+				{
+					loop.exec();
+				}
+
+				return fetched;
+			}
+
+			std::unique_ptr<MockAsyncClient> asyncClient;
+		};
+
+		enum class ClientKind
+		{
+			BLOCKING,
+			COROUTINE
+		};
+
+		// Runs the same lookups through the blocking client and the coroutine client
+		class QrzClientImplementationTests : public AsyncClientTests, public testing::WithParamInterface<ClientKind>
+		{
+		protected:
+			Callsign fetchCallsign(const std::string &call)
+			{
+				return (GetParam() == ClientKind::COROUTINE) ? net::blockingWait(asyncClient->fetchCallsign(call))
+															 : client.fetchCallsign(call);
+			}
+
+			DXCC fetchDXCC(const std::string &query)
+			{
+				return (GetParam() == ClientKind::COROUTINE) ? net::blockingWait(asyncClient->fetchDXCC(query))
+															 : client.fetchDXCC(query);
+			}
+
+			std::string fetchBio(const std::string &call)
+			{
+				return (GetParam() == ClientKind::COROUTINE) ? net::blockingWait(asyncClient->fetchBio(call))
+															 : client.fetchBio(call);
+			}
+
+			void fetchToken()
+			{
+				if (GetParam() == ClientKind::COROUTINE)
+				{
+					net::blockingWait(asyncClient->fetchToken());
+				}
+				else
+				{
+					client.fetchToken();
+				}
+			}
+		};
+
+		INSTANTIATE_TEST_SUITE_P(Clients, QrzClientImplementationTests,
+								 testing::Values(ClientKind::BLOCKING, ClientKind::COROUTINE),
+								 [](const testing::TestParamInfo<ClientKind> &info)
+								 {
+									 return (info.param == ClientKind::COROUTINE) ? "Coroutine" : "Blocking";
+								 });
+
 		TEST_F(QrzClientTests, TestGetTokenExpiration)
 		{
 			std::string expiredSessionTime = generateExpiredSessionExpiration();
@@ -189,18 +305,33 @@ namespace qrz
 			ASSERT_TRUE(tokenIsValid) << "Future session time should be recognized";
 		}
 
-		TEST_F(QrzClientTests, TestFetchToken)
+		TEST_P(QrzClientImplementationTests, TestFetchToken)
 		{
-			client.fetchToken();
+			fetchToken();
 
 			const char *expectedSessionKey = "2331uf894c4bd29f3923f3bacf02c532d7bd9";
 
 			ASSERT_STREQ(expectedSessionKey, client.getSessionKey().c_str()) << "Session key should be " << expectedSessionKey;
 		}
 
-		TEST_F(QrzClientTests, TestFetchCallsign)
+		TEST_P(QrzClientImplementationTests, TestFetchTokenReadsQuota)
 		{
-			Callsign testCallsign = client.fetchCallsign("W1AW");
+			client.setDailyLookupLimit(1000);
+			fetchToken();
+
+			QuotaStatus quota = client.getQuotaStatus();
+
+			ASSERT_TRUE(quota.hasCount()) << "Lookup count should be read from the session element";
+			ASSERT_EQ(123, quota.getCount());
+			ASSERT_EQ(877, quota.getRemaining());
+			ASSERT_STREQ("Wed Jan 1 12:34:03 2013", quota.getSubscriptionExpiration().c_str());
+			ASSERT_STREQ("Sun Aug 16 03:51:47 2012", quota.getServerTime().c_str());
+			ASSERT_DOUBLE_EQ(0.877, client.getRateLimiter().getRemainingFraction()) << "Rate limiter should follow the quota";
+		}
+
+		TEST_P(QrzClientImplementationTests, TestFetchCallsign)
+		{
+			Callsign testCallsign = fetchCallsign("W1AW");
 
 			const char *expectedCall = "W1AW";
 			const char *expectedName = "ARRL HQ OPERATORS CLUB";
@@ -211,9 +342,9 @@ namespace qrz
 			ASSERT_STREQ(expectedEmail, testCallsign.getEmail().c_str()) << "Email should be " << expectedEmail;
 		}
 
-		TEST_F(QrzClientTests, TestFetchDXCC)
+		TEST_P(QrzClientImplementationTests, TestFetchDXCC)
 		{
-			DXCC testDXCC = client.fetchDXCC("291");
+			DXCC testDXCC = fetchDXCC("291");
 
 			const char *expectedDxcc = "291";
 			const char *expectedCc = "USA";
@@ -224,9 +355,9 @@ namespace qrz
 			ASSERT_STREQ(expectedName, testDXCC.getName().c_str()) << "Name should be " << expectedName;
 		}
 
-		TEST_F(QrzClientTests, TestFetchBio)
+		TEST_P(QrzClientImplementationTests, TestFetchBio)
 		{
-			std::string testBio = client.fetchBio("W1AW");
+			std::string testBio = fetchBio("W1AW");
 			std::string url = "http://www.arrl.org/w1aw";
 
 			bool foundUrl = (testBio.find(url) != std::string::npos);
@@ -234,6 +365,107 @@ namespace qrz
 			ASSERT_TRUE(foundUrl) << "Expected URL should be found in bio HTML";
 		}
 
+		TEST_P(QrzClientImplementationTests, TestUnreachableLoginIsTransportError)
+		{
+			client.setSessionExpiration(generateExpiredSessionExpiration());
+			client.loginUnreachable = true;
+
+			ASSERT_THROW(fetchCallsign("W1AW"), TransportException) << "A failed login should not leak a Poco exception";
+			ASSERT_THROW(fetchDXCC("291"), TransportException);
+			ASSERT_THROW(fetchBio("W1AW"), TransportException);
+		}
+
+		TEST_F(AsyncClientTests, TestLookupsShareTheEventLoop)
+		{
+			int requestsBeforeAnswers = 0;
+			std::vector<std::string> fetched = fetchAll({"W1AW", "W5YI"}, requestsBeforeAnswers);
+
+			ASSERT_EQ(2, requestsBeforeAnswers) << "Both requests should be in flight before either answer arrives";
+			ASSERT_EQ(2u, fetched.size());
+		}
+
+		TEST_F(AsyncClientTests, TestConcurrentLookupsCoalesce)
+		{
+			int requestsBeforeAnswers = 0;
+			std::vector<std::string> fetched = fetchAll({"W1AW", "W1AW", "w1aw"}, requestsBeforeAnswers);
+
+			ASSERT_EQ(3u, fetched.size());
+			ASSERT_EQ(1, asyncClient->requestCount) << "Lookups of the same callsign should share one request";
+			ASSERT_EQ(2u, asyncClient->getCoalescedLookupCount());
+		}
+
+		TEST_F(AsyncClientTests, TestExpiredSessionLogsInOnce)
+		{
+			client.setSessionExpiration(generateExpiredSessionExpiration());
+
+			int requestsBeforeAnswers = 0;
+			std::vector<std::string> fetched = fetchAll({"W1AW", "W5YI"}, requestsBeforeAnswers);
+
+			ASSERT_EQ(2u, fetched.size());
+			ASSERT_EQ(3, asyncClient->requestCount) << "Both lookups should wait for a single login";
+			ASSERT_STREQ("2331uf894c4bd29f3923f3bacf02c532d7bd9", client.getSessionKey().c_str())
+										<< "The coroutine client should renew the session of the client it is built on";
+		}
+
+		TEST_F(AsyncClientTests, TestJoinedLookupSharesTheFailure)
+		{
+			client.setSessionExpiration(generateExpiredSessionExpiration());
+			client.loginUnreachable = true;
+
+			int requestsBeforeAnswers = 0;
+			std::vector<std::string> fetched = fetchAll({"W1AW", "W1AW"}, requestsBeforeAnswers);
+
+			ASSERT_TRUE(fetched.empty());
+			ASSERT_EQ(1, asyncClient->requestCount) << "The joined lookup should fail with the first instead of logging in again";
+		}
+
+		TEST_F(AsyncClientTests, TestCancelledJoinerStopsWaiting)
+		{
+			asyncClient->latency = std::chrono::milliseconds(300);
+
+			auto cancel = std::make_shared<net::CancellationToken>();
+			std::vector<std::string> finished;
+			QEventLoop loop;
+
+			asyncClient->fetchCallsign("W1AW").start(
+					[&finished, &loop](Callsign)
+					{
+						finished.push_back("leader");
+						loop.quit();
+					},
+					[&loop](std::exception_ptr)
+					{
+						loop.quit();
+					});
+
+			asyncClient->fetchCallsign("W1AW", LookupPriority::INTERACTIVE, cancel).start(
+					[&finished](Callsign)
+					{
+						finished.push_back("joiner");
+					},
+					[&finished](std::exception_ptr error)
+					{
+						try
+						{
+							std::rethrow_exception(error);
+						}
+						catch (CancelledException &)
+						{
+							finished.push_back("cancelled");
+						}
+						catch (...)
+						{
+							finished.push_back("failed");
+						}
+					});
+
+			cancel->cancel();
+			loop.exec();
+
+			ASSERT_EQ((std::vector<std::string>{"cancelled", "leader"}), finished)
+										<< "The cancelled joiner should not wait for the lookup it joined";
+		}
+
 		TEST_F(QrzClientTests, TestValidateResponseGoodResponse)
 		{
 			bool valid = client.testValidateResponse(client.sessionResponse);
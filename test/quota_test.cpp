@@ -0,0 +1,80 @@
+#include "../src/net/QuotaRateLimiter.h"
+
+#include <gtest/gtest.h>
+
+namespace qrz
+{
+	namespace
+	{
+		using namespace std::chrono_literals;
+
+		class QuotaRateLimiterTests : public testing::Test
+		{
+		protected:
+			QuotaRateLimiterTests() = default;
+
+			~QuotaRateLimiterTests() override = default;
+
+			// Start well after the limiter was created so its own clock reads do not interfere
+			net::QuotaRateLimiter::Clock::time_point start = net::QuotaRateLimiter::Clock::now() + 1h;
+		};
+
+		TEST_F(QuotaRateLimiterTests, TestBurstThenRefill)
+		{
+			// One lookup per second, up to three back to back
+			net::QuotaRateLimiter limiter(60, 3);
+
+			for (int i = 0; i < 3; i++)
+			{
+				ASSERT_TRUE(limiter.tryAcquire(LookupPriority::BACKGROUND, start)) << "Burst lookup " << i << " should be allowed";
+			}
+
+			ASSERT_FALSE(limiter.tryAcquire(LookupPriority::BACKGROUND, start)) << "Bucket should be empty after the burst";
+			ASSERT_TRUE(limiter.tryAcquire(LookupPriority::BACKGROUND, start + 1s)) << "One token should refill after a second";
+			ASSERT_FALSE(limiter.tryAcquire(LookupPriority::BACKGROUND, start + 1500ms));
+
+			net::QuotaRateLimiterStats stats = limiter.getStats();
+			ASSERT_EQ(4u, stats.granted);
+			ASSERT_EQ(2u, stats.deferred);
+		}
+
+		TEST_F(QuotaRateLimiterTests, TestLowQuotaSlowsBackground)
+		{
+			net::QuotaRateLimiter limiter(60, 1);
+
+			ASSERT_TRUE(limiter.tryAcquire(LookupPriority::BACKGROUND, start));
+
+			// With a quarter of the quota left the bucket refills four times slower
+			limiter.setRemainingFraction(0.25);
+
+			ASSERT_FALSE(limiter.tryAcquire(LookupPriority::BACKGROUND, start + 2s));
+			ASSERT_TRUE(limiter.tryAcquire(LookupPriority::BACKGROUND, start + 5s));
+		}
+
+		TEST_F(QuotaRateLimiterTests, TestExhaustedQuotaStopsBackgroundOnly)
+		{
+			net::QuotaRateLimiter limiter(60, 5);
+
+			limiter.setRemainingFraction(0.0);
+
+			ASSERT_FALSE(limiter.tryAcquire(LookupPriority::BACKGROUND, start)) << "Background lookups should stop with no quota left";
+
+			for (int i = 0; i < 10; i++)
+			{
+				ASSERT_TRUE(limiter.tryAcquire(LookupPriority::INTERACTIVE, start)) << "Interactive lookups should always get through";
+			}
+
+			ASSERT_EQ(10u, limiter.getStats().interactive);
+		}
+
+		TEST_F(QuotaRateLimiterTests, TestInteractiveUsesTokens)
+		{
+			net::QuotaRateLimiter limiter(60, 2);
+
+			ASSERT_TRUE(limiter.tryAcquire(LookupPriority::INTERACTIVE, start));
+			ASSERT_TRUE(limiter.tryAcquire(LookupPriority::INTERACTIVE, start));
+
+			ASSERT_FALSE(limiter.tryAcquire(LookupPriority::BACKGROUND, start)) << "Interactive lookups should drain the shared bucket";
+		}
+	}
+}
@@ -0,0 +1,194 @@
+#include "../src/net/CancellationToken.h"
+#include "../src/QRZClient.h"
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <optional>
+#include <thread>
+
+#include <Poco/Net/ServerSocket.h>
+
+#include "QrzClientFixture.h"
+
+namespace qrz
+{
+	namespace
+	{
+		using namespace std::chrono_literals;
+
+		class RequestDeadlineTests : public QrzClientFixture
+		{
+		protected:
+			RequestDeadlineTests() = default;
+
+			~RequestDeadlineTests() override = default;
+
+			QRZClient buildClient(const std::string &baseUrl)
+			{
+				QRZClient client = QrzClientFixture::buildClient(baseUrl);
+				client.setRequestDeadlines({500ms, 300ms, 1s});
+
+				return client;
+			}
+
+			// Answers with the W1AW record after sleeping
+			LocalQrzServer::Handler slowHandler(std::chrono::milliseconds delay)
+			{
+				return [this, delay](Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)
+				{
+					std::this_thread::sleep_for(delay);
+
+					response.setContentType("text/xml");
+					response.sendBuffer(fixtures.callsignXmlW1AW.data(), fixtures.callsignXmlW1AW.size());
+				};
+			}
+
+			static std::chrono::milliseconds elapsedSince(std::chrono::steady_clock::time_point start)
+			{
+				return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+			}
+		};
+
+		TEST_F(RequestDeadlineTests, TestCancelledTokenRunsCallbacks)
+		{
+			net::CancellationToken cancel;
+			int calls = 0;
+
+			{
+				net::CancellationToken::Registration registration = cancel.subscribe([&calls]() { calls++; });
+			}
+
+			net::CancellationToken::Registration registration = cancel.subscribe([&calls]() { calls += 10; });
+
+			cancel.cancel();
+			cancel.cancel();
+
+			ASSERT_EQ(10, calls) << "Only the live registration should run, and only once";
+			ASSERT_TRUE(cancel.isCancelled());
+			ASSERT_THROW(cancel.throwIfCancelled(), CancelledException);
+
+			cancel.subscribe([&calls]() { calls += 100; });
+			ASSERT_EQ(110, calls) << "Subscribing to a cancelled token should run the callback at once";
+		}
+
+		TEST_F(RequestDeadlineTests, TestCallbacksRunWithoutTheTokenLocked)
+		{
+			net::CancellationToken cancel;
+			std::optional<net::CancellationToken::Registration> registration;
+			bool nestedRan = false;
+
+			registration = cancel.subscribe([&]()
+			{
+				// Either of these would deadlock if the token were still locked
+				cancel.subscribe([&nestedRan]() { nestedRan = true; });
+				registration.reset();
+			});
+
+			std::thread canceller([&cancel]() { cancel.cancel(); });
+			canceller.join();
+
+			ASSERT_TRUE(nestedRan);
+			ASSERT_FALSE(registration.has_value());
+		}
+
+		TEST_F(RequestDeadlineTests, TestReadDeadline)
+		{
+			LocalQrzServer server(slowHandler(2s));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			auto start = std::chrono::steady_clock::now();
+			ASSERT_THROW(client.fetchCallsign("W1AW"), TimeoutException);
+
+			ASSERT_LT(elapsedSince(start), 1500ms) << "A silent server should be given up on after the read timeout";
+		}
+
+		TEST_F(RequestDeadlineTests, TestTotalDeadline)
+		{
+			// Trickles the body out, so no single read ever waits long enough to time out
+			LocalQrzServer server([](Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)
+			{
+				response.setContentType("text/xml");
+				response.setChunkedTransferEncoding(true);
+
+				std::ostream &out = response.send();
+				for (int i = 0; i < 40; i++)
+				{
+					out << "<!-- still going -->" << std::flush;
+					std::this_thread::sleep_for(100ms);
+				}
+			});
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			auto start = std::chrono::steady_clock::now();
+			ASSERT_THROW(client.fetchCallsign("W1AW"), TimeoutException);
+
+			ASSERT_LT(elapsedSince(start), 2s) << "A trickling server should be given up on after the total deadline";
+		}
+
+		TEST_F(RequestDeadlineTests, TestHandshakeDeadline)
+		{
+			// Completes the TCP handshake through the backlog, but never answers the TLS handshake
+			Poco::Net::ServerSocket silent(Poco::Net::SocketAddress("127.0.0.1", 0));
+
+			QRZClient client = buildClient("https://127.0.0.1:" + std::to_string(silent.address().port()));
+
+			Poco::URI uri(client.getBaseUrl());
+
+			auto start = std::chrono::steady_clock::now();
+			ASSERT_ANY_THROW(client.sendRequest(uri));
+
+			ASSERT_LT(elapsedSince(start), 1500ms) << "A stalled handshake should not outlast the deadlines";
+		}
+
+		TEST_F(RequestDeadlineTests, TestCancelInFlightLookup)
+		{
+			LocalQrzServer server(slowHandler(2s));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+			client.setRequestDeadlines({5s, 5s, 10s});
+
+			auto cancel = std::make_shared<net::CancellationToken>();
+
+			std::thread canceller([cancel]()
+			{
+				std::this_thread::sleep_for(200ms);
+				cancel->cancel();
+			});
+
+			auto start = std::chrono::steady_clock::now();
+			EXPECT_THROW(client.fetchCallsign("W1AW", LookupPriority::INTERACTIVE, cancel), CancelledException);
+			auto elapsed = elapsedSince(start);
+
+			canceller.join();
+
+			ASSERT_LT(elapsed, 1s) << "Cancelling should abort the blocked read";
+			ASSERT_FALSE(client.isKnownNotFound("W1AW")) << "A cancelled lookup is not a not found result";
+		}
+
+		TEST_F(RequestDeadlineTests, TestCancelledBeforeStart)
+		{
+			LocalQrzServer server(slowHandler(0ms));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			auto cancel = std::make_shared<net::CancellationToken>();
+			cancel->cancel();
+
+			ASSERT_THROW(client.fetchCallsign("W1AW", LookupPriority::INTERACTIVE, cancel), CancelledException);
+			ASSERT_EQ(0, server.getRequestCount()) << "A cancelled lookup should not reach the server";
+		}
+
+		TEST_F(RequestDeadlineTests, TestFastServerIsUnaffected)
+		{
+			LocalQrzServer server(slowHandler(50ms));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			Callsign callsign = client.fetchCallsign("W1AW");
+
+			ASSERT_STREQ("W1AW", callsign.getCall().c_str());
+		}
+	}
+}
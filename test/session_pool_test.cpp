@@ -0,0 +1,156 @@
+#include "../src/QRZClient.h"
+
+#include <gtest/gtest.h>
+#include <thread>
+
+#include <Poco/Net/SecureStreamSocket.h>
+
+#include "QrzClientFixture.h"
+
+namespace qrz
+{
+	namespace
+	{
+		class SessionPoolTests : public QrzClientFixture
+		{
+		protected:
+			SessionPoolTests() = default;
+
+			~SessionPoolTests() override = default;
+		};
+
+		TEST_F(SessionPoolTests, TestConnectionIsReused)
+		{
+			LocalQrzServer server(serveRecord(fixtures.callsignXmlW1AW));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			for (int i = 0; i < 5; i++)
+			{
+				Callsign callsign = client.fetchCallsign("W1AW");
+				ASSERT_STREQ("W1AW", callsign.getCall().c_str()) << "Lookup " << i << " should succeed";
+			}
+
+			net::HTTPSessionPoolStats stats = client.getSessionPool()->getStats();
+
+			ASSERT_EQ(5, server.getRequestCount()) << "Every lookup should reach the server";
+			ASSERT_EQ(1, server.getTotalConnections()) << "All lookups should share one connection";
+			ASSERT_EQ(1u, stats.created) << "Only one session should be created";
+			ASSERT_EQ(4u, stats.reused) << "The session should be reused for subsequent lookups";
+		}
+
+		TEST_F(SessionPoolTests, TestStaleConnectionReconnects)
+		{
+			// The server drops idle connections almost immediately
+			LocalQrzServer server(serveRecord(fixtures.callsignXmlW1AW),
+								  true, Poco::Timespan(0, 100000));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			Callsign first = client.fetchCallsign("W1AW");
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+			Callsign second = client.fetchCallsign("W1AW");
+
+			ASSERT_STREQ("W1AW", first.getCall().c_str()) << "First lookup should succeed";
+			ASSERT_STREQ("W1AW", second.getCall().c_str()) << "Lookup on a stale connection should transparently reconnect";
+			ASSERT_EQ(2, server.getTotalConnections()) << "A new connection should replace the stale one";
+		}
+
+		TEST_F(SessionPoolTests, TestConcurrentLeasesUseSeparateSessions)
+		{
+			LocalQrzServer server(serveRecord(fixtures.callsignXmlW1AW), false);
+
+			auto pool = std::make_shared<net::HTTPSessionPool>(Poco::URI(server.getBaseUrl()), 2);
+
+			{
+				net::HTTPSessionPool::Lease first = pool->acquire();
+				net::HTTPSessionPool::Lease second = pool->acquire();
+
+				ASSERT_NE(&first.session(), &second.session()) << "Outstanding leases must not share a session";
+				ASSERT_FALSE(first.isReused()) << "First session should be new";
+				ASSERT_FALSE(second.isReused()) << "Second session should be new";
+			}
+
+			ASSERT_EQ(2u, pool->getStats().created) << "Two sessions should have been created";
+		}
+
+		TEST_F(SessionPoolTests, TestReconnectResumesTLSSession)
+		{
+			LocalQrzServer server(serveRecord(fixtures.callsignXmlW1AW));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			net::TLSHandshakeStats before = net::SharedTLSContext::instance().getStats();
+
+			client.fetchCallsign("W1AW");
+
+			// Drop the pooled connection so the next lookup has to connect again
+			client.getSessionPool()->clear();
+
+			client.fetchCallsign("W1AW");
+
+			net::TLSHandshakeStats after = net::SharedTLSContext::instance().getStats();
+
+			ASSERT_EQ(2, server.getTotalConnections()) << "The second lookup should open a new connection";
+			ASSERT_EQ(before.full + 1, after.full) << "Only the first connection should need a full handshake";
+			ASSERT_EQ(before.resumed + 1, after.resumed) << "The second connection should resume the TLS session";
+		}
+
+		TEST_F(SessionPoolTests, TestPrewarmedConnectionIsUsedByTheNextLookup)
+		{
+			LocalQrzServer server(serveRecord(fixtures.callsignXmlW1AW));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			ASSERT_TRUE(client.getSessionPool()->prewarm(Poco::Timespan(5, 0))) << "A connection should be opened";
+			ASSERT_FALSE(client.getSessionPool()->prewarm(Poco::Timespan(5, 0))) << "An idle connection is already waiting";
+
+			client.fetchCallsign("W1AW");
+
+			net::HTTPSessionPoolStats stats = client.getSessionPool()->getStats();
+
+			ASSERT_EQ(1, server.getTotalConnections()) << "The lookup should use the prewarmed connection";
+			ASSERT_EQ(1u, stats.prewarmed);
+			ASSERT_EQ(1u, stats.reused);
+		}
+
+		TEST_F(SessionPoolTests, TestLeaseKeepsReplacedPoolAlive)
+		{
+			LocalQrzServer server(serveRecord(fixtures.callsignXmlW1AW));
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			std::shared_ptr<net::HTTPSessionPool> pool = client.getSessionPool();
+			std::weak_ptr<net::HTTPSessionPool> watched = pool;
+
+			{
+				net::HTTPSessionPool::Lease lease = pool->acquire();
+				pool.reset();
+
+				client.setBaseUrl(server.getBaseUrl());
+
+				ASSERT_FALSE(watched.expired()) << "An outstanding lease should keep its pool alive";
+				ASSERT_NE(watched.lock(), client.getSessionPool()) << "Changing the base URL should replace the pool";
+			}
+
+			ASSERT_TRUE(watched.expired()) << "The replaced pool should go once its last lease is returned";
+		}
+
+		TEST_F(SessionPoolTests, TestPrewarmedConnectionNamesTheHost)
+		{
+			LocalQrzServer server(serveRecord(fixtures.callsignXmlW1AW));
+
+			auto pool = std::make_shared<net::HTTPSessionPool>(Poco::URI(server.getBaseUrl()));
+
+			ASSERT_TRUE(pool->prewarm(Poco::Timespan(5, 0)));
+
+			net::HTTPSessionPool::Lease lease = pool->acquire();
+			Poco::Net::SecureStreamSocket socket(lease.session().socket());
+
+			// The name sent for SNI, and the one the certificate was verified against
+			ASSERT_EQ(pool->getHost(), socket.getPeerHostName());
+		}
+	}
+}
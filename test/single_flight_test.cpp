@@ -0,0 +1,248 @@
+#include "../src/SingleFlight.h"
+#include "../src/QRZClient.h"
+
+#include <chrono>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+
+#include <Poco/Net/HTMLForm.h>
+
+#include "QrzClientFixture.h"
+
+namespace qrz
+{
+	namespace
+	{
+		class SingleFlightTests : public QrzClientFixture
+		{
+		protected:
+			SingleFlightTests() = default;
+
+			~SingleFlightTests() override = default;
+
+			// Starts the given number of threads at once and waits for them all to finish
+			void runConcurrently(int count, const std::function<void(int)> &function)
+			{
+				std::vector<std::thread> threads;
+
+				for (int i = 0; i < count; i++)
+				{
+					threads.emplace_back(function, i);
+				}
+
+				for (std::thread &thread : threads)
+				{
+					thread.join();
+				}
+			}
+		};
+
+		TEST_F(SingleFlightTests, TestConcurrentCallsShareResult)
+		{
+			SingleFlight<std::string, int> flights;
+			std::atomic<int> calls = 0;
+			std::vector<int> results(8);
+
+			runConcurrently(8, [&](int i)
+			{
+				results[i] = flights.run("W1AW", [&calls]()
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(200));
+					return ++calls;
+				});
+			});
+
+			ASSERT_EQ(1, calls) << "Only one call should be made";
+			ASSERT_EQ(1u, flights.getCallCount());
+			ASSERT_EQ(7u, flights.getCoalescedCount()) << "Seven callers should have joined the first";
+
+			for (int result : results)
+			{
+				ASSERT_EQ(1, result) << "Every caller should get the same result";
+			}
+		}
+
+		TEST_F(SingleFlightTests, TestExceptionIsShared)
+		{
+			SingleFlight<std::string, int> flights;
+			std::atomic<int> failures = 0;
+
+			runConcurrently(4, [&](int)
+			{
+				try
+				{
+					flights.run("W1AW", []() -> int
+					{
+						std::this_thread::sleep_for(std::chrono::milliseconds(200));
+						throw std::runtime_error("Not found: W1AW");
+					});
+				}
+				catch (std::runtime_error &)
+				{
+					failures++;
+				}
+			});
+
+			ASSERT_EQ(4, failures) << "Every caller should see the exception";
+			ASSERT_EQ(1u, flights.getCallCount());
+		}
+
+		TEST_F(SingleFlightTests, TestCompletedCallsAreNotReused)
+		{
+			SingleFlight<std::string, int> flights;
+			int calls = 0;
+
+			flights.run("W1AW", [&calls]() { return ++calls; });
+			int second = flights.run("W1AW", [&calls]() { return ++calls; });
+
+			ASSERT_EQ(2, second) << "A call that has completed should not be shared with later callers";
+			ASSERT_EQ(0u, flights.getCoalescedCount());
+		}
+
+		TEST_F(SingleFlightTests, TestCancelledCallerStopsWaitingWhileCallCarriesOn)
+		{
+			SingleFlight<std::string, int> flights;
+			auto leaderToken = std::make_shared<net::CancellationToken>();
+			auto joinerToken = std::make_shared<net::CancellationToken>();
+			std::atomic<bool> callCancelled = false;
+			std::atomic<bool> joinerCancelled = false;
+			int leaderResult = 0;
+
+			std::thread leader([&]()
+			{
+				leaderResult = flights.run("W1AW", 0, leaderToken, [&](const std::shared_ptr<net::CancellationToken> &token)
+				{
+					callCancelled = token->waitFor(std::chrono::milliseconds(300));
+					return 1;
+				});
+			});
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+			std::thread joiner([&]()
+			{
+				try
+				{
+					flights.run("W1AW", 0, joinerToken, [](const std::shared_ptr<net::CancellationToken> &) { return 2; });
+				}
+				catch (CancelledException &)
+				{
+					joinerCancelled = true;
+				}
+			});
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			joinerToken->cancel();
+			joiner.join();
+
+			ASSERT_TRUE(joinerCancelled) << "The caller that cancelled should stop waiting straight away";
+
+			leader.join();
+
+			ASSERT_FALSE(callCancelled) << "The call should carry on while another caller still waits for it";
+			ASSERT_EQ(1, leaderResult);
+		}
+
+		TEST_F(SingleFlightTests, TestCallIsCancelledOnceEveryCallerHasCancelled)
+		{
+			SingleFlight<std::string, int> flights;
+			auto leaderToken = std::make_shared<net::CancellationToken>();
+			auto joinerToken = std::make_shared<net::CancellationToken>();
+			std::atomic<bool> callCancelled = false;
+
+			std::thread leader([&]()
+			{
+				flights.run("W1AW", 0, leaderToken, [&](const std::shared_ptr<net::CancellationToken> &token)
+				{
+					callCancelled = token->waitFor(std::chrono::seconds(5));
+					return 1;
+				});
+			});
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+			std::thread joiner([&]()
+			{
+				ASSERT_THROW(flights.run("W1AW", 0, joinerToken, [](const std::shared_ptr<net::CancellationToken> &) { return 2; }),
+							 CancelledException);
+			});
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			leaderToken->cancel();
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			ASSERT_FALSE(callCancelled) << "One caller is still waiting";
+
+			joinerToken->cancel();
+
+			joiner.join();
+			leader.join();
+
+			ASSERT_TRUE(callCancelled);
+		}
+
+		TEST_F(SingleFlightTests, TestUrgentCallerDoesNotJoinLessUrgentCall)
+		{
+			SingleFlight<std::string, int> flights;
+			std::atomic<int> calls = 0;
+			std::vector<int> results(3);
+
+			auto call = [&calls](const std::shared_ptr<net::CancellationToken> &)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(200));
+				return ++calls;
+			};
+
+			std::thread background([&]() { results[0] = flights.run("W1AW", 2, nullptr, call); });
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+			std::thread interactive([&]() { results[1] = flights.run("W1AW", 0, nullptr, call); });
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+			// Less urgent callers may join either call
+			std::thread detail([&]() { results[2] = flights.run("W1AW", 1, nullptr, call); });
+
+			background.join();
+			interactive.join();
+			detail.join();
+
+			ASSERT_EQ(2, calls) << "The interactive caller should have made its own call";
+			ASSERT_NE(results[0], results[1]);
+			ASSERT_EQ(results[1], results[2]) << "The detail caller should have joined the interactive call";
+		}
+
+		TEST_F(SingleFlightTests, TestClientCoalescesDuplicateLookups)
+		{
+			LocalQrzServer server([this](Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)
+			{
+				Poco::Net::HTMLForm form(request);
+
+				std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+				std::string body = form.has("callsign") ? fixtures.callsignXmlW1AW : fixtures.sessionResponse;
+
+				response.setContentType("text/xml");
+				response.sendBuffer(body.data(), body.size());
+			});
+
+			QRZClient client = buildClient(server.getBaseUrl());
+
+			std::vector<std::string> calls(6);
+
+			runConcurrently(6, [&](int i)
+			{
+				// Mixed case, as typed by the user and as decoded by JS8Call
+				calls[i] = client.fetchCallsign(i % 2 ? "w1aw" : "W1AW").getCall();
+			});
+
+			for (const std::string &call : calls)
+			{
+				ASSERT_STREQ("W1AW", call.c_str());
+			}
+
+			ASSERT_EQ(1, server.getRequestCount()) << "Duplicate lookups should share one request";
+			ASSERT_EQ(5u, client.getCoalescedLookupCount());
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#include "../src/StaleRecordRefresher.h"
+
+#include <chrono>
+#include <gtest/gtest.h>
+
+using namespace std::chrono_literals;
+
+namespace qrz
+{
+	namespace
+	{
+		class StaleRecordRefresherTests : public testing::Test
+		{
+		protected:
+			StaleRecordRefresherTests() = default;
+
+			~StaleRecordRefresherTests() override = default;
+
+			StaleRecordRefresher::Clock::time_point start = StaleRecordRefresher::Clock::now();
+		};
+
+		TEST_F(StaleRecordRefresherTests, TestFreshRecordsAreLeftAlone)
+		{
+			StaleRecordRefresher refresher(12h, 6);
+
+			refresher.track("W1AW", start);
+			refresher.track("W5YI", start - 11h);
+
+			ASSERT_FALSE(refresher.next(start).has_value()) << "No record is older than the maximum age";
+			ASSERT_EQ(0, refresher.getStaleCount(start));
+		}
+
+		TEST_F(StaleRecordRefresherTests, TestOldestStaleRecordIsCheckedFirst)
+		{
+			StaleRecordRefresher refresher(12h, 60);
+
+			refresher.track("W1AW", start - 13h);
+			refresher.track("W5YI", start - 20h);
+			refresher.track("K1ABC", start);
+
+			ASSERT_EQ(2, refresher.getStaleCount(start));
+			ASSERT_EQ("W5YI", refresher.next(start).value());
+			ASSERT_EQ("W1AW", refresher.next(start + 1min).value());
+			ASSERT_FALSE(refresher.next(start + 2min).has_value()) << "Records handed out count as checked";
+		}
+
+		TEST_F(StaleRecordRefresherTests, TestBudgetIsSpreadOverTheHour)
+		{
+			StaleRecordRefresher refresher(1h, 4);
+
+			for (const char *call : {"W1AW", "W5YI", "K1ABC", "W2XYZ", "KF0ABC", "N0CALL"})
+			{
+				refresher.track(call, start - 2h);
+			}
+
+			int checked = 0;
+			for (auto now = start; now < start + 1h; now += 1min)
+			{
+				if (refresher.next(now).has_value())
+				{
+					checked++;
+				}
+			}
+
+			ASSERT_EQ(4, checked) << "No more than the budget should be spent in an hour";
+		}
+
+		TEST_F(StaleRecordRefresherTests, TestForgottenRecordIsNotChecked)
+		{
+			StaleRecordRefresher refresher(12h, 6);
+
+			refresher.track("W1AW", start - 24h);
+			refresher.forget("W1AW");
+
+			ASSERT_FALSE(refresher.next(start).has_value());
+		}
+	}
+}
@@ -0,0 +1,147 @@
+#include "../src/net/TokenRefresher.h"
+#include "../src/QRZClient.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <gtest/gtest.h>
+#include <thread>
+
+
+#include "QrzClientFixture.h"
+
+namespace qrz
+{
+	namespace
+	{
+		using namespace std::chrono_literals;
+
+		class TokenRefresherTests : public QrzClientFixture
+		{
+		protected:
+			TokenRefresherTests() = default;
+
+			~TokenRefresherTests() override = default;
+		};
+
+		TEST_F(TokenRefresherTests, TestDelayUntilRefresh)
+		{
+			ASSERT_EQ(90min, net::TokenRefresher::delayUntilRefresh(2h, 30min));
+			ASSERT_EQ(0ms, net::TokenRefresher::delayUntilRefresh(10min, 30min)) << "Token inside the lead time is renewed now";
+			ASSERT_EQ(0ms, net::TokenRefresher::delayUntilRefresh(-5min, 30min)) << "Expired token is renewed now";
+		}
+
+		TEST_F(TokenRefresherTests, TestExpiringTokenIsRenewedInBackground)
+		{
+			LocalQrzServer server([this](Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)
+			{
+				std::string body = fixtures.sessionResponse;
+
+				response.setContentType("text/xml");
+				response.sendBuffer(body.data(), body.size());
+			});
+
+			// Five minutes left, well inside a thirty minute lead time
+			QRZClient client = buildClient(server.getBaseUrl(), Poco::Timespan(0, 0, 5, 0, 0));
+
+			std::promise<bool> refreshed;
+			net::TokenRefresher refresher(
+					[&client]() { return client.getTokenTimeRemaining(); },
+					[&client]()
+					{
+						client.fetchToken();
+						return client.tokenIsValid();
+					},
+					30min);
+			refresher.setCallback([&refreshed](bool success) { refreshed.set_value(success); });
+			refresher.start();
+
+			std::future<bool> result = refreshed.get_future();
+			ASSERT_EQ(std::future_status::ready, result.wait_for(5s)) << "Token should be renewed without being asked";
+			ASSERT_TRUE(result.get());
+
+			refresher.stop();
+
+			ASSERT_STREQ("2331uf894c4bd29f3923f3bacf02c532d7bd9", client.getSessionKey().c_str());
+			ASSERT_GT(client.getTokenTimeRemaining(), 23h) << "Renewed token should be good for another day";
+			ASSERT_EQ(1u, refresher.getStats().refreshes);
+			ASSERT_EQ(1, server.getRequestCount());
+		}
+
+		TEST_F(TokenRefresherTests, TestFreshTokenIsLeftAlone)
+		{
+			std::atomic<int> refreshes = 0;
+
+			net::TokenRefresher refresher(
+					[]() { return std::chrono::milliseconds(12h); },
+					[&refreshes]()
+					{
+						refreshes++;
+						return true;
+					},
+					30min);
+			refresher.start();
+
+			std::this_thread::sleep_for(100ms);
+
+			auto start = std::chrono::steady_clock::now();
+			refresher.stop();
+
+			ASSERT_LT(std::chrono::steady_clock::now() - start, 1s) << "Stopping should not wait for the next refresh";
+			ASSERT_EQ(0, refreshes);
+			ASSERT_FALSE(refresher.isRunning());
+		}
+
+		TEST_F(TokenRefresherTests, TestFailedRefreshBacksOff)
+		{
+			std::atomic<int> attempts = 0;
+
+			net::TokenRefresher refresher(
+					[]() { return std::chrono::milliseconds(0); },
+					[&attempts]()
+					{
+						attempts++;
+						return false;
+					},
+					30min, 20ms);
+			refresher.start();
+
+			// Retries at 0, 20, 60 and 140ms
+			std::this_thread::sleep_for(200ms);
+			refresher.stop();
+
+			ASSERT_GE(attempts, 3);
+			ASSERT_LE(attempts, 5) << "Retries should back off rather than spin";
+			ASSERT_EQ(static_cast<std::uint64_t>(attempts.load()), refresher.getStats().failures);
+		}
+
+		TEST_F(TokenRefresherTests, TestConcurrentTokenFetchesShareOneLogin)
+		{
+			LocalQrzServer server([this](Poco::Net::HTTPServerRequest &request, Poco::Net::HTTPServerResponse &response)
+			{
+				std::this_thread::sleep_for(100ms);
+
+				std::string body = fixtures.sessionResponse;
+
+				response.setContentType("text/xml");
+				response.sendBuffer(body.data(), body.size());
+			});
+
+			QRZClient client = buildClient(server.getBaseUrl(), Poco::Timespan(0, 0, 0, 0, 0));
+
+			std::vector<std::thread> threads;
+			for (int i = 0; i < 4; i++)
+			{
+				threads.emplace_back([&client]() { client.fetchToken(); });
+			}
+
+			for (std::thread &thread : threads)
+			{
+				thread.join();
+			}
+
+			ASSERT_TRUE(client.tokenIsValid());
+			ASSERT_EQ(1, server.getRequestCount()) << "Overlapping token requests should share one login";
+		}
+	}
+}
@@ -0,0 +1,151 @@
+#include "../src/net/TrafficArchive.h"
+#include "../src/QRZClient.h"
+
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include <Poco/InflatingStream.h>
+#include <Poco/StreamCopier.h>
+
+#include "MockQrzServer.h"
+#include "QrzClientFixture.h"
+
+namespace qrz
+{
+	namespace
+	{
+		using namespace std::chrono_literals;
+
+		class TrafficArchiveTests : public QrzClientFixture
+		{
+		protected:
+			TrafficArchiveTests() = default;
+
+			~TrafficArchiveTests() override = default;
+
+			void SetUp() override
+			{
+				archiveDir = std::filesystem::temp_directory_path() / "qrzbuddy-traffic-archive-test";
+				std::filesystem::remove_all(archiveDir);
+			}
+
+			void TearDown() override
+			{
+				std::filesystem::remove_all(archiveDir);
+			}
+
+			static std::string readArchive(const std::filesystem::path &path)
+			{
+				std::ifstream file(path, std::ios::binary);
+				Poco::InflatingInputStream in(file, Poco::InflatingStreamBuf::STREAM_GZIP);
+
+				std::string contents;
+				Poco::StreamCopier::copyToString(in, contents);
+
+				return contents;
+			}
+
+			std::filesystem::path archiveDir;
+		};
+
+		TEST_F(TrafficArchiveTests, TestRecordedResponsesAreReplayedInOrder)
+		{
+			Poco::URI first("https://xmldata.qrz.com/xml/current/?s=abc123&callsign=W1AW&agent=qrzclnt1.0");
+			Poco::URI second("https://xmldata.qrz.com/xml/current/?callsign=W1AW&s=def456");
+
+			{
+				net::TrafficArchive archive(archiveDir / "traffic.gz", net::TrafficArchive::Mode::RECORD);
+				archive.record(first, 200, "first\nresponse", 120ms);
+				archive.record(second, 503, "second", 40ms);
+			}
+
+			net::TrafficArchive archive(archiveDir / "traffic.gz", net::TrafficArchive::Mode::REPLAY);
+
+			ASSERT_EQ(2u, archive.size());
+
+			net::RecordedExchange exchange = archive.replay(second);
+
+			ASSERT_EQ("xmldata.qrz.com:443/xml/current/?callsign=W1AW", exchange.request)
+				<< "The session key should not tell lookups apart";
+			ASSERT_EQ("first\nresponse", exchange.body);
+			ASSERT_EQ(120ms, exchange.latency);
+			ASSERT_EQ(503, archive.replay(first).status);
+			ASSERT_EQ(200, archive.replay(first).status) << "Replay should start over once every response was used";
+
+			archive.setReplaySpeed(4.0);
+			ASSERT_EQ(30ms, archive.getReplayDelay(exchange));
+
+			archive.setReplaySpeed(0.0);
+			ASSERT_EQ(0ms, archive.getReplayDelay(exchange));
+
+			ASSERT_THROW(archive.replay(Poco::URI("https://xmldata.qrz.com/xml/current/?callsign=K4RWR")), std::runtime_error);
+			ASSERT_THROW(archive.replay(Poco::URI("https://fallback.example.com/xml/current/?callsign=W1AW")), std::runtime_error)
+				<< "Responses of one server should not answer requests to another";
+		}
+
+		TEST_F(TrafficArchiveTests, TestCredentialsAndSessionKeysAreScrubbed)
+		{
+			Poco::URI login("https://xmldata.qrz.com/xml/current/?username=W1AW&password=correct-horse%26battery");
+
+			std::string body = "<Session><Key>2331uf894c4bd29f3923f3bacf02c532d7bd9</Key>"
+							   "<Username>W1AW</Username><Password>correct-horse&amp;battery</Password>"
+							   "<Message>Welcome back, horse</Message></Session>";
+
+			std::string scrubbed = net::TrafficArchive::scrub(body);
+			std::string placeholder = net::TrafficArchive::SCRUBBED_KEY;
+
+			ASSERT_EQ("<Session><Key>" + placeholder + "</Key><Username>" + placeholder + "</Username><Password>" +
+					  placeholder + "</Password><Message>Welcome back, horse</Message></Session>", scrubbed)
+				<< "Only the credential elements should be touched, escaped or not";
+			ASSERT_EQ("xmldata.qrz.com:443/xml/current/?password=&username=", net::TrafficArchive::requestOf(login));
+		}
+
+		TEST_F(TrafficArchiveTests, TestCapturedLookupsReplayWithoutTheNetwork)
+		{
+			std::string sessionKey;
+			std::string baseUrl;
+
+			{
+				MockQrzServer mock;
+				mock.addCallsign(fixtures.callsignXmlW1AW);
+
+				LocalQrzServer server(mock.getHandler());
+				baseUrl = server.getBaseUrl();
+
+				auto archive = std::make_shared<net::TrafficArchive>(archiveDir / "traffic.gz",
+																	 net::TrafficArchive::Mode::RECORD);
+
+				QRZClient client = buildLoggedOutClient(server.getBaseUrl(), "correct-horse-battery");
+				client.setTrafficArchive(archive);
+
+				ASSERT_THROW(client.fetchCallsign("K4RWR"), NotFoundException);
+				ASSERT_EQ("W1AW", client.fetchCallsign("W1AW").getCall());
+
+				sessionKey = client.getSessionKey();
+
+				ASSERT_EQ(3u, archive->size()) << "The login and both lookups should have been recorded";
+			}
+
+			std::string contents = readArchive(archiveDir / "traffic.gz");
+
+			ASSERT_EQ(std::string::npos, contents.find("correct-horse-battery"));
+			ASSERT_EQ(std::string::npos, contents.find(sessionKey));
+
+			// The server is gone, every answer has to come from the archive
+			auto archive = std::make_shared<net::TrafficArchive>(archiveDir / "traffic.gz", net::TrafficArchive::Mode::REPLAY);
+			archive->setReplaySpeed(0.0);
+
+			QRZClient replaying = buildLoggedOutClient(baseUrl, "correct-horse-battery");
+			replaying.setTrafficArchive(archive);
+
+			Callsign callsign = replaying.fetchCallsign("W1AW");
+
+			ASSERT_EQ("W1AW", callsign.getCall());
+			ASSERT_FALSE(callsign.getName().empty());
+			ASSERT_EQ(net::TrafficArchive::SCRUBBED_KEY, replaying.getSessionKey());
+			ASSERT_THROW(replaying.fetchCallsign("K4RWR"), NotFoundException);
+		}
+	}
+}
@@ -0,0 +1,241 @@
+/**
+ * Compares the single pass QrzXmlDecoder with the DOM based path it replaced, which parsed every response twice:
+ * once to validate the Session element and once to map the record through a chain of string compares.
+ *
+ * Run it from a release build: qrzbuddy_benchmark [iterations]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <Poco/AutoPtr.h>
+#include <Poco/DOM/DOMParser.h>
+#include <Poco/DOM/Document.h>
+#include <Poco/DOM/Element.h>
+#include <Poco/DOM/Node.h>
+
+#include "../src/model/QrzXmlDecoder.h"
+
+using namespace qrz;
+
+namespace
+{
+	// A response as the live API sends it, with the declaration and namespace
+	const std::string callsignResponse = R"xml(<?xml version="1.0" encoding="utf-8" ?>
+<QRZDatabase version="1.34" xmlns="http://xmldata.qrz.com">
+    <Callsign>
+        <call>W1AW</call>
+        <xref/>
+        <aliases/>
+        <dxcc>291</dxcc>
+        <fname/>
+        <name>ARRL HQ OPERATORS CLUB</name>
+        <addr1>225 MAIN ST</addr1>
+        <addr2>NEWINGTON</addr2>
+        <state>CT</state>
+        <zip>06111</zip>
+        <country>United States</country>
+        <ccode>HAB</ccode>
+        <lat>41.714775</lat>
+        <lon>-72.727260</lon>
+        <grid>FN31pr</grid>
+        <county>Hartford</county>
+        <fips>09003</fips>
+        <land>United States</land>
+        <efdate>2020-12-08</efdate>
+        <expdate>2031-02-26</expdate>
+        <p_call/>
+        <class>C</class>
+        <codes>HAB</codes>
+        <qslmgr>US STATIONS PLEASE QSL VIA LOTW OR DIRECT WITH SASE.</qslmgr>
+        <email>W1AW@ARRL.ORG</email>
+        <url/>
+        <u_views>4970576</u_views>
+        <bio>2144</bio>
+        <biodate>2023-06-01 19:15:16</biodate>
+        <image>https://cdn-xml.qrz.com/w/w1aw/W1AW.jpg</image>
+        <imageinfo>168:250:20359</imageinfo>
+        <serial/>
+        <moddate>2021-10-18 16:09:52</moddate>
+        <MSA>3280</MSA>
+        <AreaCode>860</AreaCode>
+        <TimeZone>Eastern</TimeZone>
+        <GMTOffset>-5</GMTOffset>
+        <DST>Y</DST>
+        <eqsl>0</eqsl>
+        <mqsl>1</mqsl>
+        <cqzone>5</cqzone>
+        <ituzone>8</ituzone>
+        <born/>
+        <user/>
+        <lotw>1</lotw>
+        <iota/>
+        <geoloc>user</geoloc>
+        <attn>JOSEPH P CARCIA III</attn>
+        <nickname/>
+        <name_fmt>ARRL HQ OPERATORS CLUB</name_fmt>
+    </Callsign>
+	<Session>
+		<Key>d0cf9d7b3b937ed5f5de28ddf5a0122d</Key>
+		<Count>12</Count>
+		<SubExp>Wed Jan 13 13:59:00 2013</SubExp>
+		<GMTime>Mon Oct 12 22:33:56 2012</GMTime>
+	</Session>
+</QRZDatabase>
+)xml";
+
+	// Keeps the optimizer from dropping work whose result is never used
+	volatile std::size_t sink = 0;
+
+	QuotaStatus domValidate(const std::string &xml)
+	{
+		Poco::XML::DOMParser parser;
+		Poco::AutoPtr<Poco::XML::Document> doc = parser.parseString(xml);
+
+		Poco::XML::Element *sessionElement = doc->documentElement()->getChildElement("Session");
+		if (sessionElement == nullptr || sessionElement->getChildElement("Error") != nullptr)
+		{
+			throw std::runtime_error("Invalid response");
+		}
+
+		QuotaStatus quota;
+
+		Poco::XML::Element *countElement = sessionElement->getChildElement("Count");
+		if (countElement != nullptr)
+		{
+			quota.setCount(std::stoi(countElement->innerText()));
+		}
+
+		return quota;
+	}
+
+	Callsign domCallsign(const std::string &xml)
+	{
+		Poco::XML::DOMParser parser;
+		Poco::AutoPtr<Poco::XML::Document> doc = parser.parseString(xml);
+
+		Callsign callsign;
+
+		for (Poco::XML::Node *child = doc->documentElement()->getChildElement("Callsign")->firstChild();
+			 child != nullptr; child = child->nextSibling())
+		{
+			if (child->nodeType() != Poco::XML::Node::ELEMENT_NODE)
+			{
+				continue;
+			}
+
+			const std::string name = child->nodeName();
+			const std::string value = child->innerText();
+
+			if (name.empty() || value.empty()) continue;
+
+			if (name == "call") callsign.setCall(value);
+			else if (name == "xref") callsign.setXref(value);
+			else if (name == "aliases") callsign.setAliases(value);
+			else if (name == "dxcc") callsign.setDxcc(value);
+			else if (name == "fname") callsign.setFname(value);
+			else if (name == "name") callsign.setName(value);
+			else if (name == "addr1") callsign.setAddr1(value);
+			else if (name == "addr2") callsign.setCity(value);
+			else if (name == "city") callsign.setCity(value);
+			else if (name == "state") callsign.setState(value);
+			else if (name == "zip") callsign.setZip(value);
+			else if (name == "country") callsign.setCountry(value);
+			else if (name == "ccode") callsign.setCcode(value);
+			else if (name == "lat") callsign.setLat(value);
+			else if (name == "lon") callsign.setLon(value);
+			else if (name == "grid") callsign.setGrid(value);
+			else if (name == "county") callsign.setCounty(value);
+			else if (name == "fips") callsign.setFips(value);
+			else if (name == "land") callsign.setLand(value);
+			else if (name == "efdate") callsign.setEfdate(value);
+			else if (name == "expdate") callsign.setExpdate(value);
+			else if (name == "p_call") callsign.setPcall(value);
+			else if (name == "class") callsign.setClass(value);
+			else if (name == "codes") callsign.setCodes(value);
+			else if (name == "qslmgr") callsign.setQslmgr(value);
+			else if (name == "email") callsign.setEmail(value);
+			else if (name == "url") callsign.setUrl(value);
+			else if (name == "u_views") callsign.setUViews(atoi(value.c_str()));
+			else if (name == "bio") callsign.setBio(atoi(value.c_str()));
+			else if (name == "biodate") callsign.setBiodate(value);
+			else if (name == "image") callsign.setImage(value);
+			else if (name == "imageinfo") callsign.setImageinfo(value);
+			else if (name == "serial") callsign.setSerial(value);
+			else if (name == "moddate") callsign.setModdate(value);
+			else if (name == "MSA") callsign.setMsa(value);
+			else if (name == "AreaCode") callsign.setAreaCode(value);
+			else if (name == "TimeZone") callsign.setTimeZone(value);
+			else if (name == "GMTOffset") callsign.setGmtOffset(atoi(value.c_str()));
+			else if (name == "DST") callsign.setDst(value);
+			else if (name == "eqsl") callsign.setEqsl(value);
+			else if (name == "mqsl") callsign.setMqsl(value);
+			else if (name == "cqzone") callsign.setCqzone(atoi(value.c_str()));
+			else if (name == "ituzone") callsign.setItuzone(atoi(value.c_str()));
+			else if (name == "born") callsign.setBorn(value);
+			else if (name == "user") callsign.setUser(value);
+			else if (name == "lotw") callsign.setLotw(value);
+			else if (name == "iota") callsign.setIota(value);
+			else if (name == "geoloc") callsign.setGeoloc(value);
+			else if (name == "attn") callsign.setAttn(value);
+			else if (name == "nickname") callsign.setNickname(value);
+			else if (name == "name_fmt") callsign.setNameFmt(value);
+		}
+
+		return callsign;
+	}
+
+	template<typename F>
+	double nanosPerCall(int iterations, F &&decode)
+	{
+		// Warm up caches and the allocator before timing
+		for (int i = 0; i < iterations / 10; i++)
+		{
+			decode();
+		}
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (int i = 0; i < iterations; i++)
+		{
+			decode();
+		}
+
+		std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+		return elapsed.count() / iterations;
+	}
+
+	void report(const std::string &name, const std::string &xml, int iterations)
+	{
+		double dom = nanosPerCall(iterations, [&xml]()
+		{
+			QuotaStatus quota = domValidate(xml);
+			Callsign callsign = domCallsign(xml);
+			sink = sink + callsign.getCall().size() + quota.getCount();
+		});
+
+		double decoder = nanosPerCall(iterations, [&xml]()
+		{
+			Callsign callsign;
+			QuotaStatus quota = QrzXmlDecoder::decodeCallsign(xml, callsign);
+			sink = sink + callsign.getCall().size() + quota.getCount();
+		});
+
+		std::cout << name << " (" << xml.size() << " bytes)\n"
+				  << "  DOM, parsed twice:   " << dom / 1000 << " us per response\n"
+				  << "  QrzXmlDecoder:       " << decoder / 1000 << " us per response\n"
+				  << "  speedup:             " << dom / decoder << "x\n";
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int iterations = (argc > 1) ? std::atoi(argv[1]) : 20000;
+
+	report("W1AW callsign response", callsignResponse, iterations);
+
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include "../src/model/QrzXmlDecoder.h"
+#include "../src/exception/AuthenticationException.h"
+#include "../src/exception/NotFoundException.h"
+
+#include <gtest/gtest.h>
+
+#include "MockClient.h"
+
+namespace qrz
+{
+	namespace
+	{
+		class XmlDecoderTests : public testing::Test
+		{
+		protected:
+			XmlDecoderTests() = default;
+
+			~XmlDecoderTests() override = default;
+
+			// The shape of a real response: declaration, namespace, and the Session after the record
+			std::string dxccResponse = R"xml(<?xml version="1.0" encoding="utf-8" ?>
+<QRZDatabase version="1.34" xmlns="http://xmldata.qrz.com">
+  <DXCC>
+    <dxcc>291</dxcc>
+    <cc>US</cc>
+    <ccc>USA</ccc>
+    <name>United States</name>
+    <continent>NA</continent>
+    <ituzone>6</ituzone>
+    <cqzone>3</cqzone>
+    <timezone>-5</timezone>
+    <lat>37.701207</lat>
+    <lon>-97.316895</lon>
+    <notes>Includes &lt;KH&gt; &amp; &lt;KL&gt; prefixes</notes>
+  </DXCC>
+  <Session>
+    <Key>2331uf894c4bd29f3923f3bacf02c532d7bd9</Key>
+    <Count>123</Count>
+    <SubExp>Wed Jan 1 12:34:03 2025</SubExp>
+    <GMTime>Sun Aug 16 03:51:47 2024</GMTime>
+  </Session>
+</QRZDatabase>
+)xml";
+
+			MockClient fixtures;
+		};
+
+		TEST_F(XmlDecoderTests, TestDecodeCallsignResponse)
+		{
+			Callsign callsign;
+			QuotaStatus quota = QrzXmlDecoder::decodeCallsign(fixtures.callsignXmlW1AW, callsign);
+
+			ASSERT_EQ("W1AW", callsign.getCall());
+			ASSERT_EQ("ARRL HQ OPERATORS CLUB", callsign.getName());
+			ASSERT_EQ("NEWINGTON", callsign.getCity()) << "addr2 should be read as the city";
+			ASSERT_EQ(4970576, callsign.getUViews());
+			ASSERT_EQ(-5, callsign.getGmtOffset());
+			ASSERT_EQ(8, callsign.getItuzone());
+			ASSERT_EQ("3280", callsign.getMsa());
+			ASSERT_EQ("2021-10-18 16:09:52", callsign.getModdate());
+			ASSERT_TRUE(callsign.getXref().empty());
+
+			ASSERT_EQ(12, quota.getCount());
+			ASSERT_EQ("Wed Jan 13 13:59:00 2013", quota.getSubscriptionExpiration());
+		}
+
+		TEST_F(XmlDecoderTests, TestDecodeDXCCResponse)
+		{
+			DXCC dxcc;
+			QuotaStatus quota = QrzXmlDecoder::decodeDXCC(dxccResponse, dxcc);
+
+			ASSERT_EQ("291", dxcc.getDxcc());
+			ASSERT_EQ("USA", dxcc.getCcc());
+			ASSERT_EQ("Includes <KH> & <KL> prefixes", dxcc.getNotes());
+			ASSERT_EQ(123, quota.getCount());
+		}
+
+		TEST_F(XmlDecoderTests, TestSessionErrors)
+		{
+			Callsign callsign;
+
+			ASSERT_THROW(QrzXmlDecoder::decodeCallsign(
+					"<QRZDatabase><Session><Error>Session Timeout</Error></Session></QRZDatabase>", callsign),
+						 AuthenticationException);
+
+			ASSERT_THROW(QrzXmlDecoder::decodeCallsign(
+					"<QRZDatabase><Session><Error>Not found: XX9XXX</Error></Session></QRZDatabase>", callsign),
+						 NotFoundException);
+
+			ASSERT_THROW(QrzXmlDecoder::decodeSession(
+					"<QRZDatabase><Session><Error>Something broke</Error></Session></QRZDatabase>"),
+						 std::runtime_error);
+
+			ASSERT_THROW(QrzXmlDecoder::decodeCallsign("<QRZDatabase><Callsign><call>W1AW</call></Callsign></QRZDatabase>",
+													   callsign), std::runtime_error) << "A response needs a Session";
+		}
+
+		TEST_F(XmlDecoderTests, TestEscapedText)
+		{
+			std::string xml = "<?xml version='1.0' encoding='ISO-8859-1'?>"
+							  "<QRZDatabase><Callsign>"
+							  "<call>DL1ABC</call>"
+							  "<name>M\xfcller &amp; S\xf6hne &#x263A;</name>"
+							  "<fname><!-- nickname -->Hans<![CDATA[ <Jr> ]]></fname>"
+							  "<extra><nested>ignored</nested></extra>"
+							  "</Callsign></QRZDatabase>";
+
+			Callsign callsign = QrzXmlDecoder::readCallsign(xml);
+
+			ASSERT_EQ("M\xc3\xbcller & S\xc3\xb6hne \xe2\x98\xba", callsign.getName()) << "Text should come back as UTF-8";
+			ASSERT_EQ("Hans <Jr> ", callsign.getFname());
+		}
+
+		TEST_F(XmlDecoderTests, TestMalformedXml)
+		{
+			ASSERT_THROW(QrzXmlDecoder::readCallsign("<QRZDatabase><Callsign><call>W1AW</cal></Callsign></QRZDatabase>"),
+						 std::runtime_error);
+			ASSERT_THROW(QrzXmlDecoder::readCallsign("<QRZDatabase><Callsign><call>W1AW"), std::runtime_error);
+			ASSERT_THROW(QrzXmlDecoder::readCallsign("<Other><Callsign/></Other>"), std::runtime_error);
+			ASSERT_THROW(QrzXmlDecoder::readCallsign("<QRZDatabase><Callsign/></QRZDatabase>trailing"), std::runtime_error);
+			ASSERT_THROW(QrzXmlDecoder::readCallsign("<QRZDatabase><Callsign><call>&bogus;</call></Callsign></QRZDatabase>"),
+						 std::runtime_error);
+			ASSERT_THROW(QrzXmlDecoder::readDXCC("<QRZDatabase><Callsign/></QRZDatabase>"), std::runtime_error);
+		}
+	}
+}